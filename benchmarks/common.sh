@@ -32,6 +32,28 @@ if [ "$LLVM_DIR" ]; then
   export PATH=$PATH:$LLVM_DIR/bin
 fi
 
+# Multi-threaded mode: NUM_THREADS=<n> distributes the outer loops of the
+# kernels across <n> OpenMP threads (0 lets the OpenMP runtime decide, e.g.
+# all cores of a socket with OMP_PLACES=cores OMP_PROC_BIND=close).
+# PARALLEL_DIMS=1 distributes only the outermost block dimension, the
+# default 2 collapses the two outermost ones. Single-threaded by default.
+NUM_THREADS=${NUM_THREADS:-1}
+PARALLEL_DIMS=${PARALLEL_DIMS:-2}
+PARALLEL_LOOPS=false
+PARALLEL_ARGS=()
+OPENMP_ARGS=()
+OPENMP_FLAGS=()
+if [ "${NUM_THREADS}" != "1" ]; then
+  PARALLEL_LOOPS=true
+  PARALLEL_ARGS=(-convert-parallel-loops-to-openmp="num-threads=${NUM_THREADS} parallel-dims=${PARALLEL_DIMS}")
+  OPENMP_ARGS=(-convert-openmp-to-llvm)
+  OPENMP_FLAGS=(-fopenmp)
+  if [ "${NUM_THREADS}" -gt 0 ]; then
+    export OMP_NUM_THREADS=${NUM_THREADS}
+  fi
+  echo "threads: ${NUM_THREADS} (parallel dims: ${PARALLEL_DIMS})"
+fi
+
 RED='\033[0;31m'
 GREEN='\033[0;32m'
 NC='\033[0m' # No Color
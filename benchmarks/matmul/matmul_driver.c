@@ -3,6 +3,9 @@
 #include <string.h>
 
 #include <libxsmm.h>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
 
 #if !defined(ARG_MNK)
 #define ARG_MNK "32x32x32"
@@ -30,6 +33,15 @@ void matmul_refimpl(const struct vec_f2d *a, const struct vec_f2d *b,
   }
 }
 
+/* Number of threads available to the kernel under test */
+int get_num_threads(void) {
+#if defined(_OPENMP)
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
 /* Initialize matrix with value x+y at position (x, y) */
 void init_matrix(struct vec_f2d *matrix) {
   const int64_t m = matrix->sizes[1], n = matrix->sizes[0];
@@ -170,8 +182,8 @@ int main(int argc, char *argv[]) {
 #else
           "XSMM"
 #endif
-          ": %f GFLOPS/s\n",
-          1e-9 * (2.0 * m * n * k * nrepeat) / duration);
+          ": %f GFLOPS/s (%d threads)\n",
+          1e-9 * (2.0 * m * n * k * nrepeat) / duration, get_num_threads());
       fputs("Result is correct\n", stderr);
     }
   } else {
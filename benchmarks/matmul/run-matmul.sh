@@ -8,7 +8,7 @@ compile () {
   echo "Compile kernel ----> matmul_kernel_${1}"
   
   # Compile driver. 
-  clang -O3 -emit-llvm -S -I$LIB_INCLUDE_PATH -DARG_MNK=\"${1}\" matmul_driver.c
+  clang -O3 "${OPENMP_FLAGS[@]}" -emit-llvm -S -I$LIB_INCLUDE_PATH -DARG_MNK=\"${1}\" matmul_driver.c
   llc $LLC_ARGS matmul_driver.ll
 
   # Fire tpp compiler (with xsmm conversion).
@@ -16,7 +16,7 @@ compile () {
 
   tpp-opt matmul_kernel_${1}.mlir -map-linalg-to-tpp -pre-bufferization -one-shot-bufferize="bufferize-function-boundaries allow-return-allocs function-boundary-type-conversion=identity-layout-map" -canonicalize -drop-equivalent-buffer-results -finalizing-bufferize \
     -convert-linalg-to-tpp="enable-tiling" -convert-tpp-to-xsmm -loop-invariant-code-motion -convert-xsmm-to-func \
-    -convert-linalg-to-loops -arith-expand -convert-vector-to-scf -convert-scf-to-cf -convert-vector-to-llvm \
+    -convert-linalg-to-loops -arith-expand -convert-vector-to-scf "${PARALLEL_ARGS[@]}" -convert-scf-to-cf "${OPENMP_ARGS[@]}" -convert-vector-to-llvm \
     -convert-func-to-llvm -convert-memref-to-llvm -canonicalize -reconcile-unrealized-casts \
   | mlir-translate -mlir-to-llvmir -o matmul_kernel_${1}.ll
   llc $LLC_ARGS matmul_kernel_${1}.ll
@@ -29,7 +29,7 @@ compile () {
     export LD_LIBRARY_PATH=$LIB_PATH:$LD_LIBRARY_PATH
   fi
 
-  clang -O3 matmul_driver.s matmul_kernel_${1}.s -L$LIB_PATH -ltpp_c_runner_utils -lm -o matmul_${1}
+  clang -O3 "${OPENMP_FLAGS[@]}" matmul_driver.s matmul_kernel_${1}.s -L$LIB_PATH -ltpp_c_runner_utils -lm -o matmul_${1}
 
   rm *.s
   rm *.ll
@@ -3,6 +3,9 @@
 #include <string.h>
 
 #include <libxsmm.h>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
 
 #define MAX(a,b) ((a) > (b) ? (a) : (b))
 
@@ -53,6 +56,15 @@ void mlp_refimpl(const struct vec_f2d *a, const struct vec_f2d *b,
   }
 }
 
+/* Number of threads available to the mlp under test */
+int get_num_threads(void) {
+#if defined(_OPENMP)
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
 /* Initialize matrix with value x+y at position (x, y) */
 void init_matrix(struct vec_f2d *matrix) {
   const int64_t m = matrix->sizes[1], n = matrix->sizes[0];
@@ -76,6 +88,9 @@ void clear_matrix(struct vec_f2d *matrix) {
 int main(int argc, char *argv[]) {
 
   struct vec_f2d a, b, c, out, out_ref;
+  const double max_duration = 5.0;
+  const int nwarmup = 10;
+  int nrepeat = (1 < argc ? atoi(argv[1]) : 0);
   memset(&a, 0, sizeof(a));
   memset(&b, 0, sizeof(b));
   memset(&c, 0, sizeof(c));
@@ -143,6 +158,31 @@ int main(int argc, char *argv[]) {
         return EXIT_FAILURE;
       }
     }
+
+    // warmup and calibration for max_duration
+    libxsmm_timer_tickint start = libxsmm_timer_tick();
+    for (int i = 0; i < nwarmup; i++) {
+      mlp(VEC2D_ARGS(&a), VEC2D_ARGS(&b), VEC2D_ARGS(&c), VEC2D_ARGS(&out));
+    }
+    double duration = libxsmm_timer_duration(start, libxsmm_timer_tick());
+
+    if (0 >= nrepeat) {
+      nrepeat = (0 < duration ? (int)LIBXSMM_ROUND(max_duration / duration)
+                              : nwarmup);
+    }
+    if (nwarmup > nrepeat) {
+      nrepeat = nwarmup;
+    }
+
+    // actual runs
+    start = libxsmm_timer_tick();
+    for (int i = 0; i < nrepeat; i++) {
+      mlp(VEC2D_ARGS(&a), VEC2D_ARGS(&b), VEC2D_ARGS(&c), VEC2D_ARGS(&out));
+    }
+    duration = libxsmm_timer_duration(start, libxsmm_timer_tick());
+
+    printf("MLIR: %f GFLOPS/s (%d threads)\n",
+           1e-9 * (2.0 * m * n * k * nrepeat) / duration, get_num_threads());
   }
 
   vec_f2d_destroy(&a);
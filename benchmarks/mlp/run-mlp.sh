@@ -6,14 +6,14 @@ compile () {
   echo "Compile driver ----> mlp_driver"
   echo "Compile kernel ----> mlp_kernel"
  
-  clang -O3 -emit-llvm -S -I$LIB_INCLUDE_PATH -DARG_MNK=\"${1}\" mlp_driver.c
+  clang -O3 "${OPENMP_FLAGS[@]}" -emit-llvm -S -I$LIB_INCLUDE_PATH -DARG_MNK=\"${1}\" mlp_driver.c
   llc $LLC_ARGS mlp_driver.ll
 
-  tpp-opt mlp_kernel.mlir -map-linalg-to-tpp -main-closure -pre-bufferization -pack-matmul="block-factors=2,2" -loop-invariant-code-motion -canonicalize -undo-main-closure -tile-consumer-and-fuse-producers="tile-sizes=1,0,0,0" -canonicalize -tile-consumer-and-fuse-producers="tile-sizes=1,0,0" -canonicalize -one-shot-bufferize="bufferize-function-boundaries allow-return-allocs function-boundary-type-conversion=identity-layout-map" -canonicalize -drop-equivalent-buffer-results -finalizing-bufferize -canonicalize -map-linalg-to-tpp -convert-linalg-to-tpp="use-parallel-loops=false" -map-to-brgemm -convert-linalg-to-tpp -convert-tpp-to-xsmm 
+  tpp-opt mlp_kernel.mlir -map-linalg-to-tpp -main-closure -pre-bufferization -pack-matmul="block-factors=2,2" -loop-invariant-code-motion -canonicalize -undo-main-closure -tile-consumer-and-fuse-producers="tile-sizes=1,0,0,0" -canonicalize -tile-consumer-and-fuse-producers="tile-sizes=1,0,0" -canonicalize -one-shot-bufferize="bufferize-function-boundaries allow-return-allocs function-boundary-type-conversion=identity-layout-map" -canonicalize -drop-equivalent-buffer-results -finalizing-bufferize -canonicalize -map-linalg-to-tpp -convert-linalg-to-tpp="use-parallel-loops=${PARALLEL_LOOPS}" -map-to-brgemm="use-parallel-loops=${PARALLEL_LOOPS}" -convert-linalg-to-tpp -convert-tpp-to-xsmm 
 
 
   # Let's avoid calling the sparse compiler to lower to LLVM.
-  tpp-opt mlp_kernel.mlir -map-linalg-to-tpp -main-closure -pre-bufferization -pack-matmul="block-factors=2,2" -loop-invariant-code-motion -canonicalize -undo-main-closure -tile-consumer-and-fuse-producers="tile-sizes=1,0,0,0" -canonicalize -tile-consumer-and-fuse-producers="tile-sizes=1,0,0" -canonicalize -one-shot-bufferize="bufferize-function-boundaries allow-return-allocs function-boundary-type-conversion=identity-layout-map" -canonicalize -drop-equivalent-buffer-results -finalizing-bufferize -canonicalize -map-linalg-to-tpp -convert-linalg-to-tpp="use-parallel-loops=false" -map-to-brgemm -convert-linalg-to-tpp -convert-tpp-to-xsmm -loop-invariant-code-motion -convert-xsmm-to-func -convert-linalg-to-loops -arith-expand -convert-vector-to-scf -convert-scf-to-cf -convert-vector-to-llvm -convert-func-to-llvm -convert-memref-to-llvm -sparse-compiler | mlir-translate -mlir-to-llvmir -o mlp_kernel.ll
+  tpp-opt mlp_kernel.mlir -map-linalg-to-tpp -main-closure -pre-bufferization -pack-matmul="block-factors=2,2" -loop-invariant-code-motion -canonicalize -undo-main-closure -tile-consumer-and-fuse-producers="tile-sizes=1,0,0,0" -canonicalize -tile-consumer-and-fuse-producers="tile-sizes=1,0,0" -canonicalize -one-shot-bufferize="bufferize-function-boundaries allow-return-allocs function-boundary-type-conversion=identity-layout-map" -canonicalize -drop-equivalent-buffer-results -finalizing-bufferize -canonicalize -map-linalg-to-tpp -convert-linalg-to-tpp="use-parallel-loops=${PARALLEL_LOOPS}" -map-to-brgemm="use-parallel-loops=${PARALLEL_LOOPS}" -convert-linalg-to-tpp -convert-tpp-to-xsmm -loop-invariant-code-motion -convert-xsmm-to-func -convert-linalg-to-loops -arith-expand -convert-vector-to-scf "${PARALLEL_ARGS[@]}" -convert-scf-to-cf "${OPENMP_ARGS[@]}" -convert-vector-to-llvm -convert-func-to-llvm -convert-memref-to-llvm -sparse-compiler | mlir-translate -mlir-to-llvmir -o mlp_kernel.ll
 
   llc $LLC_ARGS mlp_kernel.ll
 
@@ -26,7 +26,7 @@ compile () {
     export LD_LIBRARY_PATH=$LIB_PATH:$LD_LIBRARY_PATH
   fi
 
-  clang -O3 mlp_driver.s mlp_kernel.s -L$LIB_PATH -ltpp_c_runner_utils -lm -o mlp
+  clang -O3 "${OPENMP_FLAGS[@]}" mlp_driver.s mlp_kernel.s -L$LIB_PATH -ltpp_c_runner_utils -lm -o mlp
  
   rm *.s
   rm *.ll
@@ -37,7 +37,7 @@ execute () {
 
   # Execute and check result based on MLIR toolchain.
   if [ -e ./mlp ] && ./mlp >>mlp.log 2>&1; then
-    #grep "MLIR: ..* GFLOPS\/s" mlp_${1}.log
+    grep "MLIR: ..* GFLOPS\/s" mlp.log
     # Execute tpp mlp driver.
     #if [ -e ./mlp ] && ./mlp 0 ${1} >>mlp_${1}.log 2>&1; then
     #  grep "XSMM: ..* GFLOPS\/s" mlp_${1}.log
@@ -0,0 +1,81 @@
+//===- CostModel.h - Analytical cost model for tile sizes -------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// An analytical model that estimates the cost of a [m x k] * [k x n] matmul
+// executed as a grid of micro-kernel calls, and selects the tile sizes with the
+// lowest estimated cost. The model accounts for the SIMD utilization along N,
+// the per-call overhead, and the traffic of each operand from the cache level
+// it is expected to be resident in.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TPP_COSTMODEL_H
+#define TPP_COSTMODEL_H
+
+#include <cstdint>
+
+namespace mlir {
+namespace tpp {
+
+// Description of the target core. The defaults model an AVX-512 server core.
+struct TargetInfo {
+  // Data cache sizes in bytes.
+  int64_t l1CacheBytes = 32 * 1024;
+  int64_t l2CacheBytes = 1024 * 1024;
+  // Width of a SIMD register in bytes and number of SIMD registers.
+  int64_t simdBytes = 64;
+  int64_t numVectorRegisters = 32;
+  // Vector FMAs and loads issued per cycle.
+  int64_t fmaPerCycle = 2;
+  int64_t loadsPerCycle = 2;
+  // Sustained bandwidth per core, in bytes per cycle.
+  int64_t l1BytesPerCycle = 64;
+  int64_t l2BytesPerCycle = 32;
+  int64_t memBytesPerCycle = 8;
+  // Fixed cost of a micro-kernel call, in cycles.
+  int64_t callOverheadCycles = 100;
+  // Threads sharing the outer loops, used to penalize grids with too few
+  // blocks to keep every thread busy.
+  int64_t numThreads = 1;
+};
+
+// Tile sizes along M, N and K with their estimated cost in cycles.
+struct MatmulTileSizes {
+  int64_t m;
+  int64_t n;
+  int64_t k;
+  double cost;
+};
+
+// Estimate the cost in cycles of a [m x k] * [k x n] matmul tiled by `tileM`,
+// `tileN` and `tileK`. If `batchReduce` is set, a single BRGEMM call reduces
+// the whole K dimension for each [tileM x tileN] output block, otherwise every
+// tile along K is a separate GEMM call that reloads the output block.
+double estimateMatmulCost(int64_t m, int64_t n, int64_t k, int64_t tileM,
+                          int64_t tileN, int64_t tileK, int64_t elementBytes,
+                          bool batchReduce, const TargetInfo &target);
+
+// Select the tile sizes for a matmul lowered to GEMM micro-kernels. Tile sizes
+// always divide the dimensions: a tile equal to the dimension means that the
+// dimension is not tiled.
+MatmulTileSizes selectMatmulTileSizes(int64_t m, int64_t n, int64_t k,
+                                      int64_t elementBytes,
+                                      const TargetInfo &target = TargetInfo());
+
+// Select the blocking factors [bm, bn, bk] used to pack a matmul into the
+// [M/bm][N/bn][bm][bn] += [M/bm][K/bk][bm][bk] * [N/bn][K/bk][bk][bn] layout
+// consumed by the BRGEMM micro-kernel.
+MatmulTileSizes
+selectMatmulBlockingFactors(int64_t m, int64_t n, int64_t k,
+                            int64_t elementBytes,
+                            const TargetInfo &target = TargetInfo());
+
+} // namespace tpp
+} // namespace mlir
+
+#endif // TPP_COSTMODEL_H
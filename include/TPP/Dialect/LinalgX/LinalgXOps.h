@@ -21,4 +21,14 @@
 #define GET_OP_CLASSES
 #include "TPP/Dialect/LinalgX/LinalgXOps.h.inc"
 
+namespace mlir {
+class RewritePatternSet;
+namespace linalgx {
+
+// Populate patterns that pack and unpack constants at compile time.
+void populateConstantFoldPackUnPackPatterns(RewritePatternSet &patterns);
+
+} // namespace linalgx
+} // namespace mlir
+
 #endif // LINALGX_TPP_OPS_H
@@ -45,6 +45,24 @@ class MemRefDialect;
 } // namespace memref
 } // namespace mlir
 
+namespace mlir {
+namespace arith {
+class ArithDialect;
+} // namespace arith
+} // namespace mlir
+
+namespace mlir {
+namespace tensor {
+class TensorDialect;
+} // namespace tensor
+} // namespace mlir
+
+namespace mlir {
+namespace omp {
+class OpenMPDialect;
+} // namespace omp
+} // namespace mlir
+
 namespace mlir {
 namespace xsmm {
 class XsmmDialect;
@@ -59,10 +77,20 @@ std::unique_ptr<OperationPass<func::FuncOp>> createConvertLinalgToTppPass();
 std::unique_ptr<OperationPass<func::FuncOp>>
 createConvertLinalgToTppPass(bool, bool, ArrayRef<int64_t> tiles = {});
 std::unique_ptr<OperationPass<func::FuncOp>> createPasSIMDDimensionPass();
+std::unique_ptr<OperationPass<func::FuncOp>>
+createPasSIMDDimensionPass(int64_t mMultiple, int64_t nMultiple,
+                           int64_t kMultiple);
 std::unique_ptr<OperationPass<ModuleOp>> createTppCompilerPipeline();
 std::unique_ptr<OperationPass<func::FuncOp>> createConvertTppToVectorPass();
+std::unique_ptr<OperationPass<func::FuncOp>>
+createConvertTppToVectorPass(int64_t simdWidth);
 std::unique_ptr<OperationPass<func::FuncOp>> createConvertTppToLoopsPass();
+std::unique_ptr<OperationPass<func::FuncOp>>
+createConvertTppToLoopsPass(bool parallel, int64_t unrollFactor);
 std::unique_ptr<OperationPass<ModuleOp>> createConvertXsmmToFuncPass();
+std::unique_ptr<OperationPass<ModuleOp>>
+createConvertXsmmToFuncPass(bool useExtractMetaData, bool hoistDispatch,
+                            bool traceKernelSites);
 std::unique_ptr<OperationPass<func::FuncOp>> createConvertTppToXsmmPass();
 std::unique_ptr<OperationPass<func::FuncOp>> createVectorizeCopyPass();
 std::unique_ptr<OperationPass<func::FuncOp>> createPreBufferizationPass();
@@ -74,12 +102,24 @@ std::unique_ptr<OperationPass<func::FuncOp>>
 createDecomposeConvToMatmulOrBrgemmPass();
 std::unique_ptr<OperationPass<func::FuncOp>> createPackMatmulPass();
 std::unique_ptr<OperationPass<func::FuncOp>> createMapToBatchReduceGEMMPass();
+std::unique_ptr<OperationPass<func::FuncOp>>
+createMapToBatchReduceGEMMPass(bool useParallelLoops);
 std::unique_ptr<OperationPass<func::FuncOp>> createUndoMainClosurePass();
+std::unique_ptr<OperationPass<ModuleOp>> createClosureToInitRunPass();
 std::unique_ptr<OperationPass<func::FuncOp>> createPackConv2DNchwFchwPass();
+std::unique_ptr<OperationPass<ModuleOp>> createBlockLayoutAssignmentPass();
+std::unique_ptr<OperationPass<ModuleOp>>
+createBlockLayoutAssignmentPass(int64_t maxBlockFactor);
 std::unique_ptr<OperationPass<ModuleOp>> createTransformDialectInterpreterPass();
 std::unique_ptr<OperationPass<func::FuncOp>> createIteratorCollapsingPass();
 std::unique_ptr<OperationPass<func::FuncOp>> createLinalgXToLoopsPass();
+std::unique_ptr<OperationPass<ModuleOp>> createConvertLinalgXToFuncPass();
 std::unique_ptr<OperationPass<func::FuncOp>> createPackConv2DNhwcHwcfPass();
+std::unique_ptr<OperationPass<ModuleOp>>
+createConvertParallelLoopsToOpenMPPass();
+std::unique_ptr<OperationPass<ModuleOp>>
+createConvertParallelLoopsToOpenMPPass(int64_t numThreads,
+                                       int64_t parallelDims);
 
 } // namespace tpp
 } // namespace mlir
@@ -26,8 +26,11 @@ namespace linalgx {
 
 // Attempt to map the current linalgOp to a BRGEMM.
 // On success the returned values are the materialzed loops with BRGEMM inside.
+// If `useParallelLoops` is set and the op has buffer semantics, the outer
+// loops are materialized as a single scf.parallel.
 FailureOr<SmallVector<Value>> mapToBRGEMMOp(RewriterBase &rewriter,
-                                            linalg::LinalgOp linalgOp);
+                                            linalg::LinalgOp linalgOp,
+                                            bool useParallelLoops = false);
 
 // Map a convolution to a matmul operation. We support the following formats:
 // 1. [N][P][Q][K] += [N][H][W][C] * [R][S][C][K]
@@ -46,6 +49,18 @@ FailureOr<linalg::GenericOp>
 packConv2DNhwcHwcfOp(RewriterBase &rewriter, linalg::Conv2DNhwcHwcfOp linalgOp,
                      ArrayRef<OpFoldResult> tiles);
 
+// Attempt to pack a DepthwiseConv2DNhwcHwcOp.
+FailureOr<linalg::GenericOp>
+packDepthwiseConv2DNhwcHwcOp(RewriterBase &rewriter,
+                             linalg::DepthwiseConv2DNhwcHwcOp linalgOp,
+                             ArrayRef<OpFoldResult> tiles);
+
+// Attempt to block a Conv2DNgchwFgchwOp.
+FailureOr<linalg::GenericOp>
+packConv2DNgchwFgchwOp(RewriterBase &rewriter,
+                       linalg::Conv2DNgchwFgchwOp linalgOp,
+                       ArrayRef<OpFoldResult> tiles);
+
 // Attempt to block a MatmulOp.
 FailureOr<linalg::GenericOp> packMatmulOp(RewriterBase &rewriter,
                                           linalg::MatmulOp linalgOp,
@@ -61,9 +76,11 @@ collapseIterators(RewriterBase &rewriter, linalg::GenericOp genericOp,
 namespace tpp {
 void populateConvertLinalgToTppPatterns(RewritePatternSet &patterns);
 void populateMapLinalgToTppPatterns(RewritePatternSet &patterns);
+void populateBiasBrgemmReluFusionPatterns(RewritePatternSet &patterns);
 void populateTppToXsmmPatterns(RewritePatternSet &patterns);
 void populateXsmmToFuncPatterns(RewritePatternSet &patterns,
                                 bool useExtractMetaData);
 void populateSinkRelayoutPatterns(RewritePatternSet &patterns);
+void populateLinalgXToFuncPatterns(RewritePatternSet &patterns);
 } // namespace tpp
 } // namespace mlir
@@ -0,0 +1,109 @@
+//===- TuningDatabase.h - Tuned block factors and tile sizes ----*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// A tuning database maps a tunable op, identified by the pass that tunes it,
+// the op kind, its static iteration domain and its element type, to the
+// parameters the pass should use for it: the block factors of the pack passes
+// or the tile sizes of the tiling passes. The database is a JSON file written
+// by tpp-tune:
+//
+//   {
+//     "version": 1,
+//     "entries": [
+//       { "pass": "pack-matmul", "op": "linalg.matmul",
+//         "shape": [128, 256, 512], "type": "f32",
+//         "params": [32, 32, 64], "seconds": 1.5e-05 }
+//     ]
+//   }
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TPP_TUNINGDATABASE_H
+#define TPP_TUNINGDATABASE_H
+
+#include "mlir/Support/LogicalResult.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+
+#include <map>
+#include <memory>
+#include <string>
+
+namespace mlir {
+class Operation;
+
+namespace linalg {
+class LinalgOp;
+} // namespace linalg
+
+namespace tpp {
+
+// Environment variable naming the database used by the passes whose
+// 'tuning-db' option is not set.
+constexpr const char *kTuningDatabaseEnvVar = "TPP_TUNING_DB";
+
+struct TuningEntry {
+  // Key of the entry.
+  std::string pass;
+  std::string op;
+  SmallVector<int64_t> shape;
+  std::string type;
+  // Tuned parameters and the measured run time of the kernel with them.
+  SmallVector<int64_t> params;
+  double seconds = 0.0;
+
+  // Build the key of `linalgOp` tuned by `pass`. The op kind is the library
+  // call of a marked linalg.generic, the op name otherwise. Fails if the op
+  // has dynamic shapes.
+  static FailureOr<TuningEntry> get(StringRef pass, linalg::LinalgOp linalgOp);
+
+  std::string getKey() const;
+};
+
+class TuningDatabase {
+public:
+  // Parse the database stored in `path`. On failure `error` describes the
+  // problem.
+  static FailureOr<TuningDatabase> load(StringRef path, std::string &error);
+
+  // Load the database of a pass: `path` if not empty, otherwise the file named
+  // by TPP_TUNING_DB. If neither is set the database is empty. Errors are
+  // reported on `op` and null is returned. A file is parsed once and shared by
+  // all the passes and functions until it is modified.
+  static std::shared_ptr<const TuningDatabase> loadForPass(StringRef path,
+                                                           Operation *op);
+
+  // Write the database to `path`. On failure `error` describes the problem.
+  // The copy of `path` cached by loadForPass is dropped.
+  LogicalResult save(StringRef path, std::string &error) const;
+
+  // Return the parameters tuned by `pass` for `linalgOp`, if any.
+  Optional<SmallVector<int64_t>> lookup(StringRef pass,
+                                        linalg::LinalgOp linalgOp) const;
+
+  // Return the entry with the same key as `entry`, if any.
+  const TuningEntry *find(const TuningEntry &entry) const;
+
+  // Insert `entry`, replacing any entry with the same key.
+  void insert(const TuningEntry &entry);
+
+  // Remove the entry with the same key as `entry`.
+  void erase(const TuningEntry &entry);
+
+  bool empty() const { return entries.empty(); }
+
+private:
+  // Ordered by key for a stable output.
+  std::map<std::string, TuningEntry> entries;
+};
+
+} // namespace tpp
+} // namespace mlir
+
+#endif // TPP_TUNINGDATABASE_H
@@ -0,0 +1,408 @@
+//===- BlockLayoutAssignment.cpp ---------------------------------*- C++-*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Assign the blocking factors of all the matmuls and convolutions of a module
+// at once. The ops are the nodes of a graph whose edges connect a producer to
+// its consumers, possibly through element-wise operations. Each node has a set
+// of candidate blocking factors with an estimated kernel cost, and each edge
+// costs a relayout (an unpack followed by a pack) of the tensor flowing on it
+// when the blocking factors on its two sides do not match. The assignment
+// minimizes the sum of the two, and then drives the packing of every op.
+//
+//===----------------------------------------------------------------------===//
+
+#include "TPP/CostModel.h"
+#include "TPP/Dialect/LinalgX/LinalgXOps.h"
+#include "TPP/Passes.h"
+#include "TPP/Transforms.h"
+#include "TPP/TuningDatabase.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "llvm/ADT/TypeSwitch.h"
+#include <numeric>
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "TPP/Passes.h.inc"
+
+namespace {
+
+// An op to pack with its candidate blocking factors.
+struct LayoutNode {
+  Operation *op;
+  // Candidate blocking factors, in the format expected by the pack functions,
+  // and their estimated kernel cost in cycles.
+  SmallVector<SmallVector<int64_t>> candidates;
+  SmallVector<double> costs;
+  unsigned selected = 0;
+
+  // Blocking factors of the activation (LHS or image) and of the output for
+  // the candidate `index`. A matmul blocks its LHS by [bm, bk] and its output
+  // by [bm, bn]; a convolution blocks both channel dimensions by the same
+  // factor.
+  SmallVector<int64_t> getInputLayout(unsigned index) const {
+    ArrayRef<int64_t> tiles = candidates[index];
+    if (isa<linalg::MatmulOp>(op))
+      return {tiles[0], tiles[2]};
+    return {tiles[0]};
+  }
+  SmallVector<int64_t> getOutputLayout(unsigned index) const {
+    ArrayRef<int64_t> tiles = candidates[index];
+    if (isa<linalg::MatmulOp>(op))
+      return {tiles[0], tiles[1]};
+    return {tiles[0]};
+  }
+  SmallVector<int64_t> getLayout(unsigned index, bool isOutput) const {
+    return isOutput ? getOutputLayout(index) : getInputLayout(index);
+  }
+};
+
+// A tensor flowing between two nodes: the output of `src` is either the
+// activation of `dst` or, when `dstIsOutput` is set, combined element-wise
+// with the output of `dst`. Both sides must be blocked the same way to avoid
+// a relayout costing `cost` cycles.
+struct LayoutEdge {
+  unsigned src;
+  unsigned dst;
+  bool dstIsOutput;
+  double cost;
+};
+
+// Divisors of `dim` not larger than `maxFactor`, largest first.
+static SmallVector<int64_t> getBlockingFactors(int64_t dim, int64_t maxFactor) {
+  SmallVector<int64_t> factors;
+  for (int64_t factor = std::min(dim, maxFactor); factor > 0; factor--)
+    if (dim % factor == 0)
+      factors.push_back(factor);
+  return factors;
+}
+
+static int64_t getElementBytes(Value value) {
+  return std::max<int64_t>(
+      1, value.getType().cast<ShapedType>().getElementTypeBitWidth() / 8);
+}
+
+static int64_t getNumBytes(Value value) {
+  ShapedType type = value.getType().cast<ShapedType>();
+  return type.getNumElements() * getElementBytes(value);
+}
+
+// Candidates of a matmul: every combination of factors dividing M, N and K.
+static void getMatmulCandidates(linalg::MatmulOp matmulOp, int64_t maxFactor,
+                                const tpp::TargetInfo &target,
+                                LayoutNode &node) {
+  ArrayRef<int64_t> shapeA =
+      matmulOp.getInputs()[0].getType().cast<ShapedType>().getShape();
+  ArrayRef<int64_t> shapeB =
+      matmulOp.getInputs()[1].getType().cast<ShapedType>().getShape();
+  int64_t m = shapeA[0], n = shapeB[1], k = shapeA[1];
+  int64_t elementBytes = getElementBytes(matmulOp.getInputs()[0]);
+  for (int64_t tileM : getBlockingFactors(m, maxFactor)) {
+    for (int64_t tileN : getBlockingFactors(n, maxFactor)) {
+      for (int64_t tileK : getBlockingFactors(k, maxFactor)) {
+        node.candidates.push_back({tileM, tileN, tileK});
+        node.costs.push_back(tpp::estimateMatmulCost(
+            m, n, k, tileM, tileN, tileK, elementBytes,
+            /*batchReduce=*/true, target));
+      }
+    }
+  }
+}
+
+// Candidates of a convolution: a factor dividing both C and K. The blocked
+// convolution runs, for each output row, a BRGEMM over the C blocks and the
+// filter window: [Q][bk] += [Q][bc] * [bc][bk].
+static void getConvCandidates(linalg::LinalgOp convOp, bool isNhwc,
+                              int64_t maxFactor, const tpp::TargetInfo &target,
+                              LayoutNode &node) {
+  ArrayRef<int64_t> imageShape =
+      convOp.getInputOperand(0)->get().getType().cast<ShapedType>().getShape();
+  ArrayRef<int64_t> filterShape =
+      convOp.getInputOperand(1)->get().getType().cast<ShapedType>().getShape();
+  ArrayRef<int64_t> outputShape =
+      convOp.getOutputOperand(0)->get().getType().cast<ShapedType>().getShape();
+  int64_t n = outputShape[0];
+  int64_t c = isNhwc ? imageShape[3] : imageShape[1];
+  int64_t k = isNhwc ? outputShape[3] : outputShape[1];
+  int64_t p = isNhwc ? outputShape[1] : outputShape[2];
+  int64_t q = isNhwc ? outputShape[2] : outputShape[3];
+  int64_t r = isNhwc ? filterShape[0] : filterShape[2];
+  int64_t s = isNhwc ? filterShape[1] : filterShape[3];
+  int64_t elementBytes = getElementBytes(convOp.getInputOperand(0)->get());
+  for (int64_t factor : getBlockingFactors(std::gcd(c, k), maxFactor)) {
+    node.candidates.push_back({factor, factor});
+    node.costs.push_back(tpp::estimateMatmulCost(
+        n * p * q, k, c * r * s, q, factor, factor, elementBytes,
+        /*batchReduce=*/true, target));
+  }
+}
+
+// Collect the nodes producing `value` through element-wise operations.
+static void getProducerNodes(Value value,
+                             const DenseMap<Operation *, unsigned> &nodeIds,
+                             SmallVectorImpl<unsigned> &producers) {
+  Operation *defOp = value.getDefiningOp();
+  if (!defOp)
+    return;
+  auto it = nodeIds.find(defOp);
+  if (it != nodeIds.end()) {
+    if (!llvm::is_contained(producers, it->second))
+      producers.push_back(it->second);
+    return;
+  }
+  auto genericOp = dyn_cast<linalg::GenericOp>(defOp);
+  if (!genericOp || !genericOp.hasTensorSemantics() ||
+      genericOp.getNumLoops() != genericOp.getNumParallelLoops())
+    return;
+  for (OpOperand *operand : genericOp.getInputAndOutputOperands()) {
+    if (operand->get().getType() == value.getType() &&
+        genericOp.getMatchingIndexingMap(operand).isIdentity())
+      getProducerNodes(operand->get(), nodeIds, producers);
+  }
+}
+
+// Cost of the relayout on `edge` if `srcIndex` and `dstIndex` are selected.
+static double getEdgeCost(ArrayRef<LayoutNode> nodes, const LayoutEdge &edge,
+                          unsigned srcIndex, unsigned dstIndex) {
+  if (nodes[edge.src].getOutputLayout(srcIndex) ==
+      nodes[edge.dst].getLayout(dstIndex, edge.dstIsOutput))
+    return 0.0;
+  return edge.cost;
+}
+
+// Minimize the total cost by iterated conditional modes: start from the
+// cheapest kernel of each node, then move each node to its best candidate
+// given the candidates of its neighbours until no move improves the total.
+// The result is a local minimum, which is enough to agree on the layout of
+// chains of layers.
+static void selectCandidates(MutableArrayRef<LayoutNode> nodes,
+                             ArrayRef<LayoutEdge> edges) {
+  for (LayoutNode &node : nodes)
+    node.selected = std::min_element(node.costs.begin(), node.costs.end()) -
+                    node.costs.begin();
+
+  SmallVector<SmallVector<unsigned>> incidentEdges(nodes.size());
+  for (auto en : llvm::enumerate(edges)) {
+    incidentEdges[en.value().src].push_back(en.index());
+    incidentEdges[en.value().dst].push_back(en.index());
+  }
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (auto en : llvm::enumerate(nodes)) {
+      LayoutNode &node = en.value();
+      auto getCost = [&](unsigned index) {
+        double cost = node.costs[index];
+        for (unsigned edgeId : incidentEdges[en.index()]) {
+          const LayoutEdge &edge = edges[edgeId];
+          cost += edge.src == en.index()
+                      ? getEdgeCost(nodes, edge, index,
+                                    nodes[edge.dst].selected)
+                      : getEdgeCost(nodes, edge, nodes[edge.src].selected,
+                                    index);
+        }
+        return cost;
+      };
+      // A move must be at least 1% cheaper, which also bounds the number of
+      // iterations.
+      unsigned best = node.selected;
+      double bestCost = getCost(best);
+      for (unsigned index = 0, e = node.candidates.size(); index < e;
+           index++) {
+        double cost = getCost(index);
+        if (cost < bestCost) {
+          best = index;
+          bestCost = cost;
+        }
+      }
+      if (bestCost < 0.99 * getCost(node.selected)) {
+        node.selected = best;
+        changed = true;
+      }
+    }
+  }
+}
+
+static FailureOr<linalg::GenericOp> packOp(RewriterBase &rewriter,
+                                           linalg::MatmulOp matmulOp,
+                                           ArrayRef<OpFoldResult> tiles) {
+  return linalgx::packMatmulOp(rewriter, matmulOp, tiles);
+}
+
+static FailureOr<linalg::GenericOp> packOp(RewriterBase &rewriter,
+                                           linalg::Conv2DNchwFchwOp convOp,
+                                           ArrayRef<OpFoldResult> tiles) {
+  return linalgx::packConv2DNchwFchwOp(rewriter, convOp, tiles);
+}
+
+static FailureOr<linalg::GenericOp> packOp(RewriterBase &rewriter,
+                                           linalg::Conv2DNhwcHwcfOp convOp,
+                                           ArrayRef<OpFoldResult> tiles) {
+  return linalgx::packConv2DNhwcHwcfOp(rewriter, convOp, tiles);
+}
+
+// Pack `op` with the blocking factors `tiles`.
+static LogicalResult packWithFactors(RewriterBase &rewriter, Operation *op,
+                                     ArrayRef<int64_t> tiles) {
+  rewriter.setInsertionPoint(op);
+  SmallVector<OpFoldResult> tileSizes =
+      getAsOpFoldResult(rewriter.getI64ArrayAttr(tiles));
+  return llvm::TypeSwitch<Operation *, LogicalResult>(op)
+      .Case<linalg::MatmulOp, linalg::Conv2DNchwFchwOp,
+            linalg::Conv2DNhwcHwcfOp>([&](auto linalgOp) {
+        return packOp(rewriter, linalgOp, tileSizes);
+      })
+      .Default([](Operation *) { return failure(); });
+}
+
+struct BlockLayoutAssignment
+    : public BlockLayoutAssignmentBase<BlockLayoutAssignment> {
+  BlockLayoutAssignment() = default;
+  BlockLayoutAssignment(int64_t maxBlockFactor) {
+    this->maxBlockFactor = maxBlockFactor;
+  }
+
+  // Build the node of `op`, if it can be packed. Blocking factors found in
+  // the tuning database are the only candidate of their op.
+  Optional<LayoutNode> getNode(Operation *op, const tpp::TuningDatabase &db,
+                               const tpp::TargetInfo &target) {
+    auto linalgOp = dyn_cast<linalg::LinalgOp>(op);
+    if (!linalgOp || !linalgOp.hasTensorSemantics() ||
+        linalgOp.hasDynamicShape())
+      return llvm::None;
+    StringRef passName =
+        llvm::TypeSwitch<Operation *, StringRef>(op)
+            .Case([](linalg::MatmulOp) { return "pack-matmul"; })
+            .Case([](linalg::Conv2DNchwFchwOp) {
+              return "pack-conv2DNchwFchw";
+            })
+            .Case([](linalg::Conv2DNhwcHwcfOp) {
+              return "pack-conv2DNhwcHwcf";
+            })
+            .Default([](Operation *) { return ""; });
+    if (passName.empty())
+      return llvm::None;
+
+    LayoutNode node;
+    node.op = op;
+    if (Optional<SmallVector<int64_t>> tunedTiles =
+            db.lookup(passName, linalgOp)) {
+      node.candidates.push_back(*tunedTiles);
+      node.costs.push_back(0.0);
+    } else if (auto matmulOp = dyn_cast<linalg::MatmulOp>(op)) {
+      getMatmulCandidates(matmulOp, maxBlockFactor, target, node);
+    } else {
+      getConvCandidates(linalgOp, isa<linalg::Conv2DNhwcHwcfOp>(op),
+                        maxBlockFactor, target, node);
+    }
+    if (node.candidates.empty())
+      return llvm::None;
+    return node;
+  }
+
+  void runOnOperation() override {
+    std::shared_ptr<const tpp::TuningDatabase> db =
+        tpp::TuningDatabase::loadForPass(tuningDatabase, getOperation());
+    if (!db)
+      return signalPassFailure();
+    if (maxBlockFactor <= 0) {
+      getOperation().emitError("max-block-factor must be positive");
+      return signalPassFailure();
+    }
+    tpp::TargetInfo target;
+
+    // Build the graph.
+    SmallVector<LayoutNode> nodes;
+    DenseMap<Operation *, unsigned> nodeIds;
+    getOperation().walk([&](Operation *op) {
+      if (Optional<LayoutNode> node = getNode(op, *db, target)) {
+        nodeIds[op] = nodes.size();
+        nodes.push_back(std::move(*node));
+      }
+    });
+    if (nodes.empty())
+      return;
+
+    // A relayout reads and writes the tensor twice, once for the unpack and
+    // once for the pack.
+    SmallVector<LayoutEdge> edges;
+    auto addEdge = [&](unsigned src, unsigned dst, bool dstIsOutput,
+                       Value value) {
+      if (src == dst || nodes[src].op->getName() != nodes[dst].op->getName())
+        return;
+      if (llvm::any_of(edges, [&](const LayoutEdge &edge) {
+            return edge.src == src && edge.dst == dst &&
+                   edge.dstIsOutput == dstIsOutput;
+          }))
+        return;
+      edges.push_back({src, dst, dstIsOutput,
+                       4.0 * getNumBytes(value) / target.memBytesPerCycle});
+    };
+    for (auto en : llvm::enumerate(nodes)) {
+      auto linalgOp = cast<linalg::LinalgOp>(en.value().op);
+      Value activation = linalgOp.getInputOperand(0)->get();
+      SmallVector<unsigned> producers;
+      getProducerNodes(activation, nodeIds, producers);
+      for (unsigned producer : producers)
+        addEdge(producer, en.index(), /*dstIsOutput=*/false, activation);
+    }
+    // Outputs combined by an element-wise operation, e.g. a residual add,
+    // share their layout.
+    getOperation().walk([&](linalg::GenericOp genericOp) {
+      if (genericOp.getNumResults() != 1)
+        return;
+      SmallVector<unsigned> producers;
+      getProducerNodes(genericOp.getResult(0), nodeIds, producers);
+      for (unsigned index = 1; index < producers.size(); index++)
+        addEdge(producers[0], producers[index], /*dstIsOutput=*/true,
+                genericOp.getResult(0));
+    });
+
+    selectCandidates(nodes, edges);
+
+    // Pack the ops, then let the relayouts between them sink and cancel. The
+    // ops are packed before running any pattern, as the nodes point to them.
+    MLIRContext *ctx = &getContext();
+    IRRewriter rewriter(ctx);
+    for (LayoutNode &node : nodes) {
+      ArrayRef<int64_t> tiles = node.candidates[node.selected];
+      InFlightDiagnostic remark = node.op->emitRemark()
+                                  << "assigned blocking factors: [";
+      llvm::interleaveComma(tiles, remark);
+      remark << "]";
+      remark.report();
+      (void)packWithFactors(rewriter, node.op, tiles);
+    }
+
+    RewritePatternSet patterns(ctx);
+    tpp::populateSinkRelayoutPatterns(patterns);
+    linalgx::PackOp::getCanonicalizationPatterns(patterns, ctx);
+    linalgx::UnPackOp::getCanonicalizationPatterns(patterns, ctx);
+    FrozenRewritePatternSet frozenPatterns(std::move(patterns));
+    for (func::FuncOp func : getOperation().getOps<func::FuncOp>())
+      (void)applyPatternsAndFoldGreedily(func, frozenPatterns);
+  }
+};
+
+} // namespace
+
+std::unique_ptr<OperationPass<ModuleOp>>
+mlir::tpp::createBlockLayoutAssignmentPass() {
+  return std::make_unique<BlockLayoutAssignment>();
+}
+
+std::unique_ptr<OperationPass<ModuleOp>>
+mlir::tpp::createBlockLayoutAssignmentPass(int64_t maxBlockFactor) {
+  return std::make_unique<BlockLayoutAssignment>(maxBlockFactor);
+}
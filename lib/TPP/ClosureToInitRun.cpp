@@ -0,0 +1,216 @@
+//===- ClosureToInitRun.cpp --------------------------------------*- C++-*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "TPP/Dialect/Stdx/StdxOps.h"
+#include "TPP/Passes.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "mlir/Transforms/LoopInvariantCodeMotionUtils.h"
+#include "mlir/Transforms/RegionUtils.h"
+#include "llvm/Support/Debug.h"
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "TPP/Passes.h.inc"
+
+#define DEBUG_TYPE "closure-to-init-run"
+
+namespace {
+
+// Split a function whose body is a stdx.closure into:
+//
+// - `<fn>_init(consts...) -> (state...)` that runs all the computation outside
+// the closure once, and returns the values used by the closure (e.g., packed or
+// padded weights) as state.
+//
+// - `<fn>_run(state..., inputs..., out)` that runs the closure body only.
+//
+// The original function becomes a call to `<fn>_init` followed by a call to
+// `<fn>_run`. Constants used by the closure are cloned into `<fn>_run` instead
+// of being passed as state.
+struct ClosureToInitRun : public ClosureToInitRunBase<ClosureToInitRun> {
+  ClosureToInitRun() = default;
+
+  // Return the only closure in the body of `func`, if any.
+  static stdx::ClosureOp getClosure(func::FuncOp func) {
+    if (func.isExternal())
+      return nullptr;
+    auto closures = func.getBody().front().getOps<stdx::ClosureOp>();
+    if (!llvm::hasSingleElement(closures))
+      return nullptr;
+    return *closures.begin();
+  }
+
+  LogicalResult splitClosure(func::FuncOp func, stdx::ClosureOp closure) {
+    ModuleOp module = getOperation();
+    std::string initName = (func.getName() + "_init").str();
+    std::string runName = (func.getName() + "_run").str();
+    if (module.lookupSymbol(initName) || module.lookupSymbol(runName))
+      return failure();
+
+    // Check that the function can be split before touching it, so that a
+    // rejected function is left as is. Operations that are trivially dead
+    // once the closure is formed, i.e., left behind by main-closure, do not
+    // count as uses.
+    Block &body = func.getBody().front();
+    llvm::SmallPtrSet<Operation *, 8> deadOps;
+    for (Operation &op : llvm::reverse(body)) {
+      if (&op == closure.getOperation() || !wouldOpBeTriviallyDead(&op))
+        continue;
+      if (llvm::all_of(op.getUsers(), [&](Operation *user) {
+            return deadOps.contains(user);
+          }))
+        deadOps.insert(&op);
+    }
+
+    // Expect the function to return the result of the closure.
+    func::ReturnOp returnOp = cast<func::ReturnOp>(body.getTerminator());
+    for (Operation *op = closure->getNextNode(); op != returnOp.getOperation();
+         op = op->getNextNode())
+      if (!deadOps.contains(op))
+        return failure();
+    if (!llvm::equal(returnOp.getOperands(), closure->getResults()))
+      return failure();
+
+    // The closure inputs and output must be arguments of the function, used
+    // by the closure only. All the other arguments are inputs of init.
+    llvm::SmallDenseSet<unsigned> closureArgNumbers;
+    for (Value operand : closure->getOperands()) {
+      BlockArgument arg = operand.dyn_cast<BlockArgument>();
+      if (!arg || arg.getOwner() != &body ||
+          llvm::any_of(arg.getUsers(), [&](Operation *user) {
+            return user != closure.getOperation() && !deadOps.contains(user);
+          }))
+        return failure();
+      closureArgNumbers.insert(arg.getArgNumber());
+    }
+
+    // Hoist the computation that does not depend on the closure inputs, and
+    // drop the operations left dead by main-closure.
+    moveLoopInvariantCode(cast<LoopLikeOpInterface>(closure.getOperation()));
+    for (Operation &op : llvm::make_early_inc_range(llvm::reverse(body)))
+      if (isOpTriviallyDead(&op))
+        op.erase();
+
+    SmallVector<BlockArgument> initArgs;
+    for (BlockArgument arg : func.getArguments())
+      if (!closureArgNumbers.count(arg.getArgNumber()))
+        initArgs.push_back(arg);
+
+    // Values defined outside and used by the closure are the state, except
+    // for constants that are cheaper to rematerialize.
+    SetVector<Value> captured;
+    getUsedValuesDefinedAbove(closure.getRegion(), captured);
+    SmallVector<Value> state;
+    SmallVector<Value> constants;
+    for (Value value : captured) {
+      if (matchPattern(value, m_Constant()))
+        constants.push_back(value);
+      else
+        state.push_back(value);
+    }
+
+    Location loc = func.getLoc();
+    OpBuilder builder(module.getContext());
+    builder.setInsertionPointAfter(func);
+
+    // Build `<fn>_init`.
+    func::FuncOp initFunc = builder.create<func::FuncOp>(
+        loc, initName,
+        builder.getFunctionType(ValueRange(initArgs).getTypes(),
+                                ValueRange(state).getTypes()));
+    Block *initBlock = initFunc.addEntryBlock();
+    BlockAndValueMapping initMapper;
+    for (auto en : llvm::enumerate(initArgs)) {
+      initMapper.map(en.value(), initBlock->getArgument(en.index()));
+      initFunc.setArgAttrs(en.index(),
+                           func.getArgAttrDict(en.value().getArgNumber()));
+    }
+    OpBuilder initBuilder = OpBuilder::atBlockEnd(initBlock);
+    for (Operation &op : body) {
+      if (&op == closure.getOperation())
+        break;
+      initBuilder.clone(op, initMapper);
+    }
+    SmallVector<Value> initResults;
+    for (Value value : state)
+      initResults.push_back(initMapper.lookup(value));
+    initBuilder.create<func::ReturnOp>(loc, initResults);
+
+    // Build `<fn>_run`.
+    SmallVector<Type> runArgTypes =
+        llvm::to_vector(ValueRange(state).getTypes());
+    llvm::append_range(runArgTypes, closure->getOperandTypes());
+    builder.setInsertionPointAfter(initFunc);
+    func::FuncOp runFunc = builder.create<func::FuncOp>(
+        loc, runName,
+        builder.getFunctionType(runArgTypes, closure->getResultTypes()));
+    Block *runBlock = runFunc.addEntryBlock();
+    BlockAndValueMapping runMapper;
+    runMapper.map(state, runBlock->getArguments().take_front(state.size()));
+    runMapper.map(closure.getRegion().getArguments(),
+                  runBlock->getArguments().drop_front(state.size()));
+    for (auto en : llvm::enumerate(closure->getOperands())) {
+      unsigned argNumber = en.value().cast<BlockArgument>().getArgNumber();
+      runFunc.setArgAttrs(state.size() + en.index(),
+                          func.getArgAttrDict(argNumber));
+    }
+    OpBuilder runBuilder = OpBuilder::atBlockEnd(runBlock);
+    for (Value value : constants)
+      runBuilder.clone(*value.getDefiningOp(), runMapper);
+    SmallVector<Value> runResults;
+    for (Operation &op : closure.getRegion().front()) {
+      if (isa<stdx::YieldOp>(op)) {
+        for (Value operand : op.getOperands())
+          runResults.push_back(runMapper.lookupOrDefault(operand));
+        continue;
+      }
+      runBuilder.clone(op, runMapper);
+    }
+    runBuilder.create<func::ReturnOp>(loc, runResults);
+
+    // Rewrite the original function as init followed by run.
+    OpBuilder funcBuilder(returnOp);
+    func::CallOp initCall =
+        funcBuilder.create<func::CallOp>(loc, initFunc, ValueRange(initArgs));
+    SmallVector<Value> runOperands = llvm::to_vector(initCall.getResults());
+    llvm::append_range(runOperands, closure->getOperands());
+    func::CallOp runCall =
+        funcBuilder.create<func::CallOp>(loc, runFunc, runOperands);
+    returnOp->setOperands(runCall.getResults());
+    for (Operation &op : llvm::make_early_inc_range(llvm::reverse(body))) {
+      if (&op == returnOp.getOperation() || &op == initCall.getOperation() ||
+          &op == runCall.getOperation())
+        continue;
+      op.erase();
+    }
+    return success();
+  }
+
+  void runOnOperation() override {
+    SmallVector<std::pair<func::FuncOp, stdx::ClosureOp>> worklist;
+    for (func::FuncOp func : getOperation().getOps<func::FuncOp>())
+      if (stdx::ClosureOp closure = getClosure(func))
+        worklist.push_back({func, closure});
+    for (auto [func, closure] : worklist)
+      if (failed(splitClosure(func, closure)))
+        LLVM_DEBUG(llvm::dbgs() << "[" DEBUG_TYPE "]: cannot split "
+                                << func.getName() << "\n");
+  }
+};
+
+} // namespace
+
+std::unique_ptr<OperationPass<ModuleOp>>
+mlir::tpp::createClosureToInitRunPass() {
+  return std::make_unique<ClosureToInitRun>();
+}
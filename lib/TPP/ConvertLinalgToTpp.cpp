@@ -6,17 +6,23 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "TPP/CostModel.h"
+#include "TPP/Dialect/Mathx/MathxOps.h"
 #include "TPP/Dialect/Tpp/TppOps.h"
 #include "TPP/Dialect/Tpp/TppUtils.h"
 #include "TPP/Passes.h"
 #include "TPP/Transforms.h"
+#include "TPP/TuningDatabase.h"
 #include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/Linalg/Transforms/Transforms.h"
 #include "mlir/Dialect/Linalg/Utils/Utils.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/Utils/StaticValueUtils.h"
 #include "mlir/Interfaces/ViewLikeInterface.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include <numeric>
 
 using namespace mlir;
 using namespace mlir::tpp;
@@ -118,7 +124,8 @@ struct ReshapeGenericOpForTpp : public OpRewritePattern<linalg::GenericOp> {
   }
 };
 
-// Tile sizes selection specific for matmul.
+// Tile sizes selection specific for matmul. The tiles come from the cost
+// model and always divide the loop sizes, the choice is reported as a remark.
 static SmallVector<Value>
 getTileSizesForOptimalMappingMatmulImpl(OpBuilder &builder,
                                         linalg::LinalgOp linalgOp) {
@@ -126,27 +133,21 @@ getTileSizesForOptimalMappingMatmulImpl(OpBuilder &builder,
   int64_t m = dims[0];
   int64_t n = dims[1];
   int64_t k = dims[2];
-
-  int64_t bestTileN = n;
-  if (n % 16 == 0) {
-    bestTileN = n - (n % 16);
-    if (bestTileN > 64)
-      bestTileN = 64;
-  }
-  int64_t bestTileK = k;
-  int64_t bestTileM = (m % 32 == 0) ? 32 : m;
-
+  Type elementType =
+      getElementTypeOrSelf(linalgOp.getInputOperand(0)->get().getType());
+  int64_t elementBytes = elementType.getIntOrFloatBitWidth() / 8;
+  MatmulTileSizes tiles = selectMatmulTileSizes(m, n, k, elementBytes);
+  linalgOp->emitRemark() << "cost model tile sizes: [" << tiles.m << ", "
+                         << tiles.n << ", " << tiles.k << "]";
+
+  // A tile of zero means that the dimension is not tiled.
   Location loc = linalgOp.getLoc();
-  SmallVector<Value> tppTiles(3,
-                              builder.create<arith::ConstantIndexOp>(loc, 0));
-
-  // do not tile.
-  if ((bestTileM == m) && (bestTileK == k) && (bestTileN == n))
-    return tppTiles;
-
-  tppTiles[0] = builder.create<arith::ConstantIndexOp>(loc, bestTileM);
-  tppTiles[1] = builder.create<arith::ConstantIndexOp>(loc, bestTileN);
-  tppTiles[2] = builder.create<arith::ConstantIndexOp>(loc, bestTileK);
+  int64_t tileSizes[] = {tiles.m, tiles.n, tiles.k};
+  SmallVector<Value> tppTiles;
+  for (size_t idx = 0; idx < 3; idx++) {
+    int64_t tile = (tileSizes[idx] == dims[idx]) ? 0 : tileSizes[idx];
+    tppTiles.push_back(builder.create<arith::ConstantIndexOp>(loc, tile));
+  }
   return tppTiles;
 }
 
@@ -184,12 +185,33 @@ getTileSizesForOptimalMapping(OpBuilder &builder, linalg::LinalgOp linalgOp) {
   return getTileSizesForOptimalMappingImpl(builder, linalgOp);
 }
 
+// Return the positions, among the generated tile loops, of the loops whose tile
+// size does not divide the loop size. Loops with a tile size of zero are not
+// generated.
+static SmallVector<int64_t> getLoopsToPeel(linalg::LinalgOp linalgOp,
+                                           ArrayRef<int64_t> tileSizes) {
+  SmallVector<int64_t> peeledLoops;
+  SmallVector<int64_t> loopSizes = linalgOp.computeStaticLoopSizes();
+  int64_t tileLoop = 0;
+  for (auto it : llvm::zip(loopSizes, tileSizes)) {
+    int64_t loopSize = std::get<0>(it);
+    int64_t tileSize = std::get<1>(it);
+    if (tileSize == 0)
+      continue;
+    if (!ShapedType::isDynamic(loopSize) && loopSize % tileSize != 0)
+      peeledLoops.push_back(tileLoop);
+    tileLoop++;
+  }
+  return peeledLoops;
+}
+
 // Tile the generic operation such that we can select the best micro-kernel.
 LogicalResult tileLinalgOp(linalg::GenericOp linalgOp,
                            ArrayRef<int64_t> tileSizes) {
   if (!linalgOp.hasBufferSemantics())
     return linalgOp->emitError("Expect linalgOp with buffer semantics");
-  if (!hasTppMark(linalgOp))
+  // The blocks of an offset brgemm are not rectangular tiles of its operands.
+  if (!hasTppMark(linalgOp) || isMarkedWithTpp(linalgOp, "tpp.offset_brgemm"))
     return failure();
 
   OpBuilder builder(linalgOp);
@@ -205,10 +227,21 @@ LogicalResult tileLinalgOp(linalg::GenericOp linalgOp,
         getTileSizesForOptimalMapping);
 
   IRRewriter rewriter(builder);
+  SmallVector<int64_t> peeledLoops = getLoopsToPeel(linalgOp, tileSizes);
   FailureOr<linalg::TiledLinalgOp> tiledOp =
       linalg::tileLinalgOp(rewriter, linalgOp, linalgTilingOptions);
   if (failed(tiledOp))
     return linalgOp->emitError("Failed to tile linalgOp");
+  // Split the partial tiles off into their own loops. Peeling canonicalizes
+  // the tile sizes in both loops to constants, so the full and the remainder
+  // tiles both become static and map to their own tpp operation (and XSMM
+  // dispatch) instead of a dynamically shaped generic falling off the TPP
+  // path. Peel the innermost loops first: the remainder iteration of an outer
+  // loop is a copy of its body, which then holds the already peeled inner
+  // loops and stays static as well.
+  std::reverse(peeledLoops.begin(), peeledLoops.end());
+  linalg::peelTiledLinalgOp(rewriter, *tiledOp, peeledLoops,
+                            linalg::LinalgTilingLoopType::Loops);
   linalgOp->erase();
   return success();
 }
@@ -242,6 +275,233 @@ LogicalResult checkOperandForTpp(Value operand) {
   return failure();
 }
 
+// Fixed tile size along each loop of a chain, and the largest tile, in
+// elements, whose scratch buffers a chain allocates on the stack.
+static constexpr int64_t kChainTileSize = 32;
+static constexpr int64_t kMaxChainTileElements = 128 * 128;
+
+// Return the buffer `value` is a view of.
+static Value getBaseBuffer(Value value) {
+  while (auto viewOp = value.getDefiningOp<ViewLikeOpInterface>())
+    value = viewOp.getViewSource();
+  return value;
+}
+
+// Return true if `lhs` and `rhs` are the same subview of the same buffer,
+// i.e., the subviews tiling creates for an operand both read and written.
+static bool isSameView(Value lhs, Value rhs) {
+  if (lhs == rhs)
+    return true;
+  auto lhsView = lhs.getDefiningOp<memref::SubViewOp>();
+  auto rhsView = rhs.getDefiningOp<memref::SubViewOp>();
+  if (!lhsView || !rhsView || lhsView.getType() != rhsView.getType())
+    return false;
+  auto isSame = [](ArrayRef<OpFoldResult> lhs, ArrayRef<OpFoldResult> rhs) {
+    return lhs.size() == rhs.size() &&
+           llvm::all_of(llvm::zip(lhs, rhs), [](auto it) {
+             return isEqualConstantIntOrValue(std::get<0>(it),
+                                              std::get<1>(it));
+           });
+  };
+  return isSame(lhsView.getMixedOffsets(), rhsView.getMixedOffsets()) &&
+         isSame(lhsView.getMixedSizes(), rhsView.getMixedSizes()) &&
+         isSame(lhsView.getMixedStrides(), rhsView.getMixedStrides()) &&
+         isSameView(lhsView.getSource(), rhsView.getSource());
+}
+
+// Tile every loop of a chain longer than a tile by kChainTileSize. The partial
+// tiles are peeled, so the scratch buffers stay small and static.
+static SmallVector<int64_t> getChainTileSizes(linalg::LinalgOp linalgOp) {
+  SmallVector<int64_t> tiles;
+  for (int64_t loopSize : linalgOp.computeStaticLoopSizes())
+    tiles.push_back(
+        (!ShapedType::isDynamic(loopSize) && loopSize <= kChainTileSize)
+            ? 0
+            : kChainTileSize);
+  return tiles;
+}
+
+// Convert a linalg.generic marked as "tpp.chain" to a chain of tpp operations
+// on the 2d block of its output, one per operation of the body:
+//
+// linalg.generic ins(%a, %b, %c) outs(%o) {
+//   %0 = arith.addf %a, %b
+//   %1 = mathx.relu %0
+//   %2 = arith.mulf %1, %c
+//   linalg.yield %2
+// }
+//
+// becomes, with %t0 and %t1 scratch buffers on the stack:
+//
+// tpp.identity ins(%a) out(%t0)
+// tpp.add ins(%b) out(%t0)
+// tpp.relu ins(%t0) out(%t1)
+// tpp.identity ins(%zero) out(%o)
+// tpp.muladd ins(%t1, %c) out(%o)
+//
+// The last operation writes the output. There is no element-wise multiply
+// tpp: a mulf is a muladd on a zeroed destination, or on the addend if its
+// only user is an addf. Inputs broadcast along the rows and scalars are first
+// broadcast in a scratch buffer. The scratch buffers live in an alloca scope
+// so that the stack does not grow across the tile loops. If an input may
+// alias the output without being the very same view, the last operation
+// writes a scratch buffer copied to the output at the end: writing the output
+// earlier could clobber elements of the input not read yet.
+static LogicalResult rewriteToTppChain(linalg::GenericOp linalgOp,
+                                       ArrayRef<Value> linalgOperands,
+                                       PatternRewriter &rewriter) {
+  MemRefType outputType =
+      linalgOperands.back().getType().dyn_cast<MemRefType>();
+  if (linalgOp.getNumOutputs() != 1 || !outputType ||
+      outputType.getRank() != 2 || !outputType.hasStaticShape())
+    return rewriter.notifyMatchFailure(linalgOp, "expect a static 2d output");
+  ArrayRef<int64_t> shape = outputType.getShape();
+  if (outputType.getNumElements() > kMaxChainTileElements)
+    return rewriter.notifyMatchFailure(linalgOp,
+                                       "tile too large for the stack");
+
+  // Inputs that are the same view as the output are updated in place.
+  Value output = linalgOperands.back();
+  Value outputBase = getBaseBuffer(output);
+  SmallVector<Value> operands = llvm::to_vector(linalgOperands);
+  bool mayAliasOutput = false;
+  for (Value &operand : MutableArrayRef<Value>(operands).drop_back()) {
+    if (isSameView(operand, output))
+      operand = output;
+    else if (getBaseBuffer(operand) == outputBase)
+      mayAliasOutput = true;
+  }
+
+  // Inputs are read as 2d blocks like the output or broadcast along the rows.
+  AffineMap outputMap =
+      linalgOp.getMatchingIndexingMap(linalgOp.getOutputOperand(0));
+  llvm::SmallDenseSet<unsigned> broadcastInputs;
+  for (OpOperand *input : linalgOp.getInputOperands()) {
+    MemRefType inputType = operands[input->getOperandNumber()]
+                               .getType()
+                               .dyn_cast<MemRefType>();
+    if (!inputType)
+      return rewriter.notifyMatchFailure(linalgOp, "expect memref inputs");
+    AffineMap map = linalgOp.getMatchingIndexingMap(input);
+    ArrayRef<int64_t> inputShape = inputType.getShape();
+    if (map == outputMap && inputShape == shape)
+      continue;
+    bool isRow = (inputShape.size() == 1 ||
+                  (inputShape.size() == 2 && inputShape[0] == 1)) &&
+                 inputShape.back() == shape.back();
+    if (!isRow || !map.isProjectedPermutation() || map.getNumResults() == 0 ||
+        map.getResults().back() != outputMap.getResults().back())
+      return rewriter.notifyMatchFailure(
+          linalgOp, "expect inputs broadcast along the rows");
+    broadcastInputs.insert(input->getOperandNumber());
+  }
+
+  Location loc = linalgOp.getLoc();
+  Block &body = linalgOp.getRegion().front();
+  Value yielded = cast<linalg::YieldOp>(body.getTerminator()).getOperand(0);
+  Type elementType = outputType.getElementType();
+  MemRefType scratchType = MemRefType::get(shape, elementType);
+
+  auto scope = rewriter.create<memref::AllocaScopeOp>(loc, TypeRange());
+  rewriter.createBlock(&scope.getBodyRegion());
+  auto createScratch = [&]() -> Value {
+    return rewriter.create<memref::AllocaOp>(loc, scratchType);
+  };
+  auto broadcast = [&](Value source) -> Value {
+    Value scratch = createScratch();
+    rewriter.create<tpp::IdentityOp>(loc, source, scratch);
+    return scratch;
+  };
+
+  // The buffer holding each value of the body.
+  DenseMap<Value, Value> buffers;
+  for (OpOperand &operand : linalgOp->getOpOperands()) {
+    unsigned operandNumber = operand.getOperandNumber();
+    BlockArgument arg = body.getArgument(operandNumber);
+    if (arg.use_empty())
+      continue;
+    buffers[arg] = broadcastInputs.contains(operandNumber)
+                       ? broadcast(operands[operandNumber])
+                       : operands[operandNumber];
+  }
+  auto getBuffer = [&](Value value) -> Value {
+    auto it = buffers.find(value);
+    if (it != buffers.end())
+      return it->second;
+    // A scalar defined above the linalg.generic.
+    Value buffer = broadcast(value);
+    buffers[value] = buffer;
+    return buffer;
+  };
+
+  // A mulf whose only user is an addf is lowered with the addf. If both
+  // addends are such mulf, only the first one is.
+  auto getFusedMul = [&](arith::AddFOp addOp) -> arith::MulFOp {
+    for (Value operand : {addOp.getLhs(), addOp.getRhs()}) {
+      auto mulOp = operand.getDefiningOp<arith::MulFOp>();
+      if (mulOp && mulOp->getBlock() == &body && mulOp->hasOneUse())
+        return mulOp;
+    }
+    return nullptr;
+  };
+  auto buildMulAdd = [&](arith::MulFOp mulOp, Value addend, Value dest) {
+    Value lhs = getBuffer(mulOp.getLhs());
+    Value rhs = getBuffer(mulOp.getRhs());
+    // The destination is initialized first: it cannot be a factor.
+    Value target = (dest == lhs || dest == rhs) ? createScratch() : dest;
+    Value init;
+    if (addend)
+      init = getBuffer(addend);
+    else
+      init = rewriter.create<arith::ConstantOp>(
+          loc, rewriter.getFloatAttr(elementType, 0.0));
+    if (init != target)
+      rewriter.create<tpp::IdentityOp>(loc, init, target);
+    rewriter.create<tpp::MulAddOp>(loc, lhs, rhs, target);
+    if (target != dest)
+      rewriter.create<tpp::IdentityOp>(loc, target, dest);
+  };
+
+  for (Operation &op : body.without_terminator()) {
+    if (auto mulOp = dyn_cast<arith::MulFOp>(op)) {
+      if (mulOp->hasOneUse()) {
+        auto addOp = dyn_cast<arith::AddFOp>(*mulOp->user_begin());
+        if (addOp && getFusedMul(addOp) == mulOp)
+          continue;
+      }
+    }
+    // The last operation writes the output, the others a scratch buffer.
+    Value result = op.getResult(0);
+    Value dest =
+        (result == yielded && !mayAliasOutput) ? output : createScratch();
+    if (auto reluOp = dyn_cast<mathx::ReluOp>(op)) {
+      rewriter.create<tpp::ReluOp>(loc, getBuffer(reluOp.getOperand()), dest);
+    } else if (auto addOp = dyn_cast<arith::AddFOp>(op)) {
+      if (arith::MulFOp mulOp = getFusedMul(addOp)) {
+        Value addend = (addOp.getLhs() == mulOp.getResult()) ? addOp.getRhs()
+                                                             : addOp.getLhs();
+        buildMulAdd(mulOp, addend, dest);
+      } else {
+        Value lhs = getBuffer(addOp.getLhs());
+        Value rhs = getBuffer(addOp.getRhs());
+        if (lhs == dest)
+          std::swap(lhs, rhs);
+        if (rhs != dest)
+          rewriter.create<tpp::IdentityOp>(loc, rhs, dest);
+        rewriter.create<tpp::AddOp>(loc, lhs, dest);
+      }
+    } else {
+      buildMulAdd(cast<arith::MulFOp>(op), /*addend=*/Value(), dest);
+    }
+    buffers[result] = dest;
+  }
+  if (mayAliasOutput)
+    rewriter.create<tpp::IdentityOp>(loc, getBuffer(yielded), output);
+  rewriter.create<memref::AllocaScopeReturnOp>(loc, ValueRange());
+  rewriter.eraseOp(linalgOp);
+  return success();
+}
+
 // Convert a linalg.generic to a tpp operation. Require the generic to be
 // annotated with the tpp operation to replace. Annotation uses linalg
 // library call mechanism.
@@ -272,11 +532,19 @@ struct ConvertGenericOpToTpp : public OpRewritePattern<linalg::GenericOp> {
                                               operands[1]);
       return success();
     }
+    if (libraryCall.compare("tpp.muladd") == 0) {
+      assert(operands.size() == 3 && "Expect three operands");
+      rewriter.replaceOpWithNewOp<tpp::MulAddOp>(linalgOp, operands[0],
+                                                 operands[1], operands[2]);
+      return success();
+    }
     if (libraryCall.compare("tpp.matmul") == 0) {
       rewriter.replaceOpWithNewOp<tpp::MatmulOp>(linalgOp, operands[0],
                                                  operands[1], operands[2]);
       return success();
     }
+    if (libraryCall.compare("tpp.chain") == 0)
+      return rewriteToTppChain(linalgOp, operands, rewriter);
     return rewriter.notifyMatchFailure(
         linalgOp, "failed to match a known library_call attribute");
   }
@@ -288,10 +556,17 @@ struct ConvertGenericOpToTpp : public OpRewritePattern<linalg::GenericOp> {
     if (!linalgOp.getLibraryCallAttr() || !hasTppMark(linalgOp))
       return rewriter.notifyMatchFailure(
           linalgOp, "not enough information to map to tpps");
+    if (isMarkedWithTpp(linalgOp, "tpp.offset_brgemm"))
+      return rewriter.notifyMatchFailure(linalgOp, "operands of rank > 2");
 
     if (linalgOp->getNumResults() != 0)
       return rewriter.notifyMatchFailure(linalgOp, "expect at least 1 result");
 
+    // Partial tiles are static only once the casts introduced by peeling
+    // are folded into the generic.
+    if (linalgOp.hasDynamicShape())
+      return rewriter.notifyMatchFailure(linalgOp, "expect static shapes");
+
     Location loc = linalgOp.getLoc();
     SmallVector<Value, 4> newOperands;
     for (Value operand : linalgOp->getOperands()) {
@@ -314,6 +589,8 @@ struct ConvertBrgemmToTpp
                                 PatternRewriter &rewriter) const override {
     if (!brMatmulOp.hasBufferSemantics())
       return rewriter.notifyMatchFailure(brMatmulOp, "expect buffer semantics");
+    if (brMatmulOp.hasDynamicShape())
+      return rewriter.notifyMatchFailure(brMatmulOp, "expect static shapes");
     SmallVector<Value> inputs = brMatmulOp.getInputOperands();
     SmallVector<Value> outputs = brMatmulOp.getOutputOperands();
     rewriter.replaceOpWithNewOp<tpp::BrgemmOp>(brMatmulOp, inputs, outputs[0]);
@@ -329,6 +606,8 @@ struct ConvertMatmulToTpp : public OpRewritePattern<linalg::MatmulOp> {
                                 PatternRewriter &rewriter) const override {
     if (!matmulOp.hasBufferSemantics())
       return rewriter.notifyMatchFailure(matmulOp, "expect buffer semantics");
+    if (matmulOp.hasDynamicShape())
+      return rewriter.notifyMatchFailure(matmulOp, "expect static shapes");
     SmallVector<Value> inputs = matmulOp.getInputOperands();
     SmallVector<Value> outputs = matmulOp.getOutputOperands();
     rewriter.replaceOpWithNewOp<tpp::MatmulOp>(matmulOp, inputs, outputs[0]);
@@ -336,6 +615,223 @@ struct ConvertMatmulToTpp : public OpRewritePattern<linalg::MatmulOp> {
   }
 };
 
+// Return the element offset of `operand` accessed through `map` as one
+// coefficient per loop followed by a constant, if `map` is linear and the
+// strides of `operand` are static.
+static Optional<SmallVector<int64_t>> getLinearAccess(AffineMap map,
+                                                      Value operand) {
+  SmallVector<int64_t> strides;
+  int64_t offset;
+  MemRefType memrefType = operand.getType().cast<MemRefType>();
+  if (failed(getStridesAndOffset(memrefType, strides, offset)) ||
+      llvm::any_of(strides, ShapedType::isDynamicStrideOrOffset))
+    return llvm::None;
+  unsigned numDims = map.getNumDims();
+  MLIRContext *ctx = map.getContext();
+  SmallVector<AffineExpr> zeros(numDims, getAffineConstantExpr(0, ctx));
+  SmallVector<int64_t> access(numDims + 1, 0);
+  for (auto [expr, stride] : llvm::zip(map.getResults(), strides)) {
+    if (!expr.isPureAffine())
+      return llvm::None;
+    auto constant = expr.replaceDims(zeros).dyn_cast<AffineConstantExpr>();
+    if (!constant)
+      return llvm::None;
+    for (unsigned dim = 0; dim < numDims; dim++) {
+      SmallVector<AffineExpr> unit = zeros;
+      unit[dim] = getAffineConstantExpr(1, ctx);
+      access[dim] += stride * (expr.replaceDims(unit)
+                                   .cast<AffineConstantExpr>()
+                                   .getValue() -
+                               constant.getValue());
+    }
+    access.back() += stride * constant.getValue();
+  }
+  return access;
+}
+
+// Convert a linalg.generic marked as "tpp.offset_brgemm" to a
+// tpp.offset_brgemm. The generic has loops (b..., m, n, k) with b the
+// reduction loops over the blocks and a matmul body. Each point of the b
+// loops selects an m x k block of A and a k x n block of B whose offsets,
+// linear in b, become the offsets of the operation. A must read its k
+// elements contiguously and its rows strided as its second innermost
+// dimension; B likewise with n and k.
+struct ConvertOffsetBrgemmToTpp : public OpRewritePattern<linalg::GenericOp> {
+  using OpRewritePattern<linalg::GenericOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(linalg::GenericOp linalgOp,
+                                PatternRewriter &rewriter) const override {
+    if (!isMarkedWithTpp(linalgOp, "tpp.offset_brgemm"))
+      return rewriter.notifyMatchFailure(linalgOp, "not an offset brgemm");
+    if (!linalgOp.hasBufferSemantics() || linalgOp.hasDynamicShape())
+      return rewriter.notifyMatchFailure(linalgOp,
+                                         "expect static memref operands");
+    if (linalgOp.getNumInputs() != 2 || linalgOp.getNumOutputs() != 1 ||
+        !hasMatmulBody(linalgOp))
+      return rewriter.notifyMatchFailure(linalgOp, "expect a matmul body");
+    unsigned numLoops = linalgOp.getNumLoops();
+    SmallVector<StringRef> iteratorTypes = linalgOp.getIteratorTypesArray();
+    if (numLoops < 4 ||
+        !linalg::isParallelIterator(iteratorTypes[numLoops - 3]) ||
+        !linalg::isParallelIterator(iteratorTypes[numLoops - 2]) ||
+        !linalg::isReductionIterator(iteratorTypes[numLoops - 1]) ||
+        !llvm::all_of(ArrayRef<StringRef>(iteratorTypes).drop_back(3),
+                      linalg::isReductionIterator))
+      return rewriter.notifyMatchFailure(linalgOp,
+                                         "expect loops (b..., m, n, k)");
+    unsigned dimM = numLoops - 3, dimN = numLoops - 2, dimK = numLoops - 1;
+
+    OpOperand *operandA = linalgOp.getInputOperand(0);
+    OpOperand *operandB = linalgOp.getInputOperand(1);
+    OpOperand *operandC = linalgOp.getOutputOperand(0);
+    MLIRContext *ctx = linalgOp.getContext();
+    AffineMap expectedMapC = AffineMap::get(
+        numLoops, 0,
+        {getAffineDimExpr(dimM, ctx), getAffineDimExpr(dimN, ctx)}, ctx);
+    if (linalgOp.getMatchingIndexingMap(operandC) != expectedMapC)
+      return rewriter.notifyMatchFailure(linalgOp, "expect C to be (m, n)");
+
+    Optional<SmallVector<int64_t>> accessA = getLinearAccess(
+        linalgOp.getMatchingIndexingMap(operandA), operandA->get());
+    Optional<SmallVector<int64_t>> accessB = getLinearAccess(
+        linalgOp.getMatchingIndexingMap(operandB), operandB->get());
+    if (!accessA || !accessB)
+      return rewriter.notifyMatchFailure(linalgOp, "expect linear accesses");
+    SmallVector<int64_t> loopSizes = linalgOp.computeStaticLoopSizes();
+    ArrayRef<int64_t> shapeA =
+        operandA->get().getType().cast<MemRefType>().getShape();
+    ArrayRef<int64_t> shapeB =
+        operandB->get().getType().cast<MemRefType>().getShape();
+    SmallVector<int64_t> strides;
+    int64_t offset;
+    (void)getStridesAndOffset(
+        operandA->get().getType().cast<MemRefType>(), strides, offset);
+    int64_t lda = strides[strides.size() - 2];
+    (void)getStridesAndOffset(
+        operandB->get().getType().cast<MemRefType>(), strides, offset);
+    int64_t ldb = strides[strides.size() - 2];
+    if ((*accessA)[dimK] != 1 || (*accessA)[dimM] != lda ||
+        (*accessA)[dimN] != 0 || shapeA.back() != loopSizes[dimK])
+      return rewriter.notifyMatchFailure(linalgOp, "expect A blocks of m x k");
+    if ((*accessB)[dimN] != 1 || (*accessB)[dimK] != ldb ||
+        (*accessB)[dimM] != 0 || shapeB.back() != loopSizes[dimN] ||
+        shapeB[shapeB.size() - 2] != loopSizes[dimK])
+      return rewriter.notifyMatchFailure(linalgOp, "expect B blocks of k x n");
+
+    // Enumerate the blocks in the order of the b loops, innermost fastest.
+    ArrayRef<int64_t> batchSizes = ArrayRef<int64_t>(loopSizes).drop_back(3);
+    SmallVector<int64_t> batchPoint(batchSizes.size(), 0);
+    SmallVector<int64_t> offsetsA, offsetsB;
+    int64_t numBlocks = std::accumulate(batchSizes.begin(), batchSizes.end(),
+                                        1, std::multiplies<int64_t>());
+    for (int64_t block = 0; block < numBlocks; block++) {
+      int64_t offsetA = accessA->back();
+      int64_t offsetB = accessB->back();
+      for (auto en : llvm::enumerate(batchPoint)) {
+        offsetA += (*accessA)[en.index()] * en.value();
+        offsetB += (*accessB)[en.index()] * en.value();
+      }
+      offsetsA.push_back(offsetA);
+      offsetsB.push_back(offsetB);
+      for (int64_t dim = batchPoint.size() - 1; dim >= 0; dim--) {
+        if (++batchPoint[dim] < batchSizes[dim])
+          break;
+        batchPoint[dim] = 0;
+      }
+    }
+    rewriter.replaceOpWithNewOp<tpp::OffsetBrgemmOp>(
+        linalgOp, operandA->get(), operandB->get(), operandC->get(),
+        DenseI64ArrayAttr::get(ctx, offsetsA),
+        DenseI64ArrayAttr::get(ctx, offsetsB));
+    return success();
+  }
+};
+
+// Return the bias if `identityOp` broadcasts a row vector ([n] or [1, n]) into
+// every row of `output`.
+static Value getBroadcastedBias(tpp::IdentityOp identityOp, Value output) {
+  if (identityOp.getOutput() != output)
+    return nullptr;
+  MemRefType biasType = identityOp.getInput().getType().dyn_cast<MemRefType>();
+  if (!biasType)
+    return nullptr;
+  ArrayRef<int64_t> biasShape = biasType.getShape();
+  ArrayRef<int64_t> outputShape =
+      output.getType().cast<MemRefType>().getShape();
+  if (biasShape.back() != outputShape.back())
+    return nullptr;
+  if (biasShape.size() == 2 && biasShape[0] != 1)
+    return nullptr;
+  return identityOp.getInput();
+}
+
+// Fuse the bias + contraction + relu chain:
+//
+// tpp.identity ins(%bias) out(%c)
+// contraction ins(%a, %b) out(%c)
+// tpp.relu ins(%c) out(%c)
+//
+// into a single tpp.fused_brgemm so that %c is written once. The three
+// operations must be adjacent, which is the case after tile-and-fuse.
+static LogicalResult fuseBiasBrgemmRelu(Operation *contraction, Value matrixA,
+                                        Value matrixB, Value matrixC,
+                                        PatternRewriter &rewriter) {
+  for (Value operand : {matrixA, matrixB, matrixC}) {
+    MemRefType operandType = operand.getType().dyn_cast<MemRefType>();
+    if (!operandType || !operandType.hasStaticShape())
+      return rewriter.notifyMatchFailure(contraction,
+                                         "expect static memref operands");
+  }
+  auto identityOp =
+      dyn_cast_or_null<tpp::IdentityOp>(contraction->getPrevNode());
+  if (!identityOp)
+    return rewriter.notifyMatchFailure(contraction, "expect bias before");
+  Value bias = getBroadcastedBias(identityOp, matrixC);
+  if (!bias)
+    return rewriter.notifyMatchFailure(contraction, "expect row bias on C");
+  auto reluOp = dyn_cast_or_null<tpp::ReluOp>(contraction->getNextNode());
+  if (!reluOp || reluOp.getInput() != matrixC ||
+      reluOp.getOutput() != matrixC)
+    return rewriter.notifyMatchFailure(contraction, "expect relu on C after");
+
+  rewriter.create<tpp::FusedBrgemmOp>(contraction->getLoc(), matrixA, matrixB,
+                                      bias, matrixC);
+  rewriter.eraseOp(reluOp);
+  rewriter.eraseOp(contraction);
+  rewriter.eraseOp(identityOp);
+  return success();
+}
+
+// Fuse bias + tpp.brgemm + relu into a tpp.fused_brgemm.
+struct FuseBiasTppBrgemmRelu : public OpRewritePattern<tpp::BrgemmOp> {
+  using OpRewritePattern<tpp::BrgemmOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(tpp::BrgemmOp brgemmOp,
+                                PatternRewriter &rewriter) const override {
+    return fuseBiasBrgemmRelu(brgemmOp, brgemmOp.getBatchMatrixA(),
+                              brgemmOp.getBatchMatrixB(),
+                              brgemmOp.getMatrixC(), rewriter);
+  }
+};
+
+// Fuse bias + linalg.batch_reduce_matmul + relu into a tpp.fused_brgemm. This
+// is the form produced by map-to-brgemm when the bias and the relu have
+// already been mapped to tpp.
+struct FuseBiasBatchReduceMatmulRelu
+    : public OpRewritePattern<linalg::BatchReduceMatmulOp> {
+  using OpRewritePattern<linalg::BatchReduceMatmulOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(linalg::BatchReduceMatmulOp brMatmulOp,
+                                PatternRewriter &rewriter) const override {
+    if (!brMatmulOp.hasBufferSemantics())
+      return rewriter.notifyMatchFailure(brMatmulOp, "expect buffer semantics");
+    SmallVector<Value> inputs = brMatmulOp.getInputOperands();
+    SmallVector<Value> outputs = brMatmulOp.getOutputOperands();
+    return fuseBiasBrgemmRelu(brMatmulOp, inputs[0], inputs[1], outputs[0],
+                              rewriter);
+  }
+};
+
 // Given the following pattern:
 // %0 = memref.subview %i : memref<64x32x32> -> memref<1x32x32>
 // %1 = memref.subview %0 : memref<1x32x32> -> memref<32x32>
@@ -394,10 +890,21 @@ struct ConvertLinalgToTpp : public ConvertLinalgToTppBase<ConvertLinalgToTpp> {
       if (failed(reshape2D(rewriter, linalgOp, this->useParallelLoops)))
         return signalPassFailure();
     });
-    if (enableTiling || tileSizes.size())
-      getOperation().walk([&](linalg::GenericOp linalgOp) {
+    std::shared_ptr<const TuningDatabase> db =
+        TuningDatabase::loadForPass(tuningDatabase, getOperation());
+    if (!db)
+      return signalPassFailure();
+    getOperation().walk([&](linalg::GenericOp linalgOp) {
+      if (Optional<SmallVector<int64_t>> tunedTileSizes =
+              db->lookup("convert-linalg-to-tpp", linalgOp))
+        (void)tileLinalgOp(linalgOp, *tunedTileSizes);
+      // The scratch buffers of a chain have the size of a tile: always tile
+      // chains, by a fixed block if no tile sizes are given.
+      else if (isMarkedWithTpp(linalgOp, "tpp.chain") && tileSizes.empty())
+        (void)tileLinalgOp(linalgOp, getChainTileSizes(linalgOp));
+      else if (enableTiling || tileSizes.size())
         (void)tileLinalgOp(linalgOp, tileSizes);
-      });
+    });
     MLIRContext *ctx = getOperation().getContext();
     RewritePatternSet patterns(ctx);
     tpp::populateConvertLinalgToTppPatterns(patterns);
@@ -418,8 +925,17 @@ void mlir::tpp::populateConvertLinalgToTppPatterns(
   patterns.add<ConvertGenericOpToTpp,
                ConvertBrgemmToTpp,
                ConvertMatmulToTpp,
+               ConvertOffsetBrgemmToTpp,
                ReshapeGenericOpForTpp>(patterns.getContext());
   // clang-format on
+  mlir::tpp::populateBiasBrgemmReluFusionPatterns(patterns);
+}
+
+void mlir::tpp::populateBiasBrgemmReluFusionPatterns(
+    RewritePatternSet &patterns) {
+  // Prefer fusing over converting the contraction alone.
+  patterns.add<FuseBiasTppBrgemmRelu, FuseBiasBatchReduceMatmulRelu>(
+      patterns.getContext(), /*benefit=*/2);
 }
 
 std::unique_ptr<OperationPass<func::FuncOp>>
@@ -0,0 +1,215 @@
+//===- ConvertLinalgXToFunc.cpp ----------------------------------*- C++-*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "TPP/Dialect/LinalgX/LinalgXOps.h"
+#include "TPP/Passes.h"
+#include "TPP/Transforms.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/Utils/StaticValueUtils.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "TPP/Passes.h.inc"
+
+namespace {
+
+// Return the suffix of the runtime function for `elementType`, or an empty
+// string if the runtime does not support it.
+static std::string getElementTypeAsString(Type elementType) {
+  if (elementType.isF32())
+    return "f32";
+  if (elementType.isBF16())
+    return "bf16";
+  return "";
+}
+
+// The runtime reads sizes and strides from the memref descriptor, but it
+// requires unit stride on the innermost dimension of the flat operand.
+static bool hasUnitInnerStride(MemRefType memrefType) {
+  SmallVector<int64_t> strides;
+  int64_t offset;
+  if (failed(getStridesAndOffset(memrefType, strides, offset)))
+    return false;
+  return !strides.empty() && strides.back() == 1;
+}
+
+// The leading dimensions (all but the last two) must collapse into a single
+// batch dimension with a static stride.
+static bool hasCollapsibleBatchDims(MemRefType memrefType) {
+  SmallVector<int64_t> strides;
+  int64_t offset;
+  if (failed(getStridesAndOffset(memrefType, strides, offset)))
+    return false;
+  ArrayRef<int64_t> shape = memrefType.getShape();
+  for (int64_t dim = 0, rank = memrefType.getRank(); dim < rank - 3; dim++) {
+    if (ShapedType::isDynamicStrideOrOffset(strides[dim]) ||
+        ShapedType::isDynamicStrideOrOffset(strides[dim + 1]) ||
+        strides[dim] != strides[dim + 1] * shape[dim + 1])
+      return false;
+  }
+  return true;
+}
+
+// Common preconditions: buffer semantics, static shapes and tiles, no padding.
+template <typename OpTy> static LogicalResult checkPreconditions(OpTy op) {
+  auto inputType = op.getInput().getType().template dyn_cast<MemRefType>();
+  auto outputType = op.getOutput().getType().template dyn_cast<MemRefType>();
+  if (!inputType || !outputType)
+    return failure();
+  if (!inputType.hasStaticShape() || !outputType.hasStaticShape())
+    return failure();
+  if (llvm::any_of(op.getStaticTiles(), [](int64_t tile) {
+        return ShapedType::isDynamic(tile);
+      }))
+    return failure();
+  if (getElementTypeAsString(inputType.getElementType()).empty())
+    return failure();
+  return success();
+}
+
+// Classify a 2d <-> 4d relayout as NC <-> NCnc or KC <-> CKkc. Return an empty
+// string for any other layout.
+template <typename OpTy> static std::string getBlockLayoutName(OpTy op) {
+  SmallVector<int64_t> innerDimsPos =
+      extractFromI64ArrayAttr(op.getInnerDimsPos());
+  SmallVector<int64_t> outerDimsPerm =
+      extractFromI64ArrayAttr(op.getOuterDimsPerm());
+  if (innerDimsPos != SmallVector<int64_t>{0, 1})
+    return "";
+  if (outerDimsPerm.empty() || outerDimsPerm == SmallVector<int64_t>{0, 1})
+    return "NCnc";
+  if (outerDimsPerm == SmallVector<int64_t>{1, 0})
+    return "CKkc";
+  return "";
+}
+
+static void buildRuntimeCall(Location loc, std::string funcName,
+                             Operation *op, ValueRange operands,
+                             PatternRewriter &rewriter) {
+  SmallVector<Value> castedOperands;
+  for (Value operand : operands) {
+    MemRefType memrefType = operand.getType().cast<MemRefType>();
+    UnrankedMemRefType unrankedType = UnrankedMemRefType::get(
+        memrefType.getElementType(), memrefType.getMemorySpace());
+    castedOperands.push_back(
+        rewriter.create<memref::CastOp>(loc, unrankedType, operand));
+  }
+
+  FlatSymbolRefAttr fnName = SymbolRefAttr::get(op->getContext(), funcName);
+  ModuleOp module = op->getParentOfType<ModuleOp>();
+  if (!module.lookupSymbol(fnName)) {
+    OpBuilder::InsertionGuard guard(rewriter);
+    // Insert before module terminator.
+    rewriter.setInsertionPoint(module.getBody(),
+                               std::prev(module.getBody()->end()));
+    auto libFnType =
+        rewriter.getFunctionType(ValueRange(castedOperands).getTypes(), {});
+    func::FuncOp funcOp =
+        rewriter.create<func::FuncOp>(loc, fnName.getValue(), libFnType);
+    funcOp->setAttr(LLVM::LLVMDialect::getEmitCWrapperAttrName(),
+                    UnitAttr::get(op->getContext()));
+    funcOp.setPrivate();
+  }
+  rewriter.create<func::CallOp>(loc, fnName.getValue(), TypeRange(),
+                                castedOperands);
+}
+
+// Lower a blocking or a bf16 VNNI pack to the runtime.
+struct ConvertPackOpToFunc : public OpRewritePattern<linalgx::PackOp> {
+  using OpRewritePattern<linalgx::PackOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(linalgx::PackOp packOp,
+                                PatternRewriter &rewriter) const override {
+    if (failed(checkPreconditions(packOp)) || packOp.getPaddingValue())
+      return failure();
+    MemRefType inputType = packOp.getInputType().cast<MemRefType>();
+    MemRefType outputType = packOp.getOutputType().cast<MemRefType>();
+    if (!hasUnitInnerStride(inputType) || !outputType.getLayout().isIdentity())
+      return failure();
+    std::string typeAsString =
+        getElementTypeAsString(inputType.getElementType());
+
+    std::string funcName;
+    int64_t inputRank = inputType.getRank();
+    if (inputRank == 2 && outputType.getRank() == 4) {
+      std::string layout = getBlockLayoutName(packOp);
+      if (layout.empty())
+        return failure();
+      funcName = (layout == "NCnc") ? "xsmm_pack_NC_to_NCnc_"
+                                    : "xsmm_pack_KC_to_CKkc_";
+    } else if (inputType.getElementType().isBF16() &&
+               outputType.getRank() == inputRank + 1 &&
+               packOp.getOuterDimsPerm().empty() &&
+               extractFromI64ArrayAttr(packOp.getInnerDimsPos()) ==
+                   SmallVector<int64_t>{inputRank - 2} &&
+               packOp.getStaticTiles() == SmallVector<int64_t>{2} &&
+               hasCollapsibleBatchDims(inputType)) {
+      // VNNI: [..., K, N] -> [..., K / 2, N, 2].
+      funcName = "xsmm_pack_vnni_";
+    } else {
+      return failure();
+    }
+    buildRuntimeCall(packOp.getLoc(), funcName + typeAsString, packOp,
+                     {packOp.getInput(), packOp.getOutput()}, rewriter);
+    rewriter.eraseOp(packOp);
+    return success();
+  }
+};
+
+// Lower an unblocking unpack to the runtime.
+struct ConvertUnPackOpToFunc : public OpRewritePattern<linalgx::UnPackOp> {
+  using OpRewritePattern<linalgx::UnPackOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(linalgx::UnPackOp unpackOp,
+                                PatternRewriter &rewriter) const override {
+    if (failed(checkPreconditions(unpackOp)))
+      return failure();
+    MemRefType inputType = unpackOp.getInputType().cast<MemRefType>();
+    MemRefType outputType = unpackOp.getOutputType().cast<MemRefType>();
+    if (inputType.getRank() != 4 || outputType.getRank() != 2 ||
+        !inputType.getLayout().isIdentity() || !hasUnitInnerStride(outputType))
+      return failure();
+    std::string layout = getBlockLayoutName(unpackOp);
+    if (layout.empty())
+      return failure();
+    std::string funcName = (layout == "NCnc") ? "xsmm_unpack_NCnc_to_NC_"
+                                              : "xsmm_unpack_CKkc_to_KC_";
+    buildRuntimeCall(unpackOp.getLoc(),
+                     funcName +
+                         getElementTypeAsString(inputType.getElementType()),
+                     unpackOp, {unpackOp.getInput(), unpackOp.getOutput()},
+                     rewriter);
+    rewriter.eraseOp(unpackOp);
+    return success();
+  }
+};
+
+struct ConvertLinalgXToFunc
+    : public ConvertLinalgXToFuncBase<ConvertLinalgXToFunc> {
+  void runOnOperation() override {
+    RewritePatternSet patterns(&getContext());
+    tpp::populateLinalgXToFuncPatterns(patterns);
+    (void)applyPatternsAndFoldGreedily(getOperation(), std::move(patterns));
+  }
+};
+
+} // namespace
+
+void mlir::tpp::populateLinalgXToFuncPatterns(RewritePatternSet &patterns) {
+  patterns.add<ConvertPackOpToFunc, ConvertUnPackOpToFunc>(
+      patterns.getContext());
+}
+
+std::unique_ptr<OperationPass<ModuleOp>>
+mlir::tpp::createConvertLinalgXToFuncPass() {
+  return std::make_unique<ConvertLinalgXToFunc>();
+}
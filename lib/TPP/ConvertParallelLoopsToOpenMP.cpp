@@ -0,0 +1,137 @@
+//===- ConvertParallelLoopsToOpenMP.cpp --------------------------*- C++-*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "TPP/Passes.h"
+#include "mlir/Conversion/SCFToOpenMP/SCFToOpenMP.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/OpenMP/OpenMPDialect.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Pass/PassManager.h"
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "TPP/Passes.h.inc"
+
+namespace {
+
+// Rebuild `loop` as a scf.parallel over its first `numParallelDims` dimensions
+// wrapping a scf.for nest over the remaining ones. With `numParallelDims`
+// equal to zero the loop is fully serialized.
+static void splitParallelLoop(RewriterBase &rewriter, scf::ParallelOp loop,
+                              unsigned numParallelDims) {
+  unsigned numDims = loop.getNumLoops();
+  if (numParallelDims >= numDims)
+    return;
+
+  SmallVector<Value> lbs = llvm::to_vector(loop.getLowerBound());
+  SmallVector<Value> ubs = llvm::to_vector(loop.getUpperBound());
+  SmallVector<Value> steps = llvm::to_vector(loop.getStep());
+  SmallVector<Value> ivs;
+  Block *innermostBlock = nullptr;
+  auto buildSequentialLoops = [&](OpBuilder &builder, Location loc,
+                                  ValueRange parallelIvs) {
+    ivs.assign(parallelIvs.begin(), parallelIvs.end());
+    scf::buildLoopNest(
+        builder, loc, ArrayRef<Value>(lbs).drop_front(numParallelDims),
+        ArrayRef<Value>(ubs).drop_front(numParallelDims),
+        ArrayRef<Value>(steps).drop_front(numParallelDims),
+        [&](OpBuilder &nestedBuilder, Location, ValueRange sequentialIvs) {
+          ivs.append(sequentialIvs.begin(), sequentialIvs.end());
+          innermostBlock = nestedBuilder.getInsertionBlock();
+        });
+  };
+
+  OpBuilder::InsertionGuard guard(rewriter);
+  rewriter.setInsertionPoint(loop);
+  if (numParallelDims == 0) {
+    buildSequentialLoops(rewriter, loop.getLoc(), ValueRange());
+  } else {
+    rewriter.create<scf::ParallelOp>(
+        loop.getLoc(), ArrayRef<Value>(lbs).take_front(numParallelDims),
+        ArrayRef<Value>(ubs).take_front(numParallelDims),
+        ArrayRef<Value>(steps).take_front(numParallelDims),
+        buildSequentialLoops);
+  }
+
+  // Move the body into the innermost scf.for.
+  Block *body = loop.getBody();
+  rewriter.eraseOp(body->getTerminator());
+  rewriter.mergeBlockBefore(body, innermostBlock->getTerminator(), ivs);
+  rewriter.eraseOp(loop);
+}
+
+struct ConvertParallelLoopsToOpenMP
+    : public ConvertParallelLoopsToOpenMPBase<ConvertParallelLoopsToOpenMP> {
+  ConvertParallelLoopsToOpenMP() = default;
+  ConvertParallelLoopsToOpenMP(int64_t numThreads, int64_t parallelDims) {
+    this->numThreads = numThreads;
+    this->parallelDims = parallelDims;
+  }
+
+  void runOnOperation() override {
+    ModuleOp module = getOperation();
+    if (parallelDims < 1) {
+      module.emitError("expect at least one parallel dimension");
+      return signalPassFailure();
+    }
+
+    // Nested parallel loops would spawn nested thread teams: serialize them so
+    // that each thread runs a sequential nest. The walk is post-order, inner
+    // loops are rewritten before their parents.
+    SmallVector<scf::ParallelOp> outermostLoops, nestedLoops;
+    module.walk([&](scf::ParallelOp loop) {
+      if (!loop.getInitVals().empty())
+        return;
+      if (loop->getParentOfType<scf::ParallelOp>())
+        nestedLoops.push_back(loop);
+      else
+        outermostLoops.push_back(loop);
+    });
+    IRRewriter rewriter(&getContext());
+    for (scf::ParallelOp loop : nestedLoops)
+      splitParallelLoop(rewriter, loop, /*numParallelDims=*/0);
+    for (scf::ParallelOp loop : outermostLoops)
+      splitParallelLoop(rewriter, loop, parallelDims);
+
+    // The worksharing loop of each omp.parallel is collapsed over all its
+    // dimensions when translated to LLVM IR.
+    OpPassManager pm("builtin.module");
+    pm.addPass(createConvertSCFToOpenMPPass());
+    if (failed(runPipeline(pm, module)))
+      return signalPassFailure();
+
+    if (numThreads <= 0)
+      return;
+    module.walk([&](omp::ParallelOp parallelOp) {
+      if (parallelOp.getNumThreadsVar())
+        return;
+      rewriter.setInsertionPoint(parallelOp);
+      Value numThreadsValue = rewriter.create<arith::ConstantIntOp>(
+          parallelOp.getLoc(), numThreads, /*width=*/32);
+      parallelOp.getNumThreadsVarMutable().assign(numThreadsValue);
+    });
+  }
+};
+
+} // namespace
+
+std::unique_ptr<OperationPass<ModuleOp>>
+mlir::tpp::createConvertParallelLoopsToOpenMPPass() {
+  return std::make_unique<ConvertParallelLoopsToOpenMP>();
+}
+
+std::unique_ptr<OperationPass<ModuleOp>>
+mlir::tpp::createConvertParallelLoopsToOpenMPPass(int64_t numThreads,
+                                                  int64_t parallelDims) {
+  return std::make_unique<ConvertParallelLoopsToOpenMP>(numThreads,
+                                                        parallelDims);
+}
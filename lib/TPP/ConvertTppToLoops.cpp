@@ -23,6 +23,61 @@ using namespace mlir::tpp;
 
 namespace {
 
+// Build a loop over [lb, ub) with step `step`: an scf.parallel if `parallel`
+// is set, an scf.for otherwise.
+static void
+buildOuterLoop(OpBuilder &b, Location loc, Value lb, Value ub, Value step,
+               bool parallel,
+               function_ref<void(OpBuilder &, Location, Value)> bodyFn) {
+  if (parallel) {
+    b.create<scf::ParallelOp>(
+        loc, ValueRange{lb}, ValueRange{ub}, ValueRange{step},
+        [&](OpBuilder &nb, Location nl, ValueRange ivs) {
+          bodyFn(nb, nl, ivs[0]);
+        });
+    return;
+  }
+  b.create<scf::ForOp>(loc, lb, ub, step, llvm::None,
+                       [&](OpBuilder &nb, Location nl, Value iv, ValueRange) {
+                         bodyFn(nb, nl, iv);
+                         nb.create<scf::YieldOp>(nl);
+                       });
+}
+
+// Build the loop nest of an element-wise operation on `shape`. The innermost
+// loop runs along the contiguous dimension with unit stride, so that its body
+// can be vectorized with vector.transfer_read/write. If `parallel` is set,
+// the outermost loop of a 2-D nest is an scf.parallel.
+static void buildElementwiseLoops(OpBuilder &b, Location loc,
+                                  ArrayRef<int64_t> shape, bool parallel,
+                                  function_ref<void(OpBuilder &, Location,
+                                                    ValueRange)> bodyFn) {
+  SmallVector<Value> ubs;
+  for (int64_t size : shape)
+    ubs.push_back(b.create<arith::ConstantIndexOp>(loc, size));
+  Value zero = b.create<arith::ConstantIndexOp>(loc, 0);
+  Value one = b.create<arith::ConstantIndexOp>(loc, 1);
+  size_t rank = shape.size();
+  if (!parallel || rank < 2) {
+    SmallVector<Value> lbs(rank, zero);
+    SmallVector<Value> steps(rank, one);
+    (void)scf::buildLoopNest(b, loc, lbs, ubs, steps, bodyFn);
+    return;
+  }
+  SmallVector<Value> lbs(rank - 1, zero);
+  SmallVector<Value> steps(rank - 1, one);
+  buildOuterLoop(b, loc, zero, ubs[0], one, /*parallel=*/true,
+                 [&](OpBuilder &rb, Location rl, Value row) {
+                   (void)scf::buildLoopNest(
+                       rb, rl, lbs, ArrayRef<Value>(ubs).drop_front(), steps,
+                       [&](OpBuilder &nb, Location nl, ValueRange ivs) {
+                         SmallVector<Value> localIvs = {row};
+                         localIvs.append(ivs.begin(), ivs.end());
+                         bodyFn(nb, nl, localIvs);
+                       });
+                 });
+}
+
 //
 // tpp.add ins(%a, %b) out(%c)
 //
@@ -39,7 +94,9 @@ namespace {
 // arith.addf(%a, %b)
 //
 struct ConvertTppAddOp : public OpRewritePattern<AddOp> {
-  using OpRewritePattern<AddOp>::OpRewritePattern;
+  ConvertTppAddOp(MLIRContext *context, bool parallel,
+                  PatternBenefit benefit = 1)
+      : OpRewritePattern<AddOp>(context, benefit), parallel(parallel) {}
 
   bool isScalarOp(AddOp addOp) const {
     return !addOp.getLhs().getType().isa<ShapedType>();
@@ -57,20 +114,9 @@ struct ConvertTppAddOp : public OpRewritePattern<AddOp> {
       return success();
     }
     // handle memref case.
-    SmallVector<Value> ubs;
-    size_t rank = addOp.getLhs().getType().cast<MemRefType>().getRank();
-    for (size_t idx = 0; idx < rank; idx++) {
-      Value dim = rewriter.create<arith::ConstantIndexOp>(
-          loc, addOp.getLhs().getType().cast<MemRefType>().getShape()[idx]);
-      ubs.push_back(dim);
-    }
-    Value zero = rewriter.create<arith::ConstantIndexOp>(loc, 0);
-    SmallVector<Value> lbs(rank, zero);
-    Value one = rewriter.create<arith::ConstantIndexOp>(loc, 1);
-    SmallVector<Value> steps(rank, one);
-    (void)scf::buildLoopNest(
-        rewriter, loc, lbs, ubs, steps,
-        [&](OpBuilder &b, Location loc, ValueRange localIvs) {
+    buildElementwiseLoops(
+        rewriter, loc, addOp.getLhs().getType().cast<MemRefType>().getShape(),
+        parallel, [&](OpBuilder &b, Location loc, ValueRange localIvs) {
           Value scalarLhs =
               b.create<memref::LoadOp>(loc, addOp.getLhs(), localIvs);
           Value scalarRhs =
@@ -83,11 +129,60 @@ struct ConvertTppAddOp : public OpRewritePattern<AddOp> {
     rewriter.eraseOp(addOp);
     return success();
   }
+
+private:
+  bool parallel;
+};
+
+//
+// tpp.muladd ins(%a, %b) out(%c)
+//
+// Converts to:
+//
+// scf.some_loop(%i, %j)
+//   %0 = load from %a[%i, %j]
+//   %1 = load from %b[%j] (or %b[%i, %j])
+//   %2 = load from %c[%i, %j]
+//   %3 = mul %0, %1
+//   %4 = add %2, %3
+//   store %4 to %c[%i, %j]
+//
+struct ConvertTppMulAddOp : public OpRewritePattern<MulAddOp> {
+  ConvertTppMulAddOp(MLIRContext *context, bool parallel,
+                     PatternBenefit benefit = 1)
+      : OpRewritePattern<MulAddOp>(context, benefit), parallel(parallel) {}
+
+  LogicalResult matchAndRewrite(MulAddOp mulAddOp,
+                                PatternRewriter &rewriter) const override {
+    Location loc = mulAddOp.getLoc();
+    bool broadcastRhs = mulAddOp.hasBroadcastRhs();
+    buildElementwiseLoops(
+        rewriter, loc, mulAddOp.getOutputType().getShape(), parallel,
+        [&](OpBuilder &b, Location loc, ValueRange localIvs) {
+          Value scalarLhs =
+              b.create<memref::LoadOp>(loc, mulAddOp.getLhs(), localIvs);
+          Value scalarRhs = b.create<memref::LoadOp>(
+              loc, mulAddOp.getRhs(),
+              broadcastRhs ? localIvs.drop_front() : localIvs);
+          Value scalarOut =
+              b.create<memref::LoadOp>(loc, mulAddOp.getOutput(), localIvs);
+          Value mul = b.create<arith::MulFOp>(loc, scalarLhs, scalarRhs);
+          Value add = b.create<arith::AddFOp>(loc, scalarOut, mul);
+          b.create<memref::StoreOp>(loc, add, mulAddOp.getOutput(), localIvs);
+        });
+    rewriter.eraseOp(mulAddOp);
+    return success();
+  }
+
+private:
+  bool parallel;
 };
 
 // Converts identity op.
 struct ConvertTppIdentityOp : public OpRewritePattern<IdentityOp> {
-  using OpRewritePattern<IdentityOp>::OpRewritePattern;
+  ConvertTppIdentityOp(MLIRContext *context, bool parallel,
+                       PatternBenefit benefit = 1)
+      : OpRewritePattern<IdentityOp>(context, benefit), parallel(parallel) {}
 
   bool isScalar(Value val) const { return !val.getType().isa<ShapedType>(); }
 
@@ -112,21 +207,11 @@ struct ConvertTppIdentityOp : public OpRewritePattern<IdentityOp> {
       return success();
     }
     // Handle memref.
-    SmallVector<Value> ubs;
-    size_t rank = identityOp.getOutput().getType().cast<MemRefType>().getRank();
     ArrayRef<int64_t> shapeOutput =
         identityOp.getOutput().getType().cast<MemRefType>().getShape();
-    for (size_t idx = 0; idx < rank; idx++) {
-      Value dim =
-          rewriter.create<arith::ConstantIndexOp>(loc, shapeOutput[idx]);
-      ubs.push_back(dim);
-    }
     Value zero = rewriter.create<arith::ConstantIndexOp>(loc, 0);
-    SmallVector<Value> lbs(rank, zero);
-    Value one = rewriter.create<arith::ConstantIndexOp>(loc, 1);
-    SmallVector<Value> steps(rank, one);
-    (void)scf::buildLoopNest(
-        rewriter, loc, lbs, ubs, steps,
+    buildElementwiseLoops(
+        rewriter, loc, shapeOutput, parallel,
         [&](OpBuilder &b, Location loc, ValueRange localIvs) {
           Value input = identityOp.getInput();
           // input is scalar.
@@ -156,11 +241,16 @@ struct ConvertTppIdentityOp : public OpRewritePattern<IdentityOp> {
     rewriter.eraseOp(identityOp);
     return success();
   }
+
+private:
+  bool parallel;
 };
 
 // Convert relu to loops.
 struct ConvertTppReluOp : public OpRewritePattern<ReluOp> {
-  using OpRewritePattern<ReluOp>::OpRewritePattern;
+  ConvertTppReluOp(MLIRContext *context, bool parallel,
+                   PatternBenefit benefit = 1)
+      : OpRewritePattern<ReluOp>(context, benefit), parallel(parallel) {}
 
   bool isScalarOp(ReluOp reluOp) const {
     return !reluOp.getInput().getType().isa<ShapedType>();
@@ -177,25 +267,15 @@ struct ConvertTppReluOp : public OpRewritePattern<ReluOp> {
       return success();
     }
     // handle memref case.
-    SmallVector<Value> ubs;
-    size_t rank = reluOp.getInput().getType().cast<MemRefType>().getRank();
-    for (size_t idx = 0; idx < rank; idx++) {
-      Value dim = rewriter.create<arith::ConstantIndexOp>(
-          loc, reluOp.getInput().getType().cast<MemRefType>().getShape()[idx]);
-      ubs.push_back(dim);
-    }
-    Value zero = rewriter.create<arith::ConstantIndexOp>(loc, 0);
-    SmallVector<Value> lbs(rank, zero);
-    Value one = rewriter.create<arith::ConstantIndexOp>(loc, 1);
-    SmallVector<Value> steps(rank, one);
-
     Type elementType =
         reluOp.getInput().getType().cast<MemRefType>().getElementType();
     Value zeroConstant = rewriter.create<arith::ConstantOp>(
         loc, elementType, rewriter.getFloatAttr(elementType, 0));
 
-    (void)scf::buildLoopNest(
-        rewriter, loc, lbs, ubs, steps,
+    ArrayRef<int64_t> shapeInput =
+        reluOp.getInput().getType().cast<MemRefType>().getShape();
+    buildElementwiseLoops(
+        rewriter, loc, shapeInput, parallel,
         [&](OpBuilder &b, Location loc, ValueRange localIvs) {
           Value scalarLhs =
               b.create<memref::LoadOp>(loc, reluOp.getInput(), localIvs);
@@ -208,111 +288,270 @@ struct ConvertTppReluOp : public OpRewritePattern<ReluOp> {
     rewriter.eraseOp(reluOp);
     return success();
   }
+
+private:
+  bool parallel;
+};
+
+// Multiply-accumulate `scalarA` * `scalarB` into `scalarC`. For mixed
+// precision the inputs are extended to the type of the accumulator first.
+static Value buildMulAdd(OpBuilder &b, Location loc, Value scalarA,
+                         Value scalarB, Value scalarC) {
+  Type accType = scalarC.getType();
+  if (scalarA.getType() != accType) {
+    scalarA = b.create<arith::ExtFOp>(loc, accType, scalarA);
+    scalarB = b.create<arith::ExtFOp>(loc, accType, scalarB);
+  }
+  Value scalarMul = b.create<arith::MulFOp>(loc, scalarA, scalarB);
+  return b.create<arith::AddFOp>(loc, scalarC, scalarMul);
+}
+
+// Operands of a (batch-reduce) GEMM lowered to loops. A and B have a leading
+// batch dimension if `batched` is set.
+struct GemmOperands {
+  Value matrixA;
+  Value matrixB;
+  Value matrixC;
+  bool batched = false;
 };
 
+// Build the i-[b]-k-j nest computing rows [begin, end) of C, `unrollFactor`
+// rows at a time (end - begin must be a multiple of `unrollFactor`):
+//
+// scf.parallel/for %i = begin to end step unrollFactor
+//   scf.for %b (if batched)
+//     scf.for %k
+//       %a_r = load A[%b, %i + r, %k] for r in [0, unrollFactor)
+//       scf.for %j
+//         %bkj = load B[%b, %k, %j]
+//         C[%i + r, %j] += %a_r * %bkj for r in [0, unrollFactor)
+//
+// The innermost loop streams a row of B and rows of C with unit stride while
+// the elements of A stay in registers; unrolling and jamming the rows reuses
+// each element of B `unrollFactor` times. Only the row loop is parallel, the
+// batch and k loops carry the reduction into C.
+static void buildGemmRows(OpBuilder &b, Location loc,
+                          const GemmOperands &operands, int64_t begin,
+                          int64_t end, int64_t unrollFactor, bool parallel) {
+  MemRefType typeA = operands.matrixA.getType().cast<MemRefType>();
+  MemRefType typeC = operands.matrixC.getType().cast<MemRefType>();
+  Value zero = b.create<arith::ConstantIndexOp>(loc, 0);
+  Value one = b.create<arith::ConstantIndexOp>(loc, 1);
+  Value ubK = b.create<arith::ConstantIndexOp>(loc, typeA.getShape().back());
+  Value ubJ = b.create<arith::ConstantIndexOp>(loc, typeC.getShape()[1]);
+  SmallVector<Value> reductionUbs;
+  if (operands.batched)
+    reductionUbs.push_back(
+        b.create<arith::ConstantIndexOp>(loc, typeA.getShape().front()));
+  reductionUbs.push_back(ubK);
+  SmallVector<Value> reductionLbs(reductionUbs.size(), zero);
+  SmallVector<Value> reductionSteps(reductionUbs.size(), one);
+
+  buildOuterLoop(
+      b, loc, b.create<arith::ConstantIndexOp>(loc, begin),
+      b.create<arith::ConstantIndexOp>(loc, end),
+      b.create<arith::ConstantIndexOp>(loc, unrollFactor), parallel,
+      [&](OpBuilder &ib, Location il, Value localI) {
+        SmallVector<Value> rows = {localI};
+        for (int64_t r = 1; r < unrollFactor; r++)
+          rows.push_back(ib.create<arith::AddIOp>(
+              il, localI, ib.create<arith::ConstantIndexOp>(il, r)));
+        (void)scf::buildLoopNest(
+            ib, il, reductionLbs, reductionUbs, reductionSteps,
+            [&](OpBuilder &kb, Location kl, ValueRange reductionIvs) {
+              Value localK = reductionIvs.back();
+              SmallVector<Value> batch;
+              if (operands.batched)
+                batch.push_back(reductionIvs.front());
+              SmallVector<Value> scalarsA;
+              for (Value row : rows) {
+                SmallVector<Value> indicesA = batch;
+                indicesA.append({row, localK});
+                scalarsA.push_back(kb.create<memref::LoadOp>(
+                    kl, operands.matrixA, indicesA));
+              }
+              (void)scf::buildLoopNest(
+                  kb, kl, zero, ubJ, one,
+                  [&](OpBuilder &jb, Location jl, ValueRange jIvs) {
+                    Value localJ = jIvs[0];
+                    SmallVector<Value> indicesB = batch;
+                    indicesB.append({localK, localJ});
+                    Value scalarB = jb.create<memref::LoadOp>(
+                        jl, operands.matrixB, indicesB);
+                    for (auto it : llvm::zip(rows, scalarsA)) {
+                      SmallVector<Value, 2> indicesC = {std::get<0>(it),
+                                                        localJ};
+                      Value scalarC = jb.create<memref::LoadOp>(
+                          jl, operands.matrixC, indicesC);
+                      Value scalarAdd = buildMulAdd(jb, jl, std::get<1>(it),
+                                                    scalarB, scalarC);
+                      jb.create<memref::StoreOp>(jl, scalarAdd,
+                                                 operands.matrixC, indicesC);
+                    }
+                  });
+            });
+      });
+}
+
+// Build the loops of a GEMM: the rows that fill whole unrolled iterations,
+// then the remaining rows one at a time.
+static void buildGemmLoops(OpBuilder &b, Location loc,
+                           const GemmOperands &operands, int64_t unrollFactor,
+                           bool parallel) {
+  int64_t m = operands.matrixC.getType().cast<MemRefType>().getShape()[0];
+  unrollFactor = std::max<int64_t>(1, std::min(unrollFactor, m));
+  int64_t fullM = m / unrollFactor * unrollFactor;
+  if (fullM > 0)
+    buildGemmRows(b, loc, operands, 0, fullM, unrollFactor, parallel);
+  if (fullM < m)
+    buildGemmRows(b, loc, operands, fullM, m, 1, parallel);
+}
+
 // Convert matmul to loops.
 struct ConvertTppMatmulOp : public OpRewritePattern<MatmulOp> {
-  using OpRewritePattern<MatmulOp>::OpRewritePattern;
+  ConvertTppMatmulOp(MLIRContext *context, bool parallel,
+                     int64_t unrollFactor, PatternBenefit benefit = 1)
+      : OpRewritePattern<MatmulOp>(context, benefit), parallel(parallel),
+        unrollFactor(unrollFactor) {}
 
   LogicalResult matchAndRewrite(MatmulOp matmulOp,
                                 PatternRewriter &rewriter) const override {
-    Location loc = matmulOp.getLoc();
-    ArrayRef<int64_t> shapeC = matmulOp.getMatrixCType().getShape();
     ArrayRef<int64_t> shapeA =
         matmulOp.getMatrixA().getType().cast<MemRefType>().getShape();
     if (shapeA.size() == 3)
       return rewriter.notifyMatchFailure(matmulOp, "Packed BF16 loops unsupported");
-    Value i = rewriter.create<arith::ConstantIndexOp>(loc, shapeC[0]);
-    Value j = rewriter.create<arith::ConstantIndexOp>(loc, shapeC[1]);
-    Value k = rewriter.create<arith::ConstantIndexOp>(loc, shapeA[1]);
-    SmallVector<Value> ubs = {i, j, k};
-    Value zero = rewriter.create<arith::ConstantIndexOp>(loc, 0);
-    SmallVector<Value> lbs = {zero, zero, zero};
-    Value one = rewriter.create<arith::ConstantIndexOp>(loc, 1);
-    SmallVector<Value> steps = {one, one, one};
-
-    (void)scf::buildLoopNest(
-        rewriter, loc, lbs, ubs, steps,
-        [&](OpBuilder &b, Location loc, ValueRange localIvs) {
-          assert(localIvs.size() == 3);
-          Value localI = localIvs[0];
-          Value localJ = localIvs[1];
-          Value localK = localIvs[2];
-          Value scalarA = b.create<memref::LoadOp>(loc, matmulOp.getMatrixA(),
-                                                   ValueRange{localI, localK});
-          Value scalarB = b.create<memref::LoadOp>(loc, matmulOp.getMatrixB(),
-                                                   ValueRange{localK, localJ});
-          Value scalarC = b.create<memref::LoadOp>(loc, matmulOp.getMatrixC(),
-                                                   ValueRange{localI, localJ});
-          Value scalarMul = b.create<arith::MulFOp>(loc, scalarA, scalarB);
-          Value scalarAdd = b.create<arith::AddFOp>(loc, scalarC, scalarMul);
-          b.create<memref::StoreOp>(loc, scalarAdd, matmulOp.getMatrixC(),
-                                    ValueRange{localI, localJ});
-        });
-
+    GemmOperands operands;
+    operands.matrixA = matmulOp.getMatrixA();
+    operands.matrixB = matmulOp.getMatrixB();
+    operands.matrixC = matmulOp.getMatrixC();
+    buildGemmLoops(rewriter, matmulOp.getLoc(), operands, unrollFactor,
+                   parallel);
     rewriter.eraseOp(matmulOp);
     return success();
   }
+
+private:
+  bool parallel;
+  int64_t unrollFactor;
 };
 
 struct ConvertTppBrgemmOp : public OpRewritePattern<BrgemmOp> {
-  using OpRewritePattern<BrgemmOp>::OpRewritePattern;
+  ConvertTppBrgemmOp(MLIRContext *context, bool parallel,
+                     int64_t unrollFactor, PatternBenefit benefit = 1)
+      : OpRewritePattern<BrgemmOp>(context, benefit), parallel(parallel),
+        unrollFactor(unrollFactor) {}
 
   LogicalResult matchAndRewrite(BrgemmOp brgemmOp,
                                 PatternRewriter &rewriter) const override {
+    GemmOperands operands;
+    operands.matrixA = brgemmOp.getBatchMatrixA();
+    operands.matrixB = brgemmOp.getBatchMatrixB();
+    operands.matrixC = brgemmOp.getMatrixC();
+    operands.batched = true;
+    buildGemmLoops(rewriter, brgemmOp.getLoc(), operands, unrollFactor,
+                   parallel);
+    rewriter.eraseOp(brgemmOp);
+    return success();
+  }
+
+private:
+  bool parallel;
+  int64_t unrollFactor;
+};
+
+// Converts fused brgemm op by unfusing it back to identity (bias broadcast),
+// brgemm and relu; the three are then lowered by the patterns above.
+struct ConvertTppFusedBrgemmOp : public OpRewritePattern<FusedBrgemmOp> {
+  using OpRewritePattern<FusedBrgemmOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(FusedBrgemmOp fusedBrgemmOp,
+                                PatternRewriter &rewriter) const override {
+    Location loc = fusedBrgemmOp.getLoc();
+    Value matrixC = fusedBrgemmOp.getMatrixC();
+    rewriter.create<IdentityOp>(loc, fusedBrgemmOp.getBias(), matrixC);
+    rewriter.create<BrgemmOp>(
+        loc, ValueRange{fusedBrgemmOp.getBatchMatrixA(),
+                        fusedBrgemmOp.getBatchMatrixB()},
+        matrixC);
+    rewriter.replaceOpWithNewOp<ReluOp>(fusedBrgemmOp, matrixC, matrixC);
+    return success();
+  }
+};
+
+// Converts offset brgemm op by unrolling the reduction into one tpp.matmul
+// per pair of blocks; each block is a 2-D view of its operand starting at the
+// block offset. The matmuls are then lowered by the patterns above.
+struct ConvertTppOffsetBrgemmOp : public OpRewritePattern<OffsetBrgemmOp> {
+  using OpRewritePattern<OffsetBrgemmOp>::OpRewritePattern;
+
+  // Return the `rows` x `cols` block of `operand` starting at element offset
+  // `offset`, whose rows are strided as the second innermost dimension.
+  static Value getBlock(OpBuilder &b, Location loc, Value operand,
+                        int64_t offset, int64_t rows, int64_t cols) {
+    MemRefType memrefType = operand.getType().cast<MemRefType>();
+    SmallVector<int64_t> strides;
+    int64_t staticOffset;
+    (void)getStridesAndOffset(memrefType, strides, staticOffset);
+    int64_t ld = strides[strides.size() - 2];
+    auto meta = b.create<memref::ExtractStridedMetadataOp>(loc, operand);
+    Value blockOffset = b.create<arith::AddIOp>(
+        loc, meta.getOffset(), b.create<arith::ConstantIndexOp>(loc, offset));
+    MemRefType blockType =
+        MemRefType::get({rows, cols}, memrefType.getElementType(),
+                        StridedLayoutAttr::get(
+                            b.getContext(),
+                            ShapedType::kDynamicStrideOrOffset, {ld, 1}));
+    return b.create<memref::ReinterpretCastOp>(
+        loc, blockType, operand, blockOffset, ArrayRef<OpFoldResult>{},
+        ArrayRef<OpFoldResult>{}, ArrayRef<int64_t>{rows, cols},
+        ArrayRef<int64_t>{ld, 1});
+  }
+
+  LogicalResult matchAndRewrite(OffsetBrgemmOp brgemmOp,
+                                PatternRewriter &rewriter) const override {
     Location loc = brgemmOp.getLoc();
     ArrayRef<int64_t> shapeC = brgemmOp.getMatrixCType().getShape();
-    ArrayRef<int64_t> shapeA = brgemmOp.getBatchMatrixAType().getShape();
-    Value i = rewriter.createOrFold<arith::ConstantIndexOp>(loc, shapeC[0]);
-    Value j = rewriter.createOrFold<arith::ConstantIndexOp>(loc, shapeC[1]);
-    Value k = rewriter.createOrFold<arith::ConstantIndexOp>(loc, shapeA[2]);
-    Value b = rewriter.createOrFold<arith::ConstantIndexOp>(loc, shapeA[0]);
-    SmallVector<Value> ubs = {b, i, j, k};
-    Value zero = rewriter.createOrFold<arith::ConstantIndexOp>(loc, 0);
-    SmallVector<Value> lbs = {zero, zero, zero, zero};
-    Value one = rewriter.createOrFold<arith::ConstantIndexOp>(loc, 1);
-    SmallVector<Value> steps = {one, one, one, one};
-
-    (void)scf::buildLoopNest(
-        rewriter, loc, lbs, ubs, steps,
-        [&](OpBuilder &b, Location loc, ValueRange localIvs) {
-          assert(localIvs.size() == 4);
-          Value localB = localIvs[0];
-          Value localI = localIvs[1];
-          Value localJ = localIvs[2];
-          Value localK = localIvs[3];
-          Value scalarA =
-              b.create<memref::LoadOp>(loc, brgemmOp.getBatchMatrixA(),
-                                       ValueRange{localB, localI, localK});
-          Value scalarB =
-              b.create<memref::LoadOp>(loc, brgemmOp.getBatchMatrixB(),
-                                       ValueRange{localB, localK, localJ});
-          Value scalarC = b.create<memref::LoadOp>(loc, brgemmOp.getMatrixC(),
-                                                   ValueRange{localI, localJ});
-          Value scalarMul = b.create<arith::MulFOp>(loc, scalarA, scalarB);
-          Value scalarAdd = b.create<arith::AddFOp>(loc, scalarC, scalarMul);
-          b.create<memref::StoreOp>(loc, scalarAdd, brgemmOp.getMatrixC(),
-                                    ValueRange{localI, localJ});
-        });
+    int64_t m = shapeC[0];
+    int64_t n = shapeC[1];
+    int64_t k = brgemmOp.getBatchMatrixAType().getShape().back();
+    for (auto [offsetA, offsetB] :
+         llvm::zip(brgemmOp.getOffsetsA(), brgemmOp.getOffsetsB())) {
+      Value blockA =
+          getBlock(rewriter, loc, brgemmOp.getBatchMatrixA(), offsetA, m, k);
+      Value blockB =
+          getBlock(rewriter, loc, brgemmOp.getBatchMatrixB(), offsetB, k, n);
+      rewriter.create<MatmulOp>(loc, ValueRange{blockA, blockB},
+                                brgemmOp.getMatrixC());
+    }
     rewriter.eraseOp(brgemmOp);
     return success();
   }
 };
 
-void populateTppToLoopsPatterns(RewritePatternSet &patterns) {
+void populateTppToLoopsPatterns(RewritePatternSet &patterns, bool parallel,
+                                int64_t unrollFactor) {
   // clang-format off
-  patterns.add<ConvertTppAddOp, 
+  patterns.add<ConvertTppAddOp,
+               ConvertTppMulAddOp,
                ConvertTppIdentityOp,
-               ConvertTppMatmulOp,
-               ConvertTppBrgemmOp,
-               ConvertTppReluOp>(patterns.getContext());
+               ConvertTppReluOp>(patterns.getContext(), parallel);
+  patterns.add<ConvertTppMatmulOp,
+               ConvertTppBrgemmOp>(patterns.getContext(), parallel,
+                                   unrollFactor);
+  patterns.add<ConvertTppFusedBrgemmOp,
+               ConvertTppOffsetBrgemmOp>(patterns.getContext());
   // clang-format on
 }
 
 struct ConvertTppToLoops : public ConvertTppToLoopsBase<ConvertTppToLoops> {
+  ConvertTppToLoops() = default;
+  ConvertTppToLoops(bool parallel, int64_t unrollFactor) {
+    this->parallel = parallel;
+    this->unrollFactor = unrollFactor;
+  }
   void runOnOperation() override {
     RewritePatternSet patterns(&getContext());
-    populateTppToLoopsPatterns(patterns);
+    populateTppToLoopsPatterns(patterns, parallel, unrollFactor);
     (void)applyPatternsAndFoldGreedily(getOperation(), std::move(patterns));
     return;
   }
@@ -324,3 +563,8 @@ std::unique_ptr<OperationPass<func::FuncOp>>
 mlir::tpp::createConvertTppToLoopsPass() {
   return std::make_unique<ConvertTppToLoops>();
 }
+
+std::unique_ptr<OperationPass<func::FuncOp>>
+mlir::tpp::createConvertTppToLoopsPass(bool parallel, int64_t unrollFactor) {
+  return std::make_unique<ConvertTppToLoops>(parallel, unrollFactor);
+}
@@ -10,6 +10,8 @@
 #include "TPP/Passes.h"
 #include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
 #include "mlir/Dialect/Vector/IR/VectorOps.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 
@@ -21,89 +23,529 @@ using namespace mlir::tpp;
 
 namespace {
 
-template <typename OP>
-Value replacementForUnaryTppOp(Value lhsBuffer, Value rhsBuffer, Location loc,
-                               PatternRewriter &rewriter) {
-  MemRefType lhsMemRef = lhsBuffer.getType().cast<MemRefType>();
-  MemRefType rhsMemRef = rhsBuffer.getType().cast<MemRefType>();
-  VectorType lhsVectorType =
-      VectorType::get(lhsMemRef.getShape(), lhsMemRef.getElementType());
-  VectorType rhsVectorType =
-      VectorType::get(rhsMemRef.getShape(), rhsMemRef.getElementType());
-  Value vectorLoadLhs =
-      rewriter.create<vector::LoadOp>(loc, lhsVectorType, lhsBuffer);
-  Value vectorLoadRhs =
-      rewriter.create<vector::LoadOp>(loc, rhsVectorType, rhsBuffer);
-  Value vectorOp = rewriter.create<OP>(loc, vectorLoadLhs, vectorLoadRhs);
-  return vectorOp;
+// Number of elements of `elementType` in a SIMD register of `simdWidth` bits.
+static int64_t getNumLanes(Type elementType, int64_t simdWidth) {
+  return std::max<int64_t>(1, simdWidth / elementType.getIntOrFloatBitWidth());
+}
+
+static bool isScalar(Value val) { return !val.getType().isa<ShapedType>(); }
+
+static Value buildZeroVector(OpBuilder &b, Location loc, VectorType type) {
+  Type elementType = type.getElementType();
+  return b.create<arith::ConstantOp>(
+      loc, type,
+      DenseElementsAttr::get(type, b.getFloatAttr(elementType, 0.0)));
+}
+
+// Loop over [begin, end) with step `step`, calling `bodyFn` with the induction
+// variable. A single iteration is emitted without a loop, an empty range
+// emits nothing.
+static void
+buildBlockLoop(OpBuilder &b, Location loc, int64_t begin, int64_t end,
+               int64_t step,
+               function_ref<void(OpBuilder &, Location, Value)> bodyFn) {
+  if (begin >= end)
+    return;
+  if (end - begin <= step) {
+    bodyFn(b, loc, b.create<arith::ConstantIndexOp>(loc, begin));
+    return;
+  }
+  Value lb = b.create<arith::ConstantIndexOp>(loc, begin);
+  Value ub = b.create<arith::ConstantIndexOp>(loc, end);
+  Value st = b.create<arith::ConstantIndexOp>(loc, step);
+  b.create<scf::ForOp>(loc, lb, ub, st, llvm::None,
+                       [&](OpBuilder &nb, Location nl, Value iv, ValueRange) {
+                         bodyFn(nb, nl, iv);
+                         nb.create<scf::YieldOp>(nl);
+                       });
+}
+
+using ChunkBodyFn =
+    function_ref<void(OpBuilder &, Location, ValueRange, int64_t)>;
+
+// Walk a 1-D or 2-D iteration space of shape `shape` one row at a time, in
+// chunks of `numLanes` elements along the innermost dimension. Columns that do
+// not fill a whole vector are handled by a single, narrower chunk at the end
+// of each row, so that every access is in bounds and no mask is needed.
+// `bodyFn` receives the indices of the first element of the chunk and the
+// chunk size.
+static void buildChunkedLoops(OpBuilder &b, Location loc,
+                              ArrayRef<int64_t> shape, int64_t numLanes,
+                              ChunkBodyFn bodyFn) {
+  int64_t cols = shape.back();
+  int64_t vectorSize = std::min(numLanes, cols);
+  int64_t fullCols = cols / vectorSize * vectorSize;
+  auto buildRow = [&](OpBuilder &rb, Location rl, Optional<Value> row) {
+    auto getIndices = [&](Value col) {
+      SmallVector<Value, 2> indices;
+      if (row)
+        indices.push_back(*row);
+      indices.push_back(col);
+      return indices;
+    };
+    buildBlockLoop(rb, rl, 0, fullCols, vectorSize,
+                   [&](OpBuilder &cb, Location cl, Value col) {
+                     bodyFn(cb, cl, getIndices(col), vectorSize);
+                   });
+    buildBlockLoop(rb, rl, fullCols, cols, cols - fullCols,
+                   [&](OpBuilder &cb, Location cl, Value col) {
+                     bodyFn(cb, cl, getIndices(col), cols - fullCols);
+                   });
+  };
+  if (shape.size() == 1) {
+    buildRow(b, loc, llvm::None);
+    return;
+  }
+  buildBlockLoop(b, loc, 0, shape[0], 1,
+                 [&](OpBuilder &rb, Location rl, Value row) {
+                   buildRow(rb, rl, row);
+                 });
+}
+
+static Value buildVectorRead(OpBuilder &b, Location loc, Value source,
+                             ValueRange indices, int64_t vectorSize) {
+  Type elementType = source.getType().cast<MemRefType>().getElementType();
+  VectorType vectorType = VectorType::get({vectorSize}, elementType);
+  return b.create<vector::TransferReadOp>(loc, vectorType, source, indices,
+                                          makeArrayRef(true));
+}
+
+static void buildVectorWrite(OpBuilder &b, Location loc, Value vector,
+                             Value dest, ValueRange indices) {
+  b.create<vector::TransferWriteOp>(loc, vector, dest, indices,
+                                    makeArrayRef(true));
 }
 
 //
-// tpp.add ins(%a, %b) out(%c)
+// tpp.add ins(%a) out(%b)
 //
-// Converts to:
+// Converts to, for each chunk of `simd-width` bits of each row:
 //
-// %0 = vector.load(%a) memref to vector
-// %1 = vector.load(%b) memref to vector
-// %2 = arith.add(%a, %b)
-// vector.store(%2 to %c) vector to memref
+// %0 = vector.transfer_read %a[%i, %j]
+// %1 = vector.transfer_read %b[%i, %j]
+// %2 = arith.addf %0, %1
+// vector.transfer_write %2, %b[%i, %j]
 //
 struct ConvertTppAddOp : public OpRewritePattern<AddOp> {
-  using OpRewritePattern<AddOp>::OpRewritePattern;
+  ConvertTppAddOp(MLIRContext *context, int64_t simdWidth,
+                  PatternBenefit benefit = 1)
+      : OpRewritePattern<AddOp>(context, benefit), simdWidth(simdWidth) {}
 
   LogicalResult matchAndRewrite(AddOp addOp,
                                 PatternRewriter &rewriter) const override {
-    Value vectorAdd = replacementForUnaryTppOp<arith::AddFOp>(
-        addOp.getLhs(), addOp.getRhs(), addOp.getLoc(), rewriter);
-    rewriter.create<vector::StoreOp>(addOp.getLoc(), vectorAdd.getType(),
-                                     addOp.getOutput());
+    MemRefType outputType = addOp.getOutput().getType().cast<MemRefType>();
+    buildChunkedLoops(
+        rewriter, addOp.getLoc(), outputType.getShape(),
+        getNumLanes(outputType.getElementType(), simdWidth),
+        [&](OpBuilder &b, Location loc, ValueRange indices,
+            int64_t vectorSize) {
+          Value lhs =
+              buildVectorRead(b, loc, addOp.getLhs(), indices, vectorSize);
+          Value rhs =
+              buildVectorRead(b, loc, addOp.getRhs(), indices, vectorSize);
+          Value sum = b.create<arith::AddFOp>(loc, lhs, rhs);
+          buildVectorWrite(b, loc, sum, addOp.getOutput(), indices);
+        });
     rewriter.eraseOp(addOp);
     return success();
   }
+
+private:
+  int64_t simdWidth;
+};
+
+//
+// tpp.relu ins(%a) out(%b)
+//
+// Converts to, for each chunk of `simd-width` bits of each row:
+//
+// %0 = vector.transfer_read %a[%i, %j]
+// %1 = arith.maxf %0, %zero
+// vector.transfer_write %1, %b[%i, %j]
+//
+struct ConvertTppReluOp : public OpRewritePattern<ReluOp> {
+  ConvertTppReluOp(MLIRContext *context, int64_t simdWidth,
+                   PatternBenefit benefit = 1)
+      : OpRewritePattern<ReluOp>(context, benefit), simdWidth(simdWidth) {}
+
+  LogicalResult matchAndRewrite(ReluOp reluOp,
+                                PatternRewriter &rewriter) const override {
+    Location loc = reluOp.getLoc();
+    // handle scalar case.
+    if (isScalar(reluOp.getInput())) {
+      Type type = reluOp.getInput().getType();
+      Value zero = rewriter.create<arith::ConstantOp>(
+          loc, type, rewriter.getFloatAttr(type, 0));
+      Value scalarRelu =
+          rewriter.create<arith::MaxFOp>(loc, reluOp.getInput(), zero);
+      reluOp.getOutput().replaceAllUsesWith(scalarRelu);
+      rewriter.eraseOp(reluOp);
+      return success();
+    }
+    MemRefType outputType = reluOp.getOutput().getType().cast<MemRefType>();
+    buildChunkedLoops(
+        rewriter, loc, outputType.getShape(),
+        getNumLanes(outputType.getElementType(), simdWidth),
+        [&](OpBuilder &b, Location loc, ValueRange indices,
+            int64_t vectorSize) {
+          Value input =
+              buildVectorRead(b, loc, reluOp.getInput(), indices, vectorSize);
+          Value zero =
+              buildZeroVector(b, loc, input.getType().cast<VectorType>());
+          Value relu = b.create<arith::MaxFOp>(loc, input, zero);
+          buildVectorWrite(b, loc, relu, reluOp.getOutput(), indices);
+        });
+    rewriter.eraseOp(reluOp);
+    return success();
+  }
+
+private:
+  int64_t simdWidth;
 };
 
 //
 // tpp.identity ins(%a) out(%b)
 //
-// Converts to:
+// Converts to, for each chunk of `simd-width` bits of each row of %b:
 //
-// %0 = vector.load(%a) memref to vector
-// %1 = vector.store(%0 to %b) vector to memref
+// %0 = vector.transfer_read %a[%i, %j]
+// vector.transfer_write %0, %b[%i, %j]
+//
+// The input is broadcast to the output shape: a scalar, or an input dimension
+// of size one, is broadcast along the corresponding output dimension. The
+// input dimensions are aligned with the innermost output dimensions.
 //
 struct ConvertTppIdentityOp : public OpRewritePattern<IdentityOp> {
-  using OpRewritePattern<IdentityOp>::OpRewritePattern;
+  ConvertTppIdentityOp(MLIRContext *context, int64_t simdWidth,
+                       PatternBenefit benefit = 1)
+      : OpRewritePattern<IdentityOp>(context, benefit), simdWidth(simdWidth) {
+  }
+
+  // Read the chunk of the input broadcast to the output chunk at
+  // `outputIndices`.
+  Value buildBroadcastRead(OpBuilder &b, Location loc, Value input,
+                           ArrayRef<int64_t> outputShape,
+                           ValueRange outputIndices,
+                           int64_t vectorSize) const {
+    Type elementType = getElementTypeOrSelf(input.getType());
+    VectorType vectorType = VectorType::get({vectorSize}, elementType);
+    if (isScalar(input))
+      return b.create<vector::BroadcastOp>(loc, vectorType, input);
+
+    ArrayRef<int64_t> inputShape =
+        input.getType().cast<MemRefType>().getShape();
+    size_t rankDiff = outputShape.size() - inputShape.size();
+    SmallVector<Value, 2> inputIndices;
+    Value zero;
+    for (size_t dim = 0; dim < inputShape.size(); dim++) {
+      if (inputShape[dim] == 1 && outputShape[dim + rankDiff] != 1) {
+        if (!zero)
+          zero = b.create<arith::ConstantIndexOp>(loc, 0);
+        inputIndices.push_back(zero);
+        continue;
+      }
+      inputIndices.push_back(outputIndices[dim + rankDiff]);
+    }
+    // Broadcast along the innermost dimension: splat a single element.
+    if (inputShape.back() == 1 && outputShape.back() != 1) {
+      Value element = b.create<memref::LoadOp>(loc, input, inputIndices);
+      return b.create<vector::BroadcastOp>(loc, vectorType, element);
+    }
+    return buildVectorRead(b, loc, input, inputIndices, vectorSize);
+  }
 
   LogicalResult matchAndRewrite(IdentityOp identityOp,
                                 PatternRewriter &rewriter) const override {
-    return failure(); // TODO: this is broken (do not handle scalar).
-    Location loc = identityOp.getLoc();
-    MemRefType inputMemRef = identityOp.getInput().getType().cast<MemRefType>();
-    VectorType inputVectorType =
-        VectorType::get(inputMemRef.getShape(), inputMemRef.getElementType());
-    Value vectorLoad = rewriter.create<vector::LoadOp>(loc, inputVectorType,
-                                                       identityOp.getInput());
-    MemRefType outputMemRef =
-        identityOp.getOutput().getType().cast<MemRefType>();
-    assert(inputMemRef.getElementType() == outputMemRef.getElementType() &&
-           "expect same type");
-    rewriter.create<vector::StoreOp>(loc, vectorLoad.getType(),
-                                     identityOp.getOutput());
+    Value input = identityOp.getInput();
+    Value output = identityOp.getOutput();
+    // Handle scalar.
+    if (isScalar(output)) {
+      output.replaceAllUsesWith(input);
+      rewriter.eraseOp(identityOp);
+      return success();
+    }
+    MemRefType outputType = output.getType().cast<MemRefType>();
+    if (getElementTypeOrSelf(input.getType()) != outputType.getElementType())
+      return rewriter.notifyMatchFailure(identityOp,
+                                         "expect same element types");
+    ArrayRef<int64_t> outputShape = outputType.getShape();
+    buildChunkedLoops(rewriter, identityOp.getLoc(), outputShape,
+                      getNumLanes(outputType.getElementType(), simdWidth),
+                      [&](OpBuilder &b, Location loc, ValueRange indices,
+                          int64_t vectorSize) {
+                        Value chunk = buildBroadcastRead(
+                            b, loc, input, outputShape, indices, vectorSize);
+                        buildVectorWrite(b, loc, chunk, output, indices);
+                      });
     rewriter.eraseOp(identityOp);
     return success();
   }
+
+private:
+  int64_t simdWidth;
+};
+
+// Operands of a (batch-reduce) GEMM lowered with register blocking. A and B
+// have a leading batch dimension if `batched` is set. If `bias` is set the
+// accumulators start from the bias broadcast along the rows instead of C, and
+// `relu` clamps them at zero before they are stored.
+struct GemmOperands {
+  Value matrixA;
+  Value matrixB;
+  Value matrixC;
+  Value bias;
+  bool batched = false;
+  bool relu = false;
+};
+
+// Register block of the GEMM micro-kernel: `nr` columns, one or two vectors
+// wide, by `mr` rows. The `mr` x `nr` accumulators, a row of B and a broadcast
+// element of A must fit in the vector registers: 32 with 512-bit SIMD
+// (AVX-512), 16 otherwise (AVX2, NEON).
+static std::pair<int64_t, int64_t> getRegisterBlock(int64_t m, int64_t n,
+                                                    int64_t numLanes,
+                                                    int64_t simdWidth) {
+  int64_t numRegisters = simdWidth >= 512 ? 32 : 16;
+  int64_t numVectors = n >= 2 * numLanes ? 2 : 1;
+  int64_t nr = std::min(n, numVectors * numLanes);
+  int64_t numAccumulators = numRegisters - numVectors - 2;
+  int64_t mr = std::min(m, numAccumulators / numVectors);
+  return {mr, nr};
+}
+
+// Compute the `mr` x `nr` block of C at (`i`, `j`):
+//
+// %acc = vector.transfer_read %C[%i, %j] : vector<mr x nr>
+// scf.for %b (if batched)
+//   scf.for %k
+//     %a = vector.transfer_read %A[%b, %i, %k] : vector<mr> (column of A)
+//     %b = vector.transfer_read %B[%b, %k, %j] : vector<nr> (row of B)
+//     %acc = vector.outerproduct %a, %b, %acc
+// vector.transfer_write %acc, %C[%i, %j]
+//
+// The accumulators stay in registers across the whole reduction; the outer
+// product lowers to one broadcast FMA per row of the block.
+static void buildMicroKernel(OpBuilder &b, Location loc,
+                             const GemmOperands &operands, Value i, Value j,
+                             int64_t mr, int64_t nr) {
+  MemRefType typeA = operands.matrixA.getType().cast<MemRefType>();
+  MemRefType typeB = operands.matrixB.getType().cast<MemRefType>();
+  MemRefType typeC = operands.matrixC.getType().cast<MemRefType>();
+  Type accElementType = typeC.getElementType();
+  VectorType accType = VectorType::get({mr, nr}, accElementType);
+  VectorType rowType = VectorType::get({nr}, accElementType);
+  VectorType colType = VectorType::get({mr}, accElementType);
+  bool inBounds2D[] = {true, true};
+
+  Value acc;
+  if (operands.bias) {
+    MemRefType biasType = operands.bias.getType().cast<MemRefType>();
+    SmallVector<Value, 2> biasIndices;
+    if (biasType.getRank() == 2)
+      biasIndices.push_back(b.create<arith::ConstantIndexOp>(loc, 0));
+    biasIndices.push_back(j);
+    Value biasRow = buildVectorRead(b, loc, operands.bias, biasIndices, nr);
+    if (biasType.getElementType() != accElementType)
+      biasRow = b.create<arith::ExtFOp>(loc, rowType, biasRow);
+    acc = b.create<vector::BroadcastOp>(loc, accType, biasRow);
+  } else {
+    acc = b.create<vector::TransferReadOp>(loc, accType, operands.matrixC,
+                                           ValueRange{i, j},
+                                           makeArrayRef(inBounds2D));
+  }
+
+  // Reads a column of A: the vector runs along the rows.
+  int64_t rankA = typeA.getRank();
+  AffineMap columnMap = AffineMap::get(
+      rankA, 0, b.getAffineDimExpr(rankA - 2), b.getContext());
+  auto buildReduction = [&](OpBuilder &kb, Location kl, Optional<Value> batch,
+                            Value accIn) {
+    Value zero = kb.create<arith::ConstantIndexOp>(kl, 0);
+    Value ubK = kb.create<arith::ConstantIndexOp>(kl, typeA.getShape().back());
+    Value one = kb.create<arith::ConstantIndexOp>(kl, 1);
+    auto loopK = kb.create<scf::ForOp>(
+        kl, zero, ubK, one, ValueRange{accIn},
+        [&](OpBuilder &nb, Location nl, Value k, ValueRange iterArgs) {
+          SmallVector<Value, 3> indicesA, indicesB;
+          if (batch) {
+            indicesA.push_back(*batch);
+            indicesB.push_back(*batch);
+          }
+          indicesA.append({i, k});
+          indicesB.append({k, j});
+          Value colA = nb.create<vector::TransferReadOp>(
+              nl, VectorType::get({mr}, typeA.getElementType()),
+              operands.matrixA, indicesA, columnMap, makeArrayRef(true));
+          Value rowB = nb.create<vector::TransferReadOp>(
+              nl, VectorType::get({nr}, typeB.getElementType()),
+              operands.matrixB, indicesB, makeArrayRef(true));
+          if (typeA.getElementType() != accElementType) {
+            colA = nb.create<arith::ExtFOp>(nl, colType, colA);
+            rowB = nb.create<arith::ExtFOp>(nl, rowType, rowB);
+          }
+          Value accOut =
+              nb.create<vector::OuterProductOp>(nl, colA, rowB, iterArgs[0]);
+          nb.create<scf::YieldOp>(nl, accOut);
+        });
+    return loopK.getResult(0);
+  };
+
+  if (operands.batched) {
+    Value zero = b.create<arith::ConstantIndexOp>(loc, 0);
+    Value ubBatch =
+        b.create<arith::ConstantIndexOp>(loc, typeA.getShape().front());
+    Value one = b.create<arith::ConstantIndexOp>(loc, 1);
+    auto loopBatch = b.create<scf::ForOp>(
+        loc, zero, ubBatch, one, ValueRange{acc},
+        [&](OpBuilder &nb, Location nl, Value batch, ValueRange iterArgs) {
+          nb.create<scf::YieldOp>(
+              nl, buildReduction(nb, nl, batch, iterArgs[0]));
+        });
+    acc = loopBatch.getResult(0);
+  } else {
+    acc = buildReduction(b, loc, llvm::None, acc);
+  }
+
+  if (operands.relu)
+    acc = b.create<arith::MaxFOp>(loc, acc, buildZeroVector(b, loc, accType));
+  b.create<vector::TransferWriteOp>(loc, acc, operands.matrixC,
+                                    ValueRange{i, j},
+                                    makeArrayRef(inBounds2D));
+}
+
+// Tile C in `mr` x `nr` register blocks and compute each of them with the
+// micro-kernel. The last row and column of blocks are narrower if `mr` and
+// `nr` do not divide the sizes of C; they get their own, statically sized,
+// micro-kernels.
+static void buildRegisterBlockedGemm(OpBuilder &b, Location loc,
+                                     const GemmOperands &operands,
+                                     int64_t simdWidth) {
+  MemRefType typeC = operands.matrixC.getType().cast<MemRefType>();
+  int64_t m = typeC.getShape()[0];
+  int64_t n = typeC.getShape()[1];
+  int64_t numLanes = getNumLanes(typeC.getElementType(), simdWidth);
+  int64_t mr, nr;
+  std::tie(mr, nr) = getRegisterBlock(m, n, numLanes, simdWidth);
+  int64_t fullM = m / mr * mr;
+  int64_t fullN = n / nr * nr;
+  // (begin, end, block size) along M and N.
+  std::array<int64_t, 3> rowRanges[] = {{0, fullM, mr},
+                                        {fullM, m, m - fullM}};
+  std::array<int64_t, 3> colRanges[] = {{0, fullN, nr},
+                                        {fullN, n, n - fullN}};
+  for (const std::array<int64_t, 3> &rows : rowRanges) {
+    for (const std::array<int64_t, 3> &cols : colRanges) {
+      buildBlockLoop(
+          b, loc, rows[0], rows[1], rows[2],
+          [&](OpBuilder &ib, Location il, Value i) {
+            buildBlockLoop(ib, il, cols[0], cols[1], cols[2],
+                           [&](OpBuilder &jb, Location jl, Value j) {
+                             buildMicroKernel(jb, jl, operands, i, j, rows[2],
+                                              cols[2]);
+                           });
+          });
+    }
+  }
+}
+
+// Convert matmul to register-blocked outer products.
+struct ConvertTppMatmulOp : public OpRewritePattern<MatmulOp> {
+  ConvertTppMatmulOp(MLIRContext *context, int64_t simdWidth,
+                     PatternBenefit benefit = 1)
+      : OpRewritePattern<MatmulOp>(context, benefit), simdWidth(simdWidth) {}
+
+  LogicalResult matchAndRewrite(MatmulOp matmulOp,
+                                PatternRewriter &rewriter) const override {
+    if (matmulOp.getMatrixAType().getRank() != 2)
+      return rewriter.notifyMatchFailure(matmulOp,
+                                         "Packed BF16 vectors unsupported");
+    GemmOperands operands;
+    operands.matrixA = matmulOp.getMatrixA();
+    operands.matrixB = matmulOp.getMatrixB();
+    operands.matrixC = matmulOp.getMatrixC();
+    buildRegisterBlockedGemm(rewriter, matmulOp.getLoc(), operands, simdWidth);
+    rewriter.eraseOp(matmulOp);
+    return success();
+  }
+
+private:
+  int64_t simdWidth;
+};
+
+// Convert brgemm to register-blocked outer products, reducing over the batch
+// in registers.
+struct ConvertTppBrgemmOp : public OpRewritePattern<BrgemmOp> {
+  ConvertTppBrgemmOp(MLIRContext *context, int64_t simdWidth,
+                     PatternBenefit benefit = 1)
+      : OpRewritePattern<BrgemmOp>(context, benefit), simdWidth(simdWidth) {}
+
+  LogicalResult matchAndRewrite(BrgemmOp brgemmOp,
+                                PatternRewriter &rewriter) const override {
+    if (brgemmOp.getBatchMatrixAType().getRank() != 3)
+      return rewriter.notifyMatchFailure(brgemmOp,
+                                         "Packed BF16 vectors unsupported");
+    GemmOperands operands;
+    operands.matrixA = brgemmOp.getBatchMatrixA();
+    operands.matrixB = brgemmOp.getBatchMatrixB();
+    operands.matrixC = brgemmOp.getMatrixC();
+    operands.batched = true;
+    buildRegisterBlockedGemm(rewriter, brgemmOp.getLoc(), operands, simdWidth);
+    rewriter.eraseOp(brgemmOp);
+    return success();
+  }
+
+private:
+  int64_t simdWidth;
 };
 
-void populateTppToVectorPatterns(RewritePatternSet &patterns) {
+// Convert fused brgemm as a brgemm whose accumulators start from the bias and
+// go through the relu before being stored: C is written once and never read.
+struct ConvertTppFusedBrgemmOp : public OpRewritePattern<FusedBrgemmOp> {
+  ConvertTppFusedBrgemmOp(MLIRContext *context, int64_t simdWidth,
+                          PatternBenefit benefit = 1)
+      : OpRewritePattern<FusedBrgemmOp>(context, benefit),
+        simdWidth(simdWidth) {}
+
+  LogicalResult matchAndRewrite(FusedBrgemmOp fusedBrgemmOp,
+                                PatternRewriter &rewriter) const override {
+    if (fusedBrgemmOp.getBatchMatrixAType().getRank() != 3)
+      return rewriter.notifyMatchFailure(fusedBrgemmOp,
+                                         "Packed BF16 vectors unsupported");
+    GemmOperands operands;
+    operands.matrixA = fusedBrgemmOp.getBatchMatrixA();
+    operands.matrixB = fusedBrgemmOp.getBatchMatrixB();
+    operands.matrixC = fusedBrgemmOp.getMatrixC();
+    operands.bias = fusedBrgemmOp.getBias();
+    operands.batched = true;
+    operands.relu = true;
+    buildRegisterBlockedGemm(rewriter, fusedBrgemmOp.getLoc(), operands,
+                             simdWidth);
+    rewriter.eraseOp(fusedBrgemmOp);
+    return success();
+  }
+
+private:
+  int64_t simdWidth;
+};
+
+void populateTppToVectorPatterns(RewritePatternSet &patterns,
+                                 int64_t simdWidth) {
   // clang-format off
   patterns.add<ConvertTppAddOp,
-               ConvertTppIdentityOp>(patterns.getContext());
+               ConvertTppIdentityOp,
+               ConvertTppReluOp,
+               ConvertTppMatmulOp,
+               ConvertTppBrgemmOp,
+               ConvertTppFusedBrgemmOp>(patterns.getContext(), simdWidth);
   // clang-format on
 }
 
 struct ConvertTppToVector : public ConvertTppToVectorBase<ConvertTppToVector> {
+  ConvertTppToVector() = default;
+  ConvertTppToVector(int64_t simdWidth) { this->simdWidth = simdWidth; }
   void runOnOperation() override {
     RewritePatternSet patterns(&getContext());
-    populateTppToVectorPatterns(patterns);
+    populateTppToVectorPatterns(patterns, simdWidth);
     (void)applyPatternsAndFoldGreedily(getOperation(), std::move(patterns));
     return;
   }
@@ -115,3 +557,8 @@ std::unique_ptr<OperationPass<func::FuncOp>>
 mlir::tpp::createConvertTppToVectorPass() {
   return std::make_unique<ConvertTppToVector>();
 }
+
+std::unique_ptr<OperationPass<func::FuncOp>>
+mlir::tpp::createConvertTppToVectorPass(int64_t simdWidth) {
+  return std::make_unique<ConvertTppToVector>(simdWidth);
+}
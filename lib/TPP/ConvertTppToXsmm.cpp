@@ -35,6 +35,33 @@ static FailureOr<int64_t> getLeadingDim(MemRefType memref, size_t pos = 0) {
   return strides[pos];
 }
 
+static xsmm::DataTypeAttr getDataTypeAttr(MLIRContext *ctx, Type type) {
+  if (type.isBF16())
+    return xsmm::DataTypeAttr::get(ctx, xsmm::DataType::BF16);
+  assert(type.isF32());
+  return xsmm::DataTypeAttr::get(ctx, xsmm::DataType::F32);
+}
+
+// Create the dispatch for a GEMM-like operation. The inputs and the output
+// have the same type, or the inputs are bf16 and the output f32; in the latter
+// case the kernel also accumulates in f32.
+static Value buildGemmDispatch(PatternRewriter &rewriter, Location loc,
+                               xsmm::TernaryKindAttr kind,
+                               DenseI64ArrayAttr dims, MemRefType memrefA,
+                               MemRefType memrefC) {
+  MLIRContext *ctx = rewriter.getContext();
+  Type inputType = memrefA.getElementType();
+  Type outputType = memrefC.getElementType();
+  xsmm::DataTypeAttr dtype = getDataTypeAttr(ctx, inputType);
+  xsmm::DataTypeAttr computeAndOutputType = nullptr;
+  if (inputType != outputType)
+    computeAndOutputType = getDataTypeAttr(ctx, outputType);
+  return rewriter.create<xsmm::TernaryDispatchOp>(
+      loc, rewriter.getI64Type(), kind, dims, dtype,
+      /*computeType=*/computeAndOutputType,
+      /*outputType=*/computeAndOutputType);
+}
+
 struct ConvertTppMatmulOp : public OpRewritePattern<MatmulOp> {
   using OpRewritePattern<MatmulOp>::OpRewritePattern;
 
@@ -69,22 +96,12 @@ struct ConvertTppMatmulOp : public OpRewritePattern<MatmulOp> {
       return failure();
     int64_t ldc = *ldcDim;
 
-    IntegerType integer64 = IntegerType::get(rewriter.getContext(), 64);
     DenseI64ArrayAttr dims = DenseI64ArrayAttr::get(
         rewriter.getContext(), ArrayRef<int64_t>{m, n, k, lda, ldb, ldc});
     xsmm::TernaryKindAttr attr = xsmm::TernaryKindAttr::get(
         matmulOp.getContext(), xsmm::TernaryKind::MATMUL);
-    xsmm::DataTypeAttr dtype;
-    if (memrefC.getElementType().isBF16())
-      dtype =
-          xsmm::DataTypeAttr::get(matmulOp.getContext(), xsmm::DataType::BF16);
-    else {
-      assert(memrefC.getElementType().isF32());
-      dtype =
-          xsmm::DataTypeAttr::get(matmulOp.getContext(), xsmm::DataType::F32);
-    }
-    Value dispatched = rewriter.create<xsmm::TernaryDispatchOp>(
-        loc, integer64, attr, dims, dtype);
+    Value dispatched =
+        buildGemmDispatch(rewriter, loc, attr, dims, memrefA, memrefC);
 
     SmallVector<Value, 6> invokeOperands;
     invokeOperands.push_back(dispatched);
@@ -96,10 +113,13 @@ struct ConvertTppMatmulOp : public OpRewritePattern<MatmulOp> {
   }
 };
 
-struct ConvertTppBrgemmOp : public OpRewritePattern<BrgemmOp> {
-  using OpRewritePattern<BrgemmOp>::OpRewritePattern;
+// Lower tpp.brgemm and tpp.fused_brgemm. The two share the same dispatch
+// signature; the fused variant carries the bias as an extra operand before C.
+template <typename OpTy, xsmm::TernaryKind kind>
+struct ConvertTppBrgemmLikeOp : public OpRewritePattern<OpTy> {
+  using OpRewritePattern<OpTy>::OpRewritePattern;
 
-  LogicalResult matchAndRewrite(BrgemmOp brgemmOp,
+  LogicalResult matchAndRewrite(OpTy brgemmOp,
                                 PatternRewriter &rewriter) const override {
     Location loc = brgemmOp.getLoc();
 
@@ -135,20 +155,10 @@ struct ConvertTppBrgemmOp : public OpRewritePattern<BrgemmOp> {
     IntegerType integer64 = IntegerType::get(rewriter.getContext(), 64);
     DenseI64ArrayAttr dims = DenseI64ArrayAttr::get(
         rewriter.getContext(), ArrayRef<int64_t>{m, n, k, lda, ldb, ldc});
-    xsmm::TernaryKindAttr attr = xsmm::TernaryKindAttr::get(
-        brgemmOp.getContext(), xsmm::TernaryKind::BRGEMM);
-    xsmm::DataTypeAttr dtype;
-    if (memrefC.getElementType().isBF16())
-      dtype =
-          xsmm::DataTypeAttr::get(brgemmOp.getContext(), xsmm::DataType::BF16);
-    else {
-      assert(memrefC.getElementType().isF32());
-      dtype =
-          xsmm::DataTypeAttr::get(brgemmOp.getContext(), xsmm::DataType::F32);
-    }
-
-    Value dispatched = rewriter.create<xsmm::TernaryDispatchOp>(
-        loc, integer64, attr, dims, dtype);
+    xsmm::TernaryKindAttr attr =
+        xsmm::TernaryKindAttr::get(brgemmOp.getContext(), kind);
+    Value dispatched =
+        buildGemmDispatch(rewriter, loc, attr, dims, memrefA, memrefC);
     Value batchDim = rewriter.create<arith::ConstantOp>(
         loc, integer64, rewriter.getIntegerAttr(integer64, batchSize));
     SmallVector<Value, 6> invokeOperands;
@@ -162,6 +172,65 @@ struct ConvertTppBrgemmOp : public OpRewritePattern<BrgemmOp> {
   }
 };
 
+using ConvertTppBrgemmOp =
+    ConvertTppBrgemmLikeOp<BrgemmOp, xsmm::TernaryKind::BRGEMM>;
+using ConvertTppFusedBrgemmOp =
+    ConvertTppBrgemmLikeOp<FusedBrgemmOp, xsmm::TernaryKind::FUSED_BRGEMM>;
+
+// Lower tpp.offset_brgemm to an offset-list BRGEMM. The offsets stay
+// attributes of the invoke until the lowering to function calls.
+struct ConvertTppOffsetBrgemmOp : public OpRewritePattern<OffsetBrgemmOp> {
+  using OpRewritePattern<OffsetBrgemmOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(OffsetBrgemmOp brgemmOp,
+                                PatternRewriter &rewriter) const override {
+    Location loc = brgemmOp.getLoc();
+
+    MemRefType memrefC = brgemmOp.getMatrixCType();
+    MemRefType memrefA = brgemmOp.getBatchMatrixAType();
+    MemRefType memrefB = brgemmOp.getBatchMatrixBType();
+    // The runtime dispatches offset-list kernels for one data type only.
+    if (memrefA.getElementType() != memrefC.getElementType())
+      return rewriter.notifyMatchFailure(brgemmOp, "mixed precision");
+    int64_t m = memrefC.getShape()[0];
+    int64_t n = memrefC.getShape()[1];
+    int64_t k = memrefA.getShape().back();
+
+    auto ldaDim = getLeadingDim(memrefA, memrefA.getRank() - 2);
+    if (failed(ldaDim))
+      return failure();
+    int64_t lda = *ldaDim;
+    auto ldbDim = getLeadingDim(memrefB, memrefB.getRank() - 2);
+    if (failed(ldbDim))
+      return failure();
+    int64_t ldb = *ldbDim;
+    auto ldcDim = getLeadingDim(memrefC);
+    if (failed(ldcDim))
+      return failure();
+    int64_t ldc = *ldcDim;
+
+    IntegerType integer64 = IntegerType::get(rewriter.getContext(), 64);
+    DenseI64ArrayAttr dims = DenseI64ArrayAttr::get(
+        rewriter.getContext(), ArrayRef<int64_t>{m, n, k, lda, ldb, ldc});
+    xsmm::TernaryKindAttr attr = xsmm::TernaryKindAttr::get(
+        brgemmOp.getContext(), xsmm::TernaryKind::BRGEMM_OFFS);
+    Value dispatched =
+        buildGemmDispatch(rewriter, loc, attr, dims, memrefA, memrefC);
+    Value batchDim = rewriter.create<arith::ConstantOp>(
+        loc, integer64,
+        rewriter.getIntegerAttr(integer64, brgemmOp.getBatchSize()));
+    SmallVector<Value, 6> invokeOperands;
+    invokeOperands.push_back(dispatched);
+    invokeOperands.append(brgemmOp->getOperands().begin(),
+                          brgemmOp->getOperands().end());
+    invokeOperands.push_back(batchDim);
+    rewriter.replaceOpWithNewOp<xsmm::TernaryOp>(
+        brgemmOp, attr, invokeOperands, brgemmOp.getOffsetsAAttr(),
+        brgemmOp.getOffsetsBAttr());
+    return success();
+  }
+};
+
 struct ConvertTppIdentityOp : public OpRewritePattern<IdentityOp> {
   using OpRewritePattern<IdentityOp>::OpRewritePattern;
 
@@ -322,8 +391,17 @@ struct ConvertTppReluOp : public OpRewritePattern<ReluOp> {
     MemRefType outputMemRef = outputType.cast<MemRefType>();
     int64_t m = outputMemRef.getShape()[0];
     int64_t n = outputMemRef.getShape()[1];
-    int64_t ldo = n;
-    int64_t ldi = n;
+    // The input and the output may have different layouts (i.e., a scratch
+    // buffer and a subview).
+    auto ldiDim =
+        getLeadingDim(reluOp.getInput().getType().cast<MemRefType>());
+    if (failed(ldiDim))
+      return failure();
+    int64_t ldi = *ldiDim;
+    auto ldoDim = getLeadingDim(outputMemRef);
+    if (failed(ldoDim))
+      return failure();
+    int64_t ldo = *ldoDim;
 
     xsmm::UnaryFlags bCast = xsmm::UnaryFlags::NONE;
     xsmm::UnaryKindAttr attr =
@@ -405,6 +483,61 @@ struct ConvertTppAddOp : public OpRewritePattern<AddOp> {
   }
 };
 
+// Lower tpp.muladd to an element-wise ternary kernel. A broadcast rhs is
+// dispatched with a zero leading dimension.
+struct ConvertTppMulAddOp : public OpRewritePattern<MulAddOp> {
+  using OpRewritePattern<MulAddOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(MulAddOp mulAddOp,
+                                PatternRewriter &rewriter) const override {
+    Location loc = mulAddOp.getLoc();
+    MemRefType memrefA = mulAddOp.getLhsType();
+    MemRefType memrefB = mulAddOp.getRhsType();
+    MemRefType memrefC = mulAddOp.getOutputType();
+    for (MemRefType memref : {memrefA, memrefB, memrefC}) {
+      FailureOr<int64_t> innerStride =
+          getLeadingDim(memref, memref.getRank() - 1);
+      if (failed(innerStride) || *innerStride != 1)
+        return rewriter.notifyMatchFailure(mulAddOp,
+                                           "most minor stride is != 1");
+    }
+    int64_t m = memrefC.getShape()[0];
+    int64_t n = memrefC.getShape()[1];
+    auto ldaDim = getLeadingDim(memrefA);
+    if (failed(ldaDim))
+      return failure();
+    int64_t lda = *ldaDim;
+    int64_t ldb = 0;
+    if (!mulAddOp.hasBroadcastRhs()) {
+      auto ldbDim = getLeadingDim(memrefB);
+      if (failed(ldbDim))
+        return failure();
+      ldb = *ldbDim;
+    }
+    auto ldcDim = getLeadingDim(memrefC);
+    if (failed(ldcDim))
+      return failure();
+    int64_t ldc = *ldcDim;
+
+    DenseI64ArrayAttr dims = DenseI64ArrayAttr::get(
+        rewriter.getContext(), ArrayRef<int64_t>{m, n, lda, ldb, ldc});
+    xsmm::TernaryKindAttr attr = xsmm::TernaryKindAttr::get(
+        mulAddOp.getContext(), xsmm::TernaryKind::MULADD);
+    Value dispatched = rewriter.create<xsmm::TernaryDispatchOp>(
+        loc, rewriter.getI64Type(), attr, dims,
+        getDataTypeAttr(rewriter.getContext(), memrefC.getElementType()),
+        /*computeType=*/nullptr, /*outputType=*/nullptr);
+
+    SmallVector<Value, 4> invokeOperands;
+    invokeOperands.push_back(dispatched);
+    invokeOperands.append(mulAddOp->getOperands().begin(),
+                          mulAddOp->getOperands().end());
+    rewriter.replaceOpWithNewOp<xsmm::TernaryOp>(mulAddOp, attr,
+                                                 invokeOperands);
+    return success();
+  }
+};
+
 struct ConvertTppToXsmm : public ConvertTppToXsmmBase<ConvertTppToXsmm> {
   void runOnOperation() override {
     RewritePatternSet patterns(&getContext());
@@ -421,8 +554,11 @@ void mlir::tpp::populateTppToXsmmPatterns(RewritePatternSet &patterns) {
   patterns.add<ConvertTppIdentityOp,
                ConvertTppReluOp,
                ConvertTppAddOp,
+               ConvertTppMulAddOp,
                ConvertTppMatmulOp,
-               ConvertTppBrgemmOp>(patterns.getContext());
+               ConvertTppBrgemmOp,
+               ConvertTppFusedBrgemmOp,
+               ConvertTppOffsetBrgemmOp>(patterns.getContext());
   // clang-format on
 }
 
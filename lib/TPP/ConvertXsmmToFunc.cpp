@@ -7,6 +7,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "TPP/Dialect/Xsmm/XsmmAttr.h"
+#include "TPP/Dialect/Xsmm/XsmmDialect.h"
 #include "TPP/Dialect/Xsmm/XsmmOps.h"
 #include "TPP/Passes.h"
 #include "TPP/Transforms.h"
@@ -40,6 +41,10 @@ static SmallVector<Type> extractInvokeOperandTypes(OperandRange operands) {
   return results;
 }
 
+// Bare-pointer ABI: each memref becomes a pair (aligned pointer, offset) and the
+// runtime entry point is a plain C function, without `_mlir_ciface_xxx`
+// wrapper. The kernel already knows sizes and strides, so nothing else of the
+// descriptor is needed.
 static SmallVector<Type> extractInvokeOperandTypesForMeta(OperandRange operands,
                                                           IndexType indexType) {
   SmallVector<Type> results;
@@ -220,11 +225,14 @@ private:
   bool useMeta = false;
 };
 
+// Dispatch functions only take integers, thus they always go through the
+// `_mlir_ciface_xxx` interface: it does not add any marshalling and it lets the
+// runtime serve every dispatch from its kernel cache.
 static func::CallOp buildDispatchCall(Location loc,
                                       ArrayRef<Value> dispatchOperands,
                                       ArrayRef<Type> dispatchOperandTypes,
                                       ModuleOp module, FlatSymbolRefAttr fnName,
-                                      bool useMeta, PatternRewriter &rewriter) {
+                                      PatternRewriter &rewriter) {
   auto libFnType = rewriter.getFunctionType(
       dispatchOperandTypes, IntegerType::get(rewriter.getContext(), 64));
 
@@ -235,13 +243,8 @@ static func::CallOp buildDispatchCall(Location loc,
                                std::prev(module.getBody()->end()));
     func::FuncOp funcOp =
         rewriter.create<func::FuncOp>(loc, fnName.getValue(), libFnType);
-    if (!useMeta) {
-      // Insert a function attribute that will trigger the emission of the
-      // corresponding `_mlir_ciface_xxx` interface so that external libraries
-      // see a normalized ABI.
-      funcOp->setAttr(LLVM::LLVMDialect::getEmitCWrapperAttrName(),
-                      UnitAttr::get(rewriter.getContext()));
-    }
+    funcOp->setAttr(LLVM::LLVMDialect::getEmitCWrapperAttrName(),
+                    UnitAttr::get(rewriter.getContext()));
     funcOp.setPrivate();
   }
 
@@ -252,16 +255,19 @@ static func::CallOp buildDispatchCall(Location loc,
 }
 
 struct ConvertTernaryDispatch : public OpRewritePattern<TernaryDispatchOp> {
-  ConvertTernaryDispatch(MLIRContext *context, bool useMeta,
-                         PatternBenefit benefit = 1)
-      : OpRewritePattern<TernaryDispatchOp>(context, benefit),
-        useMeta(useMeta) {}
+  using OpRewritePattern<TernaryDispatchOp>::OpRewritePattern;
 
   LogicalResult matchAndRewrite(TernaryDispatchOp dispatchOp,
                                 PatternRewriter &rewriter) const override {
     Location loc = dispatchOp.getLoc();
     std::string kindAsString = stringifyEnum(dispatchOp.getKind()).str();
     std::string typeAsString = stringifyEnum(dispatchOp.getDataType()).str();
+    // Mixed-precision kernels are suffixed with input, compute and output
+    // types, e.g., xsmm_brgemm_dispatch_bf16_f32_f32.
+    if (dispatchOp.isMixedPrecision())
+      typeAsString +=
+          "_" + stringifyEnum(dispatchOp.getResolvedComputeType()).str() +
+          "_" + stringifyEnum(dispatchOp.getResolvedOutputType()).str();
     kindAsString = "xsmm_" + kindAsString + "_dispatch_" + typeAsString;
     FlatSymbolRefAttr fnName =
         SymbolRefAttr::get(rewriter.getContext(), kindAsString);
@@ -280,20 +286,14 @@ struct ConvertTernaryDispatch : public OpRewritePattern<TernaryDispatchOp> {
     }
     func::CallOp call =
         buildDispatchCall(loc, dispatchOperands, dispatchOperandTypes, module,
-                          fnName, useMeta, rewriter);
+                          fnName, rewriter);
     rewriter.replaceOp(dispatchOp, call.getResult(0));
     return success();
   }
-
-private:
-  bool useMeta = false;
 };
 
 struct ConvertBinaryDispatch : public OpRewritePattern<BinaryDispatchOp> {
-  ConvertBinaryDispatch(MLIRContext *context, bool useMeta,
-                        PatternBenefit benefit = 1)
-      : OpRewritePattern<BinaryDispatchOp>(context, benefit), useMeta(useMeta) {
-  }
+  using OpRewritePattern<BinaryDispatchOp>::OpRewritePattern;
 
   LogicalResult matchAndRewrite(BinaryDispatchOp dispatchOp,
                                 PatternRewriter &rewriter) const override {
@@ -328,19 +328,14 @@ struct ConvertBinaryDispatch : public OpRewritePattern<BinaryDispatchOp> {
 
     func::CallOp call =
         buildDispatchCall(loc, dispatchOperands, dispatchOperandTypes, module,
-                          fnName, useMeta, rewriter);
+                          fnName, rewriter);
     rewriter.replaceOp(dispatchOp, call.getResult(0));
     return success();
   }
-
-private:
-  bool useMeta = false;
 };
 
 struct ConvertUnaryDispatch : public OpRewritePattern<UnaryDispatchOp> {
-  ConvertUnaryDispatch(MLIRContext *context, bool useMeta,
-                       PatternBenefit benefit = 1)
-      : OpRewritePattern<UnaryDispatchOp>(context, benefit), useMeta(useMeta) {}
+  using OpRewritePattern<UnaryDispatchOp>::OpRewritePattern;
 
   LogicalResult matchAndRewrite(UnaryDispatchOp dispatchOp,
                                 PatternRewriter &rewriter) const override {
@@ -376,21 +371,285 @@ struct ConvertUnaryDispatch : public OpRewritePattern<UnaryDispatchOp> {
 
     func::CallOp call =
         buildDispatchCall(loc, dispatchOperands, dispatchOperandTypes, module,
-                          fnName, useMeta, rewriter);
+                          fnName, rewriter);
     rewriter.replaceOp(dispatchOp, call.getResult(0));
     return success();
   }
-
-private:
-  bool useMeta = false;
 };
 
+// Name of the global holding the hoisted kernels.
+static constexpr StringLiteral kKernelTableName = "xsmm_kernel_table";
+
+// Return the name of the function filling the kernel table: `<module>_init`,
+// or `xsmm_init` if the module has no name.
+static std::string getDispatchInitFuncName(ModuleOp module) {
+  if (Optional<StringRef> moduleName = module.getSymName())
+    return (*moduleName + "_init").str();
+  return "xsmm_init";
+}
+
+// Two dispatch operations produce the same kernel if they have the same name
+// and the same attributes (all their inputs are attributes).
+using DispatchKey = std::pair<void *, Attribute>;
+static DispatchKey getDispatchKey(Operation *op) {
+  return {op->getName().getAsOpaquePointer(), op->getAttrDictionary()};
+}
+
+// Collect every distinct dispatch operation in the module into a global
+// kernel table filled once by a generated init function, and replace each
+// dispatch with a load from the table. The dispatches cloned into the init
+// function are then lowered to runtime calls by the usual patterns.
+static LogicalResult hoistDispatchOps(ModuleOp module) {
+  SmallVector<Operation *> dispatchOps;
+  module.walk([&](Operation *op) {
+    if (isa<TernaryDispatchOp, BinaryDispatchOp, UnaryDispatchOp>(op))
+      dispatchOps.push_back(op);
+  });
+  if (dispatchOps.empty())
+    return success();
+
+  std::string initFuncName = getDispatchInitFuncName(module);
+  if (module.lookupSymbol(initFuncName))
+    return module.emitError("symbol '") << initFuncName << "' already defined";
+  if (module.lookupSymbol(kKernelTableName))
+    return module.emitError("symbol '")
+           << kKernelTableName << "' already defined";
+
+  DenseMap<DispatchKey, int64_t> kernelIndices;
+  SmallVector<Operation *> uniqueDispatchOps;
+  for (Operation *op : dispatchOps) {
+    if (kernelIndices.try_emplace(getDispatchKey(op), uniqueDispatchOps.size())
+            .second)
+      uniqueDispatchOps.push_back(op);
+  }
+
+  OpBuilder builder(module.getContext());
+  Location loc = module.getLoc();
+  MemRefType tableType =
+      MemRefType::get({static_cast<int64_t>(uniqueDispatchOps.size())},
+                      builder.getI64Type());
+
+  builder.setInsertionPointToStart(module.getBody());
+  auto table = builder.create<memref::GlobalOp>(
+      loc, builder.getStringAttr(kKernelTableName),
+      /*sym_visibility=*/builder.getStringAttr("private"),
+      TypeAttr::get(tableType), /*initial_value=*/builder.getUnitAttr(),
+      /*constant=*/UnitAttr(), /*alignment=*/IntegerAttr());
+
+  builder.setInsertionPointAfter(table);
+  func::FuncOp initFunc = builder.create<func::FuncOp>(
+      loc, initFuncName, builder.getFunctionType({}, {}));
+  initFunc->setAttr(XsmmDialect::getDispatchInitAttrName(),
+                    builder.getUnitAttr());
+  initFunc->setAttr(LLVM::LLVMDialect::getEmitCWrapperAttrName(),
+                    builder.getUnitAttr());
+  builder.setInsertionPointToStart(initFunc.addEntryBlock());
+  Value initTable =
+      builder.create<memref::GetGlobalOp>(loc, tableType, kKernelTableName);
+  for (auto &en : llvm::enumerate(uniqueDispatchOps)) {
+    Operation *dispatch = builder.clone(*en.value());
+    Value pos = builder.create<arith::ConstantIndexOp>(loc, en.index());
+    builder.create<memref::StoreOp>(loc, dispatch->getResult(0), initTable,
+                                    pos);
+  }
+  builder.create<func::ReturnOp>(loc);
+
+  for (Operation *op : dispatchOps) {
+    Location dispatchLoc = op->getLoc();
+    builder.setInsertionPoint(op);
+    Value kernelTable = builder.create<memref::GetGlobalOp>(
+        dispatchLoc, tableType, kKernelTableName);
+    Value pos = builder.create<arith::ConstantIndexOp>(
+        dispatchLoc, kernelIndices.lookup(getDispatchKey(op)));
+    Value kernel =
+        builder.create<memref::LoadOp>(dispatchLoc, kernelTable, pos);
+    op->getResult(0).replaceAllUsesWith(kernel);
+    op->erase();
+  }
+  return success();
+}
+
+// Name of the global holding the source locations of the traced invocations.
+static constexpr StringLiteral kKernelSitesName = "xsmm_kernel_sites";
+
+// Name of the runtime function labelling the next invocation of the thread.
+static constexpr StringLiteral kTraceSiteFuncName = "xsmm_trace_site";
+
+// Print `loc` as `file:line:col` if it carries a file location, in the MLIR
+// syntax otherwise.
+static std::string getLocationString(Location loc) {
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  FileLineColLoc fileLoc;
+  loc->walk([&](Location nested) {
+    fileLoc = nested.dyn_cast<FileLineColLoc>();
+    return fileLoc ? WalkResult::interrupt() : WalkResult::advance();
+  });
+  if (fileLoc)
+    os << fileLoc.getFilename().getValue() << ":" << fileLoc.getLine() << ":"
+       << fileLoc.getColumn();
+  else
+    loc.print(os);
+  return os.str();
+}
+
+// Number every invocation of the module and precede it with a call to
+// `xsmm_trace_site(id, sites, offset)`, where `sites + offset` is the source
+// location of the invocation in a constant table of NUL-terminated strings.
+// The runtime labels the next kernel invocation of the thread with it, so that
+// the trace maps each kernel call back to the tpp operation it comes from.
+static LogicalResult insertTraceSiteCalls(ModuleOp module) {
+  SmallVector<Operation *> invokeOps;
+  module.walk([&](Operation *op) {
+    if (isa<TernaryOp, BinaryOp, UnaryOp>(op))
+      invokeOps.push_back(op);
+  });
+  if (invokeOps.empty())
+    return success();
+  if (module.lookupSymbol(kKernelSitesName))
+    return module.emitError("symbol '")
+           << kKernelSitesName << "' already defined";
+
+  std::string sites;
+  SmallVector<int64_t> siteOffsets;
+  for (Operation *op : invokeOps) {
+    siteOffsets.push_back(sites.size());
+    sites += getLocationString(op->getLoc());
+    sites.push_back('\0');
+  }
+
+  OpBuilder builder(module.getContext());
+  Location loc = module.getLoc();
+  IntegerType i8 = builder.getIntegerType(8);
+  MemRefType sitesType =
+      MemRefType::get({static_cast<int64_t>(sites.size())}, i8);
+  auto sitesData = DenseElementsAttr::get(
+      RankedTensorType::get(sitesType.getShape(), i8),
+      makeArrayRef(reinterpret_cast<const int8_t *>(sites.data()),
+                   sites.size()));
+  builder.setInsertionPointToStart(module.getBody());
+  builder.create<memref::GlobalOp>(
+      loc, builder.getStringAttr(kKernelSitesName),
+      /*sym_visibility=*/builder.getStringAttr("private"),
+      TypeAttr::get(sitesType), /*initial_value=*/sitesData,
+      /*constant=*/builder.getUnitAttr(), /*alignment=*/IntegerAttr());
+
+  if (!module.lookupSymbol(kTraceSiteFuncName)) {
+    builder.setInsertionPoint(module.getBody(),
+                              std::prev(module.getBody()->end()));
+    auto funcType = builder.getFunctionType(
+        {builder.getI64Type(), LLVM::LLVMPointerType::get(i8),
+         builder.getIndexType()},
+        {});
+    func::FuncOp funcOp =
+        builder.create<func::FuncOp>(loc, kTraceSiteFuncName, funcType);
+    funcOp.setPrivate();
+  }
+
+  for (auto &en : llvm::enumerate(invokeOps)) {
+    Operation *op = en.value();
+    Location siteLoc = op->getLoc();
+    builder.setInsertionPoint(op);
+    Value sitesTable = builder.create<memref::GetGlobalOp>(siteLoc, sitesType,
+                                                           kKernelSitesName);
+    SmallVector<Value> pointerAndOffset =
+        getMemRefOperandsUsingMetadata(builder, siteLoc, sitesTable);
+    Value siteOffset = builder.create<arith::AddIOp>(
+        siteLoc, pointerAndOffset[1],
+        builder.create<arith::ConstantIndexOp>(siteLoc,
+                                               siteOffsets[en.index()]));
+    Value siteId = builder.create<arith::ConstantOp>(
+        siteLoc, builder.getI64IntegerAttr(en.index()));
+    builder.create<func::CallOp>(
+        siteLoc, kTraceSiteFuncName, TypeRange(),
+        ValueRange{siteId, pointerAndOffset[0], siteOffset});
+  }
+  return success();
+}
+
+// Prefix of the globals holding the block offsets of batch-reduce over lists.
+static constexpr StringLiteral kBatchOffsetsName = "xsmm_batch_offsets";
+
+// Materialize the block offsets of every batch-reduce over lists as constant
+// globals of byte offsets, and pass them to the invocation as memref<Nxi64>
+// operands following the output. Identical lists share the same global.
+static LogicalResult materializeBatchOffsets(ModuleOp module) {
+  SmallVector<TernaryOp> invokeOps;
+  module.walk([&](TernaryOp op) {
+    if (op.getOffsetsA())
+      invokeOps.push_back(op);
+  });
+  if (invokeOps.empty())
+    return success();
+
+  OpBuilder builder(module.getContext());
+  Location loc = module.getLoc();
+  DenseMap<Attribute, memref::GlobalOp> globals;
+  auto getOrCreateGlobal = [&](ArrayRef<int64_t> offsets, Type elementType) {
+    int64_t elementBytes =
+        std::max<int64_t>(1, elementType.getIntOrFloatBitWidth() / 8);
+    SmallVector<int64_t> byteOffsets = llvm::to_vector(llvm::map_range(
+        offsets, [&](int64_t offset) { return offset * elementBytes; }));
+    RankedTensorType dataType = RankedTensorType::get(
+        {static_cast<int64_t>(byteOffsets.size())}, builder.getI64Type());
+    auto data = DenseElementsAttr::get(dataType, makeArrayRef(byteOffsets));
+    memref::GlobalOp &global = globals[data];
+    if (global)
+      return global;
+    std::string name =
+        (kBatchOffsetsName + "_" + Twine(globals.size() - 1)).str();
+    if (module.lookupSymbol(name))
+      return memref::GlobalOp();
+    builder.setInsertionPointToStart(module.getBody());
+    global = builder.create<memref::GlobalOp>(
+        loc, builder.getStringAttr(name),
+        /*sym_visibility=*/builder.getStringAttr("private"),
+        TypeAttr::get(
+            MemRefType::get(dataType.getShape(), builder.getI64Type())),
+        /*initial_value=*/data, /*constant=*/builder.getUnitAttr(),
+        /*alignment=*/IntegerAttr());
+    return global;
+  };
+
+  for (TernaryOp op : invokeOps) {
+    // Operands: kernel, A, B, C, batch size.
+    Type elementType =
+        op.getInputs()[1].getType().cast<MemRefType>().getElementType();
+    memref::GlobalOp globalA =
+        getOrCreateGlobal(*op.getOffsetsA(), elementType);
+    memref::GlobalOp globalB =
+        getOrCreateGlobal(*op.getOffsetsB(), elementType);
+    if (!globalA || !globalB)
+      return module.emitError("symbol '")
+             << kBatchOffsetsName << "_*' already defined";
+    builder.setInsertionPoint(op);
+    SmallVector<Value> operands = llvm::to_vector(op.getInputs());
+    Value batchSize = operands.pop_back_val();
+    for (memref::GlobalOp global : {globalA, globalB})
+      operands.push_back(builder.create<memref::GetGlobalOp>(
+          op.getLoc(), global.getType(), global.getSymName()));
+    operands.push_back(batchSize);
+    builder.create<TernaryOp>(op.getLoc(), op.getCalleeAttr(), operands);
+    op.erase();
+  }
+  return success();
+}
+
 struct ConvertXsmmToFunc : public ConvertXsmmToFuncBase<ConvertXsmmToFunc> {
   ConvertXsmmToFunc() = default;
-  ConvertXsmmToFunc(bool useExtractMetaData) {
+  ConvertXsmmToFunc(bool useExtractMetaData, bool hoistDispatch,
+                    bool traceKernelSites) {
     this->useExtractMetaData = useExtractMetaData;
+    this->hoistDispatch = hoistDispatch;
+    this->traceKernelSites = traceKernelSites;
   }
   void runOnOperation() override {
+    if (failed(materializeBatchOffsets(getOperation())))
+      return signalPassFailure();
+    if (hoistDispatch && failed(hoistDispatchOps(getOperation())))
+      return signalPassFailure();
+    if (traceKernelSites && failed(insertTraceSiteCalls(getOperation())))
+      return signalPassFailure();
     RewritePatternSet patterns(&getContext());
     tpp::populateXsmmToFuncPatterns(patterns, useExtractMetaData);
     (void)applyPatternsAndFoldGreedily(getOperation(), std::move(patterns));
@@ -406,10 +665,18 @@ void mlir::tpp::populateXsmmToFuncPatterns(RewritePatternSet &patterns,
       patterns.getContext(), useExtractMetaData);
   patterns
       .add<ConvertTernaryDispatch, ConvertBinaryDispatch, ConvertUnaryDispatch>(
-          patterns.getContext(), useExtractMetaData);
+          patterns.getContext());
 }
 
 std::unique_ptr<OperationPass<ModuleOp>>
 mlir::tpp::createConvertXsmmToFuncPass() {
   return std::make_unique<ConvertXsmmToFunc>();
 }
+
+std::unique_ptr<OperationPass<ModuleOp>>
+mlir::tpp::createConvertXsmmToFuncPass(bool useExtractMetaData,
+                                       bool hoistDispatch,
+                                       bool traceKernelSites) {
+  return std::make_unique<ConvertXsmmToFunc>(useExtractMetaData, hoistDispatch,
+                                             traceKernelSites);
+}
@@ -0,0 +1,139 @@
+//===- CostModel.cpp - Analytical cost model for tile sizes -----*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "TPP/CostModel.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace mlir;
+using namespace mlir::tpp;
+
+static int64_t ceilDiv(int64_t lhs, int64_t rhs) {
+  return (lhs + rhs - 1) / rhs;
+}
+
+// Bandwidth of the innermost cache level that holds `footprintBytes`.
+static double getBytesPerCycle(int64_t footprintBytes,
+                               const TargetInfo &target) {
+  if (footprintBytes <= target.l1CacheBytes)
+    return target.l1BytesPerCycle;
+  if (footprintBytes <= target.l2CacheBytes)
+    return target.l2BytesPerCycle;
+  return target.memBytesPerCycle;
+}
+
+// The loop nest is M (outermost), N, then K. Each call computes a
+// [tileM x tileN] block using a register tile of `regRows` rows by `regVecs`
+// vectors: per K step it issues regRows * regVecs FMAs, regRows broadcasts of
+// A and regVecs loads of B. B is streamed again for every register row block
+// and A for every register vector block, which is only visible when the tile
+// working set does not fit in L1.
+double mlir::tpp::estimateMatmulCost(int64_t m, int64_t n, int64_t k,
+                                     int64_t tileM, int64_t tileN,
+                                     int64_t tileK, int64_t elementBytes,
+                                     bool batchReduce,
+                                     const TargetInfo &target) {
+  int64_t lanes = std::max<int64_t>(1, target.simdBytes / elementBytes);
+  int64_t vectorsN = ceilDiv(tileN, lanes);
+  int64_t gridM = m / tileM;
+  int64_t gridN = n / tileN;
+  int64_t gridK = k / tileK;
+
+  // Micro-kernel compute, with masked vectors when tileN is not a multiple of
+  // the SIMD width.
+  int64_t regVecs = std::min<int64_t>(vectorsN, 4);
+  int64_t regRows = std::max<int64_t>(
+      1, std::min(tileM, (target.numVectorRegisters - regVecs - 1) / regVecs));
+  double cyclesPerStep =
+      std::max(double(regRows * regVecs) / target.fmaPerCycle,
+               double(regRows + regVecs) / target.loadsPerCycle);
+  double rowBlocks = double(gridM * ceilDiv(tileM, regRows));
+  double vecBlocks = double(gridN * ceilDiv(vectorsN, regVecs));
+  double compute = cyclesPerStep * rowBlocks * vecBlocks * k;
+
+  // Call overhead: the output block is loaded and stored once per call, and a
+  // BRGEMM pays an address computation per batch entry.
+  int64_t numCalls = gridM * gridN * (batchReduce ? 1 : gridK);
+  double overhead =
+      numCalls * (target.callOverheadCycles + 2.0 * tileM * vectorsN +
+                  (batchReduce ? 4.0 * gridK : 0.0));
+
+  // Memory traffic. Every operand comes from memory once. The row panel of A
+  // is reused across N, the whole B across M. Within a call the operands are
+  // served from the level holding the tile working set.
+  int64_t tileBytes =
+      (tileM * tileK + tileK * tileN + tileM * tileN) * elementBytes;
+  double tileBytesPerCycle = getBytesPerCycle(tileBytes, target);
+  double bytesA = double(m * k * elementBytes);
+  double bytesB = double(k * n * elementBytes);
+  double bytesC = double(m * n * elementBytes);
+  double memory = (bytesA + bytesB + 2 * bytesC) / target.memBytesPerCycle;
+  memory += bytesA * gridN /
+            getBytesPerCycle(tileM * k * elementBytes, target);
+  memory += bytesB * gridM / getBytesPerCycle(k * n * elementBytes, target);
+  if (tileBytes > target.l1CacheBytes)
+    memory += (bytesA * gridN * (ceilDiv(vectorsN, regVecs) - 1) +
+               bytesB * gridM * (ceilDiv(tileM, regRows) - 1)) /
+              tileBytesPerCycle;
+  // Without batch-reduce the output block is reloaded for every K tile.
+  if (!batchReduce && gridK > 1)
+    memory += 2 * bytesC * gridK / tileBytesPerCycle;
+
+  // Each thread runs ceil(blocks / threads) output blocks.
+  double cost = compute + overhead + memory;
+  int64_t numBlocks = gridM * gridN;
+  int64_t waves = ceilDiv(numBlocks, std::max<int64_t>(1, target.numThreads));
+  return cost * waves / numBlocks;
+}
+
+// Divisors of `dim`, largest first.
+static std::vector<int64_t> getDivisors(int64_t dim) {
+  std::vector<int64_t> divisors;
+  for (int64_t divisor = dim; divisor > 0; divisor--)
+    if (dim % divisor == 0)
+      divisors.push_back(divisor);
+  return divisors;
+}
+
+// Exhaustive search over the divisors. A candidate must be at least 1% cheaper
+// than the current best to replace it, thus larger tiles win near-ties.
+static MatmulTileSizes selectTileSizes(int64_t m, int64_t n, int64_t k,
+                                       int64_t elementBytes, bool batchReduce,
+                                       const TargetInfo &target) {
+  MatmulTileSizes best = {m, n, k,
+                          estimateMatmulCost(m, n, k, m, n, k, elementBytes,
+                                             batchReduce, target)};
+  std::vector<int64_t> divisorsM = getDivisors(m);
+  std::vector<int64_t> divisorsN = getDivisors(n);
+  std::vector<int64_t> divisorsK = getDivisors(k);
+  for (int64_t tileM : divisorsM) {
+    for (int64_t tileN : divisorsN) {
+      for (int64_t tileK : divisorsK) {
+        double cost = estimateMatmulCost(m, n, k, tileM, tileN, tileK,
+                                         elementBytes, batchReduce, target);
+        if (cost < 0.99 * best.cost)
+          best = {tileM, tileN, tileK, cost};
+      }
+    }
+  }
+  return best;
+}
+
+MatmulTileSizes mlir::tpp::selectMatmulTileSizes(int64_t m, int64_t n,
+                                                 int64_t k,
+                                                 int64_t elementBytes,
+                                                 const TargetInfo &target) {
+  return selectTileSizes(m, n, k, elementBytes, /*batchReduce=*/false, target);
+}
+
+MatmulTileSizes mlir::tpp::selectMatmulBlockingFactors(
+    int64_t m, int64_t n, int64_t k, int64_t elementBytes,
+    const TargetInfo &target) {
+  return selectTileSizes(m, n, k, elementBytes, /*batchReduce=*/true, target);
+}
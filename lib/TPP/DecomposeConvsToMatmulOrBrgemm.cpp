@@ -14,7 +14,10 @@
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/Linalg/Transforms/Transforms.h"
+#include "mlir/Dialect/Linalg/Utils/Utils.h"
+#include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "llvm/ADT/SmallBitVector.h"
 
 using namespace mlir;
 
@@ -32,30 +35,16 @@ static bool hasStaticShape(Value image, Value filter, Value output) {
            (!outputType.hasStaticShape()));
 }
 
-// return true if the conv has stride != 1.
-template <typename CONVOP> static bool hasStride(CONVOP convOp) {
-  if (DenseIntElementsAttr strides = convOp.getStrides()) {
-    auto values = strides.getValues<APInt>();
-    if (llvm::any_of(values, [](const APInt &value) {
-          return value.getSExtValue() != 1;
-        })) {
-      return true;
-    }
-  }
-  return false;
-}
-
-// return true if the conv has dilation != 1.
-template <typename CONVOP> static bool hasDilation(CONVOP convOp) {
-  if (DenseIntElementsAttr dilations = convOp.getDilations()) {
-    auto values = dilations.getValues<APInt>();
-    if (llvm::any_of(values, [](const APInt &value) {
-          return value.getSExtValue() != 1;
-        })) {
-      return true;
-    }
-  }
-  return false;
+// Return the coefficient of the dimension `pos` in `expr`, a linear
+// combination of the `numDims` dimensions.
+static int64_t getCoefficientOfDim(AffineExpr expr, unsigned pos,
+                                   unsigned numDims) {
+  MLIRContext *ctx = expr.getContext();
+  SmallVector<AffineExpr> zeros(numDims, getAffineConstantExpr(0, ctx));
+  SmallVector<AffineExpr> unit = zeros;
+  unit[pos] = getAffineConstantExpr(1, ctx);
+  return expr.replaceDims(unit).cast<AffineConstantExpr>().getValue() -
+         expr.replaceDims(zeros).cast<AffineConstantExpr>().getValue();
 }
 
 // Check dimension at index 'i' and 'j'. If both are '1' return true
@@ -71,6 +60,46 @@ static bool hasFilterWithRandSEqualOne(OpOperand *filter, unsigned i,
   return ((filterShape[i] == 1) && (filterShape[j] == 1));
 }
 
+// Materialize the `upTo` outermost loops of `linalgOp` and replace it with
+// the loop nest. `innerOpBuilder` creates the operation computing the body of
+// the nest, given the induction variables and the operands to slice.
+static LogicalResult materializeOuterLoops(
+    RewriterBase &rewriter, linalg::GenericOp linalgOp, unsigned upTo,
+    function_ref<linalg::GenericOp(OpBuilder &, Location, ValueRange,
+                                   ValueRange)>
+        innerOpBuilder) {
+  FailureOr<SmallVector<Range>> maybeLoopRanges =
+      mlir::utils::getLoopsToMaterialize(rewriter, linalgOp, upTo);
+  if (failed(maybeLoopRanges))
+    return failure();
+
+  SmallVector<Value> ivs, tensorResults;
+  auto bodyBuilder = [&](OpBuilder &builder, Location loc, ValueRange localIvs,
+                         ValueRange operandValuesToUse) -> scf::ValueVector {
+    ivs.assign(localIvs.begin(), localIvs.end());
+    linalg::GenericOp innerOp =
+        innerOpBuilder(builder, loc, localIvs, operandValuesToUse);
+    tensorResults = linalg::insertSlicesBack(
+        builder, loc, linalgOp, innerOp->getOperands(), innerOp->getResults());
+    return scf::ValueVector(tensorResults.begin(), tensorResults.end());
+  };
+  linalg::GenerateLoopNest<scf::ForOp>::doit(
+      rewriter, linalgOp.getLoc(), *maybeLoopRanges, linalgOp,
+      linalgOp.getIteratorTypesArray(), bodyBuilder);
+
+  // Get the tensor results from the outermost loop.
+  Operation *outermostLoop = nullptr;
+  for (Value iv : ivs) {
+    if (auto arg = iv.dyn_cast<BlockArgument>()) {
+      outermostLoop = arg.getOwner()->getParentOp();
+      break;
+    }
+  }
+  rewriter.replaceOp(linalgOp, outermostLoop ? outermostLoop->getResults()
+                                             : tensorResults);
+  return success();
+}
+
 struct MapConv2DNhwcHwcfToMatmul : OpRewritePattern<linalg::GenericOp> {
   using OpRewritePattern::OpRewritePattern;
 
@@ -158,11 +187,6 @@ struct GeneralizeConv2DNhwcHwcf : OpRewritePattern<linalg::Conv2DNhwcHwcfOp> {
 
   LogicalResult matchAndRewrite(linalg::Conv2DNhwcHwcfOp convOp,
                                 PatternRewriter &rewriter) const override {
-    // do not handle convolutions with dilation and strides.
-    if (hasStride<linalg::Conv2DNhwcHwcfOp>(convOp) ||
-        hasDilation<linalg::Conv2DNhwcHwcfOp>(convOp))
-      return failure();
-
     // [N][H][W][C]
     Value image = convOp.image();
     // [R][S][C][K]
@@ -193,11 +217,6 @@ struct BlockConv2DNchwFchw : OpRewritePattern<linalg::Conv2DNchwFchwOp> {
 
   LogicalResult
   blockConv2DNchwFchwPreconditions(linalg::Conv2DNchwFchwOp convOp) const {
-    // do not handle convolutions with dilation and strides.
-    if (hasStride<linalg::Conv2DNchwFchwOp>(convOp) ||
-        hasDilation<linalg::Conv2DNchwFchwOp>(convOp))
-      return failure();
-
     // [N][C][H][W]
     Value image = convOp.image();
     // [K][C][R][S]
@@ -332,7 +351,8 @@ struct DecomposeConv2DNchwFchw : OpRewritePattern<linalg::GenericOp> {
 };
 
 // Prepare for BRGEMM. Requires R = S = 1. The pattern collapses
-// H and W on the image and P and Q on the output.
+// H and W on the image and P and Q on the output. A strided image is
+// subsampled first.
 struct CollapseFilterAndImage : OpRewritePattern<linalg::GenericOp> {
   using OpRewritePattern::OpRewritePattern;
 
@@ -390,10 +410,10 @@ struct CollapseFilterAndImage : OpRewritePattern<linalg::GenericOp> {
   }
 
   // Collapse dimension at index 'startCollapse' to 'endCollapse'.
-  Type getCollapsedType(OpOperand *operand, size_t startCollapse,
+  Type getCollapsedType(Type type, size_t startCollapse,
                         size_t endCollapse) const {
     assert(endCollapse > startCollapse && "expect >");
-    ShapedType operandType = operand->get().getType().cast<ShapedType>();
+    ShapedType operandType = type.cast<ShapedType>();
     size_t rank = operandType.getRank();
     ArrayRef<int64_t> oldShape = operandType.getShape();
     SmallVector<int64_t> newShape;
@@ -414,11 +434,60 @@ struct CollapseFilterAndImage : OpRewritePattern<linalg::GenericOp> {
     assert(false && "expect tensor or memref");
   }
 
+  // Return the strides of the convolution along H and W, read from the image
+  // access: [original] = N K P Q k C R S c.
+  std::pair<int64_t, int64_t> getStrides(linalg::GenericOp linalgOp) const {
+    AffineMap imageMap =
+        linalgOp.getMatchingIndexingMap(linalgOp.getInputOperands()[0]);
+    unsigned numDims = imageMap.getNumDims();
+    return {getCoefficientOfDim(imageMap.getResult(2), /*P=*/2, numDims),
+            getCoefficientOfDim(imageMap.getResult(3), /*Q=*/3, numDims)};
+  }
+
+  // Extract the pixels of the image read with R = S = 1: with strides, one
+  // every `stride` pixels along H and W. Afterward H = P and W = Q as in the
+  // unit stride case.
+  Value getImageWithUnitStrides(linalg::GenericOp linalgOp, Type imageType,
+                                std::pair<int64_t, int64_t> strides,
+                                PatternRewriter &rewriter) const {
+    Value image = linalgOp.getInputOperands()[0]->get();
+    if (image.getType() == imageType)
+      return image;
+    ArrayRef<int64_t> shape = imageType.cast<ShapedType>().getShape();
+    SmallVector<OpFoldResult> offsets(shape.size(), rewriter.getIndexAttr(0));
+    SmallVector<OpFoldResult> sizes =
+        getAsOpFoldResult(rewriter.getI64ArrayAttr(shape));
+    SmallVector<OpFoldResult> sliceStrides = {
+        rewriter.getIndexAttr(1), rewriter.getIndexAttr(1),
+        rewriter.getIndexAttr(strides.first),
+        rewriter.getIndexAttr(strides.second), rewriter.getIndexAttr(1)};
+    return rewriter.create<tensor::ExtractSliceOp>(
+        linalgOp.getLoc(), imageType.cast<RankedTensorType>(), image, offsets,
+        sizes, sliceStrides);
+  }
+
   LogicalResult matchAndRewrite(linalg::GenericOp linalgOp,
                                 PatternRewriter &rewriter) const override {
     if (failed(CollapseFilterPreconditions(linalgOp)))
       return failure();
 
+    // With strides the image is subsampled to [N][C'][P][Q][c], which is only
+    // possible on tensors: a strided view of a buffer cannot be collapsed.
+    std::pair<int64_t, int64_t> strides = getStrides(linalgOp);
+    OpOperand *image = linalgOp.getInputOperands()[0];
+    OpOperand *output = linalgOp.getOutputOperands()[0];
+    ShapedType imageType = image->get().getType().cast<ShapedType>();
+    if (strides.first != 1 || strides.second != 1) {
+      if (!imageType.isa<RankedTensorType>())
+        return failure();
+      ArrayRef<int64_t> outputShape =
+          output->get().getType().cast<ShapedType>().getShape();
+      SmallVector<int64_t> shape = llvm::to_vector(imageType.getShape());
+      shape[2] = outputShape[2];
+      shape[3] = outputShape[3];
+      imageType = RankedTensorType::get(shape, imageType.getElementType());
+    }
+
     // [original] = N K P Q k C R S c (R and S are 1)
     // [drop R and S] = N K P Q k C c
     // [collapse P and Q ] = N K P0 k C c
@@ -441,32 +510,31 @@ struct CollapseFilterAndImage : OpRewritePattern<linalg::GenericOp> {
         getReductionIteratorTypeName(), getReductionIteratorTypeName()};
 
     Location loc = linalgOp.getLoc();
-    OpOperand *image = linalgOp.getInputOperands()[0];
-    Type newImageType = getCollapsedType(image, 2, 3);
+    Type newImageType = getCollapsedType(imageType, 2, 3);
     auto reassociationImage = getReassociationIndicesForCollapse(
-        image->get().getType().cast<ShapedType>().getShape(),
-        newImageType.cast<ShapedType>().getShape());
+        imageType.getShape(), newImageType.cast<ShapedType>().getShape());
     if (!reassociationImage)
       return failure();
 
     OpOperand *filter = linalgOp.getInputOperands()[1];
-    Type newFilterType = getCollapsedType(filter, 1, 3);
+    Type newFilterType = getCollapsedType(filter->get().getType(), 1, 3);
     auto reassociationFilter = getReassociationIndicesForCollapse(
         filter->get().getType().cast<ShapedType>().getShape(),
         newFilterType.cast<ShapedType>().getShape());
     if (!reassociationFilter)
       return failure();
 
-    OpOperand *output = linalgOp.getOutputOperands()[0];
-    Type newOutputType = getCollapsedType(output, 2, 3);
+    Type newOutputType = getCollapsedType(output->get().getType(), 2, 3);
     auto reassociationOutput = getReassociationIndicesForCollapse(
         output->get().getType().cast<ShapedType>().getShape(),
         newOutputType.cast<ShapedType>().getShape());
     if (!reassociationOutput)
       return failure();
 
+    Value unitStridesImage =
+        getImageWithUnitStrides(linalgOp, imageType, strides, rewriter);
     Value collapsedImage = collapse(
-        image->get(), newImageType,
+        unitStridesImage, newImageType,
         getReassociationIndicesAttribute(rewriter, *reassociationImage), loc,
         rewriter);
 
@@ -563,6 +631,412 @@ struct MapToBRGEMM : OpRewritePattern<linalg::GenericOp> {
   }
 };
 
+// Map a blocked convolution with R or S != 1 to an offset-based BRGEMM. The
+// filter taps join C' in the reduction: for each output row, the image blocks
+// read by the taps (c, r, s) are overlapping windows of the image, at offsets
+// linear in (c, r, s), and a single kernel call computes the row:
+//
+// N            [parallel]
+//  K'          [parallel]
+//   P          [parallel]
+//    C' R S    [reduction] // BRGEMM red dimensions
+//    /* GEMM */
+//    Q         [parallel]
+//     k        [parallel]
+//      c       [reduction]
+//        output[N][K'][P][Q][k] +=
+//          image[N][C'][P * sh + R * dh][Q + S * dw][c] *
+//          filter[K'][C'][R][S][c][k]
+//
+// The inner generic is marked as 'tpp.offset_brgemm' and becomes a
+// tpp.offset_brgemm once bufferized. Requires a unit stride along W for the
+// rows of an image block to be contiguous pixels.
+struct MapBlockedConvToOffsetBrgemm : OpRewritePattern<linalg::GenericOp> {
+  using OpRewritePattern::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(linalg::GenericOp linalgOp,
+                                PatternRewriter &rewriter) const override {
+    if (!tpp::isMarkedWithTpp(linalgOp, "tpp.BlockedConv2DNchwFchwOp"))
+      return failure();
+    if (linalgOp.hasDynamicShape() || linalgOp.getNumLoops() != 9)
+      return failure();
+    OpOperand *filter = linalgOp.getInputOperands()[1];
+    if (hasFilterWithRandSEqualOne(filter, /*Rpos=*/2, /*Spos=*/3))
+      return failure();
+
+    // [original] = N K' P Q k C' R S c.
+    AffineMap imageMap =
+        linalgOp.getMatchingIndexingMap(linalgOp.getInputOperands()[0]);
+    AffineExpr exprH = imageMap.getResult(2), exprW = imageMap.getResult(3);
+    int64_t strideH = getCoefficientOfDim(exprH, /*P=*/2, /*numDims=*/9);
+    int64_t dilationH = getCoefficientOfDim(exprH, /*R=*/6, /*numDims=*/9);
+    int64_t strideW = getCoefficientOfDim(exprW, /*Q=*/3, /*numDims=*/9);
+    int64_t dilationW = getCoefficientOfDim(exprW, /*S=*/7, /*numDims=*/9);
+    if (strideW != 1)
+      return rewriter.notifyMatchFailure(linalgOp, "expect unit stride on W");
+
+    SmallVector<int64_t> loopSizes = linalgOp.computeStaticLoopSizes();
+    int64_t sizeQ = loopSizes[3], sizeK = loopSizes[4];
+    int64_t sizeC = loopSizes[5], sizeR = loopSizes[6], sizeS = loopSizes[7];
+    int64_t sizeBlockC = loopSizes[8];
+
+    // Materialize N, K' and P.
+    MLIRContext *ctx = linalgOp.getContext();
+    auto brgemmBuilder = [&](OpBuilder &builder, Location loc,
+                             ValueRange localIvs,
+                             ValueRange operandValuesToUse) {
+      Value n = localIvs[0], blockK = localIvs[1], p = localIvs[2];
+      auto index = [&](int64_t value) -> OpFoldResult {
+        return builder.getIndexAttr(value);
+      };
+      AffineExpr d0;
+      bindDims(ctx, d0);
+      OpFoldResult row = makeComposedFoldedAffineApply(
+          builder, loc, AffineMap::get(1, 0, d0 * strideH), {p});
+
+      // [C'][(R - 1) * dh + 1][Q + (S - 1) * dw][c]
+      Value image = utils::getSliceOperand(
+          builder, linalgOp, operandValuesToUse[0],
+          {n, index(0), row, index(0), index(0)},
+          {index(1), index(sizeC), index((sizeR - 1) * dilationH + 1),
+           index(sizeQ + (sizeS - 1) * dilationW), index(sizeBlockC)},
+          SmallVector<OpFoldResult>(5, index(1)), /*desiredResultRank=*/4);
+      // [C'][R][S][c][k]
+      Value filter = utils::getSliceOperand(
+          builder, linalgOp, operandValuesToUse[1],
+          {blockK, index(0), index(0), index(0), index(0), index(0)},
+          {index(1), index(sizeC), index(sizeR), index(sizeS),
+           index(sizeBlockC), index(sizeK)},
+          SmallVector<OpFoldResult>(6, index(1)), /*desiredResultRank=*/5);
+      // [Q][k]
+      Value output = utils::getSliceOperand(
+          builder, linalgOp, operandValuesToUse[2],
+          {n, blockK, p, index(0), index(0)},
+          {index(1), index(1), index(1), index(sizeQ), index(sizeK)},
+          SmallVector<OpFoldResult>(5, index(1)), /*desiredResultRank=*/2);
+
+      //          C' R  S  Q  k  c
+      AffineExpr r1, r2, r3, p1, p2, r4;
+      bindDims(ctx, r1, r2, r3, p1, p2, r4);
+      AffineMap mapImg = AffineMap::get(
+          /*dims=*/6, /*symbols=*/0,
+          {r1, r2 * dilationH, p1 + r3 * dilationW, r4}, ctx);
+      AffineMap mapFil =
+          AffineMap::get(/*dims=*/6, /*symbols=*/0, {r1, r2, r3, r4, p2}, ctx);
+      AffineMap mapOut =
+          AffineMap::get(/*dims=*/6, /*symbols=*/0, {p1, p2}, ctx);
+      SmallVector<Type> resultTypes;
+      if (linalgOp.hasTensorSemantics())
+        resultTypes.push_back(output.getType());
+      linalg::GenericOp brgemm = builder.create<linalg::GenericOp>(
+          loc, resultTypes, ValueRange{image, filter}, ValueRange{output},
+          ArrayRef<AffineMap>{mapImg, mapFil, mapOut},
+          ArrayRef<StringRef>{
+              getReductionIteratorTypeName(), getReductionIteratorTypeName(),
+              getReductionIteratorTypeName(), getParallelIteratorTypeName(),
+              getParallelIteratorTypeName(), getReductionIteratorTypeName()},
+          /*doc=*/"", /*libraryCall=*/"tpp.offset_brgemm");
+      BlockAndValueMapping mapping;
+      linalgOp->getRegion(0).cloneInto(&brgemm.getRegion(), mapping);
+      return brgemm;
+    };
+    return materializeOuterLoops(rewriter, linalgOp, /*upTo=*/3,
+                                 brgemmBuilder);
+  }
+};
+
+// Block a DepthwiseConv2DNhwcHwc along the channels with the first blocking
+// factor. The pattern returns a generic operation marked as
+// 'tpp.BlockedDepthwiseConv2DNhwcHwcOp' on success.
+struct BlockDepthwiseConv2DNhwcHwc
+    : OpRewritePattern<linalg::DepthwiseConv2DNhwcHwcOp> {
+  BlockDepthwiseConv2DNhwcHwc(MLIRContext *context,
+                              ArrayRef<int64_t> blockingFactors,
+                              PatternBenefit benefit = 1)
+      : OpRewritePattern<linalg::DepthwiseConv2DNhwcHwcOp>(context, benefit),
+        blockingFactors(blockingFactors) {}
+
+  LogicalResult matchAndRewrite(linalg::DepthwiseConv2DNhwcHwcOp convOp,
+                                PatternRewriter &rewriter) const override {
+    // [N][H][W][C] * [R][S][C] -> [N][P][Q][C]
+    if (!hasStaticShape(convOp.image(), convOp.filter(),
+                        convOp.getOutputs()[0]))
+      return failure();
+    if (convOp.hasBufferSemantics() || blockingFactors.empty())
+      return failure();
+    ArrayRef<int64_t> channelTile =
+        ArrayRef<int64_t>(blockingFactors).take_front();
+    FailureOr<linalg::GenericOp> maybeGeneric =
+        mlir::linalgx::packDepthwiseConv2DNhwcHwcOp(
+            rewriter, convOp,
+            getAsOpFoldResult(rewriter.getI64ArrayAttr(channelTile)));
+    if (failed(maybeGeneric))
+      return failure();
+    (*maybeGeneric)
+        .setLibraryCallAttr(
+            rewriter.getStringAttr("tpp.BlockedDepthwiseConv2DNhwcHwcOp"));
+    return success();
+  }
+
+private:
+  SmallVector<int64_t> blockingFactors;
+};
+
+// Interchange iterators in a linalg.generic marked as
+// 'tpp.BlockedDepthwiseConv2DNhwcHwcOp' to expose an element-wise
+// multiply-add per filter tap.
+struct InterchangeIteratorsDepthwiseConv2DNhwcHwc
+    : OpRewritePattern<linalg::GenericOp> {
+  using OpRewritePattern::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(linalg::GenericOp linalgOp,
+                                PatternRewriter &rewriter) const override {
+    if (!tpp::isMarkedWithTpp(linalgOp, "tpp.BlockedDepthwiseConv2DNhwcHwcOp"))
+      return failure();
+
+    // clang-format off
+    // N            [parallel]
+    //  C'          [parallel - blocked]
+    //   P          [parallel]
+    //    Q         [parallel]
+    //     c        [parallel - block of C]
+    //      R       [reduction]
+    //       S      [reduction]
+    //        output[N][C'][P][Q][c] += image[N][C'][H][W][c] * filter[C'][R][S][c]
+
+    // expose the multiply-add by interchange:
+
+    // N            [parallel]
+    //  C'          [parallel - blocked]
+    //   P          [parallel]
+    //    R         [reduction]
+    //     S        [reduction]
+    //      Q       [parallel]
+    //       c      [parallel - block of C]
+    //        output[*][*][*][Q][c] += image[*][*][*][W][c] * filter[*][*][*][c]
+    // clang-format on
+
+    SmallVector<unsigned> interchangeVector = {0, 1, 2, 5, 6, 3, 4};
+    if (linalgOp.getNumLoops() != interchangeVector.size())
+      return failure();
+    FailureOr<linalg::GenericOp> maybeInterchange =
+        interchangeGenericOp(rewriter, linalgOp, interchangeVector);
+    if (failed(maybeInterchange))
+      return failure();
+    StringAttr name =
+        rewriter.getStringAttr("tpp.BlockedAndInterDepthwiseConv2DNhwcHwcOp");
+    (*maybeInterchange).setLibraryCallAttr(name);
+    return success();
+  }
+};
+
+// Map a blocked and interchanged depthwise convolution to a multiply-add per
+// output row and filter tap: the row of pixels [Q][c] read by the tap (r, s)
+// is multiplied by the taps [c] of the channel block, broadcast along Q. The
+// inner generic is marked as 'tpp.muladd' and becomes a tpp.muladd once
+// bufferized. A stride along W becomes the leading dimension of the image
+// row.
+struct MapBlockedDepthwiseConvToMulAdd : OpRewritePattern<linalg::GenericOp> {
+  using OpRewritePattern::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(linalg::GenericOp linalgOp,
+                                PatternRewriter &rewriter) const override {
+    if (!tpp::isMarkedWithTpp(linalgOp,
+                              "tpp.BlockedAndInterDepthwiseConv2DNhwcHwcOp"))
+      return failure();
+    if (linalgOp.hasDynamicShape() || linalgOp.getNumLoops() != 7)
+      return failure();
+
+    // [interchanged] = N C' P R S Q c.
+    AffineMap imageMap =
+        linalgOp.getMatchingIndexingMap(linalgOp.getInputOperands()[0]);
+    AffineExpr exprH = imageMap.getResult(2), exprW = imageMap.getResult(3);
+    int64_t strideH = getCoefficientOfDim(exprH, /*P=*/2, /*numDims=*/7);
+    int64_t dilationH = getCoefficientOfDim(exprH, /*R=*/3, /*numDims=*/7);
+    int64_t dilationW = getCoefficientOfDim(exprW, /*S=*/4, /*numDims=*/7);
+    int64_t strideW = getCoefficientOfDim(exprW, /*Q=*/5, /*numDims=*/7);
+
+    SmallVector<int64_t> loopSizes = linalgOp.computeStaticLoopSizes();
+    int64_t sizeQ = loopSizes[5], sizeBlockC = loopSizes[6];
+
+    // Materialize N, C', P, R and S.
+    MLIRContext *ctx = linalgOp.getContext();
+    auto mulAddBuilder = [&](OpBuilder &builder, Location loc,
+                             ValueRange localIvs,
+                             ValueRange operandValuesToUse) {
+      Value n = localIvs[0], blockC = localIvs[1], p = localIvs[2];
+      Value r = localIvs[3], s = localIvs[4];
+      auto index = [&](int64_t value) -> OpFoldResult {
+        return builder.getIndexAttr(value);
+      };
+      AffineExpr d0, d1;
+      bindDims(ctx, d0, d1);
+      OpFoldResult row = makeComposedFoldedAffineApply(
+          builder, loc, AffineMap::get(2, 0, d0 * strideH + d1 * dilationH),
+          {p, r});
+      OpFoldResult col = makeComposedFoldedAffineApply(
+          builder, loc, AffineMap::get(1, 0, d0 * dilationW), {s});
+
+      // [Q][c]
+      Value image = utils::getSliceOperand(
+          builder, linalgOp, operandValuesToUse[0],
+          {n, blockC, row, col, index(0)},
+          {index(1), index(1), index(1), index(sizeQ), index(sizeBlockC)},
+          {index(1), index(1), index(1), index(strideW), index(1)},
+          /*desiredResultRank=*/2);
+      // [c]
+      Value filter = utils::getSliceOperand(
+          builder, linalgOp, operandValuesToUse[1],
+          {blockC, r, s, index(0)},
+          {index(1), index(1), index(1), index(sizeBlockC)},
+          SmallVector<OpFoldResult>(4, index(1)), /*desiredResultRank=*/1);
+      // [Q][c]
+      Value output = utils::getSliceOperand(
+          builder, linalgOp, operandValuesToUse[2],
+          {n, blockC, p, index(0), index(0)},
+          {index(1), index(1), index(1), index(sizeQ), index(sizeBlockC)},
+          SmallVector<OpFoldResult>(5, index(1)), /*desiredResultRank=*/2);
+
+      //         Q   c
+      AffineExpr p1, p2;
+      bindDims(ctx, p1, p2);
+      AffineMap mapImg =
+          AffineMap::get(/*dims=*/2, /*symbols=*/0, {p1, p2}, ctx);
+      AffineMap mapFil = AffineMap::get(/*dims=*/2, /*symbols=*/0, {p2}, ctx);
+      AffineMap mapOut =
+          AffineMap::get(/*dims=*/2, /*symbols=*/0, {p1, p2}, ctx);
+      SmallVector<Type> resultTypes;
+      if (linalgOp.hasTensorSemantics())
+        resultTypes.push_back(output.getType());
+      linalg::GenericOp mulAdd = builder.create<linalg::GenericOp>(
+          loc, resultTypes, ValueRange{image, filter}, ValueRange{output},
+          ArrayRef<AffineMap>{mapImg, mapFil, mapOut},
+          ArrayRef<StringRef>{getParallelIteratorTypeName(),
+                              getParallelIteratorTypeName()},
+          /*doc=*/"", /*libraryCall=*/"tpp.muladd");
+      BlockAndValueMapping mapping;
+      linalgOp->getRegion(0).cloneInto(&mulAdd.getRegion(), mapping);
+      return mulAdd;
+    };
+    return materializeOuterLoops(rewriter, linalgOp, /*upTo=*/5,
+                                 mulAddBuilder);
+  }
+};
+
+// Block a Conv2DNgchwFgchw. The pattern returns a generic operation
+// marked as 'tpp.BlockedConv2DNgchwFgchwOp' on success.
+struct BlockConv2DNgchwFgchw : OpRewritePattern<linalg::Conv2DNgchwFgchwOp> {
+  BlockConv2DNgchwFgchw(MLIRContext *context,
+                        ArrayRef<int64_t> blockingFactors,
+                        PatternBenefit benefit = 1)
+      : OpRewritePattern<linalg::Conv2DNgchwFgchwOp>(context, benefit),
+        blockingFactors(blockingFactors) {}
+
+  LogicalResult matchAndRewrite(linalg::Conv2DNgchwFgchwOp convOp,
+                                PatternRewriter &rewriter) const override {
+    // [N][G][C][H][W] * [F][G][C][R][S] -> [N][G][F][P][Q]
+    if (!hasStaticShape(convOp.image(), convOp.filter(),
+                        convOp.getOutputs()[0]))
+      return failure();
+    if (convOp.hasBufferSemantics() || blockingFactors.empty())
+      return failure();
+    FailureOr<linalg::GenericOp> maybeGeneric =
+        mlir::linalgx::packConv2DNgchwFgchwOp(
+            rewriter, convOp,
+            getAsOpFoldResult(rewriter.getI64ArrayAttr(blockingFactors)));
+    if (failed(maybeGeneric))
+      return failure();
+    (*maybeGeneric)
+        .setLibraryCallAttr(
+            rewriter.getStringAttr("tpp.BlockedConv2DNgchwFgchwOp"));
+    return success();
+  }
+
+private:
+  SmallVector<int64_t> blockingFactors;
+};
+
+// Split a blocked grouped convolution into a blocked convolution per image
+// and group. The per-group generic is marked as 'tpp.BlockedConv2DNchwFchwOp'
+// and follows the same GEMM or BRGEMM mapping as a Conv2DNchwFchw:
+//
+// N                  [parallel]
+//  G                 [parallel]
+//   /* blocked Conv2DNchwFchw */
+//   F' P Q f C' R S c
+//     output[N][G][F'][P][Q][f] +=
+//       image[N][G][C'][H][W][c] * filter[G][F'][C'][R][S][c][f]
+struct SplitBlockedConv2DNgchwFgchwByGroup
+    : OpRewritePattern<linalg::GenericOp> {
+  using OpRewritePattern::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(linalg::GenericOp linalgOp,
+                                PatternRewriter &rewriter) const override {
+    if (!tpp::isMarkedWithTpp(linalgOp, "tpp.BlockedConv2DNgchwFgchwOp"))
+      return failure();
+    if (linalgOp.hasDynamicShape() || linalgOp.getNumLoops() != 10)
+      return failure();
+
+    // Drop G from the maps: it is the result 1 of the image and the output,
+    // and the result 0 of the filter.
+    // [original] = N G F' P Q f C' R S c.
+    llvm::SmallBitVector groupDim(linalgOp.getNumLoops());
+    groupDim.set(1);
+    SmallVector<AffineMap> indexingMaps = linalgOp.getIndexingMapsArray();
+    SmallVector<AffineMap> newIndexingMaps = {
+        compressDims(indexingMaps[0].dropResult(1), groupDim),
+        compressDims(indexingMaps[1].dropResult(0), groupDim),
+        compressDims(indexingMaps[2].dropResult(1), groupDim)};
+    SmallVector<StringRef> newIteratorTypes =
+        linalgOp.getIteratorTypesArray();
+    newIteratorTypes.erase(newIteratorTypes.begin() + 1);
+
+    // Materialize N and G.
+    auto convBuilder = [&](OpBuilder &builder, Location loc,
+                           ValueRange localIvs,
+                           ValueRange operandValuesToUse) {
+      Value n = localIvs[0], g = localIvs[1];
+      auto index = [&](int64_t value) -> OpFoldResult {
+        return builder.getIndexAttr(value);
+      };
+      // Slice the operand at `offsets` followed by zeros, with unit sizes
+      // along the leading `numUnitDims` dimensions.
+      auto slice = [&](Value operand, ArrayRef<OpFoldResult> offsets,
+                       unsigned numUnitDims) {
+        ArrayRef<int64_t> shape =
+            operand.getType().cast<ShapedType>().getShape();
+        SmallVector<OpFoldResult> sliceOffsets(offsets.begin(), offsets.end());
+        sliceOffsets.append(shape.size() - offsets.size(), index(0));
+        SmallVector<OpFoldResult> sizes(numUnitDims, index(1));
+        for (int64_t size : shape.drop_front(numUnitDims))
+          sizes.push_back(index(size));
+        return utils::getSliceOperand(
+            builder, linalgOp, operand, sliceOffsets, sizes,
+            SmallVector<OpFoldResult>(shape.size(), index(1)),
+            /*desiredResultRank=*/shape.size() - 1);
+      };
+      // [N][C'][H][W][c]
+      Value image = slice(operandValuesToUse[0], {n, g}, 2);
+      // [F'][C'][R][S][c][f]
+      Value filter = slice(operandValuesToUse[1], {g}, 1);
+      // [N][F'][P][Q][f]
+      Value output = slice(operandValuesToUse[2], {n, g}, 2);
+
+      SmallVector<Type> resultTypes;
+      if (linalgOp.hasTensorSemantics())
+        resultTypes.push_back(output.getType());
+      linalg::GenericOp conv = builder.create<linalg::GenericOp>(
+          loc, resultTypes, ValueRange{image, filter}, ValueRange{output},
+          newIndexingMaps, newIteratorTypes,
+          /*doc=*/"", /*libraryCall=*/"tpp.BlockedConv2DNchwFchwOp");
+      BlockAndValueMapping mapping;
+      linalgOp->getRegion(0).cloneInto(&conv.getRegion(), mapping);
+      return conv;
+    };
+    return materializeOuterLoops(rewriter, linalgOp, /*upTo=*/2, convBuilder);
+  }
+};
+
 // patterns for mapping a Conv2DNhwcHwcfOp to a GEMM operation.
 void populateConv2DNhwcHwcfOpDecomposePatterns(RewritePatternSet &patterns) {
   patterns.insert<GeneralizeConv2DNhwcHwcf, MapConv2DNhwcHwcfToMatmul,
@@ -580,6 +1054,9 @@ void populateconv2DNchwFchwOpDecomposePatterns(
   // collapsing: [N][K'][P + Q][k] = [N][C'][H + W][c] * [K'][C'][c][k]
   // [*][* ][P + Q][k] = [*][* ][H + W][c] * [* ][* ][c][k] // GEMM with c as red.
   // [*][* ][P + Q][k] = [*][C'][H + W][c] * [* ][C'][c][k] // BRGEMM with C' as red.
+  // else (R, S != 1 and unit stride on W)
+  // [*][* ][P][Q][k] = [*][C'][H][Q + S][c] * [* ][C'][R][S][c][k]
+  //   // offset-based BRGEMM with C', R and S as red.
   // clang-format on
 
   // This is for GEMM
@@ -595,11 +1072,31 @@ void populateconv2DNchwFchwOpDecomposePatterns(
     patterns.insert<BlockConv2DNchwFchw>(patterns.getContext(),
                                          blockingFactors);
     patterns.insert<CollapseFilterAndImage,
-                    InterchangeAfterBlockingAndCollapsing, MapToBRGEMM>(
-        patterns.getContext());
+                    InterchangeAfterBlockingAndCollapsing, MapToBRGEMM,
+                    MapBlockedConvToOffsetBrgemm>(patterns.getContext());
   }
 }
 
+// patterns for mapping a DepthwiseConv2DNhwcHwcOp to multiply-adds and a
+// Conv2DNgchwFgchwOp to a GEMM or BRGEMM per group.
+void populateDepthwiseAndGroupedConvDecomposePatterns(
+    RewritePatternSet &patterns, ArrayRef<int64_t> blockingFactors) {
+  // clang-format off
+  // depthwise: [N][P][Q][C] = [N][H][W][C] * [R][S][C]
+  // blocking: [N][C'][P][Q][c] = [N][C'][H][W][c] * [C'][R][S][c]
+  // [*][* ][*][Q][c] += [*][* ][*][W][c] * [* ][*][*][c] // muladd per R, S.
+  // grouped: [N][G][F][P][Q] = [N][G][C][H][W] * [F][G][C][R][S]
+  // blocking: [N][G][F'][P][Q][f] = [N][G][C'][H][W][c] * [G][F'][C'][R][S][c][f]
+  // [*][*][F'][P][Q][f] = [*][*][C'][H][W][c] * [*][F'][C'][R][S][c][f]
+  //   // blocked Conv2DNchwFchw per group.
+  // clang-format on
+  patterns.insert<BlockDepthwiseConv2DNhwcHwc, BlockConv2DNgchwFgchw>(
+      patterns.getContext(), blockingFactors);
+  patterns.insert<InterchangeIteratorsDepthwiseConv2DNhwcHwc,
+                  MapBlockedDepthwiseConvToMulAdd,
+                  SplitBlockedConv2DNgchwFgchwByGroup>(patterns.getContext());
+}
+
 struct DecomposeConvToMatmulOrBrgemm
     : public DecomposeConvToMatmulOrBrgemmBase<DecomposeConvToMatmulOrBrgemm> {
   DecomposeConvToMatmulOrBrgemm() = default;
@@ -617,6 +1114,8 @@ struct DecomposeConvToMatmulOrBrgemm
     populateConv2DNhwcHwcfOpDecomposePatterns(patterns);
     populateconv2DNchwFchwOpDecomposePatterns(patterns, blockingFactors,
                                               enableBrgemm);
+    populateDepthwiseAndGroupedConvDecomposePatterns(patterns,
+                                                     blockingFactors);
     (void)applyPatternsAndFoldGreedily(getOperation(), std::move(patterns));
     return;
   }
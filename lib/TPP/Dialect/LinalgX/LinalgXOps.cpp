@@ -10,11 +10,14 @@
 #include "TPP/Dialect/LinalgX/LinalgXDialect.h"
 #include "mlir/Dialect/Affine/IR/AffineOps.h"
 #include "mlir/Dialect/Affine/Utils.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/Arith/Utils/Utils.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/Dialect/SCF/IR/SCF.h"
 #include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/IR/DialectResourceBlobManager.h"
+#include "mlir/IR/Matchers.h"
 #include "mlir/IR/OpImplementation.h"
 #include "mlir/Parser/Parser.h"
 #include "mlir/Support/MathExtras.h"
@@ -28,14 +31,15 @@ using namespace mlir::bufferization;
 // PackOp and UnPackOp canonicalizer
 //===----------------------------------------------------------------------===//
 
-// Remove chain of pack(unpack(x)).
+// Remove chain of pack(unpack(x)). A padded pack writes the padding value in
+// the partial tiles, while x may hold anything there: keep it.
 struct PackUnPackSequence : public OpRewritePattern<PackOp> {
   using OpRewritePattern<PackOp>::OpRewritePattern;
 
   LogicalResult matchAndRewrite(PackOp packOp,
                                 PatternRewriter &rewriter) const override {
     UnPackOp unpackOp = packOp.getInput().getDefiningOp<linalgx::UnPackOp>();
-    if (!unpackOp)
+    if (!unpackOp || packOp.getPaddingValue())
       return failure();
     if (unpackOp.getInputType() != packOp.getOutputType())
       return failure();
@@ -44,6 +48,22 @@ struct PackUnPackSequence : public OpRewritePattern<PackOp> {
   }
 };
 
+// Remove chain of unpack(pack(x)).
+struct UnPackPackSequence : public OpRewritePattern<UnPackOp> {
+  using OpRewritePattern<UnPackOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(UnPackOp unpackOp,
+                                PatternRewriter &rewriter) const override {
+    PackOp packOp = unpackOp.getInput().getDefiningOp<linalgx::PackOp>();
+    if (!packOp)
+      return failure();
+    if (packOp.getOutputType() != unpackOp.getInputType())
+      return failure();
+    rewriter.replaceOp(unpackOp, packOp.getInput());
+    return success();
+  }
+};
+
 static FailureOr<Value> insertExpand(Value operand, Type newOperandType,
                                      ArrayAttr reassociation, Location loc,
                                      RewriterBase &rewriter) {
@@ -108,20 +128,187 @@ struct ForwardTensorEmpty : public OpRewritePattern<PackOp> {
   }
 };
 
+// Return the raw data of the constant `value`, whose elements must be integers
+// or floats of a byte-sized width. A splat constant holds a single element.
+static FailureOr<ArrayRef<char>> getRawConstantData(Value value,
+                                                    bool &isSplat) {
+  Attribute attr;
+  if (!matchPattern(value, m_Constant(&attr)))
+    return failure();
+  ShapedType type = value.getType().dyn_cast<RankedTensorType>();
+  if (!type || !type.hasStaticShape() ||
+      !type.getElementType().isIntOrFloat() ||
+      type.getElementTypeBitWidth() % 8 != 0)
+    return failure();
+  if (auto denseAttr = attr.dyn_cast<DenseElementsAttr>()) {
+    isSplat = denseAttr.isSplat();
+    return denseAttr.getRawData();
+  }
+  if (auto resourceAttr = attr.dyn_cast<DenseResourceElementsAttr>()) {
+    AsmResourceBlob *blob = resourceAttr.getRawHandle().getBlob();
+    if (!blob)
+      return failure();
+    isSplat = false;
+    return blob->getData();
+  }
+  return failure();
+}
+
+// Build the constant of type `resultType` whose element at index `idx` is the
+// element of `source` at `getSourceIndex(idx)`, or `padding` if the source
+// index is out of bounds.
+static DenseElementsAttr relayoutConstant(
+    ArrayRef<char> source, bool isSplat, ShapedType sourceType,
+    ShapedType resultType, ArrayRef<char> padding,
+    function_ref<void(ArrayRef<int64_t>, SmallVectorImpl<int64_t> &)>
+        getSourceIndex) {
+  // A single element buffer is a splat.
+  if (isSplat && padding.empty())
+    return DenseElementsAttr::getFromRawBuffer(resultType, source);
+  size_t elementSize = resultType.getElementTypeBitWidth() / 8;
+  ArrayRef<int64_t> sourceShape = sourceType.getShape();
+  ArrayRef<int64_t> resultShape = resultType.getShape();
+  std::vector<char> result(resultType.getNumElements() * elementSize);
+  SmallVector<int64_t> resultIdx(resultShape.size(), 0);
+  SmallVector<int64_t> sourceIdx;
+  for (int64_t linearIdx = 0, end = resultType.getNumElements();
+       linearIdx < end; linearIdx++) {
+    sourceIdx.clear();
+    getSourceIndex(resultIdx, sourceIdx);
+    int64_t sourceLinearIdx = 0;
+    bool isInBounds = true;
+    for (auto dim : llvm::seq<size_t>(0, sourceShape.size())) {
+      isInBounds &= sourceIdx[dim] < sourceShape[dim];
+      sourceLinearIdx = sourceLinearIdx * sourceShape[dim] + sourceIdx[dim];
+    }
+    const char *element = padding.data();
+    if (isInBounds)
+      element = source.data() + (isSplat ? 0 : sourceLinearIdx * elementSize);
+    std::copy_n(element, elementSize, result.begin() + linearIdx * elementSize);
+    // Move to the next index of the result, in row-major order.
+    for (int64_t dim = resultShape.size() - 1; dim >= 0; dim--) {
+      if (++resultIdx[dim] < resultShape[dim])
+        break;
+      resultIdx[dim] = 0;
+    }
+  }
+  return DenseElementsAttr::getFromRawBuffer(resultType, result);
+}
+
+// Pack a constant at compile time, e.g., the weights of a matmul or of a
+// convolution, including the bf16 VNNI layout.
+struct ConstantFoldPack : public OpRewritePattern<PackOp> {
+  using OpRewritePattern<PackOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(PackOp packOp,
+                                PatternRewriter &rewriter) const override {
+    if (packOp.getResults().size() != 1)
+      return failure();
+    ShapedType outputType = packOp.getOutputType();
+    if (!outputType.hasStaticShape() ||
+        llvm::is_contained(packOp.getStaticTiles(), ShapedType::kDynamicSize))
+      return failure();
+    bool isSplat = false;
+    FailureOr<ArrayRef<char>> source =
+        getRawConstantData(packOp.getInput(), isSplat);
+    if (failed(source))
+      return rewriter.notifyMatchFailure(packOp, "expect a constant input");
+
+    ArrayRef<char> padding;
+    if (Value paddingValue = packOp.getPaddingValue()) {
+      Attribute paddingAttr;
+      if (!matchPattern(paddingValue, m_Constant(&paddingAttr)))
+        return rewriter.notifyMatchFailure(packOp, "expect a constant padding");
+      padding = DenseElementsAttr::get(
+                    RankedTensorType::get({}, paddingValue.getType()),
+                    paddingAttr)
+                    .getRawData();
+    }
+
+    // The point loop `i` tiles the dimension `innerDimsPos[i]`, while the
+    // tile loop `j` iterates the dimension `outerDimsPerm[j]`.
+    SmallVector<int64_t> innerDimsPos =
+        extractFromI64ArrayAttr(packOp.getInnerDimsPos());
+    SmallVector<int64_t> outerDimsPerm =
+        extractFromI64ArrayAttr(packOp.getOuterDimsPerm());
+    SmallVector<int64_t> tiles = packOp.getStaticTiles();
+    int64_t inputRank = packOp.getInputRank();
+    auto getSourceIndex = [&](ArrayRef<int64_t> packedIdx,
+                              SmallVectorImpl<int64_t> &idx) {
+      idx.resize(inputRank);
+      for (auto dim : llvm::seq<int64_t>(0, inputRank))
+        idx[outerDimsPerm.empty() ? dim : outerDimsPerm[dim]] = packedIdx[dim];
+      for (auto en : llvm::enumerate(innerDimsPos)) {
+        idx[en.value()] = idx[en.value()] * tiles[en.index()] +
+                          packedIdx[inputRank + en.index()];
+      }
+    };
+    rewriter.replaceOpWithNewOp<arith::ConstantOp>(
+        packOp, relayoutConstant(*source, isSplat, packOp.getInputType(),
+                                 outputType, padding, getSourceIndex));
+    return success();
+  }
+};
+
+// Unpack a constant at compile time.
+struct ConstantFoldUnPack : public OpRewritePattern<UnPackOp> {
+  using OpRewritePattern<UnPackOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(UnPackOp unpackOp,
+                                PatternRewriter &rewriter) const override {
+    if (unpackOp.getResults().size() != 1)
+      return failure();
+    ShapedType outputType = unpackOp.getOutputType();
+    if (!outputType.hasStaticShape() ||
+        llvm::is_contained(unpackOp.getStaticTiles(),
+                           ShapedType::kDynamicSize))
+      return failure();
+    bool isSplat = false;
+    FailureOr<ArrayRef<char>> source =
+        getRawConstantData(unpackOp.getInput(), isSplat);
+    if (failed(source))
+      return rewriter.notifyMatchFailure(unpackOp, "expect a constant input");
+
+    SmallVector<int64_t> innerDimsPos =
+        extractFromI64ArrayAttr(unpackOp.getInnerDimsPos());
+    SmallVector<int64_t> outerDimsPerm =
+        extractFromI64ArrayAttr(unpackOp.getOuterDimsPerm());
+    SmallVector<int64_t> tiles = unpackOp.getStaticTiles();
+    int64_t outputRank = unpackOp.getOutputRank();
+    auto getSourceIndex = [&](ArrayRef<int64_t> unpackedIdx,
+                              SmallVectorImpl<int64_t> &idx) {
+      SmallVector<int64_t> tileIdx = llvm::to_vector(unpackedIdx);
+      idx.resize(outputRank + innerDimsPos.size());
+      for (auto en : llvm::enumerate(innerDimsPos)) {
+        idx[outputRank + en.index()] = unpackedIdx[en.value()] %
+                                       tiles[en.index()];
+        tileIdx[en.value()] = unpackedIdx[en.value()] / tiles[en.index()];
+      }
+      for (auto dim : llvm::seq<int64_t>(0, outputRank))
+        idx[dim] = tileIdx[outerDimsPerm.empty() ? dim : outerDimsPerm[dim]];
+    };
+    rewriter.replaceOpWithNewOp<arith::ConstantOp>(
+        unpackOp,
+        relayoutConstant(*source, isSplat, unpackOp.getInputType(), outputType,
+                         /*padding=*/{}, getSourceIndex));
+    return success();
+  }
+};
+
 void PackOp::getCanonicalizationPatterns(RewritePatternSet &results,
                                          MLIRContext *ctx) {
-  results.add<PackUnPackSequence, PackToExpandShape, ForwardTensorEmpty>(ctx);
+  results.add<PackUnPackSequence, PackToExpandShape, ForwardTensorEmpty,
+              ConstantFoldPack>(ctx);
 }
 
-LogicalResult UnPackOp::canonicalize(UnPackOp unpackOp,
-                                     PatternRewriter &rewriter) {
-  PackOp packOp = unpackOp.getInput().getDefiningOp<linalgx::PackOp>();
-  if (!packOp)
-    return failure();
-  if (packOp.getOutputType() != unpackOp.getInputType())
-    return failure();
-  rewriter.replaceOp(unpackOp, packOp.getInput());
-  return success();
+void UnPackOp::getCanonicalizationPatterns(RewritePatternSet &results,
+                                           MLIRContext *ctx) {
+  results.add<UnPackPackSequence, ConstantFoldUnPack>(ctx);
+}
+
+void mlir::linalgx::populateConstantFoldPackUnPackPatterns(
+    RewritePatternSet &patterns) {
+  patterns.add<ConstantFoldPack, ConstantFoldUnPack>(patterns.getContext());
 }
 
 //===----------------------------------------------------------------------===//
@@ -147,8 +334,8 @@ void PackOp::build(OpBuilder &builder, OperationState &result, Value input,
 
 void PackOp::build(OpBuilder &builder, OperationState &result, Value input,
                    Value output, ArrayRef<int64_t> innerDimPos,
-                   ArrayRef<int64_t> outerDimPerm,
-                   ArrayRef<OpFoldResult> tiles) {
+                   ArrayRef<int64_t> outerDimPerm, ArrayRef<OpFoldResult> tiles,
+                   Value padding) {
   assert(!innerDimPos.empty() && "expect innerDimPos to be non empty");
   assert(!tiles.empty() && "expect tiles to be non empty");
   SmallVector<Value> innerTiles;
@@ -159,12 +346,12 @@ void PackOp::build(OpBuilder &builder, OperationState &result, Value input,
   if (outerDimPerm.empty())
     build(builder, result, typeOutput, input, output,
           /*outerDimPerm=*/{}, builder.getI64ArrayAttr(innerDimPos), innerTiles,
-          builder.getI64ArrayAttr(staticInnerTiles), /*padding_value=*/{});
+          builder.getI64ArrayAttr(staticInnerTiles), padding);
   else
     build(builder, result, typeOutput, input, output,
           builder.getI64ArrayAttr(outerDimPerm),
           builder.getI64ArrayAttr(innerDimPos), innerTiles,
-          builder.getI64ArrayAttr(staticInnerTiles), /*padding_value=*/{});
+          builder.getI64ArrayAttr(staticInnerTiles), padding);
 }
 
 void UnPackOp::build(OpBuilder &builder, OperationState &result, Value input,
@@ -8,7 +8,9 @@
 
 #include "TPP/Dialect/Tpp/TppOps.h"
 #include "TPP/Dialect/Tpp/TppDialect.h"
+#include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/OpImplementation.h"
+#include "mlir/IR/TypeUtilities.h"
 
 #define GET_OP_CLASSES
 #include "TPP/Dialect/Tpp/TppOps.cpp.inc"
@@ -16,6 +18,24 @@
 using namespace mlir;
 using namespace mlir::tpp;
 
+// Verify that `lhsType` and `rhsType` are the same scalar type or memrefs with
+// the same shape and element type; the layouts of memrefs may differ.
+static LogicalResult verifySameShapeAndElementType(Operation *op, Type lhsType,
+                                                   Type rhsType) {
+  auto lhsShapedType = lhsType.dyn_cast<ShapedType>();
+  auto rhsShapedType = rhsType.dyn_cast<ShapedType>();
+  if (!lhsShapedType || !rhsShapedType) {
+    if (lhsType != rhsType)
+      return op->emitOpError("requires all operands to have the same type");
+    return success();
+  }
+  if (lhsShapedType.getShape() != rhsShapedType.getShape() ||
+      lhsShapedType.getElementType() != rhsShapedType.getElementType())
+    return op->emitOpError(
+        "requires all operands to have the same shape and element type");
+  return success();
+}
+
 //===----------------------------------------------------------------------===//
 // IdentityOp
 //===----------------------------------------------------------------------===//
@@ -84,10 +104,26 @@ static bool verifyMatmulOperandsDims(ArrayRef<int64_t> shapeA,
           (!isPackedBF16 && (shapeA[0] == m) && (shapeA[1] == k)));
 }
 
+// The inputs must have the same element type. The output has the same element
+// type as the inputs, or is f32 for bf16 inputs (mixed precision).
+static LogicalResult verifyGemmElementTypes(Operation *op, Type typeA,
+                                            Type typeB, Type typeC) {
+  Type elementA = getElementTypeOrSelf(typeA);
+  Type elementC = getElementTypeOrSelf(typeC);
+  if (elementA != getElementTypeOrSelf(typeB) ||
+      (elementA != elementC && !(elementA.isBF16() && elementC.isF32())))
+    return op->emitOpError("requires the same element type for all operands");
+  return success();
+}
+
 // XXX: Changing the op semantics based on the type is so bad and brittle.
 // We don't want to do this. This BF16 packing need to be revisited.
 // Check that op to be 2d matmul in row-major.
 LogicalResult MatmulOp::verify() {
+  if (failed(verifyGemmElementTypes(*this, getMatrixA().getType(),
+                                    getMatrixB().getType(),
+                                    getMatrixC().getType())))
+    return failure();
   MemRefType memrefA = getMatrixA().getType().cast<MemRefType>();
   MemRefType memrefB = getMatrixB().getType().cast<MemRefType>();
   MemRefType memrefC = getMatrixC().getType().cast<MemRefType>();
@@ -124,6 +160,10 @@ static bool verifyBRGemmShape(MemRefType memrefA, MemRefType memrefB,
 // XXX: Changing the op semantics based on the type is so bad and brittle.
 // We don't want to do this. This BF16 packing need to be revisited.
 LogicalResult BrgemmOp::verify() {
+  if (failed(verifyGemmElementTypes(*this, getBatchMatrixA().getType(),
+                                    getBatchMatrixB().getType(),
+                                    getMatrixC().getType())))
+    return failure();
   MemRefType tensorA = getBatchMatrixA().getType().cast<MemRefType>();
   MemRefType tensorB = getBatchMatrixB().getType().cast<MemRefType>();
   MemRefType matrixC = getMatrixC().getType().cast<MemRefType>();
@@ -151,6 +191,99 @@ void BrgemmOp::build(OpBuilder &builder, OperationState &state,
   BrgemmOp::build(builder, state, inputs[0], inputs[1], output);
 }
 
+//===----------------------------------------------------------------------===//
+// FusedBrgemmOp
+//===----------------------------------------------------------------------===//
+
+LogicalResult FusedBrgemmOp::verify() {
+  MemRefType tensorA = getBatchMatrixAType();
+  MemRefType tensorB = getBatchMatrixBType();
+  MemRefType matrixC = getMatrixCType();
+  bool isPackedBF16 =
+      tensorA.getElementType().isBF16() && tensorA.getRank() == 4;
+  if (!verifyBRGemmShape(tensorA, tensorB, matrixC, isPackedBF16))
+    return emitOpError("fails to verify operands shapes");
+  if (!isPackedBF16 && tensorA.getShape()[0] != tensorB.getShape()[0])
+    return emitOpError("fails to verify operands dimensions mismatch");
+  if (isPackedBF16 &&
+      tensorA.getShape()[0] * tensorA.getShape()[3] != tensorB.getShape()[0])
+    return emitOpError("fails to verify operands dimensions mismatch");
+  if (!isPackedBF16 &&
+      !verifyMatmulOperandsDims(tensorA.getShape().drop_front(),
+                                tensorB.getShape().drop_front(),
+                                matrixC.getShape(), isPackedBF16))
+    return emitOpError("fails to verify operands dimensions mismatch");
+  // The bias is a row vector broadcast along the rows of C: [n] or [1, n].
+  ArrayRef<int64_t> biasShape = getBiasType().getShape();
+  int64_t n = matrixC.getShape()[1];
+  if (biasShape.back() != n || (biasShape.size() == 2 && biasShape[0] != 1))
+    return emitOpError("expects bias to be broadcastable along the rows");
+  return success();
+}
+
+//===----------------------------------------------------------------------===//
+// OffsetBrgemmOp
+//===----------------------------------------------------------------------===//
+
+// Check that a `rows` x `cols` block with leading dimension `ld` starting at
+// any of `offsets` lies within `memref`. Blocks of operands with dynamic
+// strides are checked only for negative offsets.
+static bool verifyBlocksInBounds(MemRefType memref, ArrayRef<int64_t> offsets,
+                                 int64_t rows, int64_t cols, int64_t ld) {
+  SmallVector<int64_t> strides;
+  int64_t offset;
+  if (failed(getStridesAndOffset(memref, strides, offset)))
+    return false;
+  if (llvm::any_of(strides, ShapedType::isDynamicStrideOrOffset))
+    return llvm::all_of(offsets, [](int64_t off) { return off >= 0; });
+  int64_t span = 1;
+  for (auto [size, stride] : llvm::zip(memref.getShape(), strides))
+    span += (size - 1) * stride;
+  return llvm::all_of(offsets, [&](int64_t off) {
+    return off >= 0 && off + (rows - 1) * ld + cols <= span;
+  });
+}
+
+// Return the stride of the second innermost dimension of `memref`, if the
+// innermost dimension is contiguous.
+static Optional<int64_t> getLeadingDimStride(MemRefType memref) {
+  SmallVector<int64_t> strides;
+  int64_t offset;
+  if (failed(getStridesAndOffset(memref, strides, offset)) ||
+      strides.back() != 1 ||
+      ShapedType::isDynamicStrideOrOffset(strides[strides.size() - 2]))
+    return llvm::None;
+  return strides[strides.size() - 2];
+}
+
+LogicalResult OffsetBrgemmOp::verify() {
+  if (failed(verifyGemmElementTypes(*this, getBatchMatrixA().getType(),
+                                    getBatchMatrixB().getType(),
+                                    getMatrixC().getType())))
+    return failure();
+  MemRefType memrefA = getBatchMatrixAType();
+  MemRefType memrefB = getBatchMatrixBType();
+  MemRefType matrixC = getMatrixCType();
+  if (matrixC.getRank() != 2)
+    return emitOpError("fails to verify operands shapes");
+  if (getOffsetsA().empty() || getOffsetsA().size() != getOffsetsB().size())
+    return emitOpError("expects the same non-zero number of offsets");
+  Optional<int64_t> lda = getLeadingDimStride(memrefA);
+  Optional<int64_t> ldb = getLeadingDimStride(memrefB);
+  if (!lda || !ldb)
+    return emitOpError("expects static strides and contiguous rows");
+  int64_t m = matrixC.getShape()[0];
+  int64_t n = matrixC.getShape()[1];
+  int64_t k = memrefA.getShape().back();
+  ArrayRef<int64_t> shapeB = memrefB.getShape();
+  if (shapeB[shapeB.size() - 2] != k || shapeB.back() != n)
+    return emitOpError("fails to verify operands dimensions mismatch");
+  if (!verifyBlocksInBounds(memrefA, getOffsetsA(), m, k, *lda) ||
+      !verifyBlocksInBounds(memrefB, getOffsetsB(), k, n, *ldb))
+    return emitOpError("expects blocks within the bounds of the operands");
+  return success();
+}
+
 //===----------------------------------------------------------------------===//
 // AdddOp
 //===----------------------------------------------------------------------===//
@@ -163,5 +296,37 @@ LogicalResult AddOp::verify() {
   Type rhsType = getRhs().getType();
   if ((!lhsType.isa<ShapedType>()) || (!rhsType.isa<ShapedType>()))
     return emitOpError("expects both operands to be shaped type");
+  return verifySameShapeAndElementType(*this, lhsType, rhsType);
+}
+
+//===----------------------------------------------------------------------===//
+// ReluOp
+//===----------------------------------------------------------------------===//
+
+LogicalResult ReluOp::verify() {
+  return verifySameShapeAndElementType(*this, getInput().getType(),
+                                       getOutput().getType());
+}
+
+//===----------------------------------------------------------------------===//
+// MulAddOp
+//===----------------------------------------------------------------------===//
+
+LogicalResult MulAddOp::verify() {
+  MemRefType lhsType = getLhsType();
+  MemRefType rhsType = getRhsType();
+  MemRefType outputType = getOutputType();
+  if (lhsType.getElementType() != outputType.getElementType() ||
+      rhsType.getElementType() != outputType.getElementType())
+    return emitOpError("expects all operands to have the same element type");
+  if (outputType.getRank() != 2 || lhsType.getShape() != outputType.getShape())
+    return emitOpError("expects lhs and output with the same 2d shape");
+  if (hasBroadcastRhs()) {
+    if (rhsType.getShape()[0] != outputType.getShape()[1])
+      return emitOpError("expects rhs to be broadcastable along the rows");
+    return success();
+  }
+  if (rhsType.getShape() != outputType.getShape())
+    return emitOpError("expects rhs with the shape of the output");
   return success();
 }
@@ -18,7 +18,24 @@
 using namespace mlir;
 using namespace mlir::xsmm;
 
-LogicalResult TernaryOp::verify() { return success(); }
+LogicalResult TernaryOp::verify() {
+  if (!isBatchReduceOverList()) {
+    if (getOffsetsA() || getOffsetsB())
+      return emitOpError("expect offsets only for batch-reduce over lists");
+    return success();
+  }
+  // Once lowered to calls, the offsets are operands.
+  if (!getOffsetsA() && !getOffsetsB())
+    return success();
+  if (!getOffsetsA() || !getOffsetsB())
+    return emitOpError("expect offsets for both A and B");
+  if (getOffsetsA()->size() != getOffsetsB()->size())
+    return emitOpError("expect the same number of offsets for A and B");
+  if (llvm::any_of(*getOffsetsA(), [](int64_t off) { return off < 0; }) ||
+      llvm::any_of(*getOffsetsB(), [](int64_t off) { return off < 0; }))
+    return emitOpError("expect non-negative offsets");
+  return success();
+}
 
 LogicalResult BinaryOp::verify() { return success(); }
 
@@ -34,13 +34,8 @@ struct MapGenericOpToTpp : public OpRewritePattern<linalg::GenericOp> {
 
   // Return true if: 1) the region has a single block. 2) The block has two
   // operations only (linalg.YieldOp and OP). 3) The operation result types are
-  // int or float.
-  // TODO: For now we assume the region to have only two operations: The YieldOp
-  // and the 'OP', meaning that the entire linalg.generic will map to a single
-  // tpp operation. If we do element-wise fusion at the linalg level this
-  // assumption does not hold anymore as now a linalg.generic can map to n tpp
-  // operations. If we support 1:n matching what should we do if the entire
-  // linalg.op cannot be replace by tpp operations?
+  // int or float. A region with more operations may still map to a sequence
+  // of tpp operations, see hasTppChainBody.
   template <typename OP> bool hasOnlyScalarElementwiseOp(Region &region) const {
     if (!region.hasOneBlock())
       return false;
@@ -55,6 +50,35 @@ struct MapGenericOpToTpp : public OpRewritePattern<linalg::GenericOp> {
     return true;
   }
 
+  // Return true if: 1) all the loops are parallel. 2) the region has a single
+  // block. 3) The block yields the result of one of its operations. 4) All the
+  // operations, but the YieldOp, are scalar float operations with a tpp
+  // counterpart (arith.addf, arith.mulf and mathx.relu). The linalg.generic
+  // then maps 1:n to a chain of tpp operations: i.e., the body of a
+  // linalg.generic after element-wise fusion. If an operation has no tpp
+  // counterpart the linalg.generic does not map at all. A reduction is not a
+  // chain: the body accumulates into the output along the reduction loops.
+  bool hasTppChainBody(linalg::GenericOp linalgOp) const {
+    if (linalgOp.getNumLoops() != linalgOp.getNumParallelLoops())
+      return false;
+    Region &region = linalgOp.getRegion();
+    if (!region.hasOneBlock())
+      return false;
+    Block &block = region.front();
+    auto yieldOp = cast<linalg::YieldOp>(block.getTerminator());
+    if (yieldOp.getNumOperands() != 1)
+      return false;
+    Operation *yielded = yieldOp.getOperand(0).getDefiningOp();
+    if (!yielded || yielded->getBlock() != &block)
+      return false;
+    for (Operation &op : block.without_terminator()) {
+      if (!isa<arith::AddFOp, arith::MulFOp, mathx::ReluOp>(op) ||
+          !op.getResult(0).getType().isa<FloatType>())
+        return false;
+    }
+    return true;
+  }
+
   // Return true if the linalg.generic maps to a tpp.gemm.
   bool isTPPGemm(linalg::GenericOp linalgOp) const {
     // structural and access pattern.
@@ -120,6 +144,14 @@ struct MapGenericOpToTpp : public OpRewritePattern<linalg::GenericOp> {
       return success();
     }
 
+    if (hasTppChainBody(linalgOp) && hasStaticShape(linalgOp) &&
+        linalgOp.getNumOutputs() == 1) {
+      StringAttr tppMicroKernelName = rewriter.getStringAttr("tpp.chain");
+      rewriter.updateRootInPlace(
+          linalgOp, [&]() { linalgOp.setLibraryCallAttr(tppMicroKernelName); });
+      return success();
+    }
+
     return rewriter.notifyMatchFailure(linalgOp, "unmatched Linalg op");
   }
 };
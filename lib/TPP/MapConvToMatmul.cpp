@@ -59,8 +59,9 @@ static bool hasFilterWithRandSEqualOne(OpOperand *filter, unsigned i,
 }
 
 // Return success if `expr` is either a dimExpr or a mul expression dim * cst OR
-// cst * dim.
-static LogicalResult isDimExprOrMulExpr(AffineExpr expr,
+// cst * dim. If the dimension is `dimPos`, its constant is accumulated in
+// `multiplicativeFactor`.
+static LogicalResult isDimExprOrMulExpr(AffineExpr expr, unsigned dimPos,
                                         AffineExpr &multiplicativeFactor) {
   if (auto dimExpr = expr.dyn_cast<AffineDimExpr>())
     return success();
@@ -79,14 +80,16 @@ static LogicalResult isDimExprOrMulExpr(AffineExpr expr,
     // If the lhs is a constant the rhs is a dim and viceversa.
     if (auto constant = lhs.dyn_cast<AffineConstantExpr>()) {
       if (auto dim = rhs.dyn_cast<AffineDimExpr>()) {
-        multiplicativeFactor = multiplicativeFactor * constant.getValue();
+        if (dim.getPosition() == dimPos)
+          multiplicativeFactor = multiplicativeFactor * constant.getValue();
         return success();
       }
       return failure();
     }
     if (auto constant = rhs.dyn_cast<AffineConstantExpr>()) {
       if (auto dim = lhs.dyn_cast<AffineDimExpr>()) {
-        multiplicativeFactor = multiplicativeFactor * constant.getValue();
+        if (dim.getPosition() == dimPos)
+          multiplicativeFactor = multiplicativeFactor * constant.getValue();
         return success();
       }
       return failure();
@@ -96,17 +99,21 @@ static LogicalResult isDimExprOrMulExpr(AffineExpr expr,
   return failure();
 }
 
-// Walk `convExpr` in pre-order and extract a constant if any.
-static LogicalResult walkConvExpr(AffineExpr convExpr,
+// Walk `convExpr` in pre-order and extract the constant multiplying the
+// dimension `dimPos`, if any. On the image of a convolution this is the stride
+// of the output dimension, the filter dimension being multiplied by the
+// dilation.
+static LogicalResult walkConvExpr(AffineExpr convExpr, unsigned dimPos,
                                   AffineExpr &multiplicativeFactor) {
   if (auto dimExpr = convExpr.dyn_cast<AffineDimExpr>())
     return success();
   if (auto binExpr = convExpr.dyn_cast<AffineBinaryOpExpr>()) {
     if (binExpr.getKind() != AffineExprKind::Add)
       return failure();
-    return success(
-        succeeded(isDimExprOrMulExpr(binExpr.getLHS(), multiplicativeFactor)) &&
-        succeeded(isDimExprOrMulExpr(binExpr.getRHS(), multiplicativeFactor)));
+    return success(succeeded(isDimExprOrMulExpr(binExpr.getLHS(), dimPos,
+                                                multiplicativeFactor)) &&
+                   succeeded(isDimExprOrMulExpr(binExpr.getRHS(), dimPos,
+                                                multiplicativeFactor)));
   }
   return failure();
 }
@@ -131,12 +138,39 @@ getSlicedConvOperandImpl(OpBuilder &builder, linalg::LinalgOp linalgOp,
   for (size_t idx = ivs.size(), e = rank; idx < e; idx++)
     offsets.push_back(builder.getIndexAttr(0));
 
+  // We need to take into accound possible strides on W. Strides on the H
+  // are already computed using affine maps as the loops iterating over H are
+  // materialized. The W dimension is the last - 1 dimension, and the GEMM
+  // iterates over it with the m loop (the third innermost loop). Dilations
+  // only affect the offset along W, computed by
+  // `getInvolvedLocalDimsForOperand`.
+  SmallVector<OpFoldResult> strides(rank, builder.getIndexAttr(1));
+  int64_t strideOnW = 1;
+  if (isImage) {
+    AffineMap imageMap = linalgOp.getMatchingIndexingMap(operand);
+    AffineExpr wExpr = imageMap.getResult(imageMap.getNumResults() - 2);
+    AffineExpr multiplicativeFactor =
+        getAffineConstantExpr(1, linalgOp.getContext());
+    // By definition a convolution affine expression can either be:
+    // a) AffineDimExpr
+    // b) AffineDimExpr + AffineDimExpr
+    // c) AffineDimExpr * AffineConstantExpr/AffineSymbolExpr + AffineDimExpr
+    unsigned mPos = linalgOp.getNumLoops() - /*GEMM loops=*/3;
+    LogicalResult isConvExpr = walkConvExpr(wExpr, mPos, multiplicativeFactor);
+    assert(succeeded(isConvExpr) && "something went really wrong");
+    (void)isConvExpr;
+    strideOnW = multiplicativeFactor.cast<AffineConstantExpr>().getValue();
+    strides[strides.size() - 2] = builder.getIndexAttr(strideOnW);
+  }
+
   // If the filter has R and S not 1 we need to deal with a sliding window. The
-  // sizes of the matmul depend on the filter and output, use
+  // same holds with a stride, as the GEMM reads one every `strideOnW` pixels.
+  // The sizes of the matmul depend on the filter and output, use
   // `computeSizeGemmForImage` to compute them.
   OpOperand *filter = linalgOp.getInputOperands()[1];
   if (isImage &&
-      !hasFilterWithRandSEqualOne(filter, rAndSPos[0], rAndSPos[1])) {
+      (strideOnW != 1 ||
+       !hasFilterWithRandSEqualOne(filter, rAndSPos[0], rAndSPos[1]))) {
     sizes = computeSizeGemmForImage(builder, linalgOp);
   } else {
     // Get full sizes from [rank - desiredResultRank, rank).
@@ -147,24 +181,6 @@ getSlicedConvOperandImpl(OpBuilder &builder, linalg::LinalgOp linalgOp,
                                                 operand->get(), idx));
   }
 
-  // We need to take into accound possible strides on W. Strides on the H
-  // are already computed using affine maps as the loops iterating over H are
-  // materialized. The W dimension is the last - 1 dimension.
-  SmallVector<OpFoldResult> strides(rank, builder.getIndexAttr(1));
-  if (isImage) {
-    AffineMap imageMap = linalgOp.getMatchingIndexingMap(operand);
-    AffineExpr wExpr = imageMap.getResult(imageMap.getNumResults() - 2);
-    AffineExpr multiplicativeFactor =
-        getAffineConstantExpr(1, linalgOp.getContext());
-    // By definition a convolution affine expression can either be:
-    // a) AffineDimExpr
-    // b) AffineDimExpr + AffineDimExpr
-    // c) AffineDimExpr * AffineConstantExpr/AffineSymbolExpr + AffineDimExpr
-    assert(succeeded(walkConvExpr(wExpr, multiplicativeFactor)) &&
-           "something went really wrong");
-    strides[strides.size() - 2] = builder.getIndexAttr(
-        multiplicativeFactor.cast<AffineConstantExpr>().getValue());
-  }
   return utils::getSliceOperand(builder, linalgOp, operandToUse, offsets, sizes,
                                 strides, desiredResultRank);
 }
@@ -138,7 +138,8 @@ getSlicedOperands(OpBuilder &builder, Location loc, ValueRange localIvs,
 
 FailureOr<SmallVector<Value>>
 mlir::linalgx::mapToBRGEMMOp(RewriterBase &rewriter,
-                             linalg::LinalgOp linalgOp) {
+                             linalg::LinalgOp linalgOp,
+                             bool useParallelLoops) {
   if (failed(MapToBRGEMMOpPreconditions(linalgOp)))
     return failure();
 
@@ -184,9 +185,15 @@ mlir::linalgx::mapToBRGEMMOp(RewriterBase &rewriter,
 
     return scf::ValueVector(tensorResults.begin(), tensorResults.end());
   };
-  linalg::GenerateLoopNest<scf::ForOp>::doit(
-      rewriter, linalgOp.getLoc(), loopRanges, linalgOp,
-      linalgOp.getIteratorTypesArray(), brgemmBuilder);
+  // scf.parallel does not carry tensors, use it only at buffer level.
+  if (useParallelLoops && linalgOp.hasBufferSemantics())
+    linalg::GenerateLoopNest<scf::ParallelOp>::doit(
+        rewriter, linalgOp.getLoc(), loopRanges, linalgOp,
+        linalgOp.getIteratorTypesArray(), brgemmBuilder);
+  else
+    linalg::GenerateLoopNest<scf::ForOp>::doit(
+        rewriter, linalgOp.getLoc(), loopRanges, linalgOp,
+        linalgOp.getIteratorTypesArray(), brgemmBuilder);
 
   // see: `Tiling.cpp` in Linalg/Transforms
   // gather the newly created loops and return them with the new op.
@@ -215,7 +222,9 @@ mlir::linalgx::mapToBRGEMMOp(RewriterBase &rewriter,
 namespace {
 
 struct DoItOnGeneric : public OpRewritePattern<linalg::GenericOp> {
-  using OpRewritePattern<linalg::GenericOp>::OpRewritePattern;
+  DoItOnGeneric(MLIRContext *context, bool useParallelLoops)
+      : OpRewritePattern<linalg::GenericOp>(context),
+        useParallelLoops(useParallelLoops) {}
 
   // Map a generic operation to BRGEMM. The following conditions apply:
   // 1. The generic has a single region. The region performs a scalar GEMM
@@ -227,18 +236,27 @@ struct DoItOnGeneric : public OpRewritePattern<linalg::GenericOp> {
   LogicalResult matchAndRewrite(linalg::GenericOp linalgOp,
                                 PatternRewriter &rewriter) const override {
     FailureOr<SmallVector<Value>> maybeLoopsOrGenericRes =
-        mlir::linalgx::mapToBRGEMMOp(rewriter, linalgOp);
+        mlir::linalgx::mapToBRGEMMOp(rewriter, linalgOp, useParallelLoops);
     if (failed(maybeLoopsOrGenericRes))
       return failure();
     return success();
   }
+
+private:
+  bool useParallelLoops;
 };
 
 struct MapToBatchReduceGEMM
     : public MapToBatchReduceGEMMBase<MapToBatchReduceGEMM> {
+  MapToBatchReduceGEMM() = default;
+  MapToBatchReduceGEMM(bool useParallelLoops) {
+    this->useParallelLoops = useParallelLoops;
+  }
+
   void runOnOperation() override {
     RewritePatternSet patterns(getOperation().getContext());
-    patterns.add<DoItOnGeneric>(patterns.getContext());
+    patterns.add<DoItOnGeneric>(patterns.getContext(), useParallelLoops);
+    tpp::populateBiasBrgemmReluFusionPatterns(patterns);
     (void)applyPatternsAndFoldGreedily(getOperation(), std::move(patterns));
     return;
   }
@@ -250,3 +268,8 @@ std::unique_ptr<OperationPass<func::FuncOp>>
 mlir::tpp::createMapToBatchReduceGEMMPass() {
   return std::make_unique<MapToBatchReduceGEMM>();
 }
+
+std::unique_ptr<OperationPass<func::FuncOp>>
+mlir::tpp::createMapToBatchReduceGEMMPass(bool useParallelLoops) {
+  return std::make_unique<MapToBatchReduceGEMM>(useParallelLoops);
+}
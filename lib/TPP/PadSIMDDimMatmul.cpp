@@ -6,6 +6,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "TPP/Dialect/Stdx/StdxOps.h"
 #include "TPP/Dialect/Tpp/TppOps.h"
 #include "TPP/Dialect/Tpp/TppUtils.h"
 #include "TPP/Passes.h"
@@ -14,6 +15,7 @@
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/Linalg/Transforms/Transforms.h"
 #include "mlir/Dialect/Tensor/Utils/Utils.h"
+#include "mlir/IR/Matchers.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 
 using namespace mlir;
@@ -27,7 +29,9 @@ using namespace mlir::tpp;
 
 namespace {
 
-// Ensure the SIMD dimension to be multiple of 16.
+// Pad the GEMM dimensions (M, N and K) to a multiple of the kernel-friendly
+// sizes. A and B are padded with zeros along K, so the extra products do not
+// contribute to C. The result is sliced back to the original shape of C.
 //
 // Example (SIMD dimension):
 // %0 = tensor.pad (%C) : tensor<3x3xf32> to tensor<3xSIMDxf32>
@@ -37,7 +41,13 @@ namespace {
 //
 struct PadSIMDAndParallelDimensionForGemm
     : public OpRewritePattern<linalg::GenericOp> {
-  using OpRewritePattern<linalg::GenericOp>::OpRewritePattern;
+  PadSIMDAndParallelDimensionForGemm(MLIRContext *context, int64_t mMultiple,
+                                     int64_t nMultiple, int64_t kMultiple,
+                                     PatternBenefit benefit = 1)
+      : OpRewritePattern<linalg::GenericOp>(context, benefit),
+        mMultiple(std::max<int64_t>(mMultiple, 1)),
+        nMultiple(std::max<int64_t>(nMultiple, 1)),
+        kMultiple(std::max<int64_t>(kMultiple, 1)) {}
 
   // POD for GEMM operands.
   struct GemmOperands {
@@ -48,38 +58,22 @@ struct PadSIMDAndParallelDimensionForGemm
     GemmOperands(Value a, Value b, Value c) : a(a), b(b), c(c){};
   };
 
-  // Pad SIMD-dimension using a multiple of 16.
-  void padSIMDDimension(PatternRewriter &rewriter, GemmOperands &operands,
-                        int64_t simdDim, Location loc) const {
-    // no work to do, exit.
-    if (simdDim % 16 == 0)
-      return;
+  // Round `dim` up to the closest multiple of `multiple`.
+  static int64_t roundUp(int64_t dim, int64_t multiple) {
+    return llvm::divideCeil(dim, multiple) * multiple;
+  }
 
-    // compute the closest multiple of 16 and pad the
-    // simd dimension accordingly.
-    int64_t paddedSimd = 16 * std::ceil((float)simdDim / 16.0);
-    ArrayRef<int64_t> shapeB =
-        operands.b.getType().cast<ShapedType>().getShape();
-    ArrayRef<int64_t> shapeC =
-        operands.c.getType().cast<ShapedType>().getShape();
-    SmallVector<int64_t> newShapeC = {shapeC[0], paddedSimd};
-    SmallVector<int64_t> newShapeB = {shapeB[0], paddedSimd};
-    RankedTensorType newRankedC = RankedTensorType::get(
-        newShapeC, operands.c.getType().cast<ShapedType>().getElementType());
-    RankedTensorType newRankedB = RankedTensorType::get(
-        newShapeB, operands.b.getType().cast<ShapedType>().getElementType());
-    Value padZero = rewriter.create<arith::ConstantOp>(
-        loc, operands.c.getType().cast<ShapedType>().getElementType(),
-        rewriter.getZeroAttr(
-            operands.c.getType().cast<ShapedType>().getElementType()));
-    Value paddedC = tensor::createPadHighOp(newRankedC, operands.c, padZero,
-                                            /*nofold*/ false, loc, rewriter);
-    Value paddedB = tensor::createPadHighOp(newRankedB, operands.b, padZero,
-                                            /*nofold*/ false, loc, rewriter);
-
-    // update operands.
-    operands.c = paddedC;
-    operands.b = paddedB;
+  // Pad `operand` with `padZero` up to `newShape`. Return the operand itself if
+  // its shape is already `newShape`.
+  Value padToShape(PatternRewriter &rewriter, Location loc, Value operand,
+                   ArrayRef<int64_t> newShape, Value padZero) const {
+    ShapedType operandType = operand.getType().cast<ShapedType>();
+    if (operandType.getShape() == newShape)
+      return operand;
+    RankedTensorType newRankedType =
+        RankedTensorType::get(newShape, operandType.getElementType());
+    return tensor::createPadHighOp(newRankedType, operand, padZero,
+                                   /*nofold*/ false, loc, rewriter);
   }
 
   LogicalResult padDimensions(linalg::GenericOp linalgOp,
@@ -108,12 +102,29 @@ struct PadSIMDAndParallelDimensionForGemm
     assert(shapeC[0] == shapeA[0] && "expect equal");
     assert(shapeA[1] == shapeB[0] && "expect equal");
 
-    int64_t simdDim = shapeC[1];
+    int64_t m = shapeC[0];
+    int64_t n = shapeC[1];
+    int64_t k = shapeA[1];
+    int64_t paddedM = roundUp(m, mMultiple);
+    int64_t paddedN = roundUp(n, nMultiple);
+    int64_t paddedK = roundUp(k, kMultiple);
     // no work to do, exit.
-    if (simdDim % 16 == 0)
+    if (paddedM == m && paddedN == n && paddedK == k)
       return failure();
 
-    padSIMDDimension(rewriter, operands, simdDim, loc);
+    // The operands may have different element types, e.g., bf16 inputs with
+    // an f32 accumulator. Pad each one with a zero of its own type.
+    auto getPadZero = [&](Value operand) -> Value {
+      Type elementType = operand.getType().cast<ShapedType>().getElementType();
+      return rewriter.create<arith::ConstantOp>(
+          loc, elementType, rewriter.getZeroAttr(elementType));
+    };
+    operands.a = padToShape(rewriter, loc, operands.a, {paddedM, paddedK},
+                            getPadZero(operands.a));
+    operands.b = padToShape(rewriter, loc, operands.b, {paddedK, paddedN},
+                            getPadZero(operands.b));
+    operands.c = padToShape(rewriter, loc, operands.c, {paddedM, paddedN},
+                            getPadZero(operands.c));
 
     linalg::GenericOp replacementOp = rewriter.create<linalg::GenericOp>(
         loc, operands.c.getType(), ValueRange{operands.a, operands.b},
@@ -152,6 +163,144 @@ struct PadSIMDAndParallelDimensionForGemm
       return failure();
     return padDimensions(linalgOp, rewriter);
   }
+
+private:
+  int64_t mMultiple;
+  int64_t nMultiple;
+  int64_t kMultiple;
+};
+
+// Fold a static high padding of a constant into a new, padded, constant. This
+// makes padding the weights a compile-time cost.
+//
+// %cst = arith.constant dense<...> : tensor<3x3xf32>
+// %0 = tensor.pad %cst low[0, 0] high[0, 13] {
+//  ^bb0(%arg3: index, %arg4: index):
+//    tensor.yield %zero : f32
+//  } : tensor<3x3xf32> to tensor<3x16xf32>
+//
+// into
+//
+// %0 = arith.constant dense<...> : tensor<3x16xf32>
+//
+struct FoldPaddingIntoConstant : public OpRewritePattern<tensor::PadOp> {
+  using OpRewritePattern<tensor::PadOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(tensor::PadOp padOp,
+                                PatternRewriter &rewriter) const override {
+    if (!padOp.hasZeroLowPad() || padOp.getNofold())
+      return failure();
+    RankedTensorType sourceType = padOp.getSourceType();
+    RankedTensorType resultType = padOp.getResultType();
+    if (!sourceType.hasStaticShape() || !resultType.hasStaticShape())
+      return failure();
+    DenseElementsAttr source;
+    if (!matchPattern(padOp.getSource(), m_Constant(&source)))
+      return rewriter.notifyMatchFailure(padOp, "expect a constant source");
+    Type elementType = resultType.getElementType();
+    if (!elementType.isIntOrFloat() ||
+        resultType.getElementTypeBitWidth() % 8 != 0)
+      return rewriter.notifyMatchFailure(padOp, "expect byte-sized elements");
+    Value padValue = padOp.getConstantPaddingValue();
+    Attribute padAttr;
+    if (!padValue || !matchPattern(padValue, m_Constant(&padAttr)))
+      return rewriter.notifyMatchFailure(padOp, "expect a constant padding");
+
+    if (source.isSplat() && source.getSplatValue<Attribute>() == padAttr) {
+      rewriter.replaceOpWithNewOp<arith::ConstantOp>(
+          padOp, DenseElementsAttr::get(resultType, padAttr));
+      return success();
+    }
+
+    // Fill the result with the padding value, then copy the rows of the source
+    // in the top-left corner of the result. Work on the raw data to avoid
+    // materializing an attribute per element.
+    ArrayRef<char> padding =
+        DenseElementsAttr::get(RankedTensorType::get({}, elementType), padAttr)
+            .getRawData();
+    ArrayRef<char> sourceData = source.getRawData();
+    size_t elementSize = resultType.getElementTypeBitWidth() / 8;
+    ArrayRef<int64_t> sourceShape = sourceType.getShape();
+    ArrayRef<int64_t> resultShape = resultType.getShape();
+    std::vector<char> result(resultType.getNumElements() * elementSize);
+    for (size_t offset = 0, end = result.size(); offset < end;
+         offset += elementSize)
+      std::copy_n(padding.data(), elementSize, result.begin() + offset);
+    if (sourceType.getNumElements() != 0) {
+      int64_t rank = sourceShape.size();
+      int64_t rowSize = rank == 0 ? 1 : sourceShape[rank - 1];
+      SmallVector<int64_t> sourceIdx(rank, 0);
+      for (int64_t row = 0, numRows = sourceType.getNumElements() / rowSize;
+           row < numRows; row++) {
+        int64_t resultOffset = 0;
+        for (int64_t dim = 0; dim < rank; dim++)
+          resultOffset = resultOffset * resultShape[dim] + sourceIdx[dim];
+        auto resultIt = result.begin() + resultOffset * elementSize;
+        if (source.isSplat()) {
+          for (int64_t i = 0; i < rowSize; i++)
+            std::copy_n(sourceData.data(), elementSize,
+                        resultIt + i * elementSize);
+        } else {
+          std::copy_n(sourceData.data() + row * rowSize * elementSize,
+                      rowSize * elementSize, resultIt);
+        }
+        // Move to the next row of the source, in row-major order.
+        for (int64_t dim = rank - 2; dim >= 0; dim--) {
+          if (++sourceIdx[dim] < sourceShape[dim])
+            break;
+          sourceIdx[dim] = 0;
+        }
+      }
+    }
+    rewriter.replaceOpWithNewOp<arith::ConstantOp>(
+        padOp, DenseElementsAttr::getFromRawBuffer(resultType, result));
+    return success();
+  }
+};
+
+// Hoist a padding out of a closure if its source is defined outside, i.e., it
+// pads a weight (`stdx.const`). The padding then runs once, not per call.
+//
+// stdx.closure(...) {
+//   %0 = tensor.pad %weight low[0, 0] high[0, 13] {...}
+//   ...
+// }
+//
+// into
+//
+// %0 = tensor.pad %weight low[0, 0] high[0, 13] {...}
+// stdx.closure(...) {
+//   ...
+// }
+//
+struct HoistPaddingOutOfClosure : public OpRewritePattern<tensor::PadOp> {
+  using OpRewritePattern<tensor::PadOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(tensor::PadOp padOp,
+                                PatternRewriter &rewriter) const override {
+    stdx::ClosureOp closure = dyn_cast<stdx::ClosureOp>(padOp->getParentOp());
+    if (!closure)
+      return failure();
+    if (!padOp.hasZeroLowPad() || !padOp.getResultType().hasStaticShape())
+      return failure();
+    if (!closure.isDefinedOutsideOfLoop(padOp.getSource()))
+      return failure();
+    Attribute padAttr;
+    Value padValue = padOp.getConstantPaddingValue();
+    if (!padValue || !matchPattern(padValue, m_Constant(&padAttr)))
+      return rewriter.notifyMatchFailure(padOp, "expect a constant padding");
+
+    OpBuilder::InsertionGuard guard(rewriter);
+    rewriter.setInsertionPoint(closure);
+    Location loc = padOp.getLoc();
+    Value hoistedPadValue = rewriter.create<arith::ConstantOp>(
+        loc, padValue.getType(), padAttr);
+    Value hoistedPad = tensor::createPadHighOp(
+        padOp.getResultType(), padOp.getSource(), hoistedPadValue,
+        padOp.getNofold(), loc, rewriter);
+    rewriter.replaceOp(padOp, hoistedPad);
+    return success();
+  }
 };
 
 // Fold chain of static high pad operations.
@@ -610,10 +759,15 @@ struct FusePadOp : OpRewritePattern<tensor::PadOp> {
   }
 };
 
-void populateEnforcePaddingOnSIMDDim(RewritePatternSet &patterns) {
+void populateEnforcePaddingOnSIMDDim(RewritePatternSet &patterns,
+                                     int64_t mMultiple, int64_t nMultiple,
+                                     int64_t kMultiple) {
+  patterns.add<PadSIMDAndParallelDimensionForGemm>(
+      patterns.getContext(), mMultiple, nMultiple, kMultiple);
   // clang-format off
-  patterns.add<PadSIMDAndParallelDimensionForGemm,
-               FusePadOp,
+  patterns.add<FusePadOp,
+               FoldPaddingIntoConstant,
+               HoistPaddingOutOfClosure,
                FoldChainOfStaticPaddings,
                SinkExtractSliceAfterRelu,
                RemoveChainExtractInsertSlice,
@@ -624,9 +778,16 @@ void populateEnforcePaddingOnSIMDDim(RewritePatternSet &patterns) {
 
 struct PadSIMDDimensionForMatmulTpp
     : PadSIMDDimensionForMatmulTppBase<PadSIMDDimensionForMatmulTpp> {
+  PadSIMDDimensionForMatmulTpp() = default;
+  PadSIMDDimensionForMatmulTpp(int64_t mMultiple, int64_t nMultiple,
+                               int64_t kMultiple) {
+    this->mMultiple = mMultiple;
+    this->nMultiple = nMultiple;
+    this->kMultiple = kMultiple;
+  }
   void runOnOperation() override {
     RewritePatternSet patterns(&getContext());
-    populateEnforcePaddingOnSIMDDim(patterns);
+    populateEnforcePaddingOnSIMDDim(patterns, mMultiple, nMultiple, kMultiple);
     (void)applyPatternsAndFoldGreedily(getOperation(), std::move(patterns));
     return;
   }
@@ -638,3 +799,10 @@ std::unique_ptr<OperationPass<func::FuncOp>>
 mlir::tpp::createPasSIMDDimensionPass() {
   return std::make_unique<PadSIMDDimensionForMatmulTpp>();
 }
+
+std::unique_ptr<OperationPass<func::FuncOp>>
+mlir::tpp::createPasSIMDDimensionPass(int64_t mMultiple, int64_t nMultiple,
+                                      int64_t kMultiple) {
+  return std::make_unique<PadSIMDDimensionForMatmulTpp>(mMultiple, nMultiple,
+                                                        kMultiple);
+}
@@ -8,14 +8,18 @@
 
 #include "TPP/Dialect/Tpp/TppUtils.h"
 #include "TPP/Passes.h"
+#include "TPP/TuningDatabase.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/Linalg/Transforms/TilingInterfaceImpl.h"
 #include "mlir/Dialect/Linalg/Transforms/Transforms.h"
 #include "mlir/Dialect/SCF/IR/SCF.h"
 #include "mlir/Dialect/SCF/Transforms/TileUsingInterface.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/Dialect/Tensor/Transforms/Transforms.h"
 #include "mlir/Interfaces/TilingInterface.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include <deque>
 
 using namespace mlir;
 
@@ -101,92 +105,319 @@ static int64_t getSizeRange(Range loopRange) {
 //   rootIterationDomain[0]);
 // }
 
-static LogicalResult tileDivideIterationDomain(linalg::GenericOp linalgOp,
+// Check that `tiles` divide the iteration domain of `linalgOp`, or the tiles
+// of `outerTiles` along the loops they tile. Only parallel loops can be tiled
+// and a tile must be a proper divisor of its range. Missing trailing tile
+// sizes are zero: the loop is not tiled.
+static LogicalResult tileDivideIterationDomain(linalg::LinalgOp linalgOp,
                                                ArrayRef<int64_t> tiles,
+                                               ArrayRef<int64_t> outerTiles,
                                                OpBuilder &builder) {
-  if (linalgOp.getNumLoops() != tiles.size())
+  if (linalgOp.getNumLoops() < tiles.size())
     return failure();
+  SmallVector<StringRef> iteratorTypes = linalgOp.getIteratorTypesArray();
   SmallVector<Range> iterationDomain =
       cast<TilingInterface>(linalgOp.getOperation())
           .getIterationDomain(builder);
-  for (const auto &it : llvm::enumerate(iterationDomain)) {
+  for (const auto &it : llvm::enumerate(tiles)) {
     // fine, we are not tiling along this dimension.
-    if (tiles[it.index()] == 0)
+    if (it.value() == 0)
       continue;
+    if (!linalg::isParallelIterator(iteratorTypes[it.index()]))
+      return failure();
     // require static loop range
-    if (!isStaticRange(it.value()))
+    if (!isStaticRange(iterationDomain[it.index()]))
       return failure();
-    int64_t sizeRange = getSizeRange(it.value());
+    int64_t sizeRange = getSizeRange(iterationDomain[it.index()]);
+    if (it.index() < outerTiles.size() && outerTiles[it.index()] != 0)
+      sizeRange = outerTiles[it.index()];
     // fail if the tail size equals the range
     // or is not a full tile.
-    if (tiles[it.index()] == sizeRange)
+    if (it.value() == sizeRange)
       return failure();
-    if (sizeRange % tiles[it.index()] != 0)
+    if (sizeRange % it.value() != 0)
       return failure();
   }
   return success();
 }
 
-struct FuseGenericOp : public OpRewritePattern<linalg::GenericOp> {
+static bool isZeroTiling(ArrayRef<int64_t> tiles) {
+  return llvm::all_of(tiles, [](int64_t tile) { return tile == 0; });
+}
+
+// Return true if the tiles of `operand`, an input of the contraction
+// `linalgOp`, do not overlap: each dimension of the operand is indexed by a
+// single loop. The tiles of a convolution image overlap along the filter.
+static bool hasDisjointTiles(linalg::LinalgOp linalgOp, OpOperand *operand) {
+  return linalgOp.getMatchingIndexingMap(operand).isProjectedPermutation();
+}
+
+// Collect in `group` the operations to fuse into the tiles of `consumer`: the
+// element-wise producers of the consumer, transitively, down to at most one
+// contraction (matmul, conv or their blocked generics) and the element-wise
+// producers of the contraction's output (i.e., a bias broadcast). The consumer
+// may be the contraction itself. The producers of a contraction input start a
+// new chain, i.e., the previous layer of an MLP, if the input tiles do not
+// overlap; fuseProducers then fuses them only along the loops the input is
+// tiled by. A producer joins the group only if all its users are in the
+// group: a value also needed elsewhere, like the skip connection of a
+// residual block, is read per tile rather than recomputed.
+static void collectFusionGroup(linalg::LinalgOp consumer,
+                               llvm::SmallDenseSet<Operation *> &group) {
+  // Pairs of an operation and the contraction of its chain, if any.
+  SmallVector<std::pair<linalg::LinalgOp, linalg::LinalgOp>> worklist;
+  worklist.push_back(
+      {consumer, (consumer.getNumReductionLoops() > 0) ? consumer : nullptr});
+  group.insert(consumer);
+  while (!worklist.empty()) {
+    auto [current, contraction] = worklist.pop_back_val();
+    for (OpOperand *operand : current.getInputAndOutputOperands()) {
+      bool isContractionInput =
+          current == contraction &&
+          operand->getOperandNumber() < current.getNumInputs();
+      if (isContractionInput && !hasDisjointTiles(current, operand))
+        continue;
+      auto producer = operand->get().getDefiningOp<linalg::LinalgOp>();
+      if (!producer || group.contains(producer) ||
+          !producer.hasTensorSemantics() || producer->getNumResults() != 1)
+        continue;
+      linalg::LinalgOp producerContraction =
+          isContractionInput ? nullptr : contraction;
+      bool isContraction = producer.getNumReductionLoops() > 0;
+      if (isContraction ? static_cast<bool>(producerContraction)
+                        : !linalg::isElementwise(producer))
+        continue;
+      if (!llvm::all_of(producer->getUsers(), [&](Operation *user) {
+            return group.contains(user);
+          }))
+        continue;
+      if (isContraction)
+        producerContraction = producer;
+      group.insert(producer);
+      worklist.push_back({producer, producerContraction});
+    }
+  }
+}
+
+// Return true if `value` depends on the induction variable of `loop`.
+static bool dependsOnInductionVar(Value value, scf::ForOp loop) {
+  SmallVector<Value> worklist = {value};
+  llvm::SmallPtrSet<Operation *, 8> visited;
+  while (!worklist.empty()) {
+    Value current = worklist.pop_back_val();
+    if (current == loop.getInductionVar())
+      return true;
+    Operation *definingOp = current.getDefiningOp();
+    if (!definingOp || !loop->isProperAncestor(definingOp) ||
+        !visited.insert(definingOp).second)
+      continue;
+    llvm::append_range(worklist, definingOp->getOperands());
+  }
+  return false;
+}
+
+// Return true if the tile `sliceOp` extracts changes with every loop of
+// `loops`. Otherwise, fusing its producer would recompute the same tile in
+// each iteration of the loops the slice does not depend on.
+static bool isTiledByAllLoops(tensor::ExtractSliceOp sliceOp,
+                              ArrayRef<scf::ForOp> loops) {
+  return llvm::all_of(loops, [&](scf::ForOp loop) {
+    return llvm::any_of(sliceOp.getOffsets(), [&](Value offset) {
+      return dependsOnInductionVar(offset, loop);
+    });
+  });
+}
+
+// Return true if the only user of `linalgOp` fuses it: an element-wise
+// operation, or a contraction reading it as its output (i.e., a bias
+// broadcast or a fill). The user is then further down the chain and roots the
+// fusion.
+static bool isFusedIntoUser(linalg::LinalgOp linalgOp) {
+  if (!linalgOp->hasOneUse())
+    return false;
+  OpOperand &use = *linalgOp->getUses().begin();
+  auto user = dyn_cast<linalg::LinalgOp>(use.getOwner());
+  if (!user || !user.hasTensorSemantics())
+    return false;
+  if (user.getNumReductionLoops() > 0)
+    return use.getOperandNumber() >= user.getNumInputs();
+  return linalg::isElementwise(user);
+}
+
+// Return the producer of the value `sliceOp` extracts a tile from. If the
+// slice reads a loop-carried destination, walk the iter_args up to the init
+// of the outermost loop and return the init operand in `iterArgOperand`.
+static Optional<OpResult> getUntiledProducer(tensor::ExtractSliceOp sliceOp,
+                                             ArrayRef<scf::ForOp> loops,
+                                             OpOperand *&iterArgOperand) {
+  iterArgOperand = nullptr;
+  Value source = sliceOp.getSource();
+  for (scf::ForOp loop : llvm::reverse(loops)) {
+    auto blockArg = source.dyn_cast<BlockArgument>();
+    if (!blockArg || blockArg.getOwner() != loop.getBody())
+      break;
+    iterArgOperand = &loop.getOpOperandForRegionIterArg(blockArg);
+    source = iterArgOperand->get();
+  }
+  if (auto result = source.dyn_cast<OpResult>())
+    return result;
+  return llvm::None;
+}
+
+struct FuseGenericOp : public OpInterfaceRewritePattern<linalg::LinalgOp> {
   FuseGenericOp(MLIRContext *context, ArrayRef<int64_t> tileSizes,
+                ArrayRef<int64_t> innerTileSizes,
+                const tpp::TuningDatabase &tuningDatabase,
                 PatternBenefit benefit = 1)
-      : OpRewritePattern<linalg::GenericOp>(context, benefit),
-        tileSizes(tileSizes) {}
+      : OpInterfaceRewritePattern<linalg::LinalgOp>(context, benefit),
+        tileSizes(tileSizes), innerTileSizes(innerTileSizes),
+        tuningDatabase(tuningDatabase) {}
+
+  // Fuse the producers of `tiledOp` that belong to `group` into the tile
+  // loops, following the extract_slice ops on the operands of the fused ops.
+  void fuseProducers(PatternRewriter &rewriter, Operation *tiledOp,
+                     ArrayRef<scf::ForOp> loops,
+                     const llvm::SmallDenseSet<Operation *> &group) const {
+    std::deque<tensor::ExtractSliceOp> candidates;
+    auto addCandidateSlices = [&](Operation *fusedOp) {
+      auto linalgOp = dyn_cast<linalg::LinalgOp>(fusedOp);
+      bool isContraction = linalgOp && linalgOp.getNumReductionLoops() > 0;
+      for (OpOperand &operand : fusedOp->getOpOperands()) {
+        auto sliceOp = operand.get().getDefiningOp<tensor::ExtractSliceOp>();
+        if (!sliceOp)
+          continue;
+        // A contraction reads its inputs along the reduction: fuse their
+        // producers only if each tile is read by a single iteration.
+        if (isContraction &&
+            operand.getOperandNumber() < linalgOp.getNumInputs() &&
+            !isTiledByAllLoops(sliceOp, loops))
+          continue;
+        candidates.push_back(sliceOp);
+      }
+    };
+    addCandidateSlices(tiledOp);
+
+    while (!candidates.empty()) {
+      tensor::ExtractSliceOp sliceOp = candidates.front();
+      candidates.pop_front();
+      OpOperand *iterArgOperand = nullptr;
+      Optional<OpResult> producer =
+          getUntiledProducer(sliceOp, loops, iterArgOperand);
+      if (!producer || !group.contains(producer->getOwner()))
+        continue;
 
-  bool isInplace(linalg::LinalgOp linalgOp) const {
-    return linalgOp.getNumInputs() == 0;
+      Value loopCarried = sliceOp.getSource();
+      FailureOr<Value> fusedProducer =
+          tensor::replaceExtractSliceWithTiledProducer(rewriter, sliceOp,
+                                                       *producer);
+      if (failed(fusedProducer))
+        continue;
+      rewriter.replaceOp(sliceOp, *fusedProducer);
+
+      auto tiledProducer = fusedProducer->getDefiningOp<linalg::LinalgOp>();
+      if (!tiledProducer)
+        continue;
+      // The producer was the destination of the tile loops: start the loops
+      // from the producer's own destination and let the tiled producer
+      // update the loop-carried tile in place.
+      if (iterArgOperand) {
+        unsigned resultNumber = producer->getResultNumber();
+        auto untiledProducer = cast<linalg::LinalgOp>(producer->getOwner());
+        rewriter.updateRootInPlace(loops.front(), [&]() {
+          iterArgOperand->set(
+              untiledProducer.getOutputOperand(resultNumber)->get());
+        });
+        if (auto initSlice = tiledProducer.getOutputOperand(resultNumber)
+                                 ->get()
+                                 .getDefiningOp<tensor::ExtractSliceOp>())
+          rewriter.updateRootInPlace(initSlice, [&]() {
+            initSlice.getSourceMutable().assign(loopCarried);
+          });
+      }
+      addCandidateSlices(tiledProducer);
+    }
+  }
+
+  // Tile `root` by `tiles` and fuse its fusion group in the tile loops. Return
+  // the tiled root.
+  FailureOr<linalg::LinalgOp> tileAndFuse(PatternRewriter &rewriter,
+                                          linalg::LinalgOp root,
+                                          ArrayRef<int64_t> tiles) const {
+    llvm::SmallDenseSet<Operation *> group;
+    collectFusionGroup(root, group);
+    scf::SCFTilingOptions options;
+    options.setTileSizes(tiles);
+    FailureOr<scf::SCFTilingResult> tilingResult = scf::tileUsingSCFForOp(
+        rewriter, cast<TilingInterface>(root.getOperation()), options);
+    if (failed(tilingResult))
+      return failure();
+    fuseProducers(rewriter, tilingResult->tiledOp, tilingResult->loops, group);
+    rewriter.replaceOp(root, tilingResult->loops[0].getResults());
+    return cast<linalg::LinalgOp>(tilingResult->tiledOp);
   }
 
-  // Locate an element-wise operation and fuse if the producer
-  // is a matmul.
-  LogicalResult matchAndRewrite(linalg::GenericOp linalgOp,
+  // Locate the last operation mappable to a TPP of a chain (an element-wise
+  // operation or a contraction), tile it and fuse in the tile loops the
+  // element-wise chain, the contraction, the producers of its output
+  // (i.e., bias) and the chains producing its inputs along the loops that
+  // tile them (i.e., the previous layers of an MLP along the rows). With
+  // inner tile sizes, tile and fuse again the tiled chain: i.e., L1 tiles
+  // within an L2 tile.
+  LogicalResult matchAndRewrite(linalg::LinalgOp linalgOp,
                                 PatternRewriter &rewriter) const override {
 
-    // hook only element-wise operation with tensor semantics.
-    if (!linalgOp.hasTensorSemantics() || !linalg::isElementwise(linalgOp))
+    // hook only single result operations with tensor semantics.
+    if (!linalgOp.hasTensorSemantics() || linalgOp->getNumResults() != 1)
       return failure();
 
-    // further restrict to single result operations.
-    linalg::OpOperandVector operands = isInplace(linalgOp)
-                                           ? linalgOp.getOutputOperands()
-                                           : linalgOp.getInputOperands();
-    if (operands.size() != 1)
+    // further restrict to element-wise operations and contractions ending
+    // the chain.
+    if (!linalg::isElementwise(linalgOp) &&
+        linalgOp.getNumReductionLoops() == 0)
       return failure();
-    linalg::LinalgOp producer =
-        dyn_cast_or_null<linalg::LinalgOp>(operands[0]->get().getDefiningOp());
-    if (!producer)
+    if (isFusedIntoUser(linalgOp))
       return failure();
 
-    if (producer.getNumParallelLoops() != tileSizes.size()) {
-      producer->emitRemark(
-          "expect tile sizes to be equal to number of parallel loops");
+    SmallVector<int64_t> consumerTileSizes = llvm::to_vector(tileSizes);
+    if (Optional<SmallVector<int64_t>> tunedTileSizes =
+            tuningDatabase.lookup("tile-consumer-and-fuse-producers",
+                                  linalgOp))
+      consumerTileSizes = *tunedTileSizes;
+    if (isZeroTiling(consumerTileSizes))
       return failure();
-    }
 
-    if (failed(tileDivideIterationDomain(linalgOp, tileSizes, rewriter))) {
+    if (failed(tileDivideIterationDomain(linalgOp, consumerTileSizes,
+                                         /*outerTiles=*/{}, rewriter))) {
       linalgOp->emitRemark("wrong tile sizes");
       return failure();
     }
+    if (failed(tileDivideIterationDomain(linalgOp, innerTileSizes,
+                                         consumerTileSizes, rewriter))) {
+      linalgOp->emitRemark("wrong inner tile sizes");
+      return failure();
+    }
 
     // tile and fuse.
-    scf::SCFTileAndFuseOptions options;
-    options.tilingOptions.setTileSizes(tileSizes);
-    TilingInterface tilingInterfaceOp =
-        cast<TilingInterface>(linalgOp.getOperation());
-    FailureOr<scf::SCFTileAndFuseResult> tileAndFuseResult =
-        tileConsumerAndFuseProducerGreedilyUsingSCFForOp(
-            rewriter, tilingInterfaceOp, options);
-    if (failed(tileAndFuseResult))
+    FailureOr<linalg::LinalgOp> tiledOp =
+        tileAndFuse(rewriter, linalgOp, consumerTileSizes);
+    if (failed(tiledOp))
       return failure();
-    rewriter.replaceOp(linalgOp, tileAndFuseResult->loops[0].getResults());
+    if (!isZeroTiling(innerTileSizes) &&
+        failed(tileAndFuse(rewriter, *tiledOp, innerTileSizes)))
+      (*tiledOp)->emitRemark("failed to tile with inner sizes");
     return success();
   }
   ArrayRef<int64_t> tileSizes;
+  ArrayRef<int64_t> innerTileSizes;
+  const tpp::TuningDatabase &tuningDatabase;
 };
 
 void populateFusionPatterns(RewritePatternSet &patterns,
-                            ArrayRef<int64_t> tileSizes) {
-  patterns.add<FuseGenericOp>(patterns.getContext(), tileSizes);
+                            ArrayRef<int64_t> tileSizes,
+                            ArrayRef<int64_t> innerTileSizes,
+                            const tpp::TuningDatabase &tuningDatabase) {
+  patterns.add<FuseGenericOp>(patterns.getContext(), tileSizes,
+                              innerTileSizes, tuningDatabase);
 }
 
 struct TileConsumerAndFuseProducers
@@ -200,8 +431,12 @@ struct TileConsumerAndFuseProducers
     linalg::registerTilingInterfaceExternalModels(registry);
   }
   void runOnOperation() override {
+    std::shared_ptr<const tpp::TuningDatabase> db =
+        tpp::TuningDatabase::loadForPass(tuningDatabase, getOperation());
+    if (!db)
+      return signalPassFailure();
     RewritePatternSet patterns(&getContext());
-    populateFusionPatterns(patterns, tileSizes);
+    populateFusionPatterns(patterns, tileSizes, innerTileSizes, *db);
     // fold unit-extent dims for linalg on tensors.
     linalg::populateFoldUnitExtentDimsPatterns(patterns);
     (void)applyPatternsAndFoldGreedily(getOperation(), std::move(patterns));
@@ -6,10 +6,13 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "TPP/CostModel.h"
 #include "TPP/Dialect/LinalgX/LinalgXOps.h"
 #include "TPP/Dialect/Tpp/TppUtils.h"
 #include "TPP/Passes.h"
 #include "TPP/Transforms.h"
+#include "TPP/TuningDatabase.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/Bufferization/IR/Bufferization.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
@@ -19,6 +22,7 @@
 #include "mlir/Support/MathExtras.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 #include "llvm/ADT/TypeSwitch.h"
+#include <numeric>
 
 using namespace mlir;
 using namespace mlir::linalgx;
@@ -30,7 +34,25 @@ using namespace mlir::linalgx;
 // Utils
 //===----------------------------------------------------------------------===//
 
-/// Helper function to create the pack operation.
+/// Return true if one of the static `tiles` does not divide the static size
+/// of the dimension it tiles.
+static bool hasPartialTiles(ShapedType inputType, ArrayRef<int64_t> tiles,
+                            ArrayRef<int64_t> innerDimsPos) {
+  for (auto it : llvm::zip(tiles, innerDimsPos)) {
+    int64_t tile = std::get<0>(it);
+    int64_t size = inputType.getDimSize(std::get<1>(it));
+    if (ShapedType::isDynamic(tile) || ShapedType::isDynamic(size))
+      continue;
+    if (size % tile != 0)
+      return true;
+  }
+  return false;
+}
+
+/// Helper function to create the pack operation. Partial tiles are padded
+/// with zeros, so that a padded reduction dimension does not change the
+/// result of a contraction; the padding of the other dimensions is dropped
+/// by the unpack.
 static Value toPackLayoutImpl(Location loc, Value input,
                               ArrayRef<OpFoldResult> tiles,
                               ArrayRef<int64_t> innerDimsPos,
@@ -44,6 +66,12 @@ static Value toPackLayoutImpl(Location loc, Value input,
                                             innerDimsPos, outerDimsPerm);
   ShapedType inputType = input.getType().cast<ShapedType>();
   ArrayRef<int64_t> shape = result.getShape();
+  Value padding;
+  if (hasPartialTiles(inputType, staticTiles, innerDimsPos)) {
+    Type elementType = inputType.getElementType();
+    padding = builder.create<arith::ConstantOp>(
+        loc, elementType, builder.getZeroAttr(elementType));
+  }
   Value output;
   if (useAlloc)
     output = builder.create<bufferization::AllocTensorOp>(
@@ -54,7 +82,7 @@ static Value toPackLayoutImpl(Location loc, Value input,
         builder.create<tensor::EmptyOp>(loc, shape, inputType.getElementType());
   return builder
       .create<linalgx::PackOp>(loc, input, output, innerDimsPos, outerDimsPerm,
-                               tiles)
+                               tiles, padding)
       .getResults()[0];
 }
 
@@ -182,6 +210,52 @@ static Value toPackLayoutKCRS_KCRSck(Location loc, Value input,
                           useAlloc);
 }
 
+/// Helper function to pack from RSC to CRSc.
+static Value toPackLayoutRSC_CRSc(Location loc, Value input,
+                                  ArrayRef<OpFoldResult> tiles,
+                                  OpBuilder &builder) {
+  assert(tiles.size() == 1 && "expect one tile size for RSC_CRSc");
+  SmallVector<int64_t> innerDimsPos = {2};
+  SmallVector<int64_t> outerDimsPerm = {2, 0, 1};
+  return toPackLayoutImpl(loc, input, tiles, innerDimsPos, outerDimsPerm,
+                          builder);
+}
+
+static Value handleLayoutNGCHW_NGCHWc(Location loc, Value input, Value output,
+                                      ArrayRef<OpFoldResult> tiles,
+                                      OpBuilder &builder) {
+  assert(tiles.size() == 1 && "expect one tile size for NGCHW_NGCHWc");
+  SmallVector<int64_t> innerDimPos = {2};
+  if (!output)
+    return toPackLayoutImpl(loc, input, tiles, innerDimPos, {}, builder);
+  return toUnPackLayoutImpl(loc, input, output, tiles, innerDimPos, {},
+                            builder);
+}
+
+/// Helper function to pack from FGCRS to GFCRScf.
+static Value toPackLayoutFGCRS_GFCRScf(Location loc, Value input,
+                                       ArrayRef<OpFoldResult> tiles,
+                                       OpBuilder &builder) {
+  assert(tiles.size() == 2 && "expect two tiles size for FGCRS_GFCRScf");
+  SmallVector<int64_t> innerDimsPos = {2, 0};
+  SmallVector<int64_t> outerDimsPerm = {1, 0, 2, 3, 4};
+  return toPackLayoutImpl(loc, input, tiles, innerDimsPos, outerDimsPerm,
+                          builder);
+}
+
+/// Return the two values of the strides or dilations attribute of a 2D
+/// convolution, or ones if the attribute is absent.
+static SmallVector<int64_t, 2> getConv2DAttrValues(DenseIntElementsAttr attr) {
+  SmallVector<int64_t, 2> values = {1, 1};
+  if (!attr)
+    return values;
+  auto attrValues = attr.getValues<int64_t>();
+  assert(attrValues.size() == 2 && "expect two values");
+  values[0] = attrValues[0];
+  values[1] = attrValues[1];
+  return values;
+}
+
 template <typename OpTy>
 static FailureOr<linalg::GenericOp>
 packConvolutions(RewriterBase &rewriter, OpTy convOp,
@@ -226,13 +300,9 @@ packConvolutions(RewriterBase &rewriter, OpTy convOp,
           ? toPackLayoutNPQK_NKPQk(loc, output, tiles[0], rewriter)
           : toPackLayoutNCHW_NCHWc(loc, output, tiles[0], rewriter);
 
-  SmallVector<int64_t, 2> strides = {1, 1};
-  if (DenseIntElementsAttr stridesAttr = convOp.getStrides()) {
-    auto strideValues = stridesAttr.getValues<int64_t>();
-    assert(strideValues.size() == 2 && "expect two stride values");
-    strides[0] = strideValues[0];
-    strides[1] = strideValues[1];
-  }
+  SmallVector<int64_t, 2> strides = getConv2DAttrValues(convOp.getStrides());
+  SmallVector<int64_t, 2> dilations =
+      getConv2DAttrValues(convOp.getDilations());
 
   // Swap convolution with generic.
   //         N   K   P   Q   k   C   R   S   c
@@ -242,7 +312,9 @@ packConvolutions(RewriterBase &rewriter, OpTy convOp,
       AffineMap::get(/*dims=*/9, /*symbols=*/0, {p1, p2, p3, p4, p5}, ctx);
   AffineMap mapImg = AffineMap::get(
       /*dims=*/9, /*symbols=*/0,
-      {p1, r1, p3 * strides[0] + r2, p4 * strides[1] + r3, r4}, ctx);
+      {p1, r1, p3 * strides[0] + r2 * dilations[0],
+       p4 * strides[1] + r3 * dilations[1], r4},
+      ctx);
   AffineMap mapFil =
       AffineMap::get(/*dims=*/9, /*symbols=*/0, {p2, r1, r2, r3, r4, p5}, ctx);
   linalg::GenericOp replacementOp = rewriter.create<linalg::GenericOp>(
@@ -295,6 +367,141 @@ mlir::linalgx::packConv2DNchwFchwOp(RewriterBase &rewriter,
   return packConvolutions(rewriter, convOp, tiles);
 }
 
+//===----------------------------------------------------------------------===//
+// DepthwiseConv2DNhwcHwcOp
+//===----------------------------------------------------------------------===//
+// Original layout: [N][P][Q][C] += [N][H][W][C] * [R][S][C]
+// New      layout: [N][C'][P][Q][c] += [N][C'][H][W][c] * [C'][R][S][c]
+FailureOr<linalg::GenericOp> mlir::linalgx::packDepthwiseConv2DNhwcHwcOp(
+    RewriterBase &rewriter, linalg::DepthwiseConv2DNhwcHwcOp convOp,
+    ArrayRef<OpFoldResult> tiles) {
+  if (tiles.size() != 1)
+    return rewriter.notifyMatchFailure(convOp, "require 1 tile factor");
+  if (convOp.hasDynamicShape())
+    return rewriter.notifyMatchFailure(convOp, "require static shape");
+  if (convOp.hasBufferSemantics())
+    return rewriter.notifyMatchFailure(convOp, "require tensor semantics");
+
+  Location loc = convOp.getLoc();
+  MLIRContext *ctx = convOp.getContext();
+
+  SmallVector<Value> inputOperands = convOp.getInputOperands();
+  SmallVector<Value> outputOperands = convOp.getOutputOperands();
+
+  // The channels of the image, the filter and the output are blocked with
+  // the same factor.
+  Value packedImage =
+      toPackLayoutNPQK_NKPQk(loc, inputOperands[0], tiles, rewriter);
+  Value packedFilter =
+      toPackLayoutRSC_CRSc(loc, inputOperands[1], tiles, rewriter);
+  Value packedOutput =
+      toPackLayoutNPQK_NKPQk(loc, outputOperands[0], tiles, rewriter);
+
+  SmallVector<int64_t, 2> strides = getConv2DAttrValues(convOp.getStrides());
+  SmallVector<int64_t, 2> dilations =
+      getConv2DAttrValues(convOp.getDilations());
+
+  // Swap convolution with generic.
+  //         N   C'  P   Q   c   R   S
+  AffineExpr p1, p2, p3, p4, p5, r1, r2;
+  bindDims(ctx, p1, p2, p3, p4, p5, r1, r2);
+  AffineMap mapOut =
+      AffineMap::get(/*dims=*/7, /*symbols=*/0, {p1, p2, p3, p4, p5}, ctx);
+  AffineMap mapImg = AffineMap::get(
+      /*dims=*/7, /*symbols=*/0,
+      {p1, p2, p3 * strides[0] + r1 * dilations[0],
+       p4 * strides[1] + r2 * dilations[1], p5},
+      ctx);
+  AffineMap mapFil =
+      AffineMap::get(/*dims=*/7, /*symbols=*/0, {p2, r1, r2, p5}, ctx);
+  linalg::GenericOp replacementOp = rewriter.create<linalg::GenericOp>(
+      loc, packedOutput.getType(), ValueRange{packedImage, packedFilter},
+      ValueRange{packedOutput}, ArrayRef<AffineMap>{mapImg, mapFil, mapOut},
+      ArrayRef<StringRef>{
+          getParallelIteratorTypeName(), getParallelIteratorTypeName(),
+          getParallelIteratorTypeName(), getParallelIteratorTypeName(),
+          getParallelIteratorTypeName(), getReductionIteratorTypeName(),
+          getReductionIteratorTypeName()},
+      /*doc=*/"", /*libraryCall=*/"");
+  rewriter.inlineRegionBefore(convOp->getRegion(0), replacementOp.getRegion(),
+                              replacementOp.getRegion().begin());
+
+  // convert back from pack layout.
+  Value outReplacement = fromPackLayoutNKPQk_NPQK(
+      loc, replacementOp.getResult(0), outputOperands[0], tiles, rewriter);
+  rewriter.replaceOp(convOp, outReplacement);
+  return replacementOp;
+}
+
+//===----------------------------------------------------------------------===//
+// Conv2DNgchwFgchwOp
+//===----------------------------------------------------------------------===//
+// Original layout: [N][G][F][P][Q] += [N][G][C][H][W] * [F][G][C][R][S]
+// New      layout: [N][G][F'][P][Q][f] +=
+//                    [N][G][C'][H][W][c] * [G][F'][C'][R][S][c][f]
+// Each group is a blocked Conv2DNchwFchwOp: tiles are {c, f}.
+FailureOr<linalg::GenericOp>
+mlir::linalgx::packConv2DNgchwFgchwOp(RewriterBase &rewriter,
+                                      linalg::Conv2DNgchwFgchwOp convOp,
+                                      ArrayRef<OpFoldResult> tiles) {
+  if (tiles.size() != 2)
+    return rewriter.notifyMatchFailure(convOp, "require 2 tile factors");
+  if (convOp.hasDynamicShape())
+    return rewriter.notifyMatchFailure(convOp, "require static shape");
+  if (convOp.hasBufferSemantics())
+    return rewriter.notifyMatchFailure(convOp, "require tensor semantics");
+
+  Location loc = convOp.getLoc();
+  MLIRContext *ctx = convOp.getContext();
+
+  SmallVector<Value> inputOperands = convOp.getInputOperands();
+  SmallVector<Value> outputOperands = convOp.getOutputOperands();
+
+  Value packedImage = handleLayoutNGCHW_NGCHWc(loc, inputOperands[0], nullptr,
+                                               tiles[0], rewriter);
+  Value packedFilter =
+      toPackLayoutFGCRS_GFCRScf(loc, inputOperands[1], tiles, rewriter);
+  Value packedOutput = handleLayoutNGCHW_NGCHWc(loc, outputOperands[0],
+                                                nullptr, tiles[1], rewriter);
+
+  SmallVector<int64_t, 2> strides = getConv2DAttrValues(convOp.getStrides());
+  SmallVector<int64_t, 2> dilations =
+      getConv2DAttrValues(convOp.getDilations());
+
+  // Swap convolution with generic.
+  //         N   G   F'  P   Q   f   C'  R   S   c
+  AffineExpr p1, p2, p3, p4, p5, p6, r1, r2, r3, r4;
+  bindDims(ctx, p1, p2, p3, p4, p5, p6, r1, r2, r3, r4);
+  AffineMap mapOut = AffineMap::get(/*dims=*/10, /*symbols=*/0,
+                                    {p1, p2, p3, p4, p5, p6}, ctx);
+  AffineMap mapImg = AffineMap::get(
+      /*dims=*/10, /*symbols=*/0,
+      {p1, p2, r1, p4 * strides[0] + r2 * dilations[0],
+       p5 * strides[1] + r3 * dilations[1], r4},
+      ctx);
+  AffineMap mapFil = AffineMap::get(/*dims=*/10, /*symbols=*/0,
+                                    {p2, p3, r1, r2, r3, r4, p6}, ctx);
+  linalg::GenericOp replacementOp = rewriter.create<linalg::GenericOp>(
+      loc, packedOutput.getType(), ValueRange{packedImage, packedFilter},
+      ValueRange{packedOutput}, ArrayRef<AffineMap>{mapImg, mapFil, mapOut},
+      ArrayRef<StringRef>{
+          getParallelIteratorTypeName(), getParallelIteratorTypeName(),
+          getParallelIteratorTypeName(), getParallelIteratorTypeName(),
+          getParallelIteratorTypeName(), getParallelIteratorTypeName(),
+          getReductionIteratorTypeName(), getReductionIteratorTypeName(),
+          getReductionIteratorTypeName(), getReductionIteratorTypeName()},
+      /*doc=*/"", /*libraryCall=*/"");
+  rewriter.inlineRegionBefore(convOp->getRegion(0), replacementOp.getRegion(),
+                              replacementOp.getRegion().begin());
+
+  // convert back from pack layout.
+  Value outReplacement =
+      handleLayoutNGCHW_NGCHWc(loc, replacementOp.getResult(0),
+                               outputOperands[0], tiles[1], rewriter);
+  rewriter.replaceOp(convOp, outReplacement);
+  return replacementOp;
+}
+
 //===----------------------------------------------------------------------===//
 // MatmulOp
 //===----------------------------------------------------------------------===//
@@ -371,18 +578,136 @@ mlir::linalgx::packMatmulOp(RewriterBase &rewriter, linalg::MatmulOp matmulOp,
 
 namespace {
 
+// Return the blocking factors of `matmulOp` from the tuning database, or the
+// user-provided ones, or the ones selected by the cost model, in this order of
+// precedence. `fromCostModel` is set if the cost model selected them.
+static FailureOr<SmallVector<int64_t>>
+getMatmulBlockingFactors(linalg::MatmulOp matmulOp,
+                         ArrayRef<int64_t> blockingFactors, bool useCostModel,
+                         const tpp::TuningDatabase &tuningDatabase,
+                         bool &fromCostModel) {
+  fromCostModel = false;
+  if (Optional<SmallVector<int64_t>> tunedTiles =
+          tuningDatabase.lookup("pack-matmul", matmulOp))
+    return *tunedTiles;
+  if (!blockingFactors.empty())
+    return llvm::to_vector(blockingFactors);
+  if (!useCostModel || matmulOp.hasDynamicShape())
+    return failure();
+  fromCostModel = true;
+  ShapedType typeA = matmulOp.getInputs()[0].getType().cast<ShapedType>();
+  ShapedType typeB = matmulOp.getInputs()[1].getType().cast<ShapedType>();
+  int64_t elementBytes = typeA.getElementTypeBitWidth() / 8;
+  tpp::MatmulTileSizes tiles = tpp::selectMatmulBlockingFactors(
+      typeA.getShape()[0], typeB.getShape()[1], typeA.getShape()[1],
+      elementBytes);
+  return SmallVector<int64_t>{tiles.m, tiles.n, tiles.k};
+}
+
+// Report the blocking factors selected by the cost model for `matmulOp`.
+static void emitCostModelRemark(linalg::MatmulOp matmulOp,
+                                ArrayRef<int64_t> tiles) {
+  matmulOp->emitRemark() << "cost model blocking factors: [" << tiles[0]
+                         << ", " << tiles[1] << ", " << tiles[2] << "]";
+}
+
+// Return the matmul that produces `value` through a chain of element-wise
+// operations (i.e., bias and relu), if any.
+static linalg::MatmulOp getProducerMatmul(Value value) {
+  Operation *defOp = value.getDefiningOp();
+  if (auto matmulOp = dyn_cast_or_null<linalg::MatmulOp>(defOp))
+    return matmulOp;
+  auto genericOp = dyn_cast_or_null<linalg::GenericOp>(defOp);
+  if (!genericOp || !genericOp.hasTensorSemantics() ||
+      genericOp.getNumLoops() != genericOp.getNumParallelLoops())
+    return nullptr;
+  for (OpOperand *operand : genericOp.getInputAndOutputOperands()) {
+    if (operand->get().getType() != value.getType() ||
+        !genericOp.getMatchingIndexingMap(operand).isIdentity())
+      continue;
+    if (linalg::MatmulOp matmulOp = getProducerMatmul(operand->get()))
+      return matmulOp;
+  }
+  return nullptr;
+}
+
+// Harmonized blocking factors below this size make the micro-kernels too
+// small to pay off the relayout they save.
+static constexpr int64_t kMinHarmonizedBlockingFactor = 16;
+
+// Pick common blocking factors for consecutive matmuls: the output of a
+// producer [M][N] is the LHS [M][K] of its consumer, so the producer's tiles
+// on M and N must match the consumer's tiles on M and K. Otherwise the
+// activations are unpacked and packed again between the layers. Mismatching
+// factors are replaced by their greatest common divisor, which still divides
+// the dimension if both factors do. A pair keeps its relayout instead if the
+// common factors would fall below `kMinHarmonizedBlockingFactor` (or below the
+// factors selected for the pair, if already smaller), or if they would change
+// the factors of a matmul in `tunedOps`, i.e., taken from the tuning database.
+static void harmonizeBlockingFactors(
+    ArrayRef<std::pair<Operation *, Operation *>> producerConsumerPairs,
+    DenseMap<Operation *, SmallVector<int64_t>> &blockingFactors,
+    const llvm::SmallPtrSetImpl<Operation *> &tunedOps) {
+  auto isAcceptable = [](int64_t common, int64_t lhs, int64_t rhs) {
+    return common >= std::min({kMinHarmonizedBlockingFactor, lhs, rhs});
+  };
+  llvm::SmallDenseSet<unsigned> rejectedPairs;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (auto en : llvm::enumerate(producerConsumerPairs)) {
+      if (rejectedPairs.count(en.index()))
+        continue;
+      auto [producer, consumer] = en.value();
+      SmallVector<int64_t> &producerTiles =
+          blockingFactors.find(producer)->second;
+      SmallVector<int64_t> &consumerTiles =
+          blockingFactors.find(consumer)->second;
+      int64_t tileOnM = std::gcd(producerTiles[0], consumerTiles[0]);
+      int64_t tileOnK = std::gcd(producerTiles[1], consumerTiles[2]);
+      bool producerChanges =
+          producerTiles[0] != tileOnM || producerTiles[1] != tileOnK;
+      bool consumerChanges =
+          consumerTiles[0] != tileOnM || consumerTiles[2] != tileOnK;
+      if (!producerChanges && !consumerChanges)
+        continue;
+      if (!isAcceptable(tileOnM, producerTiles[0], consumerTiles[0]) ||
+          !isAcceptable(tileOnK, producerTiles[1], consumerTiles[2]) ||
+          (producerChanges && tunedOps.contains(producer)) ||
+          (consumerChanges && tunedOps.contains(consumer))) {
+        rejectedPairs.insert(en.index());
+        continue;
+      }
+      producerTiles[0] = consumerTiles[0] = tileOnM;
+      producerTiles[1] = consumerTiles[2] = tileOnK;
+      changed = true;
+    }
+  }
+}
+
 // Pack MatmulOp.
 struct DoItOnMatmul : public OpRewritePattern<linalg::MatmulOp> {
   DoItOnMatmul(MLIRContext *context, ArrayRef<int64_t> blockingFactors,
+               bool useCostModel, const tpp::TuningDatabase &tuningDatabase,
                PatternBenefit benefit = 1)
       : OpRewritePattern<linalg::MatmulOp>(context, benefit),
-        blockingFactors(blockingFactors) {}
+        blockingFactors(blockingFactors), useCostModel(useCostModel),
+        tuningDatabase(tuningDatabase) {}
 
   LogicalResult matchAndRewrite(linalg::MatmulOp matmulOp,
                                 PatternRewriter &rewriter) const override {
+    if (!matmulOp.hasTensorSemantics() || matmulOp.hasDynamicShape())
+      return rewriter.notifyMatchFailure(matmulOp, "require static tensors");
+    bool fromCostModel = false;
+    FailureOr<SmallVector<int64_t>> tiles = getMatmulBlockingFactors(
+        matmulOp, blockingFactors, useCostModel, tuningDatabase, fromCostModel);
+    if (failed(tiles))
+      return rewriter.notifyMatchFailure(matmulOp, "no blocking factors");
+    if (fromCostModel)
+      emitCostModelRemark(matmulOp, *tiles);
     FailureOr<linalg::GenericOp> packedMatmul = mlir::linalgx::packMatmulOp(
         rewriter, matmulOp,
-        getAsOpFoldResult(rewriter.getI64ArrayAttr(blockingFactors)));
+        getAsOpFoldResult(rewriter.getI64ArrayAttr(*tiles)));
     if (failed(packedMatmul))
       return failure();
     return success();
@@ -390,6 +715,8 @@ struct DoItOnMatmul : public OpRewritePattern<linalg::MatmulOp> {
 
 private:
   ArrayRef<int64_t> blockingFactors;
+  bool useCostModel;
+  const tpp::TuningDatabase &tuningDatabase;
 };
 
 // From linalg.generic to linalg.matmul.
@@ -421,12 +748,62 @@ struct PackMatmul : public PackMatmulBase<PackMatmul> {
   }
 
   void runOnOperation() override {
-    if (blockingFactors.empty())
+    std::shared_ptr<const tpp::TuningDatabase> db =
+        tpp::TuningDatabase::loadForPass(tuningDatabase, getOperation());
+    if (!db)
+      return signalPassFailure();
+    if (blockingFactors.empty() && !useCostModel && db->empty())
       return;
+
+    // Select the blocking factors of all the matmuls upfront, and make them
+    // agree along chains of matmuls.
+    SmallVector<linalg::MatmulOp> selectedMatmuls;
+    DenseMap<Operation *, SmallVector<int64_t>> selectedTiles;
+    SmallVector<std::pair<Operation *, Operation *>> producerConsumerPairs;
+    llvm::SmallPtrSet<Operation *, 4> tunedOps;
+    llvm::SmallPtrSet<Operation *, 4> costModelOps;
+    getOperation().walk([&](linalg::MatmulOp matmulOp) {
+      if (!matmulOp.hasTensorSemantics() || matmulOp.hasDynamicShape())
+        return;
+      bool fromCostModel = false;
+      FailureOr<SmallVector<int64_t>> tiles = getMatmulBlockingFactors(
+          matmulOp, blockingFactors, useCostModel, *db, fromCostModel);
+      if (failed(tiles) || tiles->size() != 3)
+        return;
+      selectedMatmuls.push_back(matmulOp);
+      selectedTiles[matmulOp] = *tiles;
+      if (db->lookup("pack-matmul", matmulOp))
+        tunedOps.insert(matmulOp);
+      if (fromCostModel)
+        costModelOps.insert(matmulOp);
+      linalg::MatmulOp producer = getProducerMatmul(matmulOp.getInputs()[0]);
+      if (producer && selectedTiles.count(producer))
+        producerConsumerPairs.push_back(
+            {producer.getOperation(), matmulOp.getOperation()});
+    });
+    harmonizeBlockingFactors(producerConsumerPairs, selectedTiles, tunedOps);
+
+    // Pack the selected matmuls before running any pattern: the selection is
+    // keyed on the matmuls, which the rewrites below erase.
     MLIRContext *ctx = getOperation().getContext();
+    IRRewriter rewriter(ctx);
+    for (linalg::MatmulOp matmulOp : selectedMatmuls) {
+      ArrayRef<int64_t> tiles = selectedTiles.find(matmulOp)->second;
+      if (costModelOps.contains(matmulOp))
+        emitCostModelRemark(matmulOp, tiles);
+      rewriter.setInsertionPoint(matmulOp);
+      (void)mlir::linalgx::packMatmulOp(
+          rewriter, matmulOp,
+          getAsOpFoldResult(rewriter.getI64ArrayAttr(tiles)));
+    }
+
     RewritePatternSet patterns(ctx);
     mlir::tpp::populateSinkRelayoutPatterns(patterns);
-    patterns.add<DoItOnMatmul>(ctx, blockingFactors);
+    // Fold the packs of constants, and cancel the unpack/pack pairs between
+    // the layers.
+    linalgx::PackOp::getCanonicalizationPatterns(patterns, ctx);
+    linalgx::UnPackOp::getCanonicalizationPatterns(patterns, ctx);
+    patterns.add<DoItOnMatmul>(ctx, blockingFactors, useCostModel, *db);
     patterns.add<DeGeneralizeMatmul>(ctx);
     (void)applyPatternsAndFoldGreedily(getOperation(), std::move(patterns));
     return;
@@ -436,16 +813,56 @@ struct PackMatmul : public PackMatmulBase<PackMatmul> {
 struct DoItOnConv2DNchwFchw
     : public OpRewritePattern<linalg::Conv2DNchwFchwOp> {
   DoItOnConv2DNchwFchw(MLIRContext *context, ArrayRef<int64_t> blockingFactors,
+                       const tpp::TuningDatabase &tuningDatabase,
                        PatternBenefit benefit = 1)
       : OpRewritePattern<linalg::Conv2DNchwFchwOp>(context, benefit),
-        blockingFactors(blockingFactors) {}
+        blockingFactors(blockingFactors), tuningDatabase(tuningDatabase) {}
 
   LogicalResult matchAndRewrite(linalg::Conv2DNchwFchwOp linalgOp,
                                 PatternRewriter &rewriter) const override {
+    SmallVector<int64_t> tiles = blockingFactors;
+    if (Optional<SmallVector<int64_t>> tunedTiles =
+            tuningDatabase.lookup("pack-conv2DNchwFchw", linalgOp))
+      tiles = *tunedTiles;
+    if (tiles.empty())
+      return rewriter.notifyMatchFailure(linalgOp, "no blocking factors");
     FailureOr<linalg::GenericOp> genericOp =
         mlir::linalgx::packConv2DNchwFchwOp(
             rewriter, linalgOp,
-            getAsOpFoldResult(rewriter.getI64ArrayAttr(blockingFactors)));
+            getAsOpFoldResult(rewriter.getI64ArrayAttr(tiles)));
+    if (failed(genericOp))
+      return failure();
+    return success();
+  }
+
+private:
+  SmallVector<int64_t> blockingFactors;
+  const tpp::TuningDatabase &tuningDatabase;
+};
+
+struct DoItOnConv2DNgchwFgchw
+    : public OpRewritePattern<linalg::Conv2DNgchwFgchwOp> {
+  DoItOnConv2DNgchwFgchw(MLIRContext *context,
+                         ArrayRef<int64_t> blockingFactors,
+                         const tpp::TuningDatabase &tuningDatabase,
+                         PatternBenefit benefit = 1)
+      : OpRewritePattern<linalg::Conv2DNgchwFgchwOp>(context, benefit),
+        blockingFactors(blockingFactors), tuningDatabase(tuningDatabase) {}
+
+  LogicalResult matchAndRewrite(linalg::Conv2DNgchwFgchwOp linalgOp,
+                                PatternRewriter &rewriter) const override {
+    // The grouped convolutions have their own entries in the database, their
+    // best blocking factors differ from the ones of a dense convolution.
+    SmallVector<int64_t> tiles = blockingFactors;
+    if (Optional<SmallVector<int64_t>> tunedTiles =
+            tuningDatabase.lookup("pack-conv2DNgchwFgchw", linalgOp))
+      tiles = *tunedTiles;
+    if (tiles.empty())
+      return rewriter.notifyMatchFailure(linalgOp, "no blocking factors");
+    FailureOr<linalg::GenericOp> genericOp =
+        mlir::linalgx::packConv2DNgchwFgchwOp(
+            rewriter, linalgOp,
+            getAsOpFoldResult(rewriter.getI64ArrayAttr(tiles)));
     if (failed(genericOp))
       return failure();
     return success();
@@ -453,6 +870,7 @@ struct DoItOnConv2DNchwFchw
 
 private:
   SmallVector<int64_t> blockingFactors;
+  const tpp::TuningDatabase &tuningDatabase;
 };
 
 struct PackConv2DNchwFchw : public PackConv2DNchwFchwBase<PackConv2DNchwFchw> {
@@ -462,12 +880,18 @@ struct PackConv2DNchwFchw : public PackConv2DNchwFchwBase<PackConv2DNchwFchw> {
   }
 
   void runOnOperation() override {
-    if (blockingFactors.empty())
+    std::shared_ptr<const tpp::TuningDatabase> db =
+        tpp::TuningDatabase::loadForPass(tuningDatabase, getOperation());
+    if (!db)
+      return signalPassFailure();
+    if (blockingFactors.empty() && db->empty())
       return;
     MLIRContext *ctx = getOperation().getContext();
     RewritePatternSet patterns(ctx);
     mlir::tpp::populateSinkRelayoutPatterns(patterns);
-    patterns.add<DoItOnConv2DNchwFchw>(ctx, blockingFactors);
+    linalgx::populateConstantFoldPackUnPackPatterns(patterns);
+    patterns.add<DoItOnConv2DNchwFchw, DoItOnConv2DNgchwFgchw>(
+        ctx, blockingFactors, *db);
     (void)applyPatternsAndFoldGreedily(getOperation(), std::move(patterns));
     return;
   }
@@ -476,16 +900,23 @@ struct PackConv2DNchwFchw : public PackConv2DNchwFchwBase<PackConv2DNchwFchw> {
 struct DoItOnConv2DNhwcHwcf
     : public OpRewritePattern<linalg::Conv2DNhwcHwcfOp> {
   DoItOnConv2DNhwcHwcf(MLIRContext *context, ArrayRef<int64_t> blockingFactors,
+                       const tpp::TuningDatabase &tuningDatabase,
                        PatternBenefit benefit = 1)
       : OpRewritePattern<linalg::Conv2DNhwcHwcfOp>(context, benefit),
-        blockingFactors(blockingFactors) {}
+        blockingFactors(blockingFactors), tuningDatabase(tuningDatabase) {}
 
   LogicalResult matchAndRewrite(linalg::Conv2DNhwcHwcfOp linalgOp,
                                 PatternRewriter &rewriter) const override {
+    SmallVector<int64_t> tiles = blockingFactors;
+    if (Optional<SmallVector<int64_t>> tunedTiles =
+            tuningDatabase.lookup("pack-conv2DNhwcHwcf", linalgOp))
+      tiles = *tunedTiles;
+    if (tiles.empty())
+      return rewriter.notifyMatchFailure(linalgOp, "no blocking factors");
     FailureOr<linalg::GenericOp> maybeGeneric =
         mlir::linalgx::packConv2DNhwcHwcfOp(
             rewriter, linalgOp,
-            getAsOpFoldResult(rewriter.getI64ArrayAttr(blockingFactors)));
+            getAsOpFoldResult(rewriter.getI64ArrayAttr(tiles)));
     if (failed(maybeGeneric))
       return failure();
     return success();
@@ -493,6 +924,41 @@ struct DoItOnConv2DNhwcHwcf
 
 private:
   SmallVector<int64_t> blockingFactors;
+  const tpp::TuningDatabase &tuningDatabase;
+};
+
+// The channels of a depthwise convolution are blocked with the first blocking
+// factor.
+struct DoItOnDepthwiseConv2DNhwcHwc
+    : public OpRewritePattern<linalg::DepthwiseConv2DNhwcHwcOp> {
+  DoItOnDepthwiseConv2DNhwcHwc(MLIRContext *context,
+                               ArrayRef<int64_t> blockingFactors,
+                               const tpp::TuningDatabase &tuningDatabase,
+                               PatternBenefit benefit = 1)
+      : OpRewritePattern<linalg::DepthwiseConv2DNhwcHwcOp>(context, benefit),
+        blockingFactors(blockingFactors), tuningDatabase(tuningDatabase) {}
+
+  LogicalResult matchAndRewrite(linalg::DepthwiseConv2DNhwcHwcOp linalgOp,
+                                PatternRewriter &rewriter) const override {
+    SmallVector<int64_t> tiles = blockingFactors;
+    if (Optional<SmallVector<int64_t>> tunedTiles =
+            tuningDatabase.lookup("pack-depthwise-conv2DNhwcHwc", linalgOp))
+      tiles = *tunedTiles;
+    if (tiles.empty())
+      return rewriter.notifyMatchFailure(linalgOp, "no blocking factors");
+    ArrayRef<int64_t> channelTile = ArrayRef<int64_t>(tiles).take_front();
+    FailureOr<linalg::GenericOp> maybeGeneric =
+        mlir::linalgx::packDepthwiseConv2DNhwcHwcOp(
+            rewriter, linalgOp,
+            getAsOpFoldResult(rewriter.getI64ArrayAttr(channelTile)));
+    if (failed(maybeGeneric))
+      return failure();
+    return success();
+  }
+
+private:
+  SmallVector<int64_t> blockingFactors;
+  const tpp::TuningDatabase &tuningDatabase;
 };
 
 struct PackConv2DNhwcHwcf : PackConv2DNhwcHwcfBase<PackConv2DNhwcHwcf> {
@@ -502,11 +968,18 @@ struct PackConv2DNhwcHwcf : PackConv2DNhwcHwcfBase<PackConv2DNhwcHwcf> {
   }
 
   void runOnOperation() override {
-    if (blockingFactors.empty())
+    std::shared_ptr<const tpp::TuningDatabase> db =
+        tpp::TuningDatabase::loadForPass(tuningDatabase, getOperation());
+    if (!db)
+      return signalPassFailure();
+    if (blockingFactors.empty() && db->empty())
       return;
     MLIRContext *ctx = getOperation().getContext();
     RewritePatternSet patterns(ctx);
-    patterns.add<DoItOnConv2DNhwcHwcf>(ctx, blockingFactors);
+    mlir::tpp::populateSinkRelayoutPatterns(patterns);
+    linalgx::populateConstantFoldPackUnPackPatterns(patterns);
+    patterns.add<DoItOnConv2DNhwcHwcf, DoItOnDepthwiseConv2DNhwcHwc>(
+        ctx, blockingFactors, *db);
     (void)applyPatternsAndFoldGreedily(getOperation(), std::move(patterns));
     return;
   }
@@ -581,11 +1054,20 @@ struct PropagateThroughPadOp : public OpRewritePattern<tensor::PadOp> {
 // PropagateThroughElementWiseOp
 //===----------------------------------------------------------------------===//
 
-// Propagate packing through element-wise linalg generic operation.
+// Propagate packing through element-wise linalg generic operation. The outer
+// dimensions of a packed operand may be permuted (e.g., NHWC to NCHWc); each
+// operand keeps its own layout and the generic indexes it accordingly.
 struct PropagateThroughElementWiseOp
     : public OpRewritePattern<linalg::GenericOp> {
   using OpRewritePattern<linalg::GenericOp>::OpRewritePattern;
 
+  // How an operand is packed.
+  struct PackInfo {
+    SmallVector<OpFoldResult> tiles;
+    SmallVector<int64_t> innerDimsPos;
+    SmallVector<int64_t> outerDimsPerm;
+  };
+
   // Check sinking preconditions: a) all loops must
   // be parallel.
   LogicalResult checkPreconditions(linalg::GenericOp linalgOp) const {
@@ -594,31 +1076,81 @@ struct PropagateThroughElementWiseOp
     return success();
   }
 
-  Value getPackOperand(OpOperand *operand, linalg::GenericOp linalgOp,
-                       DenseMap<int64_t, OpFoldResult> dimAndTileMapping,
-                       PatternRewriter &rewriter) const {
+  // If the operand comes from an unpack operation simply pack the operand
+  // with the same tiles, dimsPos and outer permutation extracted from the
+  // unpack, otherwise infer the tiles from `dimAndTileMapping` and order the
+  // outer dimensions as the loops in `outerLoopsOrder`.
+  FailureOr<PackInfo>
+  getPackInfo(OpOperand *operand, linalg::GenericOp linalgOp,
+              DenseMap<int64_t, OpFoldResult> &dimAndTileMapping,
+              ArrayRef<unsigned> outerLoopsOrder) const {
+    AffineMap mapOperand = linalgOp.getMatchingIndexingMap(operand);
+    unsigned numTiledDims = 0;
+    for (unsigned pos = 0; pos < mapOperand.getNumResults(); pos++)
+      if (dimAndTileMapping.count(mapOperand.getDimPosition(pos)))
+        numTiledDims++;
+
+    PackInfo info;
     linalgx::UnPackOp unpackOp =
         operand->get().getDefiningOp<linalgx::UnPackOp>();
-    SmallVector<OpFoldResult> tiles;
-    SmallVector<int64_t> innerDimsPos;
-    // If the operand comes from an unpack operation simply pack the operand
-    // with the same tiles, and dimsPos extracted from the unpack, otherwise
-    // infer them from `dimsAndTileMapping`.
     if (unpackOp) {
-      tiles = unpackOp.getMixedTiles();
-      innerDimsPos = extractFromI64ArrayAttr(unpackOp.getInnerDimsPos());
-    } else {
-      AffineMap mapOperand = linalgOp.getMatchingIndexingMap(operand);
+      info.tiles = unpackOp.getMixedTiles();
+      info.innerDimsPos = extractFromI64ArrayAttr(unpackOp.getInnerDimsPos());
+      info.outerDimsPerm =
+          extractFromI64ArrayAttr(unpackOp.getOuterDimsPerm());
+      // All the tiled loops must be tiled in the unpacked operand too.
+      if (info.innerDimsPos.size() != numTiledDims)
+        return failure();
+      return info;
+    }
+
+    for (unsigned pos = 0; pos < mapOperand.getNumResults(); pos++) {
+      unsigned posInDomain = mapOperand.getDimPosition(pos);
+      if (dimAndTileMapping.count(posInDomain)) {
+        info.tiles.push_back(dimAndTileMapping[posInDomain]);
+        info.innerDimsPos.push_back(pos);
+      }
+    }
+    if (outerLoopsOrder.empty())
+      return info;
+    llvm::SmallBitVector permuted(mapOperand.getNumResults());
+    for (unsigned loop : outerLoopsOrder) {
       for (unsigned pos = 0; pos < mapOperand.getNumResults(); pos++) {
-        unsigned posInDomain = mapOperand.getDimPosition(pos);
-        if (dimAndTileMapping.count(posInDomain)) {
-          tiles.push_back(dimAndTileMapping[posInDomain]);
-          innerDimsPos.push_back(pos);
+        if (mapOperand.getDimPosition(pos) == loop && !permuted.test(pos)) {
+          info.outerDimsPerm.push_back(pos);
+          permuted.set(pos);
         }
       }
     }
-    return toPackLayoutImpl(linalgOp.getLoc(), operand->get(), tiles,
-                            innerDimsPos, {}, rewriter);
+    for (unsigned pos = 0; pos < mapOperand.getNumResults(); pos++)
+      if (!permuted.test(pos))
+        info.outerDimsPerm.push_back(pos);
+    if (llvm::equal(info.outerDimsPerm,
+                    llvm::seq<int64_t>(0, mapOperand.getNumResults())))
+      info.outerDimsPerm.clear();
+    return info;
+  }
+
+  // Return the map of the packed operand: the outer dimensions, permuted,
+  // followed by the point loops of the tiled dimensions.
+  AffineMap getPackedMap(OpOperand *operand, linalg::GenericOp linalgOp,
+                         const PackInfo &info,
+                         DenseMap<int64_t, unsigned> &pointLoops,
+                         PatternRewriter &rewriter) const {
+    AffineMap mapOperand = linalgOp.getMatchingIndexingMap(operand);
+    SmallVector<int64_t> outerDimsPerm = info.outerDimsPerm;
+    if (outerDimsPerm.empty())
+      outerDimsPerm =
+          llvm::to_vector(llvm::seq<int64_t>(0, mapOperand.getNumResults()));
+    SmallVector<AffineExpr> exprs;
+    for (int64_t posInCodomain : outerDimsPerm)
+      exprs.push_back(
+          rewriter.getAffineDimExpr(mapOperand.getDimPosition(posInCodomain)));
+    for (int64_t posInCodomain : info.innerDimsPos)
+      exprs.push_back(rewriter.getAffineDimExpr(
+          pointLoops[mapOperand.getDimPosition(posInCodomain)]));
+    return AffineMap::get(linalgOp.getNumLoops() + pointLoops.size(),
+                          /*symbolCount=*/0, exprs, linalgOp.getContext());
   }
 
   LogicalResult matchAndRewrite(linalg::GenericOp linalgOp,
@@ -630,33 +1162,36 @@ struct PropagateThroughElementWiseOp
     // operation. We need to map these dimensions (co-domain) to the domain of
     // the linalg operation. Scan each input and output operands. For each map
     // associated to the operand check the equivalent dimension in the domain
-    // and bind it with the tile size.
+    // and bind it with the tile size. The first unpack with permuted outer
+    // dimensions gives the order of the outer dimensions of the operands
+    // packed here.
     DenseMap<int64_t, OpFoldResult> dimAndTileMapping;
+    SmallVector<unsigned> outerLoopsOrder;
     for (OpOperand *operand : linalgOp.getInputAndOutputOperands()) {
       linalgx::UnPackOp unpackOp =
           operand->get().getDefiningOp<linalgx::UnPackOp>();
       if (!unpackOp)
         continue;
-      // avoid having to deal with tile loop interchange.
-      SmallVector<int64_t> outerDimsPerm =
-          extractFromI64ArrayAttr(unpackOp.getOuterDimsPerm());
-      if (!outerDimsPerm.empty())
+      AffineMap mapOperand = linalgOp.getMatchingIndexingMap(operand);
+      // fail if we dealing with 'complex' affine maps. Only dim expression
+      // are accepted.
+      if (!mapOperand.isProjectedPermutation(/*allowZeroInResults=*/false))
         return failure();
       // map *domain* of linalg operation to tiles.
       DenseMap<int64_t, OpFoldResult> currentDimAndTileMapping =
           unpackOp.getDimAndTileMapping();
-      AffineMap mapOperand = linalgOp.getMatchingIndexingMap(operand);
       for (unsigned posInCodomain = 0;
            posInCodomain < mapOperand.getNumResults(); posInCodomain++) {
-        // fail if we dealing with 'complex' affine maps. Only dim expression
-        // are accepted.
-        if (!mapOperand.getResult(posInCodomain).isa<AffineDimExpr>())
-          return failure();
         unsigned posInDomain = mapOperand.getDimPosition(posInCodomain);
         if (currentDimAndTileMapping.count(posInCodomain))
           dimAndTileMapping[posInDomain] =
               currentDimAndTileMapping[posInCodomain];
       }
+      SmallVector<int64_t> outerDimsPerm =
+          extractFromI64ArrayAttr(unpackOp.getOuterDimsPerm());
+      if (outerLoopsOrder.empty())
+        for (int64_t posInCodomain : outerDimsPerm)
+          outerLoopsOrder.push_back(mapOperand.getDimPosition(posInCodomain));
     }
 
     // no work to do, exit. We did not find any unpacked input or output
@@ -664,61 +1199,58 @@ struct PropagateThroughElementWiseOp
     if (dimAndTileMapping.empty())
       return failure();
 
-    SmallVector<Value> packedInputOperands;
-    for (OpOperand *operand : linalgOp.getInputOperands()) {
-      Value packedOperand =
-          getPackOperand(operand, linalgOp, dimAndTileMapping, rewriter);
-      packedInputOperands.push_back(packedOperand);
+    // The operands without a permutation-free map cannot be packed.
+    for (OpOperand *operand : linalgOp.getInputAndOutputOperands())
+      if (!linalgOp.getMatchingIndexingMap(operand).isProjectedPermutation(
+              /*allowZeroInResults=*/false))
+        return failure();
+
+    // Bind a point loop to each tiled loop, in the order of the loops.
+    unsigned numLoops = linalgOp.getNumLoops();
+    DenseMap<int64_t, unsigned> pointLoops;
+    for (unsigned loop = 0; loop < numLoops; loop++)
+      if (dimAndTileMapping.count(loop))
+        pointLoops[loop] = numLoops + pointLoops.size();
+
+    SmallVector<PackInfo> packInfos;
+    for (OpOperand *operand : linalgOp.getInputAndOutputOperands()) {
+      FailureOr<PackInfo> info =
+          getPackInfo(operand, linalgOp, dimAndTileMapping, outerLoopsOrder);
+      if (failed(info))
+        return failure();
+      packInfos.push_back(*info);
     }
 
+    Location loc = linalgOp.getLoc();
+    SmallVector<Value> packedInputOperands;
     SmallVector<Value> packedOutputOperands;
     SmallVector<Type> packedOutputTypes;
     SmallVector<Value> unpackOutputs;
-    for (OpOperand *operand : linalgOp.getOutputOperands()) {
+    SmallVector<AffineMap> newMaps;
+    for (OpOperand *operand : linalgOp.getInputAndOutputOperands()) {
+      const PackInfo &info = packInfos[operand->getOperandNumber()];
       Value packedOperand =
-          getPackOperand(operand, linalgOp, dimAndTileMapping, rewriter);
+          toPackLayoutImpl(loc, operand->get(), info.tiles, info.innerDimsPos,
+                           info.outerDimsPerm, rewriter);
+      newMaps.push_back(
+          getPackedMap(operand, linalgOp, info, pointLoops, rewriter));
+      if (operand->getOperandNumber() < linalgOp.getNumInputs()) {
+        packedInputOperands.push_back(packedOperand);
+        continue;
+      }
       packedOutputOperands.push_back(packedOperand);
       packedOutputTypes.push_back(packedOperand.getType());
       linalgx::UnPackOp unpackOp =
           operand->get().getDefiningOp<linalgx::UnPackOp>();
-      if (unpackOp)
-        unpackOutputs.push_back(unpackOp.getOutput());
-    }
-
-    unsigned packedDims = dimAndTileMapping.size();
-    SmallVector<AffineMap> newMaps;
-    // get the new map for each operand.
-    for (OpOperand *operand : linalgOp.getInputAndOutputOperands()) {
-      AffineMap mapOperand = linalgOp.getMatchingIndexingMap(operand);
-      unsigned numSymbols = 0;
-      unsigned numDims = linalgOp.getNumLoops() + packedDims;
-      unsigned oldResultExprs = mapOperand.getNumResults();
-      SmallVector<AffineExpr> dimLoops(oldResultExprs,
-                                       rewriter.getAffineDimExpr(-1));
-      SmallVector<AffineExpr> dimPointLoops;
-      unsigned pointLoopIdx = 0;
-      for (unsigned posInCodomain = 0; posInCodomain < oldResultExprs;
-           posInCodomain++) {
-        unsigned posInDomain = mapOperand.getDimPosition(posInCodomain);
-        if (dimAndTileMapping.count(posInDomain))
-          dimPointLoops.push_back(rewriter.getAffineDimExpr(
-              linalgOp.getNumLoops() + pointLoopIdx++));
-        dimLoops[posInCodomain] = rewriter.getAffineDimExpr(posInDomain);
-      }
-      // TODO: bail out if we need to interchange the point loops:
-      // inner_dims_pos.
-      dimLoops.append(dimPointLoops);
-      AffineMap newMap =
-          AffineMap::get(numDims, numSymbols, dimLoops, linalgOp.getContext());
-      newMaps.push_back(newMap);
+      unpackOutputs.push_back(unpackOp ? unpackOp.getOutput() : operand->get());
     }
 
-    SmallVector<StringRef> newIteratorTypes(linalgOp.getNumLoops() + packedDims,
+    SmallVector<StringRef> newIteratorTypes(numLoops + pointLoops.size(),
                                             getParallelIteratorTypeName());
 
     linalg::GenericOp replacementOp = rewriter.create<linalg::GenericOp>(
-        linalgOp.getLoc(), packedOutputTypes, packedInputOperands,
-        packedOutputOperands, newMaps, newIteratorTypes, /*docs=*/"",
+        loc, packedOutputTypes, packedInputOperands, packedOutputOperands,
+        newMaps, newIteratorTypes, /*docs=*/"",
         /*libraryCall=*/"");
     rewriter.inlineRegionBefore(linalgOp.getRegion(), replacementOp.getRegion(),
                                 replacementOp.getRegion().begin());
@@ -726,20 +1258,11 @@ struct PropagateThroughElementWiseOp
     SmallVector<Value> outReplacements;
     size_t idx = 0;
     for (OpOperand *operand : replacementOp.getOutputOperands()) {
-      linalgx::PackOp packOp = operand->get().getDefiningOp<linalgx::PackOp>();
+      const PackInfo &info = packInfos[operand->getOperandNumber()];
       Value result = replacementOp.getTiedOpResult(operand);
-      if (unpackOutputs.empty())
-        outReplacements.push_back(toUnPackLayoutImpl(
-            linalgOp.getLoc(), result, linalgOp.getOutputs()[idx++],
-            packOp.getMixedTiles(),
-            extractFromI64ArrayAttr(packOp.getInnerDimsPos()),
-            /*outer_dims_perm=*/{}, rewriter));
-      else
-        outReplacements.push_back(toUnPackLayoutImpl(
-            linalgOp.getLoc(), result, unpackOutputs[idx++],
-            packOp.getMixedTiles(),
-            extractFromI64ArrayAttr(packOp.getInnerDimsPos()),
-            /*outer_dims_perm=*/{}, rewriter));
+      outReplacements.push_back(toUnPackLayoutImpl(
+          loc, result, unpackOutputs[idx++], info.tiles, info.innerDimsPos,
+          info.outerDimsPerm, rewriter));
     }
     rewriter.replaceOp(linalgOp, outReplacements);
     return success();
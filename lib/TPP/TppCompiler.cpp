@@ -11,6 +11,7 @@
 #include "mlir/Conversion/MathToLLVM/MathToLLVM.h"
 #include "mlir/Conversion/MathToLibm/MathToLibm.h"
 #include "mlir/Conversion/MemRefToLLVM/MemRefToLLVM.h"
+#include "mlir/Conversion/OpenMPToLLVM/ConvertOpenMPToLLVM.h"
 #include "mlir/Conversion/ReconcileUnrealizedCasts/ReconcileUnrealizedCasts.h"
 #include "mlir/Conversion/SCFToControlFlow/SCFToControlFlow.h"
 #include "mlir/Conversion/VectorToLLVM/ConvertVectorToLLVM.h"
@@ -79,16 +80,32 @@ void TppCompilerPipeline::runOnOperation() {
 
   // -----
 
-  if (enableXsmmConversion) // convert-tpp-to-xsmm
+  if (enableXsmmConversion) { // convert-tpp-to-xsmm
     pm.addNestedPass<func::FuncOp>(createConvertTppToXsmmPass());
-  else // convert-tpp-to-loops
-    pm.addNestedPass<func::FuncOp>(createConvertTppToLoopsPass());
+  } else {
+    // convert-tpp-to-vector, the operations it does not handle go to loops.
+    if (enableVectorConversion)
+      pm.addNestedPass<func::FuncOp>(createConvertTppToVectorPass());
+    // convert-tpp-to-loops
+    pm.addNestedPass<func::FuncOp>(createConvertTppToLoopsPass(
+        /*parallel=*/enableParallel, /*unrollFactor=*/4));
+  }
 
-  pm.addPass(createConvertXsmmToFuncPass());
+  // Invoke the kernels with the bare-pointer ABI.
+  pm.addPass(createConvertXsmmToFuncPass(/*useExtractMetaData=*/true,
+                                         /*hoistDispatch=*/false,
+                                         traceKernelSites));
   pm.addNestedPass<func::FuncOp>(createConvertLinalgToLoopsPass());
   pm.addNestedPass<func::FuncOp>(arith::createArithExpandOpsPass());
   pm.addNestedPass<func::FuncOp>(createConvertVectorToSCFPass());
+  // Distribute the outer parallel loops across threads, otherwise they are
+  // serialized by scf-to-cf.
+  if (enableParallel)
+    pm.addPass(
+        createConvertParallelLoopsToOpenMPPass(numThreads, parallelDims));
   pm.addNestedPass<func::FuncOp>(createConvertSCFToCFPass());
+  if (enableParallel)
+    pm.addPass(createConvertOpenMPToLLVMPass());
   pm.addPass(createConvertVectorToLLVMPass());
   pm.addNestedPass<func::FuncOp>(createConvertMathToLLVMPass());
   pm.addPass(createConvertMathToLibmPass());
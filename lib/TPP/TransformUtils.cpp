@@ -23,7 +23,8 @@ namespace utils {
 // return the dimensions used by a given operand looking at its access map. As
 // a simple example consider the following: map operand = (d0, d1, d2, d3, d4,
 // d5, d6) -> (d0, d1 + d2, d4 + d3, d6) Assuming localIvs = (d0, d1, d2, d3)
-// The result is: {d0, affine_apply(d1 + d2), d3}.
+// The result is: {d0, affine_apply(d1 + d2), d3}. With (d4 + d3 * 2) instead
+// of (d4 + d3) the last offset is affine_apply(d3 * 2).
 FailureOr<SmallVector<Value>>
 getInvolvedLocalDimsForOperand(OpBuilder &builder, Location loc,
                                OpOperand *operand, AffineMap mapOperand,
@@ -52,9 +53,26 @@ getInvolvedLocalDimsForOperand(OpBuilder &builder, Location loc,
       ivsResult.push_back(
           makeComposedAffineApply(builder, loc, resMap, touchedIvs)
               .getResult());
-    } else
-      // single dimension touched just return it.
-      ivsResult.push_back(touchedIvs[0]);
+    } else {
+      // single dimension touched. The other dimensions of the expression are
+      // not materialized and start at zero, thus the offset is the touched
+      // dimension scaled by its coefficient (e.g., S * dilation on the image
+      // of a dilated convolution).
+      SmallVector<AffineExpr> localDims;
+      for (unsigned pos = 0, e = mapOperand.getNumDims(); pos < e; pos++)
+        localDims.push_back(pos < localIvs.size()
+                                ? builder.getAffineDimExpr(pos)
+                                : builder.getAffineConstantExpr(0));
+      AffineExpr offset = results[idx].replaceDims(localDims);
+      if (offset.isa<AffineDimExpr>()) {
+        ivsResult.push_back(touchedIvs[0]);
+        continue;
+      }
+      AffineMap offsetMap = AffineMap::get(localIvs.size(), 0, offset);
+      ivsResult.push_back(
+          makeComposedAffineApply(builder, loc, offsetMap, localIvs)
+              .getResult());
+    }
   }
   return ivsResult;
 }
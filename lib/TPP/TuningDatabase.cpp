@@ -0,0 +1,250 @@
+//===- TuningDatabase.cpp - Tuned block factors and tile sizes --*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "TPP/TuningDatabase.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <cstdlib>
+#include <mutex>
+
+using namespace mlir;
+using namespace mlir::tpp;
+
+// Bump when the layout of the file changes.
+static constexpr int64_t kTuningDatabaseVersion = 1;
+
+FailureOr<TuningEntry> TuningEntry::get(StringRef pass,
+                                        linalg::LinalgOp linalgOp) {
+  if (linalgOp.hasDynamicShape())
+    return failure();
+  TuningEntry entry;
+  entry.pass = pass.str();
+  entry.op = linalgOp->getName().getStringRef().str();
+  if (auto genericOp = dyn_cast<linalg::GenericOp>(linalgOp.getOperation())) {
+    std::string libraryCall = genericOp.getLibraryCallName();
+    if (!libraryCall.empty())
+      entry.op = libraryCall;
+  }
+  entry.shape = linalgOp.computeStaticLoopSizes();
+  Type elementType = getElementTypeOrSelf(
+      linalgOp.getOutputOperand(0)->get().getType());
+  if (linalgOp.getNumInputs() > 0)
+    elementType =
+        getElementTypeOrSelf(linalgOp.getInputOperand(0)->get().getType());
+  llvm::raw_string_ostream typeStream(entry.type);
+  elementType.print(typeStream);
+  typeStream.flush();
+  return entry;
+}
+
+std::string TuningEntry::getKey() const {
+  std::string key;
+  llvm::raw_string_ostream keyStream(key);
+  keyStream << pass << ":" << op << ":";
+  llvm::interleave(shape, keyStream, "x");
+  keyStream << ":" << type;
+  return keyStream.str();
+}
+
+static bool parseIntegerArray(const llvm::json::Array *array,
+                              SmallVectorImpl<int64_t> &values) {
+  if (!array)
+    return false;
+  for (const llvm::json::Value &value : *array) {
+    Optional<int64_t> integer = value.getAsInteger();
+    if (!integer)
+      return false;
+    values.push_back(*integer);
+  }
+  return true;
+}
+
+FailureOr<TuningDatabase> TuningDatabase::load(StringRef path,
+                                               std::string &error) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer =
+      llvm::MemoryBuffer::getFile(path);
+  if (!buffer) {
+    error = "cannot open tuning database '" + path.str() +
+            "': " + buffer.getError().message();
+    return failure();
+  }
+  llvm::Expected<llvm::json::Value> json =
+      llvm::json::parse((*buffer)->getBuffer());
+  if (!json) {
+    error = "cannot parse tuning database '" + path.str() +
+            "': " + llvm::toString(json.takeError());
+    return failure();
+  }
+
+  auto malformed = [&](const Twine &reason) {
+    error = ("malformed tuning database '" + path + "': " + reason).str();
+    return failure();
+  };
+  const llvm::json::Object *root = json->getAsObject();
+  if (!root)
+    return malformed("expect a top-level object");
+  if (root->getInteger("version") != kTuningDatabaseVersion)
+    return malformed("expect version " + Twine(kTuningDatabaseVersion));
+  const llvm::json::Array *entries = root->getArray("entries");
+  if (!entries)
+    return malformed("expect an 'entries' array");
+
+  TuningDatabase db;
+  for (const llvm::json::Value &value : *entries) {
+    const llvm::json::Object *object = value.getAsObject();
+    if (!object)
+      return malformed("expect entries to be objects");
+    Optional<StringRef> pass = object->getString("pass");
+    Optional<StringRef> op = object->getString("op");
+    Optional<StringRef> type = object->getString("type");
+    if (!pass || !op || !type)
+      return malformed("expect 'pass', 'op' and 'type' strings");
+    TuningEntry entry;
+    entry.pass = pass->str();
+    entry.op = op->str();
+    entry.type = type->str();
+    if (!parseIntegerArray(object->getArray("shape"), entry.shape) ||
+        !parseIntegerArray(object->getArray("params"), entry.params))
+      return malformed("expect 'shape' and 'params' integer arrays");
+    entry.seconds = object->getNumber("seconds").value_or(0.0);
+    db.insert(entry);
+  }
+  return db;
+}
+
+namespace {
+
+// A parsed database and the status of its file when it was read.
+struct CachedDatabase {
+  llvm::sys::TimePoint<> modificationTime;
+  uint64_t size = 0;
+  std::shared_ptr<const TuningDatabase> db;
+};
+
+// Databases already parsed, by path. Function passes look them up
+// concurrently.
+struct DatabaseCache {
+  std::mutex mutex;
+  llvm::StringMap<CachedDatabase> entries;
+};
+
+} // namespace
+
+static DatabaseCache &getDatabaseCache() {
+  static DatabaseCache cache;
+  return cache;
+}
+
+std::shared_ptr<const TuningDatabase>
+TuningDatabase::loadForPass(StringRef path, Operation *op) {
+  std::string dbPath = path.str();
+  if (dbPath.empty()) {
+    if (const char *envPath = std::getenv(kTuningDatabaseEnvVar))
+      dbPath = envPath;
+  }
+  if (dbPath.empty())
+    return std::make_shared<const TuningDatabase>();
+
+  // Reuse the parsed database as long as the file is unchanged. A missing file
+  // is not cached, load reports it.
+  llvm::sys::fs::file_status status;
+  bool hasStatus = !llvm::sys::fs::status(dbPath, status);
+  DatabaseCache &cache = getDatabaseCache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  auto it = cache.entries.find(dbPath);
+  if (hasStatus && it != cache.entries.end() &&
+      it->second.modificationTime == status.getLastModificationTime() &&
+      it->second.size == status.getSize())
+    return it->second.db;
+
+  std::string error;
+  FailureOr<TuningDatabase> db = load(dbPath, error);
+  if (failed(db)) {
+    op->emitError(error);
+    return nullptr;
+  }
+  auto parsedDb = std::make_shared<const TuningDatabase>(std::move(*db));
+  if (hasStatus)
+    cache.entries[dbPath] = {status.getLastModificationTime(),
+                             status.getSize(), parsedDb};
+  return parsedDb;
+}
+
+LogicalResult TuningDatabase::save(StringRef path, std::string &error) const {
+  // The file may be rewritten within the resolution of its modification time.
+  {
+    DatabaseCache &cache = getDatabaseCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.entries.erase(path);
+  }
+  std::error_code ec;
+  llvm::raw_fd_ostream os(path, ec);
+  if (ec) {
+    error = "cannot write tuning database '" + path.str() +
+            "': " + ec.message();
+    return failure();
+  }
+  llvm::json::OStream json(os, /*IndentSize=*/2);
+  json.object([&] {
+    json.attribute("version", kTuningDatabaseVersion);
+    json.attributeArray("entries", [&] {
+      for (const auto &it : entries) {
+        const TuningEntry &entry = it.second;
+        json.object([&] {
+          json.attribute("pass", entry.pass);
+          json.attribute("op", entry.op);
+          json.attributeArray("shape", [&] {
+            for (int64_t size : entry.shape)
+              json.value(size);
+          });
+          json.attribute("type", entry.type);
+          json.attributeArray("params", [&] {
+            for (int64_t param : entry.params)
+              json.value(param);
+          });
+          json.attribute("seconds", entry.seconds);
+        });
+      }
+    });
+  });
+  os << "\n";
+  return success();
+}
+
+Optional<SmallVector<int64_t>>
+TuningDatabase::lookup(StringRef pass, linalg::LinalgOp linalgOp) const {
+  if (entries.empty())
+    return llvm::None;
+  FailureOr<TuningEntry> key = TuningEntry::get(pass, linalgOp);
+  if (failed(key))
+    return llvm::None;
+  const TuningEntry *entry = find(*key);
+  if (!entry)
+    return llvm::None;
+  return entry->params;
+}
+
+const TuningEntry *TuningDatabase::find(const TuningEntry &entry) const {
+  auto it = entries.find(entry.getKey());
+  if (it == entries.end())
+    return nullptr;
+  return &it->second;
+}
+
+void TuningDatabase::insert(const TuningEntry &entry) {
+  entries[entry.getKey()] = entry;
+}
+
+void TuningDatabase::erase(const TuningEntry &entry) {
+  entries.erase(entry.getKey());
+}
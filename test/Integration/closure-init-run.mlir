@@ -0,0 +1,55 @@
+// RUN: tpp-run %s \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlirdir/libmlir_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// tpp-run splits the kernel wrapped in a closure into init and run functions
+// before lowering: E = B + B runs in the init function, C += A x E in the run
+// function.
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+
+module {
+  memref.global "private" constant @__constant_A : memref<4x4xf32> = dense<[[1.0, 2.0, 0.0, -1.0], [0.0, 1.0, 1.0, 0.0], [2.0, 0.0, -1.0, 1.0], [1.0, 1.0, 1.0, 1.0]]>
+  memref.global "private" constant @__constant_B : memref<4x4xf32> = dense<[[1.0, 0.0, 0.0, 1.0], [0.0, 1.0, 0.0, 0.0], [0.0, 0.0, 1.0, 0.0], [1.0, 0.0, 0.0, 1.0]]>
+  memref.global "private" constant @__constant_C : memref<4x4xf32> = dense<1.0>
+
+  func.func @kernel(%A: memref<4x4xf32>, %B: memref<4x4xf32>,
+                    %C: memref<4x4xf32>) -> memref<4x4xf32> {
+    %E = memref.alloc() : memref<4x4xf32>
+    linalg.generic {indexing_maps = [#map, #map, #map],
+                    iterator_types = ["parallel", "parallel"]}
+      ins(%B, %B: memref<4x4xf32>, memref<4x4xf32>) outs(%E: memref<4x4xf32>) {
+        ^bb0(%b0: f32, %b1: f32, %e: f32):
+          %0 = arith.addf %b0, %b1 : f32
+          linalg.yield %0 : f32
+    }
+    %0 = stdx.closure init_args(%a = %A) -> (memref<4x4xf32>)
+                      init_outs(%c = %C) -> (memref<4x4xf32>) {
+      linalg.matmul ins(%a, %E: memref<4x4xf32>, memref<4x4xf32>)
+                    outs(%c: memref<4x4xf32>)
+      stdx.yield %c : memref<4x4xf32>
+    }
+    return %0 : memref<4x4xf32>
+  }
+
+  func.func @entry() {
+    %A = memref.get_global @__constant_A : memref<4x4xf32>
+    %B = memref.get_global @__constant_B : memref<4x4xf32>
+    %C = memref.get_global @__constant_C : memref<4x4xf32>
+    %D = call @kernel(%A, %B, %C)
+      : (memref<4x4xf32>, memref<4x4xf32>, memref<4x4xf32>) -> memref<4x4xf32>
+
+    // C = 1 + A x (B + B)
+    // CHECK:      ( ( 1, 5, 1, 1 ),
+    // CHECK-SAME:   ( 1, 3, 3, 1 ),
+    // CHECK-SAME:   ( 7, 1, -1, 7 ),
+    // CHECK-SAME:   ( 5, 3, 3, 5 ) )
+    %c0 = arith.constant 0 : index
+    %d1 = arith.constant -1.0 : f32
+    %v = vector.transfer_read %D[%c0, %c0], %d1 : memref<4x4xf32>, vector<4x4xf32>
+    vector.print %v : vector<4x4xf32>
+    return
+  }
+}
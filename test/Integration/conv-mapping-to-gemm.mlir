@@ -12,8 +12,19 @@
 // RUN: FileCheck --check-prefixes=CHECK-NOOPT %s
 //
 
+// RUN: tpp-opt %s -decompose-conv-to-matmul-or-brgemm="enable-brgemm=true block-factors=2,2" -one-shot-bufferize="bufferize-function-boundaries allow-return-allocs function-boundary-type-conversion=identity-layout-map"  -canonicalize -drop-equivalent-buffer-results -finalizing-bufferize -linalg-ext-to-loops -convert-linalg-to-loops -convert-vector-to-scf -convert-scf-to-cf -sparse-compiler | \
+// RUN: mlir-cpu-runner \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlirdir/libmlir_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
 // TODO: we probably miss a pass and we abuse sparse-compiler to lower.
 
+// The strided and dilated convolutions check the coefficients of the image
+// accesses in the GEMM mapping, and the subsampling of the image of a strided
+// 1x1 convolution before H and W are collapsed for BRGEMM.
+
 module {
 
   func.func @conv(%img: tensor<1x4x4x3xi64>, %filt: tensor<2x2x3x8xi64>,
@@ -25,6 +36,33 @@ module {
     return %0 : tensor<1x3x3x8xi64>
   } 
 
+  func.func @conv_strided(%img: tensor<1x4x4x3xi64>, %filt: tensor<2x2x3x8xi64>,
+                          %out: tensor<1x2x2x8xi64>) -> tensor<1x2x2x8xi64> {
+    %0 = linalg.conv_2d_nhwc_hwcf { dilations = dense<[1,1]> : tensor<2xi64>,
+                                    strides = dense<[2,2]> : tensor<2xi64> }
+      ins(%img, %filt: tensor<1x4x4x3xi64>, tensor<2x2x3x8xi64>)
+      outs(%out: tensor<1x2x2x8xi64>) -> tensor<1x2x2x8xi64>
+    return %0 : tensor<1x2x2x8xi64>
+  }
+
+  func.func @conv_dilated(%img: tensor<1x4x4x3xi64>, %filt: tensor<2x2x3x8xi64>,
+                          %out: tensor<1x2x2x8xi64>) -> tensor<1x2x2x8xi64> {
+    %0 = linalg.conv_2d_nhwc_hwcf { dilations = dense<[2,2]> : tensor<2xi64>,
+                                    strides = dense<[1,1]> : tensor<2xi64> }
+      ins(%img, %filt: tensor<1x4x4x3xi64>, tensor<2x2x3x8xi64>)
+      outs(%out: tensor<1x2x2x8xi64>) -> tensor<1x2x2x8xi64>
+    return %0 : tensor<1x2x2x8xi64>
+  }
+
+  func.func @conv_nchw_strided(%img: tensor<1x4x4x4xi64>, %filt: tensor<4x4x1x1xi64>,
+                               %out: tensor<1x4x2x2xi64>) -> tensor<1x4x2x2xi64> {
+    %0 = linalg.conv_2d_nchw_fchw { dilations = dense<[1,1]> : tensor<2xi64>,
+                                    strides = dense<[2,2]> : tensor<2xi64> }
+      ins(%img, %filt: tensor<1x4x4x4xi64>, tensor<4x4x1x1xi64>)
+      outs(%out: tensor<1x4x2x2xi64>) -> tensor<1x4x2x2xi64>
+    return %0 : tensor<1x4x2x2xi64>
+  }
+
   func.func @entry() {
     %c0 = arith.constant 0 : index
     %d1 = arith.constant -1 : i64
@@ -111,6 +149,73 @@ module {
       : tensor<1x3x3x8xi64>, vector<1x3x3x8xi64>
     vector.print %v0 : vector<1x3x3x8xi64>
 
+    %out1 = arith.constant dense<0> : tensor<1x2x2x8xi64>
+    %1 = call @conv_strided(%img, %filt, %out1)
+      : (tensor<1x4x4x3xi64>, tensor<2x2x3x8xi64>, tensor<1x2x2x8xi64>) -> tensor<1x2x2x8xi64>
+    //
+    // CHECK: ( ( ( ( 530, 644, 758, 872, 986, 1100, 1214, 1328 ),
+    // CHECK-SAME:  ( 890, 1076, 1262, 1448, 1634, 1820, 2006, 2192 ) ),
+    // CHECK-SAME:( ( 1970, 2372, 2774, 3176, 3578, 3980, 4382, 4784 ),
+    // CHECK-SAME:  ( 2320, 2784, 3248, 3712, 4176, 4640, 5104, 5568 ) ) ) )
+    //
+    // CHECK-NOOPT: ( ( ( ( 530, 644, 758, 872, 986, 1100, 1214, 1328 ),
+    // CHECK-NOOPT-SAME:  ( 890, 1076, 1262, 1448, 1634, 1820, 2006, 2192 ) ),
+    // CHECK-NOOPT-SAME:( ( 1970, 2372, 2774, 3176, 3578, 3980, 4382, 4784 ),
+    // CHECK-NOOPT-SAME:  ( 2320, 2784, 3248, 3712, 4176, 4640, 5104, 5568 ) ) ) )
+    //
+    %v1 = vector.transfer_read %1[%c0, %c0, %c0, %c0], %d1
+      : tensor<1x2x2x8xi64>, vector<1x2x2x8xi64>
+    vector.print %v1 : vector<1x2x2x8xi64>
+
+    %2 = call @conv_dilated(%img, %filt, %out1)
+      : (tensor<1x4x4x3xi64>, tensor<2x2x3x8xi64>, tensor<1x2x2x8xi64>) -> tensor<1x2x2x8xi64>
+    //
+    // CHECK: ( ( ( ( 908, 1112, 1316, 1520, 1724, 1928, 2132, 2336 ),
+    // CHECK-SAME:  ( 1088, 1328, 1568, 1808, 2048, 2288, 2528, 2768 ) ),
+    // CHECK-SAME:( ( 1628, 1976, 2324, 2672, 3020, 3368, 3716, 4064 ),
+    // CHECK-SAME:  ( 1798, 2172, 2546, 2920, 3294, 3668, 4042, 4416 ) ) ) )
+    //
+    // CHECK-NOOPT: ( ( ( ( 908, 1112, 1316, 1520, 1724, 1928, 2132, 2336 ),
+    // CHECK-NOOPT-SAME:  ( 1088, 1328, 1568, 1808, 2048, 2288, 2528, 2768 ) ),
+    // CHECK-NOOPT-SAME:( ( 1628, 1976, 2324, 2672, 3020, 3368, 3716, 4064 ),
+    // CHECK-NOOPT-SAME:  ( 1798, 2172, 2546, 2920, 3294, 3668, 4042, 4416 ) ) ) )
+    //
+    %v2 = vector.transfer_read %2[%c0, %c0, %c0, %c0], %d1
+      : tensor<1x2x2x8xi64>, vector<1x2x2x8xi64>
+    vector.print %v2 : vector<1x2x2x8xi64>
+
+    %img_nchw = arith.constant dense<[
+    [
+     [[ 1, 2, 3, 4 ], [ 5, 6, 7, 8 ], [ 9, 10, 11, 12 ], [ 13, 14, 15, 16 ]],
+     [[ 17, 18, 19, 20 ], [ 21, 22, 23, 24 ], [ 25, 26, 27, 28 ], [ 29, 30, 31, 32 ]],
+     [[ 33, 34, 35, 36 ], [ 37, 38, 39, 40 ], [ 41, 42, 43, 44 ], [ 45, 46, 47, 48 ]],
+     [[ 49, 50, 51, 52 ], [ 53, 54, 55, 56 ], [ 57, 58, 59, 60 ], [ 61, 62, 63, 64 ]]
+    ]
+    ]> : tensor<1x4x4x4xi64>
+    %filt_nchw = arith.constant dense<[
+      [[[ 1 ]], [[ 3 ]], [[ 5 ]], [[ 2 ]]],
+      [[[ 2 ]], [[ 4 ]], [[ 1 ]], [[ 3 ]]],
+      [[[ 3 ]], [[ 5 ]], [[ 2 ]], [[ 4 ]]],
+      [[[ 4 ]], [[ 1 ]], [[ 3 ]], [[ 5 ]]]
+    ]> : tensor<4x4x1x1xi64>
+    %out3 = arith.constant dense<0> : tensor<1x4x2x2xi64>
+    %3 = call @conv_nchw_strided(%img_nchw, %filt_nchw, %out3)
+      : (tensor<1x4x4x4xi64>, tensor<4x4x1x1xi64>, tensor<1x4x2x2xi64>) -> tensor<1x4x2x2xi64>
+    //
+    // CHECK: ( ( ( ( 315, 337 ), ( 403, 425 ) ),
+    // CHECK-SAME:  ( ( 250, 270 ), ( 330, 350 ) ),
+    // CHECK-SAME:  ( ( 350, 378 ), ( 462, 490 ) ),
+    // CHECK-SAME:  ( ( 365, 391 ), ( 469, 495 ) ) ) )
+    //
+    // CHECK-NOOPT: ( ( ( ( 315, 337 ), ( 403, 425 ) ),
+    // CHECK-NOOPT-SAME:  ( ( 250, 270 ), ( 330, 350 ) ),
+    // CHECK-NOOPT-SAME:  ( ( 350, 378 ), ( 462, 490 ) ),
+    // CHECK-NOOPT-SAME:  ( ( 365, 391 ), ( 469, 495 ) ) ) )
+    //
+    %v3 = vector.transfer_read %3[%c0, %c0, %c0, %c0], %d1
+      : tensor<1x4x2x2xi64>, vector<1x4x2x2xi64>
+    vector.print %v3 : vector<1x4x2x2xi64>
+
     return
   }
 
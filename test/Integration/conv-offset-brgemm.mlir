@@ -0,0 +1,113 @@
+// RUN: tpp-opt %s -decompose-conv-to-matmul-or-brgemm="enable-brgemm=true block-factors=2,2" -one-shot-bufferize="bufferize-function-boundaries allow-return-allocs function-boundary-type-conversion=identity-layout-map"  -canonicalize -drop-equivalent-buffer-results -finalizing-bufferize -linalg-ext-to-loops -convert-linalg-to-tpp -convert-tpp-to-xsmm -convert-xsmm-to-func -convert-linalg-to-loops -convert-vector-to-scf -convert-scf-to-cf | \
+// RUN: tpp-run \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlirdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// RUN: tpp-opt %s -decompose-conv-to-matmul-or-brgemm="enable-brgemm=true block-factors=2,2" -one-shot-bufferize="bufferize-function-boundaries allow-return-allocs function-boundary-type-conversion=identity-layout-map"  -canonicalize -drop-equivalent-buffer-results -finalizing-bufferize -linalg-ext-to-loops -convert-linalg-to-tpp -convert-tpp-to-loops -convert-linalg-to-loops -convert-vector-to-scf -convert-scf-to-cf | \
+// RUN: tpp-run \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlirdir/libmlir_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// RUN: tpp-opt %s -one-shot-bufferize="bufferize-function-boundaries allow-return-allocs function-boundary-type-conversion=identity-layout-map"  -canonicalize -drop-equivalent-buffer-results -finalizing-bufferize -convert-linalg-to-loops -convert-vector-to-scf -convert-scf-to-cf | \
+// RUN: tpp-run \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlirdir/libmlir_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// A 3x3 convolution blocked by 2 on C and K is mapped to an offset-list
+// BRGEMM per output row, reducing over C', R and S. The first run executes
+// the LIBXSMM offset-list kernel, the second one the loops of the BRGEMM, and
+// the last one the undecomposed convolution as reference.
+
+module {
+
+  func.func @conv(%img: tensor<1x4x6x6xf32>, %filt: tensor<4x4x3x3xf32>,
+                  %out: tensor<1x4x4x4xf32>) -> tensor<1x4x4x4xf32> {
+    %0 = linalg.conv_2d_nchw_fchw { dilations = dense<[1,1]> : tensor<2xi64>,
+                                    strides = dense<[1,1]> : tensor<2xi64> }
+      ins(%img, %filt: tensor<1x4x6x6xf32>, tensor<4x4x3x3xf32>)
+      outs(%out: tensor<1x4x4x4xf32>) -> tensor<1x4x4x4xf32>
+    return %0 : tensor<1x4x4x4xf32>
+  }
+
+  func.func @entry() {
+    %c0 = arith.constant 0 : index
+    %d1 = arith.constant -1.0 : f32
+
+    %img = arith.constant dense<[
+      [
+        [
+          [ -2.0, -1.0, 0.0, 1.0, 2.0, -2.0 ],
+          [ 1.0, 2.0, -2.0, -1.0, 0.0, 1.0 ],
+          [ -1.0, 0.0, 1.0, 2.0, -2.0, -1.0 ],
+          [ 2.0, -2.0, -1.0, 0.0, 1.0, 2.0 ],
+          [ 0.0, 1.0, 2.0, -2.0, -1.0, 0.0 ],
+          [ -2.0, -1.0, 0.0, 1.0, 2.0, -2.0 ]
+        ],
+        [
+          [ 0.0, 1.0, 2.0, -2.0, -1.0, 0.0 ],
+          [ -2.0, -1.0, 0.0, 1.0, 2.0, -2.0 ],
+          [ 1.0, 2.0, -2.0, -1.0, 0.0, 1.0 ],
+          [ -1.0, 0.0, 1.0, 2.0, -2.0, -1.0 ],
+          [ 2.0, -2.0, -1.0, 0.0, 1.0, 2.0 ],
+          [ 0.0, 1.0, 2.0, -2.0, -1.0, 0.0 ]
+        ],
+        [
+          [ 2.0, -2.0, -1.0, 0.0, 1.0, 2.0 ],
+          [ 0.0, 1.0, 2.0, -2.0, -1.0, 0.0 ],
+          [ -2.0, -1.0, 0.0, 1.0, 2.0, -2.0 ],
+          [ 1.0, 2.0, -2.0, -1.0, 0.0, 1.0 ],
+          [ -1.0, 0.0, 1.0, 2.0, -2.0, -1.0 ],
+          [ 2.0, -2.0, -1.0, 0.0, 1.0, 2.0 ]
+        ],
+        [
+          [ -1.0, 0.0, 1.0, 2.0, -2.0, -1.0 ],
+          [ 2.0, -2.0, -1.0, 0.0, 1.0, 2.0 ],
+          [ 0.0, 1.0, 2.0, -2.0, -1.0, 0.0 ],
+          [ -2.0, -1.0, 0.0, 1.0, 2.0, -2.0 ],
+          [ 1.0, 2.0, -2.0, -1.0, 0.0, 1.0 ],
+          [ -1.0, 0.0, 1.0, 2.0, -2.0, -1.0 ]
+        ]
+      ]
+    ]> : tensor<1x4x6x6xf32>
+
+    %filt = arith.constant dense<[[[[-1.0, 1.0, 0.0], [0.0, -1.0, 1.0], [1.0, 0.0, -1.0]],
+      [[1.0, 0.0, -1.0], [-1.0, 1.0, 0.0], [0.0, -1.0, 1.0]],
+      [[0.0, -1.0, 1.0], [1.0, 0.0, -1.0], [-1.0, 1.0, 0.0]],
+      [[-1.0, 1.0, 0.0], [0.0, -1.0, 1.0], [1.0, 0.0, -1.0]]],
+      [[[0.0, -1.0, 1.0], [1.0, 0.0, -1.0], [-1.0, 1.0, 0.0]],
+      [[-1.0, 1.0, 0.0], [0.0, -1.0, 1.0], [1.0, 0.0, -1.0]],
+      [[1.0, 0.0, -1.0], [-1.0, 1.0, 0.0], [0.0, -1.0, 1.0]],
+      [[0.0, -1.0, 1.0], [1.0, 0.0, -1.0], [-1.0, 1.0, 0.0]]],
+      [[[1.0, 0.0, -1.0], [-1.0, 1.0, 0.0], [0.0, -1.0, 1.0]],
+      [[0.0, -1.0, 1.0], [1.0, 0.0, -1.0], [-1.0, 1.0, 0.0]],
+      [[-1.0, 1.0, 0.0], [0.0, -1.0, 1.0], [1.0, 0.0, -1.0]],
+      [[1.0, 0.0, -1.0], [-1.0, 1.0, 0.0], [0.0, -1.0, 1.0]]],
+      [[[-1.0, 1.0, 0.0], [0.0, -1.0, 1.0], [1.0, 0.0, -1.0]],
+      [[1.0, 0.0, -1.0], [-1.0, 1.0, 0.0], [0.0, -1.0, 1.0]],
+      [[0.0, -1.0, 1.0], [1.0, 0.0, -1.0], [-1.0, 1.0, 0.0]],
+      [[-1.0, 1.0, 0.0], [0.0, -1.0, 1.0], [1.0, 0.0, -1.0]]]]> : tensor<4x4x3x3xf32>
+
+    %out = arith.constant dense<0.0> : tensor<1x4x4x4xf32>
+    %0 = call @conv(%img, %filt, %out)
+      : (tensor<1x4x6x6xf32>, tensor<4x4x3x3xf32>, tensor<1x4x4x4xf32>) -> tensor<1x4x4x4xf32>
+
+    //
+    // CHECK: ( ( ( ( -10, 15, 20, 0 ), ( 0, -25, -10, 15 ), ( 15, 20, 0, -25 ), ( -25, -10, 15, 20 ) ),
+    // CHECK-SAME:  ( ( 20, 10, -20, -20 ), ( -20, 10, 20, 10 ), ( 10, -20, -20, 10 ), ( 10, 20, 10, -20 ) ),
+    // CHECK-SAME:  ( ( -10, -25, 0, 20 ), ( 20, 15, -10, -25 ), ( -25, 0, 20, 15 ), ( 15, -10, -25, 0 ) ),
+    // CHECK-SAME:  ( ( -10, 15, 20, 0 ), ( 0, -25, -10, 15 ), ( 15, 20, 0, -25 ), ( -25, -10, 15, 20 ) ) ) )
+    //
+    %v0 = vector.transfer_read %0[%c0, %c0, %c0, %c0], %d1
+      : tensor<1x4x4x4xf32>, vector<1x4x4x4xf32>
+    vector.print %v0 : vector<1x4x4x4xf32>
+
+    return
+  }
+
+}
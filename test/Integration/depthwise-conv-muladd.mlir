@@ -0,0 +1,97 @@
+// RUN: tpp-opt %s -decompose-conv-to-matmul-or-brgemm="block-factors=2,2" -one-shot-bufferize="bufferize-function-boundaries allow-return-allocs function-boundary-type-conversion=identity-layout-map"  -canonicalize -drop-equivalent-buffer-results -finalizing-bufferize -linalg-ext-to-loops -convert-linalg-to-tpp -convert-tpp-to-xsmm -convert-xsmm-to-func -convert-linalg-to-loops -convert-vector-to-scf -convert-scf-to-cf | \
+// RUN: tpp-run \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlirdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// RUN: tpp-opt %s -decompose-conv-to-matmul-or-brgemm="block-factors=2,2" -one-shot-bufferize="bufferize-function-boundaries allow-return-allocs function-boundary-type-conversion=identity-layout-map"  -canonicalize -drop-equivalent-buffer-results -finalizing-bufferize -linalg-ext-to-loops -convert-linalg-to-tpp -convert-tpp-to-loops -convert-linalg-to-loops -convert-vector-to-scf -convert-scf-to-cf | \
+// RUN: tpp-run \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlirdir/libmlir_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// RUN: tpp-opt %s -one-shot-bufferize="bufferize-function-boundaries allow-return-allocs function-boundary-type-conversion=identity-layout-map"  -canonicalize -drop-equivalent-buffer-results -finalizing-bufferize -convert-linalg-to-loops -convert-vector-to-scf -convert-scf-to-cf | \
+// RUN: tpp-run \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlirdir/libmlir_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// A 3x3 depthwise convolution blocked by 2 on C is mapped to a multiply-add
+// per output row and filter tap, with the taps broadcast along the row. The
+// first run executes the LIBXSMM ternary kernel, the second one the loops of
+// the multiply-add, and the last one the undecomposed convolution as
+// reference. The strided convolution reads the image rows with a leading
+// dimension.
+
+module {
+
+  func.func @depthwise_conv(%img: tensor<1x5x5x4xf32>, %filt: tensor<3x3x4xf32>,
+                            %out: tensor<1x3x3x4xf32>) -> tensor<1x3x3x4xf32> {
+    %0 = linalg.depthwise_conv_2d_nhwc_hwc { dilations = dense<[1,1]> : tensor<2xi64>,
+                                             strides = dense<[1,1]> : tensor<2xi64> }
+      ins(%img, %filt: tensor<1x5x5x4xf32>, tensor<3x3x4xf32>)
+      outs(%out: tensor<1x3x3x4xf32>) -> tensor<1x3x3x4xf32>
+    return %0 : tensor<1x3x3x4xf32>
+  }
+
+  func.func @depthwise_conv_strided(%img: tensor<1x5x5x4xf32>, %filt: tensor<3x3x4xf32>,
+                                    %out: tensor<1x2x2x4xf32>) -> tensor<1x2x2x4xf32> {
+    %0 = linalg.depthwise_conv_2d_nhwc_hwc { dilations = dense<[1,1]> : tensor<2xi64>,
+                                             strides = dense<[2,2]> : tensor<2xi64> }
+      ins(%img, %filt: tensor<1x5x5x4xf32>, tensor<3x3x4xf32>)
+      outs(%out: tensor<1x2x2x4xf32>) -> tensor<1x2x2x4xf32>
+    return %0 : tensor<1x2x2x4xf32>
+  }
+
+  func.func @entry() {
+    %c0 = arith.constant 0 : index
+    %d1 = arith.constant -1.0 : f32
+
+    %img = arith.constant dense<[
+      [
+        [ [ -3.0, -2.0, -1.0, 0.0 ], [ 0.0, 1.0, 2.0, 3.0 ], [ 3.0, -3.0, -2.0, -1.0 ], [ -1.0, 0.0, 1.0, 2.0 ], [ 2.0, 3.0, -3.0, -2.0 ] ],
+        [ [ 2.0, 3.0, -3.0, -2.0 ], [ -2.0, -1.0, 0.0, 1.0 ], [ 1.0, 2.0, 3.0, -3.0 ], [ -3.0, -2.0, -1.0, 0.0 ], [ 0.0, 1.0, 2.0, 3.0 ] ],
+        [ [ 0.0, 1.0, 2.0, 3.0 ], [ 3.0, -3.0, -2.0, -1.0 ], [ -1.0, 0.0, 1.0, 2.0 ], [ 2.0, 3.0, -3.0, -2.0 ], [ -2.0, -1.0, 0.0, 1.0 ] ],
+        [ [ -2.0, -1.0, 0.0, 1.0 ], [ 1.0, 2.0, 3.0, -3.0 ], [ -3.0, -2.0, -1.0, 0.0 ], [ 0.0, 1.0, 2.0, 3.0 ], [ 3.0, -3.0, -2.0, -1.0 ] ],
+        [ [ 3.0, -3.0, -2.0, -1.0 ], [ -1.0, 0.0, 1.0, 2.0 ], [ 2.0, 3.0, -3.0, -2.0 ], [ -2.0, -1.0, 0.0, 1.0 ], [ 1.0, 2.0, 3.0, -3.0 ] ]
+      ]
+    ]> : tensor<1x5x5x4xf32>
+
+    %filt = arith.constant dense<[
+      [ [ -1.0, 0.0, 1.0, -1.0 ], [ 0.0, 1.0, -1.0, 0.0 ], [ 1.0, -1.0, 0.0, 1.0 ] ],
+      [ [ 1.0, -1.0, 0.0, 1.0 ], [ -1.0, 0.0, 1.0, -1.0 ], [ 0.0, 1.0, -1.0, 0.0 ] ],
+      [ [ 0.0, 1.0, -1.0, 0.0 ], [ 1.0, -1.0, 0.0, 1.0 ], [ -1.0, 0.0, 1.0, -1.0 ] ]
+    ]> : tensor<3x3x4xf32>
+
+    %out = arith.constant dense<0.0> : tensor<1x3x3x4xf32>
+    %0 = call @depthwise_conv(%img, %filt, %out)
+      : (tensor<1x5x5x4xf32>, tensor<3x3x4xf32>, tensor<1x3x3x4xf32>) -> tensor<1x3x3x4xf32>
+
+    //
+    // CHECK: ( ( ( ( 14, 7, -7, -7 ), ( -7, -7, 7, 7 ), ( 7, -7, -7, -7 ) ),
+    // CHECK-SAME:  ( ( 0, -7, -7, 0 ), ( 0, 14, 0, -7 ), ( -7, -7, 0, 14 ) ),
+    // CHECK-SAME:  ( ( -7, -7, 7, 7 ), ( 7, -7, -7, -7 ), ( -7, 7, 14, 0 ) ) ) )
+    //
+    %v0 = vector.transfer_read %0[%c0, %c0, %c0, %c0], %d1
+      : tensor<1x3x3x4xf32>, vector<1x3x3x4xf32>
+    vector.print %v0 : vector<1x3x3x4xf32>
+
+    %out1 = arith.constant dense<0.0> : tensor<1x2x2x4xf32>
+    %1 = call @depthwise_conv_strided(%img, %filt, %out1)
+      : (tensor<1x5x5x4xf32>, tensor<3x3x4xf32>, tensor<1x2x2x4xf32>) -> tensor<1x2x2x4xf32>
+
+    //
+    // CHECK: ( ( ( ( 14, 7, -7, -7 ), ( 7, -7, -7, -7 ) ),
+    // CHECK-SAME:  ( ( -7, -7, 7, 7 ), ( -7, 7, 14, 0 ) ) ) )
+    //
+    %v1 = vector.transfer_read %1[%c0, %c0, %c0, %c0], %d1
+      : tensor<1x2x2x4xf32>, vector<1x2x2x4xf32>
+    vector.print %v1 : vector<1x2x2x4xf32>
+
+    return
+  }
+
+}
@@ -0,0 +1,118 @@
+// RUN: tpp-opt %s -convert-tpp-to-loops -convert-linalg-to-loops -convert-vector-to-scf -convert-scf-to-cf | \
+// RUN: tpp-run \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlirdir/libmlir_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// RUN: tpp-opt %s -convert-tpp-to-vector -convert-linalg-to-loops -convert-vector-to-scf -convert-scf-to-cf | \
+// RUN: tpp-run \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlirdir/libmlir_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// RUN: tpp-opt %s -convert-tpp-to-vector="simd-width=128" -convert-linalg-to-loops -convert-vector-to-scf -convert-scf-to-cf | \
+// RUN: tpp-run \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlirdir/libmlir_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// RUN: tpp-opt %s -convert-tpp-to-vector="simd-width=512" -convert-linalg-to-loops -convert-vector-to-scf -convert-scf-to-cf | \
+// RUN: tpp-run \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlirdir/libmlir_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// The register-blocked lowering must match the scalar loops. With 128, 256
+// and 512-bit SIMD the 7x20 output is split in full register blocks and
+// narrower remainder blocks along both M and N.
+
+module {
+  memref.global "private" constant @__constant_A : memref<7x3xf32> = dense<[[-3.0, 0.0, 3.0], [-1.0, 3.0, 0.0], [1.0, -1.0, -3.0], [3.0, 2.0, 1.0], [-2.0, -2.0, -2.0], [0.0, 1.0, 2.0], [2.0, -3.0, -1.0]]>
+  memref.global "private" constant @__constant_B : memref<3x20xf32> = dense<[[-2.0, 1.0, -3.0, 0.0, 3.0, -1.0, 2.0, -2.0, 1.0, -3.0, 0.0, 3.0, -1.0, 2.0, -2.0, 1.0, -3.0, 0.0, 3.0, -1.0], [-1.0, 2.0, -2.0, 1.0, -3.0, 0.0, 3.0, -1.0, 2.0, -2.0, 1.0, -3.0, 0.0, 3.0, -1.0, 2.0, -2.0, 1.0, -3.0, 0.0], [2.0, -2.0, 1.0, -3.0, 0.0, 3.0, -1.0, 2.0, -2.0, 1.0, -3.0, 0.0, 3.0, -1.0, 2.0, -2.0, 1.0, -3.0, 0.0, 3.0]]>
+  memref.global "private" constant @__constant_BA : memref<2x7x3xf32> = dense<[[[-3.0, 0.0, 3.0], [-1.0, 3.0, 0.0], [1.0, -1.0, -3.0], [3.0, 2.0, 1.0], [-2.0, -2.0, -2.0], [0.0, 1.0, 2.0], [2.0, -3.0, -1.0]], [[-3.0, 0.0, 3.0], [0.0, -3.0, 1.0], [3.0, 1.0, -1.0], [-1.0, -2.0, -3.0], [2.0, 2.0, 2.0], [-2.0, -1.0, 0.0], [1.0, 3.0, -2.0]]]>
+  memref.global "private" constant @__constant_BB : memref<2x3x20xf32> = dense<[[[-2.0, 1.0, -3.0, 0.0, 3.0, -1.0, 2.0, -2.0, 1.0, -3.0, 0.0, 3.0, -1.0, 2.0, -2.0, 1.0, -3.0, 0.0, 3.0, -1.0], [-1.0, 2.0, -2.0, 1.0, -3.0, 0.0, 3.0, -1.0, 2.0, -2.0, 1.0, -3.0, 0.0, 3.0, -1.0, 2.0, -2.0, 1.0, -3.0, 0.0], [2.0, -2.0, 1.0, -3.0, 0.0, 3.0, -1.0, 2.0, -2.0, 1.0, -3.0, 0.0, 3.0, -1.0, 2.0, -2.0, 1.0, -3.0, 0.0, 3.0]], [[-2.0, 2.0, -1.0, 3.0, 0.0, -3.0, 1.0, -2.0, 2.0, -1.0, 3.0, 0.0, -3.0, 1.0, -2.0, 2.0, -1.0, 3.0, 0.0, -3.0], [-1.0, 3.0, 0.0, -3.0, 1.0, -2.0, 2.0, -1.0, 3.0, 0.0, -3.0, 1.0, -2.0, 2.0, -1.0, 3.0, 0.0, -3.0, 1.0, -2.0], [2.0, -1.0, 3.0, 0.0, -3.0, 1.0, -2.0, 2.0, -1.0, 3.0, 0.0, -3.0, 1.0, -2.0, 2.0, -1.0, 3.0, 0.0, -3.0, 1.0]]]>
+  memref.global "private" constant @__constant_bias : memref<20xf32> = dense<[-2.0, -1.0, 2.0, 2.0, -1.0, -2.0, -1.0, 2.0, 2.0, -1.0, -2.0, -1.0, 2.0, 2.0, -1.0, -2.0, -1.0, 2.0, 2.0, -1.0]>
+  memref.global "private" constant @__constant_C : memref<7x20xf32> = dense<1.0>
+
+  func.func @matmul(%A: memref<7x3xf32>, %B: memref<3x20xf32>, %C: memref<7x20xf32>) {
+    tpp.matmul ins(%A: memref<7x3xf32>, %B: memref<3x20xf32>) out(%C: memref<7x20xf32>)
+    return
+  }
+
+  func.func @brgemm(%A: memref<2x7x3xf32>, %B: memref<2x3x20xf32>, %C: memref<7x20xf32>) {
+    tpp.brgemm ins(%A: memref<2x7x3xf32>, %B: memref<2x3x20xf32>) out(%C: memref<7x20xf32>)
+    return
+  }
+
+  func.func @fused_brgemm(%A: memref<2x7x3xf32>, %B: memref<2x3x20xf32>, %bias: memref<20xf32>,
+                          %C: memref<7x20xf32>) {
+    tpp.fused_brgemm ins(%A: memref<2x7x3xf32>, %B: memref<2x3x20xf32>, %bias: memref<20xf32>)
+                     out(%C: memref<7x20xf32>)
+    return
+  }
+
+  func.func @print(%C: memref<7x20xf32>) {
+    %c0 = arith.constant 0 : index
+    %d1 = arith.constant -1.0 : f32
+    %v = vector.transfer_read %C[%c0, %c0], %d1 : memref<7x20xf32>, vector<7x20xf32>
+    vector.print %v : vector<7x20xf32>
+    return
+  }
+
+  func.func @entry() {
+    %A = memref.get_global @__constant_A : memref<7x3xf32>
+    %B = memref.get_global @__constant_B : memref<3x20xf32>
+    %BA = memref.get_global @__constant_BA : memref<2x7x3xf32>
+    %BB = memref.get_global @__constant_BB : memref<2x3x20xf32>
+    %bias = memref.get_global @__constant_bias : memref<20xf32>
+    %C = memref.get_global @__constant_C : memref<7x20xf32>
+
+    // C = 1 + A x B
+    // CHECK:      ( ( 13, -8, 13, -8, -8, 13, -8, 13, -8, 13, -8, -8, 13, -8, 13, -8, 13, -8, -8, 13 ),
+    // CHECK-SAME:   ( 0, 6, -2, 4, -11, 2, 8, 0, 6, -2, 4, -11, 2, 8, 0, 6, -2, 4, -11, 2 ),
+    // CHECK-SAME:   ( -6, 6, -3, 9, 7, -9, 3, -6, 6, -3, 9, 7, -9, 3, -6, 6, -3, 9, 7, -9 ),
+    // CHECK-SAME:   ( -5, 6, -11, 0, 4, 1, 12, -5, 6, -11, 0, 4, 1, 12, -5, 6, -11, 0, 4, 1 ),
+    // CHECK-SAME:   ( 3, -1, 9, 5, 1, -3, -7, 3, -1, 9, 5, 1, -3, -7, 3, -1, 9, 5, 1, -3 ),
+    // CHECK-SAME:   ( 4, -1, 1, -4, -2, 7, 2, 4, -1, 1, -4, -2, 7, 2, 4, -1, 1, -4, -2, 7 ),
+    // CHECK-SAME:   ( -2, -1, 0, 1, 16, -4, -3, -2, -1, 0, 1, 16, -4, -3, -2, -1, 0, 1, 16, -4 ) )
+    %0 = memref.alloc() : memref<7x20xf32>
+    memref.copy %C, %0 : memref<7x20xf32> to memref<7x20xf32>
+    call @matmul(%A, %B, %0) : (memref<7x3xf32>, memref<3x20xf32>, memref<7x20xf32>) -> ()
+    call @print(%0) : (memref<7x20xf32>) -> ()
+    memref.dealloc %0 : memref<7x20xf32>
+
+    // C = 1 + sum_b BA[b] x BB[b]
+    // CHECK:      ( ( 25, -17, 25, -17, -17, 25, -17, 25, -17, 25, -17, -17, 25, -17, 25, -17, 25, -17, -17, 25 ),
+    // CHECK-SAME:   ( 5, -4, 1, 13, -17, 9, 0, 5, -4, 1, 13, -17, 9, 0, 5, -4, 1, 13, -17, 9 ),
+    // CHECK-SAME:   ( -15, 16, -9, 15, 11, -21, 10, -15, 16, -9, 15, 11, -21, 10, -15, 16, -9, 15, 11, -21 ),
+    // CHECK-SAME:   ( -7, 1, -19, 3, 11, 5, 13, -7, 1, -19, 3, 11, 5, 13, -7, 1, -19, 3, 11, 5 ),
+    // CHECK-SAME:   ( 1, 7, 13, 5, -3, -11, -5, 1, 7, 13, 5, -3, -11, -5, 1, 7, 13, 5, -3, -11 ),
+    // CHECK-SAME:   ( 9, -8, 3, -7, -3, 15, -2, 9, -8, 3, -7, -3, 15, -2, 9, -8, 3, -7, -3, 15 ),
+    // CHECK-SAME:   ( -11, 12, -7, -5, 25, -15, 8, -11, 12, -7, -5, 25, -15, 8, -11, 12, -7, -5, 25, -15 ) )
+    %1 = memref.alloc() : memref<7x20xf32>
+    memref.copy %C, %1 : memref<7x20xf32> to memref<7x20xf32>
+    call @brgemm(%BA, %BB, %1) : (memref<2x7x3xf32>, memref<2x3x20xf32>, memref<7x20xf32>) -> ()
+    call @print(%1) : (memref<7x20xf32>) -> ()
+    memref.dealloc %1 : memref<7x20xf32>
+
+    // C = relu(bias + sum_b BA[b] x BB[b]), the initial C is ignored.
+    // CHECK:      ( ( 22, 0, 26, 0, 0, 22, 0, 26, 0, 23, 0, 0, 26, 0, 23, 0, 23, 0, 0, 23 ),
+    // CHECK-SAME:   ( 2, 0, 2, 14, 0, 6, 0, 6, 0, 0, 10, 0, 10, 1, 3, 0, 0, 14, 0, 7 ),
+    // CHECK-SAME:   ( 0, 14, 0, 16, 9, 0, 8, 0, 17, 0, 12, 9, 0, 11, 0, 13, 0, 16, 12, 0 ),
+    // CHECK-SAME:   ( 0, 0, 0, 4, 9, 2, 11, 0, 2, 0, 0, 9, 6, 14, 0, 0, 0, 4, 12, 3 ),
+    // CHECK-SAME:   ( 0, 5, 14, 6, 0, 0, 0, 2, 8, 11, 2, 0, 0, 0, 0, 4, 11, 6, 0, 0 ),
+    // CHECK-SAME:   ( 6, 0, 4, 0, 0, 12, 0, 10, 0, 1, 0, 0, 16, 0, 7, 0, 1, 0, 0, 13 ),
+    // CHECK-SAME:   ( 0, 10, 0, 0, 23, 0, 6, 0, 13, 0, 0, 23, 0, 9, 0, 9, 0, 0, 26, 0 ) )
+    %2 = memref.alloc() : memref<7x20xf32>
+    memref.copy %C, %2 : memref<7x20xf32> to memref<7x20xf32>
+    call @fused_brgemm(%BA, %BB, %bias, %2) : (memref<2x7x3xf32>, memref<2x3x20xf32>, memref<20xf32>, memref<7x20xf32>) -> ()
+    call @print(%2) : (memref<7x20xf32>) -> ()
+    memref.dealloc %2 : memref<7x20xf32>
+
+    return
+  }
+}
@@ -0,0 +1,34 @@
+// RUN: echo '{"version": 1, "entries": [{"pass": "convert-linalg-to-tpp", "op": "tpp.relu", "shape": [64, 64], "type": "f32", "params": [8, 0], "seconds": 0.0}, {"pass": "pack-matmul", "op": "linalg.matmul", "shape": [128, 256, 512], "type": "f32", "params": [32, 64, 16], "seconds": 0.0}]}' > %t.json
+// RUN: tpp-tune %s -e entry -o %t.json -max-candidates=2 -n=2 \
+// RUN:  -pipeline="func.func(convert-linalg-to-tpp{enable-tiling=true},convert-tpp-to-loops)" \
+// RUN:  -shared-libs=%llvmlirdir/libmlir_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+// RUN: cat %t.json | FileCheck %s -check-prefix=DB
+//
+
+// The baseline uses the entry already in the database, then the tile sizes
+// that tile fewer loops are timed first.
+// CHECK: Found 1 tunable ops
+// CHECK-NEXT: convert-linalg-to-tpp:tpp.relu:64x64:f32
+// CHECK-NEXT: baseline: {{.+}} s
+// CHECK-NEXT: [0, 32]: {{.+}} s
+// CHECK-NEXT: [0, 16]: {{.+}} s
+// CHECK-NEXT: best: [{{.+}}]
+
+// The tuned op is added to the database, the entries of other kernels are kept.
+// DB: "version": 1
+// DB: "pass": "convert-linalg-to-tpp"
+// DB-NEXT: "op": "tpp.relu"
+// DB: "pass": "pack-matmul"
+// DB-NEXT: "op": "linalg.matmul"
+
+#map0 = affine_map<(d0, d1) -> (d0, d1)>
+
+func.func @entry(%arg0: memref<64x64xf32>) {
+  linalg.generic {indexing_maps = [#map0], iterator_types = ["parallel", "parallel"], library_call = "tpp.relu"} outs(%arg0 : memref<64x64xf32>) {
+    ^bb0(%arg1: f32):
+      %0 = mathx.relu %arg1 : f32
+      linalg.yield %0 : f32
+  }
+  return
+}
@@ -0,0 +1,54 @@
+// RUN: tpp-opt %s -convert-xsmm-to-func -convert-linalg-to-loops -convert-vector-to-scf -convert-scf-to-cf | \
+// RUN: tpp-run \
+// RUN:  -e entry -entry-point-result=void  \
+// RUN: -shared-libs=%llvmlirdir/libmlir_c_runner_utils%shlibext,%tpplibdir/libtpp_c_runner_utils%shlibext | \
+// RUN: FileCheck %s
+//
+
+// The offset-list and the address-list BRGEMM reduce over the same blocks:
+// A0 starts at element 12 of A and A1 at element 2, overlapping as the pixels
+// read by the taps of a convolution, while B0 starts at element 4 of B and B1
+// at element 0.
+
+module {
+  memref.global "private" constant @__constant_A : memref<2x6x2xf32> = dense<[[[0.0, 1.0], [2.0, 3.0], [4.0, 5.0], [6.0, 7.0], [8.0, 9.0], [10.0, 11.0]], [[12.0, 13.0], [14.0, 15.0], [16.0, 17.0], [18.0, 19.0], [20.0, 21.0], [22.0, 23.0]]]>
+  memref.global "private" constant @__constant_B : memref<2x2x2xf32> = dense<[[[0.0, 1.0], [2.0, 3.0]], [[4.0, 5.0], [6.0, 7.0]]]>
+
+  func.func @print(%C: memref<4x2xf32>) {
+    %c0 = arith.constant 0 : index
+    %d1 = arith.constant -1.0 : f32
+    %v = vector.transfer_read %C[%c0, %c0], %d1 : memref<4x2xf32>, vector<4x2xf32>
+    vector.print %v : vector<4x2xf32>
+    return
+  }
+
+  func.func @entry() {
+    %A = memref.get_global @__constant_A : memref<2x6x2xf32>
+    %B = memref.get_global @__constant_B : memref<2x2x2xf32>
+    %one = arith.constant 1.0 : f32
+    %batch = arith.constant 2 : i64
+
+    // C = 1 + A[12:20] x B[4:8] + A[2:10] x B[0:4]
+    // CHECK: ( ( 133, 163 ), ( 157, 195 ), ( 181, 227 ), ( 205, 259 ) )
+    %C0 = memref.alloc() : memref<4x2xf32>
+    linalg.fill ins(%one : f32) outs(%C0 : memref<4x2xf32>)
+    %offs = xsmm.ternary.dispatch brgemm_offs [4, 2, 2, 2, 2, 2](dataType f32)
+    xsmm.ternary brgemm_offs(%offs, %A, %B, %C0, %batch)
+      {offsetsA = array<i64: 12, 2>, offsetsB = array<i64: 4, 0>}
+      : (i64, memref<2x6x2xf32>, memref<2x2x2xf32>, memref<4x2xf32>, i64) -> ()
+    call @print(%C0) : (memref<4x2xf32>) -> ()
+
+    // CHECK: ( ( 133, 163 ), ( 157, 195 ), ( 181, 227 ), ( 205, 259 ) )
+    %C1 = memref.alloc() : memref<4x2xf32>
+    linalg.fill ins(%one : f32) outs(%C1 : memref<4x2xf32>)
+    %addr = xsmm.ternary.dispatch brgemm_addr [4, 2, 2, 2, 2, 2](dataType f32)
+    xsmm.ternary brgemm_addr(%addr, %A, %B, %C1, %batch)
+      {offsetsA = array<i64: 12, 2>, offsetsB = array<i64: 4, 0>}
+      : (i64, memref<2x6x2xf32>, memref<2x2x2xf32>, memref<4x2xf32>, i64) -> ()
+    call @print(%C1) : (memref<4x2xf32>) -> ()
+
+    memref.dealloc %C0 : memref<4x2xf32>
+    memref.dealloc %C1 : memref<4x2xf32>
+    return
+  }
+}
@@ -0,0 +1,46 @@
+// RUN: tpp-opt %s -split-input-file -verify-diagnostics -assign-block-layout -canonicalize | FileCheck %s
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+
+// On their own, both layers pick [64, 64, 32]. The first layer moves to
+// [64, 32, 64] to produce its output in the layout consumed by the second
+// layer, which is cheaper than relayouting the activations.
+// CHECK-LABEL: func.func @mlp(
+// CHECK: %[[L1:.+]] = linalg.generic
+// CHECK-SAME:  ins(%{{.+}}, %{{.+}} : tensor<2x4x64x64xf32>, tensor<16x4x64x32xf32>) outs(%{{.+}} : tensor<2x16x64x32xf32>)
+// CHECK-NOT: linalgx.unpack
+// CHECK: %[[RELU:.+]] = linalg.generic
+// CHECK-SAME:  ins(%[[L1]] : tensor<2x16x64x32xf32>)
+// CHECK-NOT: linalgx.unpack
+// CHECK: %[[L2:.+]] = linalg.generic
+// CHECK-SAME:  ins(%[[RELU]], %{{.+}} : tensor<2x16x64x32xf32>, tensor<1x16x32x64xf32>) outs(%{{.+}} : tensor<2x1x64x64xf32>)
+// CHECK: %[[OUT:.+]] = linalgx.unpack %[[L2]]
+// CHECK: return %[[OUT]] : tensor<128x64xf32>
+func.func @mlp(%arg0: tensor<128x256xf32>, %arg1: tensor<256x512xf32>,
+               %arg2: tensor<128x512xf32>, %arg3: tensor<512x64xf32>,
+               %arg4: tensor<128x64xf32>) -> tensor<128x64xf32> {
+  %cst = arith.constant 0.000000e+00 : f32
+  // expected-remark @below {{assigned blocking factors: [64, 32, 64]}}
+  %0 = linalg.matmul ins(%arg0, %arg1: tensor<128x256xf32>, tensor<256x512xf32>) outs(%arg2: tensor<128x512xf32>) -> tensor<128x512xf32>
+  %1 = tensor.empty() : tensor<128x512xf32>
+  %2 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]} ins(%0 : tensor<128x512xf32>) outs(%1 : tensor<128x512xf32>) {
+    ^bb0(%in: f32, %out: f32):
+      %3 = arith.maxf %in, %cst : f32
+      linalg.yield %3 : f32
+  } -> tensor<128x512xf32>
+  // expected-remark @below {{assigned blocking factors: [64, 64, 32]}}
+  %4 = linalg.matmul ins(%2, %arg3: tensor<128x512xf32>, tensor<512x64xf32>) outs(%arg4: tensor<128x64xf32>) -> tensor<128x64xf32>
+  return %4 : tensor<128x64xf32>
+}
+
+// -----
+
+// CHECK-LABEL: func.func @conv(
+// CHECK: linalg.generic
+// CHECK-SAME:  ins(%{{.+}}, %{{.+}} : tensor<1x2x16x16x32xf32>, tensor<2x2x3x3x32x32xf32>) outs(%{{.+}} : tensor<1x2x14x14x32xf32>)
+func.func @conv(%i: tensor<1x64x16x16xf32>, %f: tensor<64x64x3x3xf32>,
+                %o: tensor<1x64x14x14xf32>) -> tensor<1x64x14x14xf32> {
+  // expected-remark @below {{assigned blocking factors: [32, 32]}}
+  %0 = linalg.conv_2d_nchw_fchw ins(%i, %f: tensor<1x64x16x16xf32>, tensor<64x64x3x3xf32>) outs(%o: tensor<1x64x14x14xf32>) -> tensor<1x64x14x14xf32>
+  return %0 : tensor<1x64x14x14xf32>
+}
@@ -0,0 +1,96 @@
+// RUN: tpp-opt -main-closure -closure-to-init-run -split-input-file %s | FileCheck %s
+
+#map0 = affine_map<(d0, d1, d2) -> (d0, d2)>
+#map1 = affine_map<(d0, d1, d2) -> (d2, d1)>
+#map2 = affine_map<(d0, d1, d2) -> (d0, d1)>
+#map3 = affine_map<(d0, d1) -> (d0, d1)>
+
+// CHECK-LABEL: func.func @main(
+// CHECK-SAME:  %[[A:.+]]: tensor<6x9xf32>, %[[B:.+]]: tensor<9x12xf32> {stdx.const},
+// CHECK-SAME:  %[[D:.+]]: tensor<9x12xf32> {stdx.const}, %[[C:.+]]: tensor<6x12xf32> {stdx.res})
+// CHECK-NOT: stdx.closure
+// CHECK: %[[STATE:.+]] = call @main_init(%[[B]], %[[D]]) : (tensor<9x12xf32>, tensor<9x12xf32>) -> tensor<9x12xf32>
+// CHECK: %[[RES:.+]] = call @main_run(%[[STATE]], %[[A]], %[[C]]) : (tensor<9x12xf32>, tensor<6x9xf32>, tensor<6x12xf32>) -> tensor<6x12xf32>
+// CHECK: return %[[RES]] : tensor<6x12xf32>
+
+// CHECK-LABEL: func.func @main_init(
+// CHECK-SAME:  %[[INITB:.+]]: tensor<9x12xf32> {stdx.const}, %[[INITD:.+]]: tensor<9x12xf32> {stdx.const}) -> tensor<9x12xf32>
+// CHECK: %[[E:.+]] = linalg.generic
+// CHECK-SAME:  ins(%[[INITB]] : tensor<9x12xf32>) outs(%[[INITD]] : tensor<9x12xf32>)
+// CHECK: return %[[E]] : tensor<9x12xf32>
+
+// CHECK-LABEL: func.func @main_run(
+// CHECK-SAME:  %[[RUNE:.+]]: tensor<9x12xf32>, %[[RUNA:.+]]: tensor<6x9xf32>,
+// CHECK-SAME:  %[[RUNC:.+]]: tensor<6x12xf32> {stdx.res}) -> tensor<6x12xf32>
+// CHECK: %[[F:.+]] = linalg.generic
+// CHECK-SAME:  ins(%[[RUNA]], %[[RUNE]] : tensor<6x9xf32>, tensor<9x12xf32>) outs(%[[RUNC]] : tensor<6x12xf32>)
+// CHECK-NOT: linalg.generic
+// CHECK: return %[[F]] : tensor<6x12xf32>
+func.func @main(%A: tensor<6x9xf32>, %B: tensor<9x12xf32> {stdx.const}, %D: tensor<9x12xf32> {stdx.const},
+                %C: tensor<6x12xf32> {stdx.res}) -> tensor<6x12xf32> {
+  %E = linalg.generic {indexing_maps = [#map3, #map3],
+                       iterator_types = ["parallel", "parallel"]}
+    ins(%B: tensor<9x12xf32>) outs(%D: tensor<9x12xf32>) {
+      ^bb0(%a: f32, %b: f32):
+        %0 = arith.addf %a, %b : f32
+        linalg.yield %0 : f32
+  } -> tensor<9x12xf32>
+  %F = linalg.generic {indexing_maps = [#map0, #map1, #map2],
+                       iterator_types = ["parallel", "parallel", "reduction"]}
+    ins(%A, %E: tensor<6x9xf32>, tensor<9x12xf32>) outs(%C: tensor<6x12xf32>) {
+      ^bb0(%a: f32, %b: f32, %c: f32):
+        %0 = arith.mulf %a, %b : f32
+        %1 = arith.addf %c, %0 : f32
+        linalg.yield %1 : f32
+  } -> tensor<6x12xf32>
+  return %F: tensor<6x12xf32>
+}
+
+// -----
+
+#map0 = affine_map<(d0, d1, d2) -> (d0, d2)>
+#map1 = affine_map<(d0, d1, d2) -> (d2, d1)>
+#map2 = affine_map<(d0, d1, d2) -> (d0, d1)>
+#map3 = affine_map<(d0, d1) -> (d0, d1)>
+
+// The function also returns a value that is not the result of the closure, so
+// it cannot be split. The closure must be left untouched, including the
+// closure-invariant computation that would otherwise be hoisted.
+
+// CHECK-LABEL: func.func @rejected(
+// CHECK-SAME:  %[[A:.+]]: tensor<6x9xf32>, %[[B:.+]]: tensor<9x12xf32>, %[[D:.+]]: tensor<9x12xf32>,
+// CHECK-SAME:  %[[C:.+]]: tensor<6x12xf32>)
+// CHECK-NOT: call
+// CHECK: %[[RES:.+]] = stdx.closure init_args(%[[INITA:.+]] = %[[A]])
+// CHECK-SAME: init_outs(%[[INITC:.+]] = %[[C]])
+// CHECK: %[[E:.+]] = linalg.generic
+// CHECK-SAME:  ins(%[[B]] : tensor<9x12xf32>) outs(%[[D]] : tensor<9x12xf32>)
+// CHECK: %[[F:.+]] = linalg.generic
+// CHECK-SAME:  ins(%[[INITA]], %[[E]] : tensor<6x9xf32>, tensor<9x12xf32>) outs(%[[INITC]] : tensor<6x12xf32>)
+// CHECK: stdx.yield %[[F]] : tensor<6x12xf32>
+// CHECK: return %[[RES]], %[[B]] : tensor<6x12xf32>, tensor<9x12xf32>
+// CHECK-NOT: func.func @rejected_init
+// CHECK-NOT: func.func @rejected_run
+func.func @rejected(%A: tensor<6x9xf32>, %B: tensor<9x12xf32>, %D: tensor<9x12xf32>,
+                    %C: tensor<6x12xf32>) -> (tensor<6x12xf32>, tensor<9x12xf32>) {
+  %0 = stdx.closure init_args(%a = %A) -> (tensor<6x9xf32>)
+                    init_outs(%c = %C) -> (tensor<6x12xf32>) {
+    %E = linalg.generic {indexing_maps = [#map3, #map3],
+                         iterator_types = ["parallel", "parallel"]}
+      ins(%B: tensor<9x12xf32>) outs(%D: tensor<9x12xf32>) {
+        ^bb0(%b: f32, %d: f32):
+          %1 = arith.addf %b, %d : f32
+          linalg.yield %1 : f32
+    } -> tensor<9x12xf32>
+    %F = linalg.generic {indexing_maps = [#map0, #map1, #map2],
+                         iterator_types = ["parallel", "parallel", "reduction"]}
+      ins(%a, %E: tensor<6x9xf32>, tensor<9x12xf32>) outs(%c: tensor<6x12xf32>) {
+        ^bb0(%x: f32, %y: f32, %z: f32):
+          %1 = arith.mulf %x, %y : f32
+          %2 = arith.addf %z, %1 : f32
+          linalg.yield %2 : f32
+    } -> tensor<6x12xf32>
+    stdx.yield %F : tensor<6x12xf32>
+  }
+  return %0, %B : tensor<6x12xf32>, tensor<9x12xf32>
+}
@@ -7,3 +7,73 @@ func.func @conv(%i: tensor<14x512x28x28xf32>, %f: tensor<1024x512x1x1xf32>,
                                 outs(%o: tensor<14x1024x28x28xf32>) -> tensor<14x1024x28x28xf32>
   return %0: tensor<14x1024x28x28xf32>
 }
+
+// The image is subsampled, then H and W are collapsed as with unit strides.
+// CHECK-LABEL: func.func @conv_strided(
+func.func @conv_strided(%i: tensor<1x64x8x8xf32>, %f: tensor<64x64x1x1xf32>,
+                        %o: tensor<1x64x4x4xf32>) -> tensor<1x64x4x4xf32> {
+  // CHECK: tensor.extract_slice %{{.+}}[0, 0, 0, 0, 0] [1, 2, 4, 4, 32] [1, 1, 2, 2, 1] : tensor<1x2x8x8x32xf32> to tensor<1x2x4x4x32xf32>
+  // CHECK: linalg.batch_reduce_matmul
+  %0 = linalg.conv_2d_nchw_fchw {dilations = dense<1> : tensor<2xi64>, strides = dense<2> : tensor<2xi64>}
+    ins(%i, %f: tensor<1x64x8x8xf32>, tensor<64x64x1x1xf32>) outs(%o: tensor<1x64x4x4xf32>) -> tensor<1x64x4x4xf32>
+  return %0 : tensor<1x64x4x4xf32>
+}
+
+// The filter taps join C' in the reduction of an offset-based BRGEMM per
+// output row.
+// CHECK-LABEL: func.func @conv_3x3(
+func.func @conv_3x3(%i: tensor<1x64x6x6xf32>, %f: tensor<64x64x3x3xf32>,
+                    %o: tensor<1x64x4x4xf32>) -> tensor<1x64x4x4xf32> {
+  // CHECK: scf.for
+  // CHECK: scf.for
+  // CHECK: scf.for
+  // CHECK: tensor.extract_slice %{{.+}}[%{{.+}}, 0, %{{.+}}, 0, 0] [1, 2, 3, 6, 32] [1, 1, 1, 1, 1] : tensor<1x2x6x6x32xf32> to tensor<2x3x6x32xf32>
+  // CHECK: tensor.extract_slice %{{.+}}[%{{.+}}, 0, 0, 0, 0, 0] [1, 2, 3, 3, 32, 32] [1, 1, 1, 1, 1, 1] : tensor<2x2x3x3x32x32xf32> to tensor<2x3x3x32x32xf32>
+  // CHECK: tensor.extract_slice %{{.+}}[%{{.+}}, %{{.+}}, %{{.+}}, 0, 0] [1, 1, 1, 4, 32] [1, 1, 1, 1, 1] : tensor<1x2x4x4x32xf32> to tensor<4x32xf32>
+  // CHECK: linalg.generic
+  // CHECK-SAME: iterator_types = ["reduction", "reduction", "reduction", "parallel", "parallel", "reduction"]
+  // CHECK-SAME: library_call = "tpp.offset_brgemm"
+  // CHECK-NOT: linalg.batch_reduce_matmul
+  %0 = linalg.conv_2d_nchw_fchw ins(%i, %f: tensor<1x64x6x6xf32>, tensor<64x64x3x3xf32>)
+                                outs(%o: tensor<1x64x4x4xf32>) -> tensor<1x64x4x4xf32>
+  return %0 : tensor<1x64x4x4xf32>
+}
+
+// A depthwise convolution is a multiply-add per output row and filter tap,
+// with the taps of a channel block broadcast along the row.
+// CHECK-LABEL: func.func @depthwise_conv_3x3(
+func.func @depthwise_conv_3x3(%i: tensor<1x6x6x64xf32>, %f: tensor<3x3x64xf32>,
+                              %o: tensor<1x4x4x64xf32>) -> tensor<1x4x4x64xf32> {
+  // CHECK: scf.for
+  // CHECK: scf.for
+  // CHECK: scf.for
+  // CHECK: scf.for
+  // CHECK: scf.for
+  // CHECK: tensor.extract_slice %{{.+}}[%{{.+}}, %{{.+}}, %{{.+}}, %{{.+}}, 0] [1, 1, 1, 4, 32] [1, 1, 1, 1, 1] : tensor<1x2x6x6x32xf32> to tensor<4x32xf32>
+  // CHECK: tensor.extract_slice %{{.+}}[%{{.+}}, %{{.+}}, %{{.+}}, 0] [1, 1, 1, 32] [1, 1, 1, 1] : tensor<2x3x3x32xf32> to tensor<32xf32>
+  // CHECK: tensor.extract_slice %{{.+}}[%{{.+}}, %{{.+}}, %{{.+}}, 0, 0] [1, 1, 1, 4, 32] [1, 1, 1, 1, 1] : tensor<1x2x4x4x32xf32> to tensor<4x32xf32>
+  // CHECK: linalg.generic
+  // CHECK-SAME: iterator_types = ["parallel", "parallel"]
+  // CHECK-SAME: library_call = "tpp.muladd"
+  %0 = linalg.depthwise_conv_2d_nhwc_hwc {dilations = dense<1> : tensor<2xi64>,
+                                          strides = dense<1> : tensor<2xi64>}
+    ins(%i, %f: tensor<1x6x6x64xf32>, tensor<3x3x64xf32>)
+    outs(%o: tensor<1x4x4x64xf32>) -> tensor<1x4x4x64xf32>
+  return %0 : tensor<1x4x4x64xf32>
+}
+
+// A grouped convolution is a blocked convolution per image and group.
+// CHECK-LABEL: func.func @grouped_conv(
+func.func @grouped_conv(%i: tensor<1x2x64x6x6xf32>, %f: tensor<64x2x64x1x1xf32>,
+                        %o: tensor<1x2x64x6x6xf32>) -> tensor<1x2x64x6x6xf32> {
+  // CHECK: scf.for
+  // CHECK: scf.for
+  // CHECK: tensor.extract_slice %{{.+}}[%{{.+}}, %{{.+}}, 0, 0, 0, 0] [1, 1, 2, 6, 6, 32] [1, 1, 1, 1, 1, 1] : tensor<1x2x2x6x6x32xf32> to tensor<1x2x6x6x32xf32>
+  // CHECK: tensor.extract_slice %{{.+}}[%{{.+}}, 0, 0, 0, 0, 0, 0] [1, 2, 2, 1, 1, 32, 32] [1, 1, 1, 1, 1, 1, 1] : tensor<2x2x2x1x1x32x32xf32> to tensor<2x2x1x1x32x32xf32>
+  // CHECK: linalg.batch_reduce_matmul
+  %0 = linalg.conv_2d_ngchw_fgchw {dilations = dense<1> : tensor<2xi64>,
+                                   strides = dense<1> : tensor<2xi64>}
+    ins(%i, %f: tensor<1x2x64x6x6xf32>, tensor<64x2x64x1x1xf32>)
+    outs(%o: tensor<1x2x64x6x6xf32>) -> tensor<1x2x64x6x6xf32>
+  return %0 : tensor<1x2x64x6x6xf32>
+}
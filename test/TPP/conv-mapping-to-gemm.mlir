@@ -50,3 +50,41 @@ func.func @conv(%i: tensor<?x?x?x?xf32>, %f: tensor<?x?x3x?xf32>,
   %0 = linalg.conv_2d_nchw_fchw ins(%i, %f: tensor<?x?x?x?xf32>, tensor<?x?x3x?xf32>) outs(%o: tensor<?x?x?x?xf32>) -> tensor<?x?x?x?xf32>
   return %0 : tensor<?x?x?x?xf32>
 }
+
+// -----
+
+// CHECK-LABEL: func.func @conv_strided(
+func.func @conv_strided(%i: tensor<1x9x9x8xf32>, %f: tensor<3x3x8x16xf32>,
+                        %o: tensor<1x4x4x16xf32>) -> tensor<1x4x4x16xf32> {
+  // CHECK: tensor.extract_slice %{{.+}}[{{.+}}] [1, 1, 4, 8] [1, 1, 2, 1] : tensor<1x9x9x8xf32> to tensor<4x8xf32>
+  // CHECK: linalg.matmul
+  %0 = linalg.conv_2d_nhwc_hwcf {dilations = dense<1> : tensor<2xi64>, strides = dense<2> : tensor<2xi64>}
+    ins(%i, %f: tensor<1x9x9x8xf32>, tensor<3x3x8x16xf32>) outs(%o: tensor<1x4x4x16xf32>) -> tensor<1x4x4x16xf32>
+  return %0 : tensor<1x4x4x16xf32>
+}
+
+// -----
+
+// CHECK-DAG: #[[DILATION:.+]] = affine_map<(d0) -> (d0 * 2)>
+// CHECK-LABEL: func.func @conv_dilated(
+func.func @conv_dilated(%i: tensor<1x8x8x8xf32>, %f: tensor<3x3x8x16xf32>,
+                        %o: tensor<1x4x4x16xf32>) -> tensor<1x4x4x16xf32> {
+  // CHECK: %[[W:.+]] = affine.apply #[[DILATION]](%{{.+}})
+  // CHECK: tensor.extract_slice %{{.+}}[%{{.+}}, %{{.+}}, %[[W]], 0] [1, 1, 4, 8] [1, 1, 1, 1] : tensor<1x8x8x8xf32> to tensor<4x8xf32>
+  // CHECK: linalg.matmul
+  %0 = linalg.conv_2d_nhwc_hwcf {dilations = dense<2> : tensor<2xi64>, strides = dense<1> : tensor<2xi64>}
+    ins(%i, %f: tensor<1x8x8x8xf32>, tensor<3x3x8x16xf32>) outs(%o: tensor<1x4x4x16xf32>) -> tensor<1x4x4x16xf32>
+  return %0 : tensor<1x4x4x16xf32>
+}
+
+// -----
+
+// CHECK-LABEL: func.func @conv_nchw_strided(
+func.func @conv_nchw_strided(%i: tensor<1x64x8x8xf32>, %f: tensor<64x64x1x1xf32>,
+                             %o: tensor<1x64x4x4xf32>) -> tensor<1x64x4x4xf32> {
+  // CHECK: tensor.extract_slice %{{.+}}[{{.+}}] [1, 1, 1, 4, 32] [1, 1, 1, 2, 1] : tensor<1x2x8x8x32xf32> to tensor<4x32xf32>
+  // CHECK: linalg.matmul
+  %0 = linalg.conv_2d_nchw_fchw {dilations = dense<1> : tensor<2xi64>, strides = dense<2> : tensor<2xi64>}
+    ins(%i, %f: tensor<1x64x8x8xf32>, tensor<64x64x1x1xf32>) outs(%o: tensor<1x64x4x4xf32>) -> tensor<1x64x4x4xf32>
+  return %0 : tensor<1x64x4x4xf32>
+}
@@ -0,0 +1,67 @@
+// RUN: tpp-opt %s -pack-conv2DNhwcHwcf="block-factors=32,32" -pack-conv2DNchwFchw="block-factors=32,32" -canonicalize -split-input-file | FileCheck %s
+
+#map = affine_map<(d0, d1, d2, d3) -> (d0, d1, d2, d3)>
+
+// The relu reads the NHWC output in the NCHWc layout of the depthwise
+// convolution: its map permutes the outer dimensions.
+// CHECK-DAG: #[[MAP:.+]] = affine_map<(d0, d1, d2, d3, d4) -> (d0, d3, d1, d2, d4)>
+// CHECK-LABEL: func.func @depthwise_relu(
+// CHECK-SAME:  %[[ARG0:.+]]: tensor<1x6x6x64xf32>,
+// CHECK-SAME:  %[[ARG1:.+]]: tensor<3x3x64xf32>,
+// CHECK-SAME:  %[[ARG2:.+]]: tensor<1x4x4x64xf32>)
+// CHECK: linalgx.pack %[[ARG0]] outer_dims_perm = [0, 3, 1, 2] inner_dims_pos = [3] inner_tiles = [32]
+// CHECK: linalgx.pack %[[ARG1]] outer_dims_perm = [2, 0, 1] inner_dims_pos = [2] inner_tiles = [32]
+// CHECK: %[[CONV:.+]] = linalg.generic
+// CHECK-SAME:  iterator_types = ["parallel", "parallel", "parallel", "parallel", "parallel", "reduction", "reduction"]
+// CHECK-SAME:  outs(%{{.+}} : tensor<1x2x4x4x32xf32>)
+// CHECK-NOT: linalgx.unpack
+// CHECK: %[[RELU:.+]] = linalg.generic {indexing_maps = [#[[MAP]]], iterator_types = ["parallel", "parallel", "parallel", "parallel", "parallel"]} outs(%[[CONV]] : tensor<1x2x4x4x32xf32>)
+// CHECK: %[[OUT:.+]] = linalgx.unpack %[[RELU]] outer_dims_perm = [0, 3, 1, 2] inner_dims_pos = [3] inner_tiles = [32] into %[[ARG2]]
+// CHECK: return %[[OUT]] : tensor<1x4x4x64xf32>
+func.func @depthwise_relu(%i: tensor<1x6x6x64xf32>, %f: tensor<3x3x64xf32>,
+                          %o: tensor<1x4x4x64xf32>) -> tensor<1x4x4x64xf32> {
+  %cst = arith.constant 0.000000e+00 : f32
+  %0 = linalg.depthwise_conv_2d_nhwc_hwc {dilations = dense<1> : tensor<2xi64>,
+                                          strides = dense<1> : tensor<2xi64>}
+    ins(%i, %f: tensor<1x6x6x64xf32>, tensor<3x3x64xf32>)
+    outs(%o: tensor<1x4x4x64xf32>) -> tensor<1x4x4x64xf32>
+  %1 = linalg.generic {indexing_maps = [#map], iterator_types = ["parallel", "parallel", "parallel", "parallel"]} outs(%0 : tensor<1x4x4x64xf32>) {
+    ^bb0(%out: f32):
+      %2 = arith.maxf %out, %cst : f32
+      linalg.yield %2 : f32
+  } -> tensor<1x4x4x64xf32>
+  return %1 : tensor<1x4x4x64xf32>
+}
+
+// -----
+
+#map = affine_map<(d0, d1, d2, d3, d4) -> (d0, d1, d2, d3, d4)>
+
+// Each group is blocked as a Conv2DNchwFchw.
+// CHECK-LABEL: func.func @grouped_relu(
+// CHECK-SAME:  %[[ARG0:.+]]: tensor<1x2x64x6x6xf32>,
+// CHECK-SAME:  %[[ARG1:.+]]: tensor<64x2x64x1x1xf32>,
+// CHECK-SAME:  %[[ARG2:.+]]: tensor<1x2x64x6x6xf32>)
+// CHECK: linalgx.pack %[[ARG0]] inner_dims_pos = [2] inner_tiles = [32] into %{{.+}} : (tensor<1x2x64x6x6xf32> tensor<1x2x2x6x6x32xf32>)
+// CHECK: linalgx.pack %[[ARG1]] outer_dims_perm = [1, 0, 2, 3, 4] inner_dims_pos = [2, 0] inner_tiles = [32, 32] into %{{.+}} : (tensor<64x2x64x1x1xf32> tensor<2x2x2x1x1x32x32xf32>)
+// CHECK: %[[CONV:.+]] = linalg.generic
+// CHECK-SAME:  iterator_types = ["parallel", "parallel", "parallel", "parallel", "parallel", "parallel", "reduction", "reduction", "reduction", "reduction"]
+// CHECK-NOT: linalgx.unpack
+// CHECK: %[[RELU:.+]] = linalg.generic
+// CHECK-SAME:  outs(%[[CONV]] : tensor<1x2x2x6x6x32xf32>)
+// CHECK: %[[OUT:.+]] = linalgx.unpack %[[RELU]] inner_dims_pos = [2] inner_tiles = [32] into %[[ARG2]]
+// CHECK: return %[[OUT]] : tensor<1x2x64x6x6xf32>
+func.func @grouped_relu(%i: tensor<1x2x64x6x6xf32>, %f: tensor<64x2x64x1x1xf32>,
+                        %o: tensor<1x2x64x6x6xf32>) -> tensor<1x2x64x6x6xf32> {
+  %cst = arith.constant 0.000000e+00 : f32
+  %0 = linalg.conv_2d_ngchw_fgchw {dilations = dense<1> : tensor<2xi64>,
+                                   strides = dense<1> : tensor<2xi64>}
+    ins(%i, %f: tensor<1x2x64x6x6xf32>, tensor<64x2x64x1x1xf32>)
+    outs(%o: tensor<1x2x64x6x6xf32>) -> tensor<1x2x64x6x6xf32>
+  %1 = linalg.generic {indexing_maps = [#map], iterator_types = ["parallel", "parallel", "parallel", "parallel", "parallel"]} outs(%0 : tensor<1x2x64x6x6xf32>) {
+    ^bb0(%out: f32):
+      %2 = arith.maxf %out, %cst : f32
+      linalg.yield %2 : f32
+  } -> tensor<1x2x64x6x6xf32>
+  return %1 : tensor<1x2x64x6x6xf32>
+}
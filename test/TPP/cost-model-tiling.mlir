@@ -0,0 +1,48 @@
+// RUN: tpp-opt %s -split-input-file -verify-diagnostics -convert-linalg-to-tpp="enable-tiling" | FileCheck %s
+
+#map0 = affine_map<(d0, d1, d2) -> (d0, d2)>
+#map1 = affine_map<(d0, d1, d2) -> (d2, d1)>
+#map2 = affine_map<(d0, d1, d2) -> (d0, d1)>
+
+// Large K: keep the output block in registers and tile the reduction.
+// CHECK-LABEL: func.func @large_k(
+// CHECK-SAME:  %[[ARG0:.+]]: memref<64x4096xf32>, %[[ARG1:.+]]: memref<4096x64xf32>, %[[ARG2:.+]]: memref<64x64xf32>
+// CHECK-DAG: %[[C0:.+]] = arith.constant 0 : index
+// CHECK-DAG: %[[C32:.+]] = arith.constant 32 : index
+// CHECK-DAG: %[[C4096:.+]] = arith.constant 4096 : index
+// CHECK: scf.for %[[K:.+]] = %[[C0]] to %[[C4096]] step %[[C32]] {
+// CHECK: %[[A:.+]] = memref.subview %[[ARG0]][0, %[[K]]] [64, 32] [1, 1]
+// CHECK: %[[B:.+]] = memref.subview %[[ARG1]][%[[K]], 0] [32, 64] [1, 1]
+// CHECK: tpp.matmul ins(%[[A]] : {{.+}}, %[[B]] : {{.+}}) out(%[[ARG2]] : memref<64x64xf32>)
+func.func @large_k(%arg0: memref<64x4096xf32>, %arg1: memref<4096x64xf32>, %arg2: memref<64x64xf32>) {
+  // expected-remark @below {{cost model tile sizes: [64, 64, 32]}}
+  linalg.generic {indexing_maps = [#map0, #map1, #map2], iterator_types = ["parallel", "parallel", "reduction"], library_call = "tpp.matmul"} ins(%arg0, %arg1 : memref<64x4096xf32>, memref<4096x64xf32>) outs(%arg2 : memref<64x64xf32>) {
+    ^bb0(%a: f32, %b: f32, %c: f32):
+      %0 = arith.mulf %a, %b : f32
+      %1 = arith.addf %c, %0 : f32
+      linalg.yield %1 : f32
+  }
+  return
+}
+
+// -----
+
+#map0 = affine_map<(d0, d1, d2) -> (d0, d2)>
+#map1 = affine_map<(d0, d1, d2) -> (d2, d1)>
+#map2 = affine_map<(d0, d1, d2) -> (d0, d1)>
+
+// Tall and skinny: a single SIMD vector along N, few large blocks along M.
+// CHECK-LABEL: func.func @tall_skinny(
+// CHECK-DAG: %[[C2048:.+]] = arith.constant 2048 : index
+// CHECK: scf.for %{{.+}} = %{{.+}} to %{{.+}} step %[[C2048]] {
+// CHECK: tpp.matmul ins(%{{.+}} : memref<2048x64xf32, {{.+}}>, %{{.+}} : memref<64x16xf32>) out(%{{.+}} : memref<2048x16xf32, {{.+}}>)
+func.func @tall_skinny(%arg0: memref<4096x64xf32>, %arg1: memref<64x16xf32>, %arg2: memref<4096x16xf32>) {
+  // expected-remark @below {{cost model tile sizes: [2048, 16, 64]}}
+  linalg.generic {indexing_maps = [#map0, #map1, #map2], iterator_types = ["parallel", "parallel", "reduction"], library_call = "tpp.matmul"} ins(%arg0, %arg1 : memref<4096x64xf32>, memref<64x16xf32>) outs(%arg2 : memref<4096x16xf32>) {
+    ^bb0(%a: f32, %b: f32, %c: f32):
+      %0 = arith.mulf %a, %b : f32
+      %1 = arith.addf %c, %0 : f32
+      linalg.yield %1 : f32
+  }
+  return
+}
@@ -0,0 +1,60 @@
+// RUN: tpp-opt %s -convert-linalg-to-tpp -split-input-file | FileCheck %s
+// RUN: tpp-opt %s -map-to-brgemm -split-input-file | FileCheck %s
+
+// CHECK-LABEL: func.func @fuse_bias_brgemm_relu(
+// CHECK-SAME: %[[ARG0:.+]]: memref<4x32x32xf32>, %[[ARG1:.+]]: memref<4x32x32xf32>, %[[ARG2:.+]]: memref<32xf32>, %[[ARG3:.+]]: memref<32x32xf32>
+func.func @fuse_bias_brgemm_relu(%arg0: memref<4x32x32xf32>, %arg1: memref<4x32x32xf32>,
+                                 %arg2: memref<32xf32>, %arg3: memref<32x32xf32>) {
+  // CHECK-NOT: tpp.identity
+  // CHECK: tpp.fused_brgemm ins(%[[ARG0]] : memref<4x32x32xf32>, %[[ARG1]] : memref<4x32x32xf32>, %[[ARG2]] : memref<32xf32>) out(%[[ARG3]] : memref<32x32xf32>)
+  // CHECK-NOT: tpp.relu
+  tpp.identity ins(%arg2: memref<32xf32>) out(%arg3: memref<32x32xf32>)
+  linalg.batch_reduce_matmul ins(%arg0, %arg1: memref<4x32x32xf32>, memref<4x32x32xf32>)
+                             outs(%arg3: memref<32x32xf32>)
+  tpp.relu ins(%arg3: memref<32x32xf32>) out(%arg3: memref<32x32xf32>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @fuse_bias_brgemm_relu_tile(
+func.func @fuse_bias_brgemm_relu_tile(%arg0: memref<4x8x32x32xf32>, %arg1: memref<8x8x32x32xf32>,
+                                      %arg2: memref<1x256xf32>, %arg3: memref<4x8x32x32xf32>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  %c8 = arith.constant 8 : index
+  // CHECK: scf.for
+  // CHECK:   scf.for
+  // CHECK-NOT: tpp.identity
+  // CHECK:     tpp.fused_brgemm
+  // CHECK-NOT: tpp.relu
+  scf.for %i = %c0 to %c4 step %c1 {
+    scf.for %j = %c0 to %c8 step %c1 {
+      %off = affine.apply affine_map<(d0) -> (d0 * 32)>(%j)
+      %a = memref.subview %arg0[%i, 0, 0, 0] [1, 8, 32, 32] [1, 1, 1, 1] : memref<4x8x32x32xf32> to memref<8x32x32xf32, strided<[1024, 32, 1], offset: ?>>
+      %b = memref.subview %arg1[%j, 0, 0, 0] [1, 8, 32, 32] [1, 1, 1, 1] : memref<8x8x32x32xf32> to memref<8x32x32xf32, strided<[1024, 32, 1], offset: ?>>
+      %bias = memref.subview %arg2[0, %off] [1, 32] [1, 1] : memref<1x256xf32> to memref<1x32xf32, strided<[256, 1], offset: ?>>
+      %c = memref.subview %arg3[%i, %j, 0, 0] [1, 1, 32, 32] [1, 1, 1, 1] : memref<4x8x32x32xf32> to memref<32x32xf32, strided<[32, 1], offset: ?>>
+      tpp.identity ins(%bias: memref<1x32xf32, strided<[256, 1], offset: ?>>) out(%c: memref<32x32xf32, strided<[32, 1], offset: ?>>)
+      linalg.batch_reduce_matmul ins(%a, %b: memref<8x32x32xf32, strided<[1024, 32, 1], offset: ?>>, memref<8x32x32xf32, strided<[1024, 32, 1], offset: ?>>)
+                                 outs(%c: memref<32x32xf32, strided<[32, 1], offset: ?>>)
+      tpp.relu ins(%c: memref<32x32xf32, strided<[32, 1], offset: ?>>) out(%c: memref<32x32xf32, strided<[32, 1], offset: ?>>)
+    }
+  }
+  return
+}
+
+// -----
+
+// Without the relu there is nothing to fuse.
+// CHECK-LABEL: func.func @no_relu(
+func.func @no_relu(%arg0: memref<4x32x32xf32>, %arg1: memref<4x32x32xf32>,
+                   %arg2: memref<32xf32>, %arg3: memref<32x32xf32>) {
+  // CHECK: tpp.identity
+  // CHECK-NOT: tpp.fused_brgemm
+  tpp.identity ins(%arg2: memref<32xf32>) out(%arg3: memref<32x32xf32>)
+  linalg.batch_reduce_matmul ins(%arg0, %arg1: memref<4x32x32xf32>, memref<4x32x32xf32>)
+                             outs(%arg3: memref<32x32xf32>)
+  return
+}
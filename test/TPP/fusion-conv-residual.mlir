@@ -0,0 +1,90 @@
+// RUN: tpp-opt %s -tile-consumer-and-fuse-producers="tile-sizes=1,1,0,0" -split-input-file | FileCheck %s
+
+#map0 = affine_map<(d0, d1, d2, d3) -> (d3)>
+#map1 = affine_map<(d0, d1, d2, d3) -> (d0, d1, d2, d3)>
+
+// The bias, the conv, the residual add and the relu are computed per output
+// tile: the skip tensor is read once per tile.
+// CHECK-LABEL: func.func @conv_bias_add_relu(
+// CHECK-SAME:  %[[ARG0:.+]]: tensor<2x6x6x32xf32>, %[[ARG1:.+]]: tensor<3x3x32x64xf32>,
+// CHECK-SAME:  %[[ARG2:.+]]: tensor<64xf32>, %[[ARG3:.+]]: tensor<2x4x4x64xf32>
+// CHECK-NOT: linalg.conv_2d_nhwc_hwcf
+// CHECK: scf.for
+// CHECK:   scf.for
+// CHECK:     linalg.generic
+// CHECK:     linalg.conv_2d_nhwc_hwcf
+// CHECK:     tensor.extract_slice %[[ARG3]]
+// CHECK:     linalg.generic
+// CHECK:       arith.addf
+// CHECK:     linalg.generic
+// CHECK:       arith.maxf
+// CHECK:     scf.yield
+// CHECK-NOT: linalg.generic
+// CHECK-NOT: linalg.conv_2d_nhwc_hwcf
+func.func @conv_bias_add_relu(%i: tensor<2x6x6x32xf32>, %f: tensor<3x3x32x64xf32>,
+                              %b: tensor<64xf32>, %skip: tensor<2x4x4x64xf32>,
+                              %o: tensor<2x4x4x64xf32>) -> tensor<2x4x4x64xf32> {
+  %cst = arith.constant 0.000000e+00 : f32
+  %0 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel", "parallel", "parallel"]} ins(%b : tensor<64xf32>) outs(%o : tensor<2x4x4x64xf32>) {
+    ^bb0(%arg0: f32, %arg1: f32):
+      linalg.yield %arg0 : f32
+  } -> tensor<2x4x4x64xf32>
+  %1 = linalg.conv_2d_nhwc_hwcf {dilations = dense<1> : tensor<2xi64>,
+                                 strides = dense<1> : tensor<2xi64>}
+    ins(%i, %f : tensor<2x6x6x32xf32>, tensor<3x3x32x64xf32>)
+    outs(%0 : tensor<2x4x4x64xf32>) -> tensor<2x4x4x64xf32>
+  %2 = linalg.generic {indexing_maps = [#map1, #map1, #map1], iterator_types = ["parallel", "parallel", "parallel", "parallel"]} ins(%1, %skip : tensor<2x4x4x64xf32>, tensor<2x4x4x64xf32>) outs(%o : tensor<2x4x4x64xf32>) {
+    ^bb0(%arg0: f32, %arg1: f32, %arg2: f32):
+      %4 = arith.addf %arg0, %arg1 : f32
+      linalg.yield %4 : f32
+  } -> tensor<2x4x4x64xf32>
+  %3 = linalg.generic {indexing_maps = [#map1], iterator_types = ["parallel", "parallel", "parallel", "parallel"]} outs(%2 : tensor<2x4x4x64xf32>) {
+    ^bb0(%arg0: f32):
+      %4 = arith.maxf %arg0, %cst : f32
+      linalg.yield %4 : f32
+  } -> tensor<2x4x4x64xf32>
+  return %3 : tensor<2x4x4x64xf32>
+}
+
+// -----
+
+#map1 = affine_map<(d0, d1, d2, d3) -> (d0, d1, d2, d3)>
+
+// The skip tensor is also returned: it is computed once, outside the tile
+// loops, and read per tile.
+// CHECK-LABEL: func.func @shared_skip(
+// CHECK: linalg.generic
+// CHECK:   arith.maxf
+// CHECK: scf.for
+// CHECK:   scf.for
+// CHECK:     linalg.conv_2d_nhwc_hwcf
+// CHECK:     linalg.generic
+// CHECK:       arith.addf
+// CHECK:     linalg.generic
+// CHECK:       arith.maxf
+// CHECK:     scf.yield
+func.func @shared_skip(%i: tensor<2x6x6x32xf32>, %f: tensor<3x3x32x64xf32>,
+                       %skip: tensor<2x4x4x64xf32>, %o: tensor<2x4x4x64xf32>)
+    -> (tensor<2x4x4x64xf32>, tensor<2x4x4x64xf32>) {
+  %cst = arith.constant 0.000000e+00 : f32
+  %0 = linalg.generic {indexing_maps = [#map1, #map1], iterator_types = ["parallel", "parallel", "parallel", "parallel"]} ins(%skip : tensor<2x4x4x64xf32>) outs(%o : tensor<2x4x4x64xf32>) {
+    ^bb0(%arg0: f32, %arg1: f32):
+      %4 = arith.maxf %arg0, %cst : f32
+      linalg.yield %4 : f32
+  } -> tensor<2x4x4x64xf32>
+  %1 = linalg.conv_2d_nhwc_hwcf {dilations = dense<1> : tensor<2xi64>,
+                                 strides = dense<1> : tensor<2xi64>}
+    ins(%i, %f : tensor<2x6x6x32xf32>, tensor<3x3x32x64xf32>)
+    outs(%o : tensor<2x4x4x64xf32>) -> tensor<2x4x4x64xf32>
+  %2 = linalg.generic {indexing_maps = [#map1, #map1, #map1], iterator_types = ["parallel", "parallel", "parallel", "parallel"]} ins(%1, %0 : tensor<2x4x4x64xf32>, tensor<2x4x4x64xf32>) outs(%o : tensor<2x4x4x64xf32>) {
+    ^bb0(%arg0: f32, %arg1: f32, %arg2: f32):
+      %4 = arith.addf %arg0, %arg1 : f32
+      linalg.yield %4 : f32
+  } -> tensor<2x4x4x64xf32>
+  %3 = linalg.generic {indexing_maps = [#map1], iterator_types = ["parallel", "parallel", "parallel", "parallel"]} outs(%2 : tensor<2x4x4x64xf32>) {
+    ^bb0(%arg0: f32):
+      %4 = arith.maxf %arg0, %cst : f32
+      linalg.yield %4 : f32
+  } -> tensor<2x4x4x64xf32>
+  return %3, %0 : tensor<2x4x4x64xf32>, tensor<2x4x4x64xf32>
+}
@@ -0,0 +1,92 @@
+// RUN: tpp-opt %s -tile-consumer-and-fuse-producers="tile-sizes=32,0" | FileCheck %s -check-prefix=ROWS
+// RUN: tpp-opt %s -tile-consumer-and-fuse-producers="tile-sizes=32,32" | FileCheck %s -check-prefix=TILES
+
+#map0 = affine_map<(d0, d1) -> (d1)>
+#map1 = affine_map<(d0, d1) -> (d0, d1)>
+#map2 = affine_map<(d0, d1, d2) -> (d0, d2)>
+#map3 = affine_map<(d0, d1, d2) -> (d2, d1)>
+#map4 = affine_map<(d0, d1, d2) -> (d0, d1)>
+
+// Tiled along the rows, the second layer reads a row block of the first
+// layer's output: both layers are computed per row block.
+// ROWS-LABEL: func.func @two_layers(
+// ROWS: scf.for
+// ROWS:   linalg.generic
+// ROWS-SAME:  outs(%{{.+}} : tensor<32x512xf32>)
+// ROWS:   linalg.generic
+// ROWS-SAME:  iterator_types = ["parallel", "parallel", "reduction"]
+// ROWS-SAME:  outs(%{{.+}} : tensor<32x512xf32>)
+// ROWS:   linalg.generic
+// ROWS:     arith.maxf
+// ROWS:   linalg.generic
+// ROWS-SAME:  outs(%{{.+}} : tensor<32x64xf32>)
+// ROWS:   linalg.generic
+// ROWS-SAME:  iterator_types = ["parallel", "parallel", "reduction"]
+// ROWS-SAME:  outs(%{{.+}} : tensor<32x64xf32>)
+// ROWS:   linalg.generic
+// ROWS:     arith.maxf
+// ROWS:   scf.yield
+// ROWS-NOT: linalg.generic
+// ROWS: return
+
+// Tiled along the columns too, a row block of the first layer would be
+// recomputed for every column tile: each layer is tiled in its own loops.
+// TILES-LABEL: func.func @two_layers(
+// TILES: scf.for
+// TILES:   scf.for
+// TILES:     linalg.generic
+// TILES-SAME:  outs(%{{.+}} : tensor<32x32xf32>)
+// TILES:     linalg.generic
+// TILES-SAME:  iterator_types = ["parallel", "parallel", "reduction"]
+// TILES-SAME:  outs(%{{.+}} : tensor<32x32xf32>)
+// TILES:     linalg.generic
+// TILES:       arith.maxf
+// TILES:     scf.yield
+// TILES: scf.for
+// TILES:   scf.for
+// TILES:     tensor.extract_slice %{{.+}}[%{{.+}}, 0] [32, 512] [1, 1]
+// TILES:     linalg.generic
+// TILES-SAME:  outs(%{{.+}} : tensor<32x32xf32>)
+// TILES:     linalg.generic
+// TILES-SAME:  iterator_types = ["parallel", "parallel", "reduction"]
+// TILES-SAME:  outs(%{{.+}} : tensor<32x32xf32>)
+// TILES:     linalg.generic
+// TILES:       arith.maxf
+// TILES:     scf.yield
+func.func @two_layers(%arg0: tensor<128x256xf32>, %arg1: tensor<256x512xf32>,
+                      %arg2: tensor<512xf32>, %arg3: tensor<512x64xf32>,
+                      %arg4: tensor<64xf32>, %output0: tensor<128x512xf32>,
+                      %output1: tensor<128x64xf32>) -> tensor<128x64xf32> {
+  %cst = arith.constant 0.000000e+00 : f32
+  %0 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel"]} ins(%arg2 : tensor<512xf32>) outs(%output0 : tensor<128x512xf32>) {
+    ^bb0(%in: f32, %out: f32):
+      linalg.yield %in : f32
+  } -> tensor<128x512xf32>
+  %1 = linalg.generic {indexing_maps = [#map2, #map3, #map4], iterator_types = ["parallel", "parallel", "reduction"]} ins(%arg0, %arg1 : tensor<128x256xf32>, tensor<256x512xf32>) outs(%0 : tensor<128x512xf32>) {
+    ^bb0(%a: f32, %b: f32, %c: f32):
+      %6 = arith.mulf %a, %b : f32
+      %7 = arith.addf %c, %6 : f32
+      linalg.yield %7 : f32
+  } -> tensor<128x512xf32>
+  %2 = linalg.generic {indexing_maps = [#map1], iterator_types = ["parallel", "parallel"]} outs(%1 : tensor<128x512xf32>) {
+    ^bb0(%out: f32):
+      %6 = arith.maxf %out, %cst : f32
+      linalg.yield %6 : f32
+  } -> tensor<128x512xf32>
+  %3 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel"]} ins(%arg4 : tensor<64xf32>) outs(%output1 : tensor<128x64xf32>) {
+    ^bb0(%in: f32, %out: f32):
+      linalg.yield %in : f32
+  } -> tensor<128x64xf32>
+  %4 = linalg.generic {indexing_maps = [#map2, #map3, #map4], iterator_types = ["parallel", "parallel", "reduction"]} ins(%2, %arg3 : tensor<128x512xf32>, tensor<512x64xf32>) outs(%3 : tensor<128x64xf32>) {
+    ^bb0(%a: f32, %b: f32, %c: f32):
+      %6 = arith.mulf %a, %b : f32
+      %7 = arith.addf %c, %6 : f32
+      linalg.yield %7 : f32
+  } -> tensor<128x64xf32>
+  %5 = linalg.generic {indexing_maps = [#map1], iterator_types = ["parallel", "parallel"]} outs(%4 : tensor<128x64xf32>) {
+    ^bb0(%out: f32):
+      %6 = arith.maxf %out, %cst : f32
+      linalg.yield %6 : f32
+  } -> tensor<128x64xf32>
+  return %5 : tensor<128x64xf32>
+}
@@ -0,0 +1,124 @@
+// RUN: tpp-opt %s -tile-consumer-and-fuse-producers="tile-sizes=64,64 inner-tile-sizes=32,32" -split-input-file | FileCheck %s
+
+#map0 = affine_map<(d0, d1) -> (d1)>
+#map1 = affine_map<(d0, d1) -> (d0, d1)>
+#map2 = affine_map<(d0, d1, d2) -> (d0, d2)>
+#map3 = affine_map<(d0, d1, d2) -> (d2, d1)>
+#map4 = affine_map<(d0, d1, d2) -> (d0, d1)>
+
+// The matmul and its epilogue are computed per 32x32 tile within each 64x64
+// tile.
+// CHECK-LABEL: func.func @matmul_epilogue(
+// CHECK-DAG: %[[C32:.+]] = arith.constant 32 : index
+// CHECK-DAG: %[[C64:.+]] = arith.constant 64 : index
+// CHECK: scf.for %{{.+}} = %{{.+}} to %{{.+}} step %[[C64]]
+// CHECK:   scf.for %{{.+}} = %{{.+}} to %{{.+}} step %[[C64]]
+// CHECK:     scf.for %{{.+}} = %{{.+}} to %{{.+}} step %[[C32]]
+// CHECK:       scf.for %{{.+}} = %{{.+}} to %{{.+}} step %[[C32]]
+// CHECK:         linalg.generic
+// CHECK-SAME:      outs(%{{.+}} : tensor<32x32xf32>)
+// CHECK:         linalg.generic
+// CHECK-SAME:      iterator_types = ["parallel", "parallel", "reduction"]
+// CHECK-SAME:      outs(%{{.+}} : tensor<32x32xf32>)
+// CHECK:         linalg.generic
+// CHECK:           arith.maxf
+// CHECK:         linalg.generic
+// CHECK:           arith.addf
+// CHECK-NOT: linalg.generic
+// CHECK: return
+func.func @matmul_epilogue(%arg0: tensor<128x256xf32>, %arg1: tensor<256x512xf32>,
+                           %arg2: tensor<512xf32>, %arg3: tensor<128x512xf32>,
+                           %output: tensor<128x512xf32>) -> tensor<128x512xf32> {
+  %cst = arith.constant 0.000000e+00 : f32
+  %0 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel"]} ins(%arg2 : tensor<512xf32>) outs(%output : tensor<128x512xf32>) {
+    ^bb0(%in: f32, %out: f32):
+      linalg.yield %in : f32
+  } -> tensor<128x512xf32>
+  %1 = linalg.generic {indexing_maps = [#map2, #map3, #map4], iterator_types = ["parallel", "parallel", "reduction"]} ins(%arg0, %arg1 : tensor<128x256xf32>, tensor<256x512xf32>) outs(%0 : tensor<128x512xf32>) {
+    ^bb0(%a: f32, %b: f32, %c: f32):
+      %4 = arith.mulf %a, %b : f32
+      %5 = arith.addf %c, %4 : f32
+      linalg.yield %5 : f32
+  } -> tensor<128x512xf32>
+  %2 = linalg.generic {indexing_maps = [#map1], iterator_types = ["parallel", "parallel"]} outs(%1 : tensor<128x512xf32>) {
+    ^bb0(%out: f32):
+      %4 = arith.maxf %out, %cst : f32
+      linalg.yield %4 : f32
+  } -> tensor<128x512xf32>
+  %3 = linalg.generic {indexing_maps = [#map1, #map1, #map1], iterator_types = ["parallel", "parallel"]} ins(%2, %arg3 : tensor<128x512xf32>, tensor<128x512xf32>) outs(%output : tensor<128x512xf32>) {
+    ^bb0(%in: f32, %in_0: f32, %out: f32):
+      %4 = arith.addf %in, %in_0 : f32
+      linalg.yield %4 : f32
+  } -> tensor<128x512xf32>
+  return %3 : tensor<128x512xf32>
+}
+
+// -----
+
+#map0 = affine_map<(d0, d1) -> (d1)>
+#map1 = affine_map<(d0, d1) -> (d0, d1)>
+#map2 = affine_map<(d0, d1, d2) -> (d0, d2)>
+#map3 = affine_map<(d0, d1, d2) -> (d2, d1)>
+#map4 = affine_map<(d0, d1, d2) -> (d0, d1)>
+
+// Without an epilogue the matmul roots the tiling and its bias is fused.
+// CHECK-LABEL: func.func @matmul_bias(
+// CHECK: scf.for
+// CHECK:   scf.for
+// CHECK:     scf.for
+// CHECK:       scf.for
+// CHECK:         linalg.generic
+// CHECK-SAME:      outs(%{{.+}} : tensor<32x32xf32>)
+// CHECK:         linalg.generic
+// CHECK-SAME:      iterator_types = ["parallel", "parallel", "reduction"]
+// CHECK-SAME:      outs(%{{.+}} : tensor<32x32xf32>)
+// CHECK-NOT: linalg.generic
+// CHECK: return
+func.func @matmul_bias(%arg0: tensor<128x256xf32>, %arg1: tensor<256x512xf32>,
+                       %arg2: tensor<512xf32>,
+                       %output: tensor<128x512xf32>) -> tensor<128x512xf32> {
+  %0 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel"]} ins(%arg2 : tensor<512xf32>) outs(%output : tensor<128x512xf32>) {
+    ^bb0(%in: f32, %out: f32):
+      linalg.yield %in : f32
+  } -> tensor<128x512xf32>
+  %1 = linalg.generic {indexing_maps = [#map2, #map3, #map4], iterator_types = ["parallel", "parallel", "reduction"]} ins(%arg0, %arg1 : tensor<128x256xf32>, tensor<256x512xf32>) outs(%0 : tensor<128x512xf32>) {
+    ^bb0(%a: f32, %b: f32, %c: f32):
+      %2 = arith.mulf %a, %b : f32
+      %3 = arith.addf %c, %2 : f32
+      linalg.yield %3 : f32
+  } -> tensor<128x512xf32>
+  return %1 : tensor<128x512xf32>
+}
+
+// -----
+
+#map1 = affine_map<(d0, d1) -> (d0, d1)>
+
+// An element-wise chain is fused without a contraction.
+// CHECK-LABEL: func.func @add_relu(
+// CHECK: scf.for
+// CHECK:   scf.for
+// CHECK:     scf.for
+// CHECK:       scf.for
+// CHECK:         linalg.generic
+// CHECK-SAME:      outs(%{{.+}} : tensor<32x32xf32>)
+// CHECK:           arith.addf
+// CHECK:         linalg.generic
+// CHECK:           arith.maxf
+// CHECK-NOT: linalg.generic
+// CHECK: return
+func.func @add_relu(%arg0: tensor<128x512xf32>, %arg1: tensor<128x512xf32>,
+                    %output: tensor<128x512xf32>) -> tensor<128x512xf32> {
+  %cst = arith.constant 0.000000e+00 : f32
+  %0 = linalg.generic {indexing_maps = [#map1, #map1, #map1], iterator_types = ["parallel", "parallel"]} ins(%arg0, %arg1 : tensor<128x512xf32>, tensor<128x512xf32>) outs(%output : tensor<128x512xf32>) {
+    ^bb0(%in: f32, %in_0: f32, %out: f32):
+      %2 = arith.addf %in, %in_0 : f32
+      linalg.yield %2 : f32
+  } -> tensor<128x512xf32>
+  %1 = linalg.generic {indexing_maps = [#map1], iterator_types = ["parallel", "parallel"]} outs(%0 : tensor<128x512xf32>) {
+    ^bb0(%out: f32):
+      %2 = arith.maxf %out, %cst : f32
+      linalg.yield %2 : f32
+  } -> tensor<128x512xf32>
+  return %1 : tensor<128x512xf32>
+}
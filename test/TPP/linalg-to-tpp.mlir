@@ -75,3 +75,197 @@ func.func @relu(%arg3: memref<64x32x32xf32>) -> memref<64x32x32xf32> {
   }
   return %arg3 : memref<64x32x32xf32>
 }
+
+// -----
+
+#mapImg = affine_map<(d0, d1, d2, d3, d4, d5) -> (d0, d1, d3 + d2, d5)>
+#mapFil = affine_map<(d0, d1, d2, d3, d4, d5) -> (d0, d1, d2, d5, d4)>
+#mapOut = affine_map<(d0, d1, d2, d3, d4, d5) -> (d3, d4)>
+
+// The blocks read by the filter taps are at offsets linear in (C', R, S).
+// CHECK-LABEL: func.func @offset_brgemm(
+// CHECK-SAME: %[[arg0:.*]]: memref<2x3x6x2xf32>,
+// CHECK-SAME: %[[arg1:.*]]: memref<2x3x3x2x2xf32>,
+// CHECK-SAME: %[[arg2:.*]]: memref<4x2xf32>)
+func.func @offset_brgemm(%arg0: memref<2x3x6x2xf32>, %arg1: memref<2x3x3x2x2xf32>,
+                         %arg2: memref<4x2xf32>) {
+  // CHECK: tpp.offset_brgemm ins(%[[arg0]] : memref<2x3x6x2xf32>, %[[arg1]] : memref<2x3x3x2x2xf32>) out(%[[arg2]] : memref<4x2xf32>)
+  // CHECK-SAME: offsetsA = [0, 2, 4, 12, 14, 16, 24, 26, 28, 36, 38, 40, 48, 50, 52, 60, 62, 64]
+  // CHECK-SAME: offsetsB = [0, 4, 8, 12, 16, 20, 24, 28, 32, 36, 40, 44, 48, 52, 56, 60, 64, 68]
+  linalg.generic {
+    indexing_maps = [#mapImg, #mapFil, #mapOut],
+    iterator_types = ["reduction", "reduction", "reduction", "parallel", "parallel", "reduction"],
+    library_call = "tpp.offset_brgemm"}
+    ins(%arg0, %arg1 : memref<2x3x6x2xf32>, memref<2x3x3x2x2xf32>)
+    outs(%arg2 : memref<4x2xf32>) {
+      ^bb0(%a: f32, %b: f32, %c: f32):
+        %0 = arith.mulf %a, %b : f32
+        %1 = arith.addf %c, %0 : f32
+        linalg.yield %1 : f32
+  }
+  return
+}
+
+// -----
+
+#mapQc = affine_map<(d0, d1) -> (d0, d1)>
+#mapc = affine_map<(d0, d1) -> (d1)>
+
+// The taps of a channel block are broadcast along the row of pixels.
+// CHECK-LABEL: func.func @muladd(
+// CHECK-SAME: %[[arg0:.*]]: memref<4x32xf32>,
+// CHECK-SAME: %[[arg1:.*]]: memref<32xf32>,
+// CHECK-SAME: %[[arg2:.*]]: memref<4x32xf32>)
+func.func @muladd(%arg0: memref<4x32xf32>, %arg1: memref<32xf32>,
+                  %arg2: memref<4x32xf32>) {
+  // CHECK: tpp.muladd ins(%[[arg0]] : memref<4x32xf32>, %[[arg1]] : memref<32xf32>) out(%[[arg2]] : memref<4x32xf32>)
+  linalg.generic {
+    indexing_maps = [#mapQc, #mapc, #mapQc],
+    iterator_types = ["parallel", "parallel"],
+    library_call = "tpp.muladd"}
+    ins(%arg0, %arg1 : memref<4x32xf32>, memref<32xf32>)
+    outs(%arg2 : memref<4x32xf32>) {
+      ^bb0(%a: f32, %b: f32, %c: f32):
+        %0 = arith.mulf %a, %b : f32
+        %1 = arith.addf %c, %0 : f32
+        linalg.yield %1 : f32
+  }
+  return
+}
+
+// -----
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+#mapc = affine_map<(d0, d1) -> (d1)>
+
+// A fused body maps to a chain of tpp operations with the intermediate values
+// in scratch buffers.
+// CHECK-LABEL: func.func @chain(
+// CHECK-SAME: %[[arg0:.*]]: memref<32x32xf32>, %[[arg1:.*]]: memref<32x32xf32>,
+// CHECK-SAME: %[[arg2:.*]]: memref<32xf32>, %[[arg3:.*]]: memref<32x32xf32>)
+func.func @chain(%arg0: memref<32x32xf32>, %arg1: memref<32x32xf32>,
+                 %arg2: memref<32xf32>, %arg3: memref<32x32xf32>) {
+  // CHECK: memref.alloca_scope {
+  // CHECK: %[[bias:.*]] = memref.alloca() : memref<32x32xf32>
+  // CHECK: tpp.identity ins(%[[arg2]] : memref<32xf32>) out(%[[bias]] : memref<32x32xf32>)
+  // CHECK: %[[t0:.*]] = memref.alloca() : memref<32x32xf32>
+  // CHECK: tpp.identity ins(%[[arg1]] : memref<32x32xf32>) out(%[[t0]] : memref<32x32xf32>)
+  // CHECK: tpp.add ins(%[[arg0]] : memref<32x32xf32>) out(%[[t0]] : memref<32x32xf32>)
+  // CHECK: %[[t1:.*]] = memref.alloca() : memref<32x32xf32>
+  // CHECK: tpp.relu ins(%[[t0]] : memref<32x32xf32>) out(%[[t1]] : memref<32x32xf32>)
+  // CHECK: tpp.identity ins(%{{.*}} : f32) out(%[[arg3]] : memref<32x32xf32>)
+  // CHECK: tpp.muladd ins(%[[t1]] : memref<32x32xf32>, %[[bias]] : memref<32x32xf32>) out(%[[arg3]] : memref<32x32xf32>)
+  // CHECK-NOT: linalg.generic
+  linalg.generic {
+    indexing_maps = [#map, #map, #mapc, #map],
+    iterator_types = ["parallel", "parallel"],
+    library_call = "tpp.chain"}
+    ins(%arg0, %arg1, %arg2 : memref<32x32xf32>, memref<32x32xf32>, memref<32xf32>)
+    outs(%arg3 : memref<32x32xf32>) {
+      ^bb0(%a: f32, %b: f32, %c: f32, %o: f32):
+        %0 = arith.addf %a, %b : f32
+        %1 = mathx.relu %0 : f32
+        %2 = arith.mulf %1, %c : f32
+        linalg.yield %2 : f32
+  }
+  return
+}
+
+// -----
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+
+// The chain is tiled to 32x32 blocks and a multiply feeding an add becomes a
+// muladd on the addend.
+// CHECK-LABEL: func.func @chain_fma(
+// CHECK-SAME: %[[arg0:.*]]: memref<64x32xf32>, %[[arg1:.*]]: memref<64x32xf32>,
+// CHECK-SAME: %[[arg2:.*]]: memref<64x32xf32>, %[[arg3:.*]]: memref<64x32xf32>)
+func.func @chain_fma(%arg0: memref<64x32xf32>, %arg1: memref<64x32xf32>,
+                     %arg2: memref<64x32xf32>, %arg3: memref<64x32xf32>) {
+  // CHECK: scf.for
+  // CHECK: memref.alloca_scope {
+  // CHECK-NOT: memref.alloca()
+  // CHECK: tpp.identity ins(%{{.*}} : memref<32x32xf32, {{.*}}>) out(%[[out:.*]] : memref<32x32xf32, {{.*}}>)
+  // CHECK-NEXT: tpp.muladd ins(%{{.*}} : memref<32x32xf32, {{.*}}>, %{{.*}} : memref<32x32xf32, {{.*}}>) out(%[[out]] : memref<32x32xf32, {{.*}}>)
+  linalg.generic {
+    indexing_maps = [#map, #map, #map, #map],
+    iterator_types = ["parallel", "parallel"],
+    library_call = "tpp.chain"}
+    ins(%arg0, %arg1, %arg2 : memref<64x32xf32>, memref<64x32xf32>, memref<64x32xf32>)
+    outs(%arg3 : memref<64x32xf32>) {
+      ^bb0(%a: f32, %b: f32, %c: f32, %o: f32):
+        %0 = arith.mulf %a, %b : f32
+        %1 = arith.addf %0, %c : f32
+        linalg.yield %1 : f32
+  }
+  return
+}
+
+// -----
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+
+// The input overlaps the output in the same buffer: the add writes a scratch
+// buffer copied to the output once the input has been read.
+// CHECK-LABEL: func.func @chain_aliasing_input(
+// CHECK-SAME: %[[arg0:.*]]: memref<64x32xf32>, %[[arg1:.*]]: memref<32x32xf32>)
+func.func @chain_aliasing_input(%arg0: memref<64x32xf32>, %arg1: memref<32x32xf32>) {
+  // CHECK: %[[mm:.*]] = memref.subview %[[arg0]][16, 0] [32, 32] [1, 1]
+  // CHECK: %[[out:.*]] = memref.subview %[[arg0]][0, 0] [32, 32] [1, 1]
+  // CHECK: memref.alloca_scope {
+  // CHECK: %[[t0:.*]] = memref.alloca() : memref<32x32xf32>
+  // CHECK: tpp.relu ins(%[[arg1]] : memref<32x32xf32>) out(%[[t0]] : memref<32x32xf32>)
+  // CHECK: %[[t1:.*]] = memref.alloca() : memref<32x32xf32>
+  // CHECK: tpp.identity ins(%[[t0]] : memref<32x32xf32>) out(%[[t1]] : memref<32x32xf32>)
+  // CHECK: tpp.add ins(%[[mm]] : memref<32x32xf32, {{.*}}>) out(%[[t1]] : memref<32x32xf32>)
+  // CHECK: tpp.identity ins(%[[t1]] : memref<32x32xf32>) out(%[[out]] : memref<32x32xf32, {{.*}}>)
+  // CHECK-NOT: linalg.generic
+  %mm = memref.subview %arg0[16, 0] [32, 32] [1, 1] : memref<64x32xf32> to memref<32x32xf32, strided<[32, 1], offset: 512>>
+  %out = memref.subview %arg0[0, 0] [32, 32] [1, 1] : memref<64x32xf32> to memref<32x32xf32, strided<[32, 1]>>
+  linalg.generic {
+    indexing_maps = [#map, #map, #map],
+    iterator_types = ["parallel", "parallel"],
+    library_call = "tpp.chain"}
+    ins(%mm, %arg1 : memref<32x32xf32, strided<[32, 1], offset: 512>>, memref<32x32xf32>)
+    outs(%out : memref<32x32xf32, strided<[32, 1]>>) {
+      ^bb0(%a: f32, %s: f32, %o: f32):
+        %0 = mathx.relu %s : f32
+        %1 = arith.addf %a, %0 : f32
+        linalg.yield %1 : f32
+  }
+  return
+}
+
+// -----
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+
+// The chain is tiled by 32x32 blocks and the partial tiles are peeled, so the
+// scratch buffers stay small and static.
+// CHECK-LABEL: func.func @chain_remainder(
+func.func @chain_remainder(%arg0: memref<40x48xf32>, %arg1: memref<40x48xf32>,
+                           %arg2: memref<40x48xf32>) {
+  // CHECK: scf.for
+  // CHECK:   scf.for
+  // CHECK:     memref.alloca() : memref<32x32xf32>
+  // CHECK:   scf.for
+  // CHECK:     memref.alloca() : memref<32x16xf32>
+  // CHECK: scf.for
+  // CHECK:   scf.for
+  // CHECK:     memref.alloca() : memref<8x32xf32>
+  // CHECK:   scf.for
+  // CHECK:     memref.alloca() : memref<8x16xf32>
+  // CHECK-NOT: linalg.generic
+  linalg.generic {
+    indexing_maps = [#map, #map, #map],
+    iterator_types = ["parallel", "parallel"],
+    library_call = "tpp.chain"}
+    ins(%arg0, %arg1 : memref<40x48xf32>, memref<40x48xf32>)
+    outs(%arg2 : memref<40x48xf32>) {
+      ^bb0(%a: f32, %b: f32, %o: f32):
+        %0 = arith.addf %a, %b : f32
+        %1 = mathx.relu %0 : f32
+        linalg.yield %1 : f32
+  }
+  return
+}
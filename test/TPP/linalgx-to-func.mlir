@@ -0,0 +1,59 @@
+// RUN: tpp-opt %s -split-input-file -convert-linalgx-to-func | FileCheck %s
+
+// CHECK: func.func private @xsmm_pack_NC_to_NCnc_f32(memref<*xf32>, memref<*xf32>) attributes {llvm.emit_c_interface}
+// CHECK-LABEL: func.func @NC_to_NCnc(
+// CHECK-SAME:  %[[ARG0:.+]]: memref<128x256xf32>, %[[ARG1:.+]]: memref<4x8x32x32xf32>
+func.func @NC_to_NCnc(%arg0: memref<128x256xf32>, %arg1: memref<4x8x32x32xf32>) {
+  // CHECK: %[[IN:.+]] = memref.cast %[[ARG0]] : memref<128x256xf32> to memref<*xf32>
+  // CHECK: %[[OUT:.+]] = memref.cast %[[ARG1]] : memref<4x8x32x32xf32> to memref<*xf32>
+  // CHECK: call @xsmm_pack_NC_to_NCnc_f32(%[[IN]], %[[OUT]])
+  // CHECK-NOT: linalgx.pack
+  linalgx.pack %arg0 inner_dims_pos = [0, 1] inner_tiles = [32, 32] into %arg1 : (memref<128x256xf32> memref<4x8x32x32xf32>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @KC_to_CKkc(
+func.func @KC_to_CKkc(%arg0: memref<256x512xbf16>, %arg1: memref<128x64x4x4xbf16>) {
+  // CHECK: call @xsmm_pack_KC_to_CKkc_bf16(
+  linalgx.pack %arg0 outer_dims_perm = [1, 0] inner_dims_pos = [0, 1] inner_tiles = [4, 4] into %arg1 : (memref<256x512xbf16> memref<128x64x4x4xbf16>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @NCnc_to_NC(
+func.func @NCnc_to_NC(%arg0: memref<4x8x32x32xf32>, %arg1: memref<128x256xf32>) {
+  // CHECK: call @xsmm_unpack_NCnc_to_NC_f32(
+  linalgx.unpack %arg0 inner_dims_pos = [0, 1] inner_tiles = [32, 32] into %arg1 : (memref<4x8x32x32xf32> memref<128x256xf32>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @vnni(
+func.func @vnni(%arg0: memref<128x256xbf16>, %arg1: memref<64x256x2xbf16>,
+                %arg2: memref<4x8x32x32xbf16>, %arg3: memref<4x8x16x32x2xbf16>) {
+  // CHECK: call @xsmm_pack_vnni_bf16(
+  linalgx.pack %arg0 inner_dims_pos = [0] inner_tiles = [2] into %arg1 : (memref<128x256xbf16> memref<64x256x2xbf16>)
+  // CHECK: call @xsmm_pack_vnni_bf16(
+  linalgx.pack %arg2 inner_dims_pos = [2] inner_tiles = [2] into %arg3 : (memref<4x8x32x32xbf16> memref<4x8x16x32x2xbf16>)
+  return
+}
+
+// -----
+
+// The runtime does not handle padding or batch dimensions that do not
+// collapse into a single strided batch: leave them to linalg-ext-to-loops.
+// CHECK-LABEL: func.func @not_supported(
+func.func @not_supported(%arg0: memref<13x15xf32>, %arg1: memref<2x8x8x2xf32>, %arg2: f32,
+                         %arg3: memref<64x4x4xbf16, strided<[32, 4, 1], offset: ?>>,
+                         %arg4: memref<64x2x4x2xbf16>) {
+  // CHECK-NOT: call
+  // CHECK: linalgx.pack
+  linalgx.pack %arg0 padding_value(%arg2 : f32) inner_dims_pos = [0, 1] inner_tiles = [8, 2] into %arg1 : (memref<13x15xf32> memref<2x8x8x2xf32>)
+  // CHECK: linalgx.pack
+  linalgx.pack %arg3 inner_dims_pos = [1] inner_tiles = [2] into %arg4 : (memref<64x4x4xbf16, strided<[32, 4, 1], offset: ?>> memref<64x2x4x2xbf16>)
+  return
+}
@@ -0,0 +1,31 @@
+// RUN: tpp-opt -split-input-file -verify-diagnostics -pack-matmul="use-cost-model" -canonicalize %s | FileCheck %s
+
+// CHECK-LABEL: func.func @matmul(
+// CHECK-SAME:  %[[ARG0:.+]]: tensor<128x512xf32>, %[[ARG1:.+]]: tensor<512x256xf32>, %[[ARG2:.+]]: tensor<128x256xf32>
+// CHECK: linalgx.pack %[[ARG0]] inner_dims_pos = [0, 1] inner_tiles = [64, 32] into %{{.+}} : (tensor<128x512xf32> tensor<2x16x64x32xf32>)
+// CHECK: linalgx.pack %[[ARG1]] outer_dims_perm = [1, 0] inner_dims_pos = [0, 1] inner_tiles = [32, 64] into %{{.+}} : (tensor<512x256xf32> tensor<4x16x32x64xf32>)
+// CHECK: linalgx.pack %[[ARG2]] inner_dims_pos = [0, 1] inner_tiles = [64, 64] into %{{.+}} : (tensor<128x256xf32> tensor<2x4x64x64xf32>)
+// CHECK: linalg.generic
+// CHECK-SAME: ins(%{{.+}}, %{{.+}} : tensor<2x16x64x32xf32>, tensor<4x16x32x64xf32>) outs(%{{.+}} : tensor<2x4x64x64xf32>)
+// CHECK: linalgx.unpack %{{.+}} inner_dims_pos = [0, 1] inner_tiles = [64, 64] into %[[ARG2]]
+func.func @matmul(%arg0: tensor<128x512xf32>,
+                  %arg1: tensor<512x256xf32>,
+                  %arg2: tensor<128x256xf32>) -> tensor<128x256xf32> {
+  // expected-remark @below {{cost model blocking factors: [64, 64, 32]}}
+  %0 = linalg.matmul ins(%arg0, %arg1: tensor<128x512xf32>, tensor<512x256xf32>) outs(%arg2: tensor<128x256xf32>) -> tensor<128x256xf32>
+  return %0 : tensor<128x256xf32>
+}
+
+// -----
+
+// Tall and skinny: one SIMD vector along N, small K blocks.
+// CHECK-LABEL: func.func @tall_skinny(
+// CHECK: linalg.generic
+// CHECK-SAME: ins(%{{.+}}, %{{.+}} : tensor<16x8x256x8xf32>, tensor<1x8x8x16xf32>) outs(%{{.+}} : tensor<16x1x256x16xf32>)
+func.func @tall_skinny(%arg0: tensor<4096x64xf32>,
+                       %arg1: tensor<64x16xf32>,
+                       %arg2: tensor<4096x16xf32>) -> tensor<4096x16xf32> {
+  // expected-remark @below {{cost model blocking factors: [256, 16, 8]}}
+  %0 = linalg.matmul ins(%arg0, %arg1: tensor<4096x64xf32>, tensor<64x16xf32>) outs(%arg2: tensor<4096x16xf32>) -> tensor<4096x16xf32>
+  return %0 : tensor<4096x16xf32>
+}
@@ -24,3 +24,44 @@ func.func @matmul(%arg0: tensor<128x512xf32>,
 // CHECK: %[[OUT:.+]] = linalgx.unpack %[[VAL]] inner_dims_pos = [0, 1] inner_tiles = [32, 32] into %[[ARG2]] : (tensor<4x8x32x32xf32> tensor<128x256xf32>) -> tensor<128x256xf32>
 // CHECK: return %[[OUT]] : tensor<128x256xf32>
 // CHECK: }
+
+// -----
+
+// Partial blocks are padded with zeros.
+func.func @matmul_partial_blocks(%arg0: tensor<100x512xf32>,
+                                 %arg1: tensor<512x250xf32>,
+                                 %arg2: tensor<100x250xf32>) -> tensor<100x250xf32> {
+  %0 = linalg.matmul ins(%arg0, %arg1: tensor<100x512xf32>, tensor<512x250xf32>) outs(%arg2: tensor<100x250xf32>) -> tensor<100x250xf32>
+  return %0 : tensor<100x250xf32>
+}
+
+// CHECK: func.func @matmul_partial_blocks(
+// CHECK-SAME:  %[[ARG0:.+]]: tensor<100x512xf32>,
+// CHECK-SAME:  %[[ARG1:.+]]: tensor<512x250xf32>,
+// CHECK-SAME:  %[[ARG2:.+]]: tensor<100x250xf32>) -> tensor<100x250xf32> {
+// CHECK-DAG: %[[PAD:.+]] = arith.constant 0.000000e+00 : f32
+// CHECK: %[[PACK0:.+]] = linalgx.pack %[[ARG0]] padding_value(%[[PAD]] : f32) inner_dims_pos = [0, 1] inner_tiles = [32, 32] into %{{.+}} : (tensor<100x512xf32> tensor<4x16x32x32xf32>) -> tensor<4x16x32x32xf32>
+// CHECK: %[[PACK1:.+]] = linalgx.pack %[[ARG1]] padding_value(%[[PAD]] : f32) outer_dims_perm = [1, 0] inner_dims_pos = [0, 1] inner_tiles = [32, 32] into %{{.+}} : (tensor<512x250xf32> tensor<8x16x32x32xf32>) -> tensor<8x16x32x32xf32>
+// CHECK: %[[PACK2:.+]] = linalgx.pack %[[ARG2]] padding_value(%[[PAD]] : f32) inner_dims_pos = [0, 1] inner_tiles = [32, 32] into %{{.+}} : (tensor<100x250xf32> tensor<4x8x32x32xf32>) -> tensor<4x8x32x32xf32>
+// CHECK: %[[VAL:.+]] = linalg.generic {{.*}} ins(%[[PACK0]], %[[PACK1]] : tensor<4x16x32x32xf32>, tensor<8x16x32x32xf32>) outs(%[[PACK2]] : tensor<4x8x32x32xf32>)
+// CHECK: %[[OUT:.+]] = linalgx.unpack %[[VAL]] inner_dims_pos = [0, 1] inner_tiles = [32, 32] into %[[ARG2]] : (tensor<4x8x32x32xf32> tensor<100x250xf32>) -> tensor<100x250xf32>
+// CHECK: return %[[OUT]] : tensor<100x250xf32>
+
+// -----
+
+// Constant weights are packed at compile time.
+func.func @matmul_constant_weights(%arg0: tensor<128x512xf32>,
+                                   %arg2: tensor<128x256xf32>) -> tensor<128x256xf32> {
+  %cst = arith.constant dense<1.0> : tensor<512x256xf32>
+  %0 = linalg.matmul ins(%arg0, %cst: tensor<128x512xf32>, tensor<512x256xf32>) outs(%arg2: tensor<128x256xf32>) -> tensor<128x256xf32>
+  return %0 : tensor<128x256xf32>
+}
+
+// CHECK: func.func @matmul_constant_weights(
+// CHECK-SAME:  %[[ARG0:.+]]: tensor<128x512xf32>,
+// CHECK-SAME:  %[[ARG2:.+]]: tensor<128x256xf32>) -> tensor<128x256xf32> {
+// CHECK-DAG: %[[CST:.+]] = arith.constant dense<1.000000e+00> : tensor<8x16x32x32xf32>
+// CHECK: %[[PACK0:.+]] = linalgx.pack %[[ARG0]]
+// CHECK-NOT: linalgx.pack %{{.+}} : (tensor<512x256xf32>
+// CHECK: %[[PACK2:.+]] = linalgx.pack %[[ARG2]]
+// CHECK: %{{.+}} = linalg.generic {{.*}} ins(%[[PACK0]], %[[CST]] : tensor<4x16x32x32xf32>, tensor<8x16x32x32xf32>) outs(%[[PACK2]] : tensor<4x8x32x32xf32>)
@@ -0,0 +1,48 @@
+// RUN: echo '{"version": 1, "entries": [{"pass": "pack-matmul", "op": "linalg.matmul", "shape": [128, 512, 256], "type": "f32", "params": [32, 64, 32], "seconds": 0.0}, {"pass": "pack-matmul", "op": "linalg.matmul", "shape": [128, 64, 512], "type": "f32", "params": [64, 32, 32], "seconds": 0.0}]}' > %t.json
+// RUN: echo '{"version": 1, "entries": [{"pass": "pack-matmul", "op": "linalg.matmul", "shape": [128, 512, 256], "type": "f32", "params": [32, 32, 32], "seconds": 0.0}]}' > %t.first.json
+// RUN: tpp-opt %s -pack-matmul="tuning-db=%t.json" -canonicalize | FileCheck %s -check-prefix=TUNED
+// RUN: tpp-opt %s -pack-matmul="block-factors=32,32,32" -canonicalize | FileCheck %s
+// RUN: tpp-opt %s -pack-matmul="block-factors=64,32,64 tuning-db=%t.first.json" -canonicalize | FileCheck %s
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+
+// Both layers have their blocking factors in the database: they are kept,
+// together with the relayout of the activations.
+// TUNED-LABEL: func.func @mlp(
+// TUNED: linalg.generic
+// TUNED-SAME:  ins(%{{.+}}, %{{.+}} : tensor<4x8x32x32xf32>, tensor<8x8x32x64xf32>) outs(%{{.+}} : tensor<4x8x32x64xf32>)
+// TUNED: linalgx.unpack
+// TUNED: linalgx.pack %{{.+}} inner_dims_pos = [0, 1] inner_tiles = [64, 32] into %{{.+}} : (tensor<128x512xf32> tensor<2x16x64x32xf32>)
+// TUNED: linalg.generic
+// TUNED-SAME:  ins(%{{.+}}, %{{.+}} : tensor<2x16x64x32xf32>, tensor<2x16x32x32xf32>) outs(%{{.+}} : tensor<2x2x64x32xf32>)
+
+// The activations stay blocked between the layers: the blocking factors of
+// the two layers are the same, or the ones of the second layer are replaced by
+// the ones of the first layer from the database.
+// CHECK-LABEL: func.func @mlp(
+// CHECK-SAME:  %[[ARG0:.+]]: tensor<128x256xf32>
+// CHECK: %[[PACK0:.+]] = linalgx.pack %[[ARG0]] inner_dims_pos = [0, 1] inner_tiles = [32, 32]
+// CHECK: %[[L1:.+]] = linalg.generic
+// CHECK-SAME:  ins(%[[PACK0]], %{{.+}} : tensor<4x8x32x32xf32>, tensor<16x8x32x32xf32>) outs(%{{.+}} : tensor<4x16x32x32xf32>)
+// CHECK-NOT: linalgx.unpack
+// CHECK: %[[RELU:.+]] = linalg.generic
+// CHECK-SAME:  ins(%[[L1]] : tensor<4x16x32x32xf32>)
+// CHECK-NOT: linalgx.unpack
+// CHECK: %[[L2:.+]] = linalg.generic
+// CHECK-SAME:  ins(%[[RELU]], %{{.+}} : tensor<4x16x32x32xf32>, tensor<2x16x32x32xf32>) outs(%{{.+}} : tensor<4x2x32x32xf32>)
+// CHECK: %[[OUT:.+]] = linalgx.unpack %[[L2]]
+// CHECK: return %[[OUT]] : tensor<128x64xf32>
+func.func @mlp(%arg0: tensor<128x256xf32>, %arg1: tensor<256x512xf32>,
+               %arg2: tensor<128x512xf32>, %arg3: tensor<512x64xf32>,
+               %arg4: tensor<128x64xf32>) -> tensor<128x64xf32> {
+  %cst = arith.constant 0.000000e+00 : f32
+  %0 = linalg.matmul ins(%arg0, %arg1: tensor<128x256xf32>, tensor<256x512xf32>) outs(%arg2: tensor<128x512xf32>) -> tensor<128x512xf32>
+  %1 = tensor.empty() : tensor<128x512xf32>
+  %2 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]} ins(%0 : tensor<128x512xf32>) outs(%1 : tensor<128x512xf32>) {
+    ^bb0(%in: f32, %out: f32):
+      %3 = arith.maxf %in, %cst : f32
+      linalg.yield %3 : f32
+  } -> tensor<128x512xf32>
+  %4 = linalg.matmul ins(%2, %arg3: tensor<128x512xf32>, tensor<512x64xf32>) outs(%arg4: tensor<128x64xf32>) -> tensor<128x64xf32>
+  return %4 : tensor<128x64xf32>
+}
@@ -62,3 +62,61 @@ func.func @packTensorEmpty() -> tensor<1x2x58x58x32xf32> {
 // CHECK: func.func @packTensorEmpty() -> tensor<1x2x58x58x32xf32> {
 // CHECK: %[[ALLOC:.+]] = tensor.empty() : tensor<1x2x58x58x32xf32>
 // CHECK: return %[[ALLOC]] : tensor<1x2x58x58x32xf32>
+
+// -----
+
+func.func @packConstant() -> tensor<2x2x2x2xi32> {
+  %cst = arith.constant dense<[[0, 1, 2, 3], [4, 5, 6, 7], [8, 9, 10, 11], [12, 13, 14, 15]]> : tensor<4x4xi32>
+  %alloc = tensor.empty() : tensor<2x2x2x2xi32>
+  %0 = linalgx.pack %cst inner_dims_pos = [0, 1] inner_tiles = [2, 2] into %alloc : (tensor<4x4xi32> tensor<2x2x2x2xi32>) -> tensor<2x2x2x2xi32>
+  return %0 : tensor<2x2x2x2xi32>
+}
+
+// CHECK: func.func @packConstant() -> tensor<2x2x2x2xi32> {
+// CHECK: %[[CST:.+]] = arith.constant dense<{{\[}}{{\[}}{{\[}}[0, 1], [4, 5]], {{\[}}[2, 3], [6, 7]]], {{\[}}{{\[}}[8, 9], [12, 13]], {{\[}}[10, 11], [14, 15]]]]> : tensor<2x2x2x2xi32>
+// CHECK-NOT: linalgx.pack
+// CHECK: return %[[CST]] : tensor<2x2x2x2xi32>
+
+// -----
+
+func.func @packConstantWithPadding() -> tensor<2x2x2x2xi32> {
+  %pad = arith.constant 0 : i32
+  %cst = arith.constant dense<[[1, 2, 3], [4, 5, 6], [7, 8, 9]]> : tensor<3x3xi32>
+  %alloc = tensor.empty() : tensor<2x2x2x2xi32>
+  %0 = linalgx.pack %cst padding_value(%pad : i32) inner_dims_pos = [0, 1] inner_tiles = [2, 2] into %alloc : (tensor<3x3xi32> tensor<2x2x2x2xi32>) -> tensor<2x2x2x2xi32>
+  return %0 : tensor<2x2x2x2xi32>
+}
+
+// CHECK: func.func @packConstantWithPadding() -> tensor<2x2x2x2xi32> {
+// CHECK: %[[CST:.+]] = arith.constant dense<{{\[}}{{\[}}{{\[}}[1, 2], [4, 5]], {{\[}}[3, 0], [6, 0]]], {{\[}}{{\[}}[7, 8], [0, 0]], {{\[}}[9, 0], [0, 0]]]]> : tensor<2x2x2x2xi32>
+// CHECK-NOT: linalgx.pack
+// CHECK: return %[[CST]] : tensor<2x2x2x2xi32>
+
+// -----
+
+// bf16 VNNI: [K][N] -> [K / 2][N][2].
+func.func @packConstantVNNI() -> tensor<2x2x2xbf16> {
+  %cst = arith.constant dense<[[1.0, 2.0], [3.0, 4.0], [5.0, 6.0], [7.0, 8.0]]> : tensor<4x2xbf16>
+  %alloc = tensor.empty() : tensor<2x2x2xbf16>
+  %0 = linalgx.pack %cst inner_dims_pos = [0] inner_tiles = [2] into %alloc : (tensor<4x2xbf16> tensor<2x2x2xbf16>) -> tensor<2x2x2xbf16>
+  return %0 : tensor<2x2x2xbf16>
+}
+
+// CHECK: func.func @packConstantVNNI() -> tensor<2x2x2xbf16> {
+// CHECK: %[[CST:.+]] = arith.constant dense<{{\[}}{{\[}}[1.000000e+00, 3.000000e+00], [2.000000e+00, 4.000000e+00]], {{\[}}[5.000000e+00, 7.000000e+00], [6.000000e+00, 8.000000e+00]]]> : tensor<2x2x2xbf16>
+// CHECK-NOT: linalgx.pack
+// CHECK: return %[[CST]] : tensor<2x2x2xbf16>
+
+// -----
+
+func.func @unpackConstant() -> tensor<4x4xi32> {
+  %cst = arith.constant dense<[[[[0, 1], [4, 5]], [[2, 3], [6, 7]]], [[[8, 9], [12, 13]], [[10, 11], [14, 15]]]]> : tensor<2x2x2x2xi32>
+  %alloc = tensor.empty() : tensor<4x4xi32>
+  %0 = linalgx.unpack %cst outer_dims_perm = [1, 0] inner_dims_pos = [0, 1] inner_tiles = [2, 2] into %alloc : (tensor<2x2x2x2xi32> tensor<4x4xi32>) -> tensor<4x4xi32>
+  return %0 : tensor<4x4xi32>
+}
+
+// CHECK: func.func @unpackConstant() -> tensor<4x4xi32> {
+// CHECK: %[[CST:.+]] = arith.constant dense<{{\[}}[0, 1, 8, 9], [4, 5, 12, 13], [2, 3, 10, 11], [6, 7, 14, 15]]> : tensor<4x4xi32>
+// CHECK-NOT: linalgx.unpack
+// CHECK: return %[[CST]] : tensor<4x4xi32>
@@ -0,0 +1,162 @@
+// RUN: tpp-opt %s -map-linalg-to-tpp -pad-simd-dim-for-matmul="m-multiple=4 n-multiple=16 k-multiple=8" -split-input-file | FileCheck %s
+
+#map0 = affine_map<(d0, d1, d2) -> (d0, d2)>
+#map1 = affine_map<(d0, d1, d2) -> (d2, d1)>
+#map2 = affine_map<(d0, d1, d2) -> (d0, d1)>
+
+// CHECK-LABEL: func.func @pad_all_dims(
+// CHECK-SAME:  %[[ARG0:.+]]: tensor<3x5xf32>, %[[ARG1:.+]]: tensor<5x3xf32>,
+// CHECK-SAME:  %[[ARG2:.+]]: tensor<3x3xf32>)
+func.func @pad_all_dims(%A: tensor<3x5xf32>, %B: tensor<5x3xf32>,
+                        %C: tensor<3x3xf32>) -> tensor<3x3xf32> {
+  // CHECK: %[[PA:.+]] = tensor.pad %[[ARG0]] low[0, 0] high[1, 3]
+  // CHECK: tensor<3x5xf32> to tensor<4x8xf32>
+  // CHECK: %[[PB:.+]] = tensor.pad %[[ARG1]] low[0, 0] high[3, 13]
+  // CHECK: tensor<5x3xf32> to tensor<8x16xf32>
+  // CHECK: %[[PC:.+]] = tensor.pad %[[ARG2]] low[0, 0] high[1, 13]
+  // CHECK: tensor<3x3xf32> to tensor<4x16xf32>
+  // CHECK: %[[MUL:.+]] = linalg.generic
+  // CHECK-SAME: library_call = "tpp.matmul"
+  // CHECK-SAME: ins(%[[PA]], %[[PB]] : tensor<4x8xf32>, tensor<8x16xf32>)
+  // CHECK-SAME: outs(%[[PC]] : tensor<4x16xf32>)
+  // CHECK: %{{.+}} = tensor.extract_slice %[[MUL]][0, 0] [3, 3] [1, 1]
+  %D = linalg.generic {indexing_maps = [#map0, #map1, #map2],
+                       iterator_types = ["parallel", "parallel", "reduction"]}
+    ins(%A, %B: tensor<3x5xf32>, tensor<5x3xf32>) outs(%C: tensor<3x3xf32>) {
+      ^bb0(%a: f32, %b: f32, %c: f32):
+        %0 = arith.mulf %a, %b : f32
+        %1 = arith.addf %c, %0 : f32
+        linalg.yield %1 : f32
+  } -> tensor<3x3xf32>
+  return %D : tensor<3x3xf32>
+}
+
+// -----
+
+#map0 = affine_map<(d0, d1, d2) -> (d0, d2)>
+#map1 = affine_map<(d0, d1, d2) -> (d2, d1)>
+#map2 = affine_map<(d0, d1, d2) -> (d0, d1)>
+
+// CHECK-LABEL: func.func @fold_constant_weight(
+// CHECK-SAME:  %[[ARG0:.+]]: tensor<4x8xf32>, %[[ARG1:.+]]: tensor<4x3xf32>)
+func.func @fold_constant_weight(%A: tensor<4x8xf32>,
+                                %C: tensor<4x3xf32>) -> tensor<4x3xf32> {
+  // CHECK: %[[CST:.+]] = arith.constant dense<{{.+}}> : tensor<8x16xf32>
+  // CHECK: %[[PC:.+]] = tensor.pad %[[ARG1]]
+  // CHECK: linalg.generic
+  // CHECK-SAME: ins(%[[ARG0]], %[[CST]] : tensor<4x8xf32>, tensor<8x16xf32>)
+  // CHECK-SAME: outs(%[[PC]] : tensor<4x16xf32>)
+  %B = arith.constant dense<1.0> : tensor<8x3xf32>
+  %D = linalg.generic {indexing_maps = [#map0, #map1, #map2],
+                       iterator_types = ["parallel", "parallel", "reduction"]}
+    ins(%A, %B: tensor<4x8xf32>, tensor<8x3xf32>) outs(%C: tensor<4x3xf32>) {
+      ^bb0(%a: f32, %b: f32, %c: f32):
+        %0 = arith.mulf %a, %b : f32
+        %1 = arith.addf %c, %0 : f32
+        linalg.yield %1 : f32
+  } -> tensor<4x3xf32>
+  return %D : tensor<4x3xf32>
+}
+
+// -----
+
+#map0 = affine_map<(d0, d1, d2) -> (d0, d2)>
+#map1 = affine_map<(d0, d1, d2) -> (d2, d1)>
+#map2 = affine_map<(d0, d1, d2) -> (d0, d1)>
+
+// CHECK-LABEL: func.func @hoist_weight_padding(
+// CHECK-SAME:  %[[ARG0:.+]]: tensor<4x8xf32>, %[[ARG1:.+]]: tensor<8x3xf32>
+func.func @hoist_weight_padding(%A: tensor<4x8xf32>,
+                                %B: tensor<8x3xf32> {stdx.const},
+                                %C: tensor<4x3xf32>) -> tensor<4x3xf32> {
+  // CHECK: %[[PB:.+]] = tensor.pad %[[ARG1]]
+  // CHECK: tensor<8x3xf32> to tensor<8x16xf32>
+  // CHECK: stdx.closure
+  // CHECK: linalg.generic
+  // CHECK-SAME: ins(%{{.+}}, %[[PB]] : tensor<4x8xf32>, tensor<8x16xf32>)
+  %0 = stdx.closure init_args(%init0 = %A) -> (tensor<4x8xf32>)
+                    init_outs(%init1 = %C) -> (tensor<4x3xf32>) {
+    %1 = linalg.generic {indexing_maps = [#map0, #map1, #map2],
+                         iterator_types = ["parallel", "parallel", "reduction"]}
+      ins(%init0, %B: tensor<4x8xf32>, tensor<8x3xf32>)
+      outs(%init1: tensor<4x3xf32>) {
+        ^bb0(%a: f32, %b: f32, %c: f32):
+          %2 = arith.mulf %a, %b : f32
+          %3 = arith.addf %c, %2 : f32
+          linalg.yield %3 : f32
+    } -> tensor<4x3xf32>
+    stdx.yield %1 : tensor<4x3xf32>
+  }
+  return %0 : tensor<4x3xf32>
+}
+
+// -----
+
+#map0 = affine_map<(d0, d1, d2) -> (d0, d2)>
+#map1 = affine_map<(d0, d1, d2) -> (d2, d1)>
+#map2 = affine_map<(d0, d1, d2) -> (d0, d1)>
+
+// CHECK-LABEL: func.func @pad_mixed_precision(
+// CHECK-SAME:  %[[ARG0:.+]]: tensor<3x5xbf16>, %[[ARG1:.+]]: tensor<5x3xbf16>,
+// CHECK-SAME:  %[[ARG2:.+]]: tensor<3x3xf32>)
+func.func @pad_mixed_precision(%A: tensor<3x5xbf16>, %B: tensor<5x3xbf16>,
+                               %C: tensor<3x3xf32>) -> tensor<3x3xf32> {
+  // CHECK-DAG: %[[ZEROBF16:.+]] = arith.constant 0.000000e+00 : bf16
+  // CHECK-DAG: %[[ZEROF32:.+]] = arith.constant 0.000000e+00 : f32
+  // CHECK: %[[PA:.+]] = tensor.pad %[[ARG0]] low[0, 0] high[1, 3]
+  // CHECK: tensor.yield %[[ZEROBF16]] : bf16
+  // CHECK: tensor<3x5xbf16> to tensor<4x8xbf16>
+  // CHECK: %[[PB:.+]] = tensor.pad %[[ARG1]] low[0, 0] high[3, 13]
+  // CHECK: tensor.yield %[[ZEROBF16]] : bf16
+  // CHECK: tensor<5x3xbf16> to tensor<8x16xbf16>
+  // CHECK: %[[PC:.+]] = tensor.pad %[[ARG2]] low[0, 0] high[1, 13]
+  // CHECK: tensor.yield %[[ZEROF32]] : f32
+  // CHECK: tensor<3x3xf32> to tensor<4x16xf32>
+  // CHECK: %[[MUL:.+]] = linalg.generic
+  // CHECK-SAME: library_call = "tpp.matmul"
+  // CHECK-SAME: ins(%[[PA]], %[[PB]] : tensor<4x8xbf16>, tensor<8x16xbf16>)
+  // CHECK-SAME: outs(%[[PC]] : tensor<4x16xf32>)
+  // CHECK: %{{.+}} = tensor.extract_slice %[[MUL]][0, 0] [3, 3] [1, 1]
+  %D = linalg.generic {indexing_maps = [#map0, #map1, #map2],
+                       iterator_types = ["parallel", "parallel", "reduction"],
+                       library_call = "tpp.matmul"}
+    ins(%A, %B: tensor<3x5xbf16>, tensor<5x3xbf16>) outs(%C: tensor<3x3xf32>) {
+      ^bb0(%a: bf16, %b: bf16, %c: f32):
+        %0 = arith.extf %a : bf16 to f32
+        %1 = arith.extf %b : bf16 to f32
+        %2 = arith.mulf %0, %1 : f32
+        %3 = arith.addf %c, %2 : f32
+        linalg.yield %3 : f32
+  } -> tensor<3x3xf32>
+  return %D : tensor<3x3xf32>
+}
+
+// -----
+
+#map0 = affine_map<(d0, d1, d2) -> (d0, d2)>
+#map1 = affine_map<(d0, d1, d2) -> (d2, d1)>
+#map2 = affine_map<(d0, d1, d2) -> (d0, d1)>
+
+// CHECK-LABEL: func.func @fold_constant_weight_rows(
+// CHECK-SAME:  %[[ARG0:.+]]: tensor<4x8xf32>, %[[ARG1:.+]]: tensor<4x3xf32>)
+func.func @fold_constant_weight_rows(%A: tensor<4x8xf32>,
+                                     %C: tensor<4x3xf32>) -> tensor<4x3xf32> {
+  // CHECK: %[[CST:.+]] = arith.constant dense<{{\[}}[1.000000e+00, 2.000000e+00, 3.000000e+00, 0.000000e+00
+  // CHECK-SAME: [4.000000e+00, 5.000000e+00, 6.000000e+00, 0.000000e+00
+  // CHECK-SAME: : tensor<8x16xf32>
+  // CHECK: linalg.generic
+  // CHECK-SAME: ins(%[[ARG0]], %[[CST]] : tensor<4x8xf32>, tensor<8x16xf32>)
+  %B = arith.constant dense<[[1.0, 2.0, 3.0], [4.0, 5.0, 6.0],
+                             [1.0, 2.0, 3.0], [4.0, 5.0, 6.0],
+                             [1.0, 2.0, 3.0], [4.0, 5.0, 6.0],
+                             [1.0, 2.0, 3.0], [4.0, 5.0, 6.0]]> : tensor<8x3xf32>
+  %D = linalg.generic {indexing_maps = [#map0, #map1, #map2],
+                       iterator_types = ["parallel", "parallel", "reduction"]}
+    ins(%A, %B: tensor<4x8xf32>, tensor<8x3xf32>) outs(%C: tensor<4x3xf32>) {
+      ^bb0(%a: f32, %b: f32, %c: f32):
+        %0 = arith.mulf %a, %b : f32
+        %1 = arith.addf %c, %0 : f32
+        linalg.yield %1 : f32
+  } -> tensor<4x3xf32>
+  return %D : tensor<4x3xf32>
+}
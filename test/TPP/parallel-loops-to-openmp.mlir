@@ -0,0 +1,71 @@
+// RUN: tpp-opt %s -split-input-file -map-to-brgemm="use-parallel-loops" -convert-parallel-loops-to-openmp | FileCheck %s
+// RUN: tpp-opt %s -split-input-file -map-to-brgemm="use-parallel-loops" -convert-parallel-loops-to-openmp="parallel-dims=1 num-threads=4" | FileCheck %s -check-prefix=ONED
+// RUN: tpp-opt %s -split-input-file -map-to-brgemm="use-parallel-loops" | FileCheck %s -check-prefix=BRGEMM
+
+#map3 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d0, d2, d3, d5)>
+#map4 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d1, d2, d5, d4)>
+#map5 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d0, d1, d3, d4)>
+
+// BRGEMM-LABEL: func.func @blocked_matmul(
+// BRGEMM-SAME: %[[ARG0:.+]]: memref<4x16x32x32xf32>, %[[ARG1:.+]]: memref<8x16x32x32xf32>, %[[ARG2:.+]]: memref<4x8x32x32xf32>
+// BRGEMM-DAG: %[[C0:.+]] = arith.constant 0 : index
+// BRGEMM-DAG: %[[C1:.+]] = arith.constant 1 : index
+// BRGEMM-DAG: %[[C4:.+]] = arith.constant 4 : index
+// BRGEMM-DAG: %[[C8:.+]] = arith.constant 8 : index
+// BRGEMM: scf.parallel (%[[P1:.+]], %[[P2:.+]]) = (%[[C0]], %[[C0]]) to (%[[C4]], %[[C8]]) step (%[[C1]], %[[C1]]) {
+// BRGEMM: %[[A:.+]] = memref.subview %[[ARG0]][%[[P1]], 0, 0, 0] [1, 16, 32, 32] [1, 1, 1, 1]
+// BRGEMM: %[[B:.+]] = memref.subview %[[ARG1]][%[[P2]], 0, 0, 0] [1, 16, 32, 32] [1, 1, 1, 1]
+// BRGEMM: %[[C:.+]] = memref.subview %[[ARG2]][%[[P1]], %[[P2]], 0, 0] [1, 1, 32, 32] [1, 1, 1, 1]
+// BRGEMM: linalg.batch_reduce_matmul ins(%[[A]], %[[B]] : {{.+}}) outs(%[[C]] : {{.+}})
+// BRGEMM-NOT: scf.for
+
+// The two block dimensions are distributed across threads by default.
+// CHECK-LABEL: func.func @blocked_matmul(
+// CHECK: omp.parallel {
+// CHECK: omp.wsloop for (%{{.+}}, %{{.+}}) : index
+// CHECK: linalg.batch_reduce_matmul
+// CHECK: omp.yield
+// CHECK: omp.terminator
+// CHECK-NOT: scf.parallel
+
+// With parallel-dims=1 only [NB] is distributed, each thread runs over [KB].
+// ONED-LABEL: func.func @blocked_matmul(
+// ONED: %[[THREADS:.+]] = arith.constant 4 : i32
+// ONED: omp.parallel num_threads(%[[THREADS]] : i32) {
+// ONED: omp.wsloop for (%{{.+}}) : index
+// ONED: scf.for
+// ONED: linalg.batch_reduce_matmul
+// ONED-NOT: scf.parallel
+func.func @blocked_matmul(%arg0: memref<4x16x32x32xf32>, %arg1: memref<8x16x32x32xf32>, %arg2: memref<4x8x32x32xf32>) {
+  linalg.generic {indexing_maps = [#map3, #map4, #map5], iterator_types = ["parallel", "parallel", "reduction", "parallel", "parallel", "reduction"]} ins(%arg0, %arg1 : memref<4x16x32x32xf32>, memref<8x16x32x32xf32>) outs(%arg2 : memref<4x8x32x32xf32>) {
+    ^bb0(%arg3: f32, %arg4: f32, %arg5: f32):
+      %8 = arith.mulf %arg3, %arg4 : f32
+      %9 = arith.addf %arg5, %8 : f32
+      linalg.yield %9 : f32
+  }
+  return
+}
+
+// -----
+
+// A nested parallel loop runs sequentially within each thread.
+// CHECK-LABEL: func.func @nested(
+// CHECK: omp.parallel {
+// CHECK: omp.wsloop for (%[[I:.+]], %[[J:.+]]) : index
+// CHECK: scf.for %[[K:.+]] =
+// CHECK: scf.for %[[L:.+]] =
+// CHECK: memref.store %{{.+}}, %{{.+}}[%[[I]], %[[J]], %[[K]], %[[L]]]
+// CHECK-NOT: omp.parallel
+func.func @nested(%arg0: memref<2x4x8x8xf32>, %arg1: f32) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c2 = arith.constant 2 : index
+  %c4 = arith.constant 4 : index
+  %c8 = arith.constant 8 : index
+  scf.parallel (%i, %j) = (%c0, %c0) to (%c2, %c4) step (%c1, %c1) {
+    scf.parallel (%k, %l) = (%c0, %c0) to (%c8, %c8) step (%c1, %c1) {
+      memref.store %arg1, %arg0[%i, %j, %k, %l] : memref<2x4x8x8xf32>
+    }
+  }
+  return
+}
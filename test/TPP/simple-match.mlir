@@ -118,3 +118,58 @@ func.func @add(%arga: tensor<32xf32>, %argb: tensor<32xf32>) -> tensor<32xf32> {
   return %1: tensor<32xf32>
 }
 
+
+// -----
+
+#map0 = affine_map<(d0, d1) -> (d0, d1)>
+
+// CHECK-LABEL: func.func @add_relu_mul
+func.func @add_relu_mul(%arga: tensor<32x32xf32>, %argb: tensor<32x32xf32>,
+                        %argc: tensor<32x32xf32>, %argd: tensor<32x32xf32>) -> tensor<32x32xf32> {
+  // CHECK: library_call = "tpp.chain"
+  %1 = linalg.generic {indexing_maps = [#map0, #map0, #map0, #map0], iterator_types = ["parallel", "parallel"]} ins(%arga, %argb, %argc: tensor<32x32xf32>, tensor<32x32xf32>, tensor<32x32xf32>) outs(%argd: tensor<32x32xf32>) {
+    ^bb0(%a: f32, %b: f32, %c: f32, %d: f32):
+      %0 = arith.addf %a, %b : f32
+      %2 = mathx.relu %0 : f32
+      %3 = arith.mulf %2, %c : f32
+      linalg.yield %3 : f32
+  } -> tensor<32x32xf32>
+  return %1: tensor<32x32xf32>
+}
+
+// -----
+
+#map0 = affine_map<(d0, d1) -> (d0, d1)>
+
+// A body with an operation without tpp counterpart does not map.
+// CHECK-LABEL: func.func @add_sub
+func.func @add_sub(%arga: tensor<32x32xf32>, %argb: tensor<32x32xf32>,
+                   %argc: tensor<32x32xf32>) -> tensor<32x32xf32> {
+  // CHECK-NOT: library_call
+  %1 = linalg.generic {indexing_maps = [#map0, #map0, #map0], iterator_types = ["parallel", "parallel"]} ins(%arga, %argb: tensor<32x32xf32>, tensor<32x32xf32>) outs(%argc: tensor<32x32xf32>) {
+    ^bb0(%a: f32, %b: f32, %c: f32):
+      %0 = arith.addf %a, %b : f32
+      %2 = arith.subf %0, %c : f32
+      linalg.yield %2 : f32
+  } -> tensor<32x32xf32>
+  return %1: tensor<32x32xf32>
+}
+
+// -----
+
+#map0 = affine_map<(d0, d1) -> (d0, d1)>
+#map1 = affine_map<(d0, d1) -> (d0)>
+
+// A reduction with a chain body does not map.
+// CHECK-LABEL: func.func @add_reduction
+func.func @add_reduction(%arga: tensor<32x32xf32>, %argb: tensor<32x32xf32>,
+                         %argc: tensor<32xf32>) -> tensor<32xf32> {
+  // CHECK-NOT: library_call
+  %1 = linalg.generic {indexing_maps = [#map0, #map0, #map1], iterator_types = ["parallel", "reduction"]} ins(%arga, %argb: tensor<32x32xf32>, tensor<32x32xf32>) outs(%argc: tensor<32xf32>) {
+    ^bb0(%a: f32, %b: f32, %c: f32):
+      %0 = arith.mulf %a, %b : f32
+      %2 = arith.addf %0, %c : f32
+      linalg.yield %2 : f32
+  } -> tensor<32xf32>
+  return %1: tensor<32xf32>
+}
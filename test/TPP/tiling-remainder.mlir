@@ -0,0 +1,81 @@
+// RUN: tpp-opt %s -split-input-file -map-linalg-to-tpp -convert-linalg-to-tpp="tile-sizes=32,0" | FileCheck %s
+// RUN: tpp-opt %s -split-input-file -map-linalg-to-tpp -convert-linalg-to-tpp="tile-sizes=32,0,32" | FileCheck %s -check-prefix=MATMUL
+// RUN: tpp-opt %s -split-input-file -pack-matmul="block-factors=32,32,32" -map-to-brgemm | FileCheck %s -check-prefix=BRGEMM
+
+#map0 = affine_map<(d0, d1) -> (d0, d1)>
+
+// The last, partial, tile is peeled into its own loop and tpp operation.
+// CHECK-LABEL: func.func @relu_remainder(
+func.func @relu_remainder(%arg0: memref<70x64xf32>) {
+  // CHECK-DAG: %[[c0:.+]] = arith.constant 0 : index
+  // CHECK-DAG: %[[c32:.+]] = arith.constant 32 : index
+  // CHECK-DAG: %[[c64:.+]] = arith.constant 64 : index
+  // CHECK-DAG: %[[c70:.+]] = arith.constant 70 : index
+  // CHECK: scf.for %[[i:.+]] = %[[c0]] to %[[c64]] step %[[c32]] {
+  // CHECK:   %[[full:.+]] = memref.subview %arg0[%[[i]], 0] [32, 64] [1, 1]
+  // CHECK:   tpp.relu ins(%[[full]] : memref<32x64xf32, {{.+}}>) out(%[[full]] : memref<32x64xf32, {{.+}}>)
+  // CHECK: }
+  // CHECK: scf.for %[[j:.+]] = %[[c64]] to %[[c70]] step %[[c32]] {
+  // CHECK:   %[[partial:.+]] = memref.subview %arg0[%[[j]], 0] [6, 64] [1, 1]
+  // CHECK:   tpp.relu ins(%[[partial]] : memref<6x64xf32, {{.+}}>) out(%[[partial]] : memref<6x64xf32, {{.+}}>)
+  // CHECK: }
+  // CHECK-NOT: linalg.generic
+  linalg.generic {indexing_maps = [#map0], iterator_types = ["parallel", "parallel"]}
+    outs(%arg0: memref<70x64xf32>) {
+      ^bb0(%a: f32):
+        %0 = mathx.relu %a : f32
+        linalg.yield %0: f32
+  }
+  return
+}
+
+// -----
+
+#map0 = affine_map<(d0, d1, d2) -> (d0, d2)>
+#map1 = affine_map<(d0, d1, d2) -> (d2, d1)>
+#map2 = affine_map<(d0, d1, d2) -> (d0, d1)>
+
+// M and K are both peeled. The inner loop is peeled first, so the remainder
+// rows also get a full and a partial K tile with static shapes.
+// MATMUL-LABEL: func.func @matmul_remainder(
+func.func @matmul_remainder(%arg0: memref<70x48xf32>, %arg1: memref<48x40xf32>, %arg2: memref<70x40xf32>) {
+  // MATMUL-DAG: %[[c0:.+]] = arith.constant 0 : index
+  // MATMUL-DAG: %[[c32:.+]] = arith.constant 32 : index
+  // MATMUL-DAG: %[[c64:.+]] = arith.constant 64 : index
+  // MATMUL-DAG: %[[c70:.+]] = arith.constant 70 : index
+  // MATMUL: scf.for %{{.+}} = %[[c0]] to %[[c64]] step %[[c32]] {
+  // MATMUL:   tpp.matmul ins(%{{.+}} : memref<32x32xf32, {{.+}}>, %{{.+}} : memref<32x40xf32, {{.+}}>) out(%{{.+}} : memref<32x40xf32, {{.+}}>)
+  // MATMUL:   tpp.matmul ins(%{{.+}} : memref<32x16xf32, {{.+}}>, %{{.+}} : memref<16x40xf32, {{.+}}>) out(%{{.+}} : memref<32x40xf32, {{.+}}>)
+  // MATMUL: }
+  // MATMUL: scf.for %{{.+}} = %[[c64]] to %[[c70]] step %[[c32]] {
+  // MATMUL:   tpp.matmul ins(%{{.+}} : memref<6x32xf32, {{.+}}>, %{{.+}} : memref<32x40xf32, {{.+}}>) out(%{{.+}} : memref<6x40xf32, {{.+}}>)
+  // MATMUL:   tpp.matmul ins(%{{.+}} : memref<6x16xf32, {{.+}}>, %{{.+}} : memref<16x40xf32, {{.+}}>) out(%{{.+}} : memref<6x40xf32, {{.+}}>)
+  // MATMUL: }
+  // MATMUL-NOT: linalg.generic
+  linalg.generic {indexing_maps = [#map0, #map1, #map2], iterator_types = ["parallel", "parallel", "reduction"]}
+    ins(%arg0, %arg1: memref<70x48xf32>, memref<48x40xf32>) outs(%arg2: memref<70x40xf32>) {
+      ^bb0(%a: f32, %b: f32, %c: f32):
+        %0 = arith.mulf %a, %b : f32
+        %1 = arith.addf %c, %0 : f32
+        linalg.yield %1 : f32
+  }
+  return
+}
+
+// -----
+
+// With blocks that do not divide M, N and K, the packs pad the partial blocks
+// with zeros: the brgemm only sees full, static, blocks.
+// BRGEMM-LABEL: func.func @brgemm_remainder(
+func.func @brgemm_remainder(%arg0: tensor<70x48xf32>, %arg1: tensor<48x40xf32>, %arg2: tensor<70x40xf32>) -> tensor<70x40xf32> {
+  // BRGEMM-DAG: %[[PAD:.+]] = arith.constant 0.000000e+00 : f32
+  // BRGEMM: %[[A:.+]] = linalgx.pack %{{.+}} padding_value(%[[PAD]] : f32) inner_dims_pos = [0, 1] inner_tiles = [32, 32] into %{{.+}} : (tensor<70x48xf32> tensor<3x2x32x32xf32>)
+  // BRGEMM: %[[B:.+]] = linalgx.pack %{{.+}} padding_value(%[[PAD]] : f32) outer_dims_perm = [1, 0] inner_dims_pos = [0, 1] inner_tiles = [32, 32] into %{{.+}} : (tensor<48x40xf32> tensor<2x2x32x32xf32>)
+  // BRGEMM: %[[C:.+]] = linalgx.pack %{{.+}} padding_value(%[[PAD]] : f32) inner_dims_pos = [0, 1] inner_tiles = [32, 32] into %{{.+}} : (tensor<70x40xf32> tensor<3x2x32x32xf32>)
+  // BRGEMM: scf.for
+  // BRGEMM:   scf.for
+  // BRGEMM:     linalg.batch_reduce_matmul ins(%{{.+}}, %{{.+}} : tensor<2x32x32xf32>, tensor<2x32x32xf32>) outs(%{{.+}} : tensor<32x32xf32>) -> tensor<32x32xf32>
+  // BRGEMM: linalgx.unpack %{{.+}} inner_dims_pos = [0, 1] inner_tiles = [32, 32] into %{{.+}} : (tensor<3x2x32x32xf32> tensor<70x40xf32>)
+  %0 = linalg.matmul ins(%arg0, %arg1: tensor<70x48xf32>, tensor<48x40xf32>) outs(%arg2: tensor<70x40xf32>) -> tensor<70x40xf32>
+  return %0 : tensor<70x40xf32>
+}
@@ -3,7 +3,7 @@
 func.func @tpp_add_invalid(%arg0: memref<1x2xf32>, 
                            %arg1: memref<2x2xf32>) -> memref<2x1xf32> {
 
-  // expected-error @below {{'tpp.add' op requires all operands to have the same type}}
+  // expected-error @below {{'tpp.add' op requires all operands to have the same shape and element type}}
   tpp.add ins(%arg0: memref<1x2xf32>) out(%arg1: memref<2x2xf32>)
   return %arg1: memref<2x2xf32>
 }
@@ -21,7 +21,7 @@ func.func @tpp_add_invalid(%arg0: f32, %arg1: f32) {
 
 func.func @tpp_relu_invalid(%arg0: memref<1x2xf32>, %arg1: memref<2x1xf32>) -> memref<2x1xf32> {
 
-  // expected-error @below {{'tpp.relu' op requires all operands to have the same type}}
+  // expected-error @below {{'tpp.relu' op requires all operands to have the same shape and element type}}
   tpp.relu ins(%arg0: memref<1x2xf32>) out(%arg1: memref<2x1xf32>)
   return %arg1: memref<2x1xf32>
 }
@@ -83,10 +83,10 @@ func.func @tpp_matmul_invalid(%arg0: memref<3x5x1xbf16>, %arg1: memref<5x6xbf16>
 // -----
 
 // Mixed types
-func.func @tpp_matmul_invalid(%arg0: memref<3x5x1xbf16>, %arg1: memref<5x6xbf16>,
+func.func @tpp_matmul_invalid(%arg0: memref<3x5x1xbf16>, %arg1: memref<5x6xf32>,
                               %arg2: memref<6x6xf32>) -> memref<6x6xf32> {
   // expected-error @below {{'tpp.matmul' op requires the same element type for all operands}}
-  tpp.matmul ins(%arg0: memref<3x5x1xbf16>, %arg1: memref<5x6xbf16>) out(%arg2: memref<6x6xf32>)
+  tpp.matmul ins(%arg0: memref<3x5x1xbf16>, %arg1: memref<5x6xf32>) out(%arg2: memref<6x6xf32>)
   return %arg2: memref<6x6xf32>
 }
 
@@ -99,3 +99,66 @@ func.func @tpp_matmul_invalid(%arg0: memref<3x2xf32>, %arg1: memref<2x3xf32>,
   tpp.matmul ins(%arg0: memref<3x2xf32>, %arg1: memref<2x3xf32>) out(%arg2: memref<3x3xbf16>)
   return %arg2: memref<3x3xbf16>
 }
+
+// -----
+
+func.func @tpp_fused_brgemm_invalid(%arg0: memref<2x5x4xf32>, %arg1: memref<2x4x5xf32>,
+                                    %arg2: memref<5x5xf32>,
+                                    %arg3: memref<5x5xf32>) -> memref<5x5xf32> {
+  // expected-error @below {{'tpp.fused_brgemm' op expects bias to be broadcastable along the rows}}
+  tpp.fused_brgemm ins(%arg0: memref<2x5x4xf32>, %arg1: memref<2x4x5xf32>, %arg2: memref<5x5xf32>)
+                   out(%arg3: memref<5x5xf32>)
+  return %arg3: memref<5x5xf32>
+}
+
+// -----
+
+// Mixed types
+func.func @tpp_brgemm_invalid(%arg0: memref<2x5x4xf32>, %arg1: memref<2x4x5xf32>,
+                              %arg2: memref<5x5xbf16>) -> memref<5x5xbf16> {
+  // expected-error @below {{'tpp.brgemm' op requires the same element type for all operands}}
+  tpp.brgemm ins(%arg0: memref<2x5x4xf32>, %arg1: memref<2x4x5xf32>) out(%arg2: memref<5x5xbf16>)
+  return %arg2: memref<5x5xbf16>
+}
+
+// -----
+
+func.func @tpp_offset_brgemm_invalid(%arg0: memref<2x6x2xf32>, %arg1: memref<2x2x2xf32>,
+                                     %arg2: memref<4x2xf32>) -> memref<4x2xf32> {
+  // expected-error @below {{'tpp.offset_brgemm' op expects blocks within the bounds of the operands}}
+  tpp.offset_brgemm ins(%arg0: memref<2x6x2xf32>, %arg1: memref<2x2x2xf32>)
+                    out(%arg2: memref<4x2xf32>)
+                    offsetsA = [0, 16] offsetsB = [0, 4]
+  return %arg2: memref<4x2xf32>
+}
+
+// -----
+
+func.func @tpp_offset_brgemm_invalid(%arg0: memref<2x6x2xf32>, %arg1: memref<2x2x2xf32>,
+                                     %arg2: memref<4x2xf32>) -> memref<4x2xf32> {
+  // expected-error @below {{'tpp.offset_brgemm' op expects the same non-zero number of offsets}}
+  tpp.offset_brgemm ins(%arg0: memref<2x6x2xf32>, %arg1: memref<2x2x2xf32>)
+                    out(%arg2: memref<4x2xf32>)
+                    offsetsA = [0, 12] offsetsB = [0]
+  return %arg2: memref<4x2xf32>
+}
+
+// -----
+
+func.func @tpp_muladd_invalid(%arg0: memref<5x6xf32>, %arg1: memref<5xf32>,
+                              %arg2: memref<5x6xf32>) {
+  // expected-error @below {{'tpp.muladd' op expects rhs to be broadcastable along the rows}}
+  tpp.muladd ins(%arg0: memref<5x6xf32>, %arg1: memref<5xf32>)
+             out(%arg2: memref<5x6xf32>)
+  return
+}
+
+// -----
+
+func.func @tpp_muladd_invalid(%arg0: memref<5x6xf32>, %arg1: memref<6xbf16>,
+                              %arg2: memref<5x6xf32>) {
+  // expected-error @below {{'tpp.muladd' op expects all operands to have the same element type}}
+  tpp.muladd ins(%arg0: memref<5x6xf32>, %arg1: memref<6xbf16>)
+             out(%arg2: memref<5x6xf32>)
+  return
+}
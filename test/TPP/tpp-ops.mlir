@@ -23,6 +23,10 @@ func.func @myfunc(%arg0: memref<2x2xf32>,
   tpp.matmul ins(%arg0: memref<2x2xf32>, %arg1: memref<2x2xf32>)
              out(%arg2: memref<2x2xf32>) 
 
+  // CHECK: tpp.muladd
+  tpp.muladd ins(%arg0: memref<2x2xf32>, %arg1: memref<2x2xf32>)
+             out(%arg2: memref<2x2xf32>)
+
   return %arg2: memref<2x2xf32>
 }
 
@@ -49,6 +53,17 @@ func.func @testBrgemm(%arg0: memref<2x5x4xf32>, %arg1: memref<2x4x5xf32>,
   return %arg2: memref<5x5xf32>
 }
 
+// CHECK-LABEL: func.func @testFusedBrgemm
+func.func @testFusedBrgemm(%arg0: memref<2x5x4xf32>, %arg1: memref<2x4x5xf32>,
+                           %arg2: memref<5xf32>,
+                           %arg3: memref<5x5xf32>) -> memref<5x5xf32> {
+  // CHECK: tpp.fused_brgemm
+  tpp.fused_brgemm ins(%arg0: memref<2x5x4xf32>, %arg1: memref<2x4x5xf32>,
+                       %arg2: memref<5xf32>)
+                   out(%arg3: memref<5x5xf32>)
+  return %arg3: memref<5x5xf32>
+}
+
 // CHECK-LABEL: func.func @testGemmWithBf16
 func.func @testGemmWithBf16(%arg0: memref<3x5x2xbf16>, %arg1: memref<5x6xbf16>, 
                             %arg2: memref<6x6xbf16>) -> memref<6x6xbf16> {
@@ -64,3 +79,38 @@ func.func @testBrgemmWithBf16(%arg0: memref<32x4x4x2xbf16>, %arg1: memref<64x4x4
   tpp.brgemm ins(%arg0: memref<32x4x4x2xbf16>, %arg1: memref<64x4x4xbf16>) out(%arg2: memref<4x4xbf16>)
   return %arg2: memref<4x4xbf16>
 }
+
+// CHECK-LABEL: func.func @testGemmWithBf16AndF32Output
+func.func @testGemmWithBf16AndF32Output(%arg0: memref<3x5x2xbf16>, %arg1: memref<5x6xbf16>,
+                                        %arg2: memref<6x6xf32>) -> memref<6x6xf32> {
+  // CHECK: tpp.matmul
+  tpp.matmul ins(%arg0: memref<3x5x2xbf16>, %arg1: memref<5x6xbf16>) out(%arg2: memref<6x6xf32>)
+  return %arg2: memref<6x6xf32>
+}
+
+// CHECK-LABEL: func.func @testBrgemmWithBf16AndF32Output
+func.func @testBrgemmWithBf16AndF32Output(%arg0: memref<32x4x4x2xbf16>, %arg1: memref<64x4x4xbf16>,
+                                          %arg2: memref<4x4xf32>) -> memref<4x4xf32> {
+  // CHECK: tpp.brgemm
+  tpp.brgemm ins(%arg0: memref<32x4x4x2xbf16>, %arg1: memref<64x4x4xbf16>) out(%arg2: memref<4x4xf32>)
+  return %arg2: memref<4x4xf32>
+}
+
+// CHECK-LABEL: func.func @testOffsetBrgemm
+func.func @testOffsetBrgemm(%arg0: memref<2x3x6x2xf32>, %arg1: memref<2x3x3x2x2xf32>,
+                            %arg2: memref<4x2xf32>) -> memref<4x2xf32> {
+  // CHECK: tpp.offset_brgemm
+  tpp.offset_brgemm ins(%arg0: memref<2x3x6x2xf32>, %arg1: memref<2x3x3x2x2xf32>)
+                    out(%arg2: memref<4x2xf32>)
+                    offsetsA = [0, 2, 4, 12, 14, 16] offsetsB = [0, 4, 8, 12, 16, 20]
+  return %arg2: memref<4x2xf32>
+}
+
+// CHECK-LABEL: func.func @muladdBcastRow
+func.func @muladdBcastRow(%arg0: memref<5x6xf32>, %arg1: memref<6xf32>,
+                          %arg2: memref<5x6xf32>) {
+  // CHECK: tpp.muladd
+  tpp.muladd ins(%arg0: memref<5x6xf32>, %arg1: memref<6xf32>)
+             out(%arg2: memref<5x6xf32>)
+  return
+}
@@ -0,0 +1,67 @@
+// RUN: tpp-opt %s -convert-tpp-to-loops="parallel unroll-factor=2" -split-input-file | FileCheck %s
+
+// CHECK-LABEL: func.func @relu_to_loops(
+func.func @relu_to_loops(%arg0: memref<3x5xf32>, %arg1: memref<3x5xf32>) {
+  // CHECK-DAG: %[[three:.*]] = arith.constant 3 : index
+  // CHECK-DAG: %[[five:.*]] = arith.constant 5 : index
+  // CHECK-DAG: %[[zero:.*]] = arith.constant 0 : index
+  // CHECK-DAG: %[[one:.*]] = arith.constant 1 : index
+  // CHECK: scf.parallel (%[[i:.*]]) = (%[[zero]]) to (%[[three]]) step (%[[one]]) {
+  // CHECK:   scf.for %[[j:.*]] = %[[zero]] to %[[five]] step %[[one]] {
+  // CHECK:     memref.load %arg0[%[[i]], %[[j]]] : memref<3x5xf32>
+  // CHECK:     arith.maxf
+  // CHECK:     memref.store {{.*}}, %arg1[%[[i]], %[[j]]] : memref<3x5xf32>
+  tpp.relu ins(%arg0: memref<3x5xf32>) out(%arg1: memref<3x5xf32>)
+  return
+}
+
+// -----
+
+// Rows 0 and 1 are unrolled and jammed, row 2 is the remainder.
+// CHECK-LABEL: func.func @matmul_to_loops(
+func.func @matmul_to_loops(%arg0: memref<3x4xf32>, %arg1: memref<4x5xf32>, %arg2: memref<3x5xf32>) {
+  // CHECK-DAG: %[[zero:.*]] = arith.constant 0 : index
+  // CHECK-DAG: %[[one:.*]] = arith.constant 1 : index
+  // CHECK-DAG: %[[two:.*]] = arith.constant 2 : index
+  // CHECK-DAG: %[[three:.*]] = arith.constant 3 : index
+  // CHECK-DAG: %[[four:.*]] = arith.constant 4 : index
+  // CHECK-DAG: %[[five:.*]] = arith.constant 5 : index
+  // CHECK: scf.parallel (%[[i:.*]]) = (%[[zero]]) to (%[[two]]) step (%[[two]]) {
+  // CHECK:   %[[i1:.*]] = arith.addi %[[i]], %[[one]] : index
+  // CHECK:   scf.for %[[k:.*]] = %[[zero]] to %[[four]] step %[[one]] {
+  // CHECK:     %[[a0:.*]] = memref.load %arg0[%[[i]], %[[k]]] : memref<3x4xf32>
+  // CHECK:     %[[a1:.*]] = memref.load %arg0[%[[i1]], %[[k]]] : memref<3x4xf32>
+  // CHECK:     scf.for %[[j:.*]] = %[[zero]] to %[[five]] step %[[one]] {
+  // CHECK:       %[[b:.*]] = memref.load %arg1[%[[k]], %[[j]]] : memref<4x5xf32>
+  // CHECK:       %[[c0:.*]] = memref.load %arg2[%[[i]], %[[j]]] : memref<3x5xf32>
+  // CHECK:       %[[mul0:.*]] = arith.mulf %[[a0]], %[[b]] : f32
+  // CHECK:       %[[add0:.*]] = arith.addf %[[c0]], %[[mul0]] : f32
+  // CHECK:       memref.store %[[add0]], %arg2[%[[i]], %[[j]]] : memref<3x5xf32>
+  // CHECK:       %[[c1:.*]] = memref.load %arg2[%[[i1]], %[[j]]] : memref<3x5xf32>
+  // CHECK:       %[[mul1:.*]] = arith.mulf %[[a1]], %[[b]] : f32
+  // CHECK:       %[[add1:.*]] = arith.addf %[[c1]], %[[mul1]] : f32
+  // CHECK:       memref.store %[[add1]], %arg2[%[[i1]], %[[j]]] : memref<3x5xf32>
+  // CHECK: scf.parallel (%[[r:.*]]) = (%[[two]]) to (%[[three]]) step (%[[one]]) {
+  // CHECK:   scf.for %[[k2:.*]] = %[[zero]] to %[[four]] step %[[one]] {
+  // CHECK:     memref.load %arg0[%[[r]], %[[k2]]] : memref<3x4xf32>
+  // CHECK:     scf.for
+  // CHECK-NOT:   arith.addi
+  tpp.matmul ins(%arg0: memref<3x4xf32>, %arg1: memref<4x5xf32>) out(%arg2: memref<3x5xf32>)
+  return
+}
+
+// -----
+
+// The batch reduction stays sequential inside the parallel row loop.
+// CHECK-LABEL: func.func @brgemm_to_loops(
+func.func @brgemm_to_loops(%arg0: memref<2x4x3xf32>, %arg1: memref<2x3x4xf32>, %arg2: memref<4x4xf32>) {
+  // CHECK: scf.parallel (%[[i:.*]]) =
+  // CHECK:   scf.for %[[b:.*]] =
+  // CHECK:     scf.for %[[k:.*]] =
+  // CHECK:       memref.load %arg0[%[[b]], %[[i]], %[[k]]] : memref<2x4x3xf32>
+  // CHECK:       scf.for %[[j:.*]] =
+  // CHECK:         memref.load %arg1[%[[b]], %[[k]], %[[j]]] : memref<2x3x4xf32>
+  // CHECK-NOT: scf.parallel
+  tpp.brgemm ins(%arg0: memref<2x4x3xf32>, %arg1: memref<2x3x4xf32>) out(%arg2: memref<4x4xf32>)
+  return
+}
@@ -53,6 +53,29 @@ func.func @add_to_loops(%arg0: memref<3x3xf32>, %arg1: memref<3x3xf32>) {
 
 // -----
 
+func.func @muladd_to_loops(%arg0: memref<3x4xf32>, %arg1: memref<4xf32>,
+                           %arg2: memref<3x4xf32>) {
+  // CHECK-DAG: %[[ub0:.*]] = arith.constant 3 : index
+  // CHECK-DAG: %[[ub1:.*]] = arith.constant 4 : index
+  // CHECK-DAG: %[[lb:.*]] = arith.constant 0 : index
+  // CHECK-DAG: %[[step:.*]] = arith.constant 1 : index
+  // CHECK: scf.for %[[i:.*]] = %[[lb]] to %[[ub0]] step %[[step]] {
+  // CHECK:   scf.for %[[j:.*]] = %[[lb]] to %[[ub1]] step %[[step]] {
+  // CHECK:     %[[lhs:.*]] = memref.load %arg0[%[[i]], %[[j]]] : memref<3x4xf32>
+  // CHECK:     %[[rhs:.*]] = memref.load %arg1[%[[j]]] : memref<4xf32>
+  // CHECK:     %[[out:.*]] = memref.load %arg2[%[[i]], %[[j]]] : memref<3x4xf32>
+  // CHECK:     %[[mul:.*]] = arith.mulf %[[lhs]], %[[rhs]] : f32
+  // CHECK:     %[[add:.*]] = arith.addf %[[out]], %[[mul]] : f32
+  // CHECK:     memref.store %[[add]], %arg2[%[[i]], %[[j]]] : memref<3x4xf32>
+  // CHECK:   }
+  // CHECK: }
+  tpp.muladd ins(%arg0: memref<3x4xf32>, %arg1: memref<4xf32>)
+             out(%arg2: memref<3x4xf32>)
+  return
+}
+
+// -----
+
 func.func @identity_to_loops(%arg0: memref<3x3xf32>, %arg1: memref<3xf32>) {
   // CHECK-DAG: %[[ub:.*]] = arith.constant 3 : index
   // CHECK-DAG: %[[lb:.*]] = arith.constant 0 : index
@@ -134,11 +157,11 @@ func.func @brgemm_to_loops(%arg0: memref<2x3x4xf32>, %arg1: memref<2x4x3xf32>, %
   // CHECK-DAG: %[[two:.*]] = arith.constant 2 : index
   // CHECK-DAG: %[[zero:.*]] = arith.constant 0 : index
   // CHECK-DAG: %[[one:.*]] = arith.constant 1 : index
-  // CHECK: scf.for %[[b:.*]] = %[[zero]] to %[[two]] step %[[one]] {
   // CHECK: scf.for %[[i:.*]] = %[[zero]] to %[[three]] step %[[one]] {
-  // CHECK: scf.for %[[j:.*]] = %[[zero]] to %[[three]] step %[[one]] {
+  // CHECK: scf.for %[[b:.*]] = %[[zero]] to %[[two]] step %[[one]] {
   // CHECK: scf.for %[[k:.*]] = %[[zero]] to %[[four]] step %[[one]] {
   // CHECK: %[[ma:.*]] = memref.load %arg0[%[[b]], %[[i]], %[[k]]] : memref<2x3x4xf32>
+  // CHECK: scf.for %[[j:.*]] = %[[zero]] to %[[three]] step %[[one]] {
   // CHECK: %[[mb:.*]] = memref.load %arg1[%[[b]], %[[k]], %[[j]]] : memref<2x4x3xf32>
   // CHECK: %[[mc:.*]] = memref.load %arg2[%[[i]], %[[j]]] : memref<3x3xf32>
   // CHECK: %[[mul:.*]] = arith.mulf %[[ma]], %[[mb]] : f32
@@ -147,3 +170,64 @@ func.func @brgemm_to_loops(%arg0: memref<2x3x4xf32>, %arg1: memref<2x4x3xf32>, %
   tpp.brgemm ins(%arg0: memref<2x3x4xf32>, %arg1: memref<2x4x3xf32>) out(%arg2: memref<3x3xf32>)
   return 
 }
+
+// -----
+
+// CHECK-LABEL: func.func @fused_brgemm_to_loops(
+func.func @fused_brgemm_to_loops(%arg0: memref<2x3x4xf32>, %arg1: memref<2x4x3xf32>,
+                                 %arg2: memref<3xf32>, %arg3: memref<3x3xf32>) {
+  // Bias broadcast.
+  // CHECK: scf.for %[[i:.*]] =
+  // CHECK:   scf.for %[[j:.*]] =
+  // CHECK:     %[[bias:.*]] = memref.load %arg2[%[[j]]] : memref<3xf32>
+  // CHECK:     memref.store %[[bias]], %arg3[%[[i]], %[[j]]] : memref<3x3xf32>
+  // Batch-reduce gemm.
+  // CHECK: scf.for
+  // CHECK:   scf.for
+  // CHECK:     scf.for
+  // CHECK:       scf.for
+  // CHECK:         arith.mulf
+  // CHECK:         arith.addf
+  // Relu.
+  // CHECK: scf.for
+  // CHECK:   scf.for
+  // CHECK:     arith.maxf
+  tpp.fused_brgemm ins(%arg0: memref<2x3x4xf32>, %arg1: memref<2x4x3xf32>, %arg2: memref<3xf32>)
+                   out(%arg3: memref<3x3xf32>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @mixed_matmul_to_loops(
+func.func @mixed_matmul_to_loops(%arg0: memref<3x4xbf16>, %arg1: memref<4x3xbf16>, %arg2: memref<3x3xf32>) {
+  // CHECK: %[[ma:.*]] = memref.load %arg0[{{.*}}] : memref<3x4xbf16>
+  // CHECK: %[[mb:.*]] = memref.load %arg1[{{.*}}] : memref<4x3xbf16>
+  // CHECK: %[[mc:.*]] = memref.load %arg2[{{.*}}] : memref<3x3xf32>
+  // CHECK: %[[ea:.*]] = arith.extf %[[ma]] : bf16 to f32
+  // CHECK: %[[eb:.*]] = arith.extf %[[mb]] : bf16 to f32
+  // CHECK: %[[mul:.*]] = arith.mulf %[[ea]], %[[eb]] : f32
+  // CHECK: %[[add:.*]] = arith.addf %[[mc]], %[[mul]] : f32
+  // CHECK: memref.store %[[add]], %arg2[{{.*}}] : memref<3x3xf32>
+  tpp.matmul ins(%arg0: memref<3x4xbf16>, %arg1: memref<4x3xbf16>) out(%arg2: memref<3x3xf32>)
+  return
+}
+
+// -----
+
+// Each pair of blocks becomes a matmul on views of the operands.
+// CHECK-LABEL: func.func @offset_brgemm_to_loops(
+// CHECK-SAME: %[[ARG0:.+]]: memref<2x6x2xf32>, %[[ARG1:.+]]: memref<2x2x2xf32>, %[[ARG2:.+]]: memref<4x2xf32>
+func.func @offset_brgemm_to_loops(%arg0: memref<2x6x2xf32>, %arg1: memref<2x2x2xf32>,
+                                  %arg2: memref<4x2xf32>) -> memref<4x2xf32> {
+  // CHECK: memref.reinterpret_cast %[[ARG0]] to offset: [{{.+}}], sizes: [4, 2], strides: [2, 1]
+  // CHECK: memref.reinterpret_cast %[[ARG1]] to offset: [{{.+}}], sizes: [2, 2], strides: [2, 1]
+  // CHECK: scf.for
+  // CHECK: memref.reinterpret_cast %[[ARG0]] to offset: [{{.+}}], sizes: [4, 2], strides: [2, 1]
+  // CHECK: memref.reinterpret_cast %[[ARG1]] to offset: [{{.+}}], sizes: [2, 2], strides: [2, 1]
+  // CHECK: scf.for
+  tpp.offset_brgemm ins(%arg0: memref<2x6x2xf32>, %arg1: memref<2x2x2xf32>)
+                    out(%arg2: memref<4x2xf32>)
+                    offsetsA = [0, 12] offsetsB = [0, 4]
+  return %arg2: memref<4x2xf32>
+}
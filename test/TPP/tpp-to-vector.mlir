@@ -0,0 +1,170 @@
+// RUN: tpp-opt %s -convert-tpp-to-vector -split-input-file | FileCheck %s
+
+// CHECK-LABEL: func.func @add_to_vector(
+func.func @add_to_vector(%arg0: memref<4x12xf32>, %arg1: memref<4x12xf32>) {
+  // CHECK-DAG: %[[c0:.*]] = arith.constant 0 : index
+  // CHECK-DAG: %[[c1:.*]] = arith.constant 1 : index
+  // CHECK-DAG: %[[c4:.*]] = arith.constant 4 : index
+  // CHECK-DAG: %[[c8:.*]] = arith.constant 8 : index
+  // CHECK: scf.for %[[i:.*]] = %[[c0]] to %[[c4]] step %[[c1]] {
+  // CHECK:   %[[lhs:.*]] = vector.transfer_read %arg0[%[[i]], %[[c0]]]{{.*}}{in_bounds = [true]} : memref<4x12xf32>, vector<8xf32>
+  // CHECK:   %[[rhs:.*]] = vector.transfer_read %arg1[%[[i]], %[[c0]]]{{.*}} : memref<4x12xf32>, vector<8xf32>
+  // CHECK:   %[[sum:.*]] = arith.addf %[[lhs]], %[[rhs]] : vector<8xf32>
+  // CHECK:   vector.transfer_write %[[sum]], %arg1[%[[i]], %[[c0]]]{{.*}} : vector<8xf32>, memref<4x12xf32>
+  // Remainder of the row.
+  // CHECK:   vector.transfer_read %arg0[%[[i]], %[[c8]]]{{.*}} : memref<4x12xf32>, vector<4xf32>
+  // CHECK:   vector.transfer_read %arg1[%[[i]], %[[c8]]]{{.*}} : memref<4x12xf32>, vector<4xf32>
+  // CHECK:   arith.addf {{.*}} : vector<4xf32>
+  // CHECK:   vector.transfer_write {{.*}}, %arg1[%[[i]], %[[c8]]]{{.*}} : vector<4xf32>, memref<4x12xf32>
+  // CHECK: }
+  tpp.add ins(%arg0: memref<4x12xf32>) out(%arg1: memref<4x12xf32>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @relu_to_vector(
+func.func @relu_to_vector(%arg0: memref<32xf32>, %arg1: memref<32xf32>) {
+  // CHECK-DAG: %[[c0:.*]] = arith.constant 0 : index
+  // CHECK-DAG: %[[c8:.*]] = arith.constant 8 : index
+  // CHECK-DAG: %[[c32:.*]] = arith.constant 32 : index
+  // CHECK-DAG: %[[zero:.*]] = arith.constant dense<0.000000e+00> : vector<8xf32>
+  // CHECK: scf.for %[[j:.*]] = %[[c0]] to %[[c32]] step %[[c8]] {
+  // CHECK:   %[[in:.*]] = vector.transfer_read %arg0[%[[j]]]{{.*}} : memref<32xf32>, vector<8xf32>
+  // CHECK:   %[[max:.*]] = arith.maxf %[[in]], %[[zero]] : vector<8xf32>
+  // CHECK:   vector.transfer_write %[[max]], %arg1[%[[j]]]{{.*}} : vector<8xf32>, memref<32xf32>
+  tpp.relu ins(%arg0: memref<32xf32>) out(%arg1: memref<32xf32>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @identity_scalar_to_vector(
+func.func @identity_scalar_to_vector(%arg0: memref<3x8xf32>) {
+  // CHECK: %[[fill:.*]] = arith.constant dense<0.000000e+00> : vector<8xf32>
+  // CHECK: scf.for %[[i:.*]] =
+  // CHECK:   vector.transfer_write %[[fill]], %arg0[%[[i]], %{{.*}}]{{.*}} : vector<8xf32>, memref<3x8xf32>
+  %cst = arith.constant 0.000000e+00 : f32
+  tpp.identity ins(%cst: f32) out(%arg0: memref<3x8xf32>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @identity_row_broadcast_to_vector(
+func.func @identity_row_broadcast_to_vector(%arg0: memref<8xf32>, %arg1: memref<3x8xf32>) {
+  // CHECK-DAG: %[[c0:.*]] = arith.constant 0 : index
+  // CHECK: scf.for %[[i:.*]] =
+  // CHECK:   %[[row:.*]] = vector.transfer_read %arg0[%[[c0]]]{{.*}} : memref<8xf32>, vector<8xf32>
+  // CHECK:   vector.transfer_write %[[row]], %arg1[%[[i]], %[[c0]]]{{.*}} : vector<8xf32>, memref<3x8xf32>
+  tpp.identity ins(%arg0: memref<8xf32>) out(%arg1: memref<3x8xf32>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @identity_col_broadcast_to_vector(
+func.func @identity_col_broadcast_to_vector(%arg0: memref<3x1xf32>, %arg1: memref<3x8xf32>) {
+  // CHECK-DAG: %[[c0:.*]] = arith.constant 0 : index
+  // CHECK: scf.for %[[i:.*]] =
+  // CHECK:   %[[elem:.*]] = memref.load %arg0[%[[i]], %[[c0]]] : memref<3x1xf32>
+  // CHECK:   %[[splat:.*]] = vector.broadcast %[[elem]] : f32 to vector<8xf32>
+  // CHECK:   vector.transfer_write %[[splat]], %arg1[%[[i]], %[[c0]]]{{.*}} : vector<8xf32>, memref<3x8xf32>
+  tpp.identity ins(%arg0: memref<3x1xf32>) out(%arg1: memref<3x8xf32>)
+  return
+}
+
+// -----
+
+// A single 4x16 register block: two vectors per row.
+// CHECK-LABEL: func.func @matmul_to_vector(
+func.func @matmul_to_vector(%arg0: memref<4x8xf32>, %arg1: memref<8x16xf32>, %arg2: memref<4x16xf32>) {
+  // CHECK-DAG: %[[c0:.*]] = arith.constant 0 : index
+  // CHECK-DAG: %[[c1:.*]] = arith.constant 1 : index
+  // CHECK-DAG: %[[c8:.*]] = arith.constant 8 : index
+  // CHECK: %[[acc:.*]] = vector.transfer_read %arg2[%[[c0]], %[[c0]]]{{.*}} : memref<4x16xf32>, vector<4x16xf32>
+  // CHECK: %[[res:.*]] = scf.for %[[k:.*]] = %[[c0]] to %[[c8]] step %[[c1]] iter_args(%[[iter:.*]] = %[[acc]]) -> (vector<4x16xf32>) {
+  // CHECK:   %[[a:.*]] = vector.transfer_read %arg0[%[[c0]], %[[k]]]{{.*}}permutation_map = #{{.*}}} : memref<4x8xf32>, vector<4xf32>
+  // CHECK:   %[[b:.*]] = vector.transfer_read %arg1[%[[k]], %[[c0]]]{{.*}} : memref<8x16xf32>, vector<16xf32>
+  // CHECK:   %[[outer:.*]] = vector.outerproduct %[[a]], %[[b]], %[[iter]] {{.*}} : vector<4xf32>, vector<16xf32>
+  // CHECK:   scf.yield %[[outer]] : vector<4x16xf32>
+  // CHECK: }
+  // CHECK: vector.transfer_write %[[res]], %arg2[%[[c0]], %[[c0]]]{{.*}} : vector<4x16xf32>, memref<4x16xf32>
+  tpp.matmul ins(%arg0: memref<4x8xf32>, %arg1: memref<8x16xf32>) out(%arg2: memref<4x16xf32>)
+  return
+}
+
+// -----
+
+// 6x16 register blocks, and a 6x8 block for the remaining columns.
+// CHECK-LABEL: func.func @matmul_register_blocks(
+func.func @matmul_register_blocks(%arg0: memref<12x4xf32>, %arg1: memref<4x24xf32>, %arg2: memref<12x24xf32>) {
+  // CHECK-DAG: %[[c0:.*]] = arith.constant 0 : index
+  // CHECK-DAG: %[[c6:.*]] = arith.constant 6 : index
+  // CHECK-DAG: %[[c12:.*]] = arith.constant 12 : index
+  // CHECK-DAG: %[[c16:.*]] = arith.constant 16 : index
+  // CHECK: scf.for %[[i:.*]] = %[[c0]] to %[[c12]] step %[[c6]] {
+  // CHECK:   vector.transfer_read %arg2[%[[i]], %[[c0]]]{{.*}} : memref<12x24xf32>, vector<6x16xf32>
+  // CHECK:   scf.for
+  // CHECK:     vector.outerproduct {{.*}} : vector<6xf32>, vector<16xf32>
+  // CHECK:   vector.transfer_write {{.*}}, %arg2[%[[i]], %[[c0]]]{{.*}} : vector<6x16xf32>, memref<12x24xf32>
+  // CHECK: }
+  // CHECK: scf.for %[[i2:.*]] = %[[c0]] to %[[c12]] step %[[c6]] {
+  // CHECK:   vector.transfer_read %arg2[%[[i2]], %[[c16]]]{{.*}} : memref<12x24xf32>, vector<6x8xf32>
+  // CHECK:   scf.for
+  // CHECK:     vector.outerproduct {{.*}} : vector<6xf32>, vector<8xf32>
+  // CHECK:   vector.transfer_write {{.*}}, %arg2[%[[i2]], %[[c16]]]{{.*}} : vector<6x8xf32>, memref<12x24xf32>
+  // CHECK: }
+  tpp.matmul ins(%arg0: memref<12x4xf32>, %arg1: memref<4x24xf32>) out(%arg2: memref<12x24xf32>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @mixed_matmul_to_vector(
+func.func @mixed_matmul_to_vector(%arg0: memref<3x4xbf16>, %arg1: memref<4x8xbf16>, %arg2: memref<3x8xf32>) {
+  // CHECK: scf.for
+  // CHECK:   %[[a:.*]] = vector.transfer_read %arg0{{.*}} : memref<3x4xbf16>, vector<3xbf16>
+  // CHECK:   %[[b:.*]] = vector.transfer_read %arg1{{.*}} : memref<4x8xbf16>, vector<8xbf16>
+  // CHECK:   %[[ea:.*]] = arith.extf %[[a]] : vector<3xbf16> to vector<3xf32>
+  // CHECK:   %[[eb:.*]] = arith.extf %[[b]] : vector<8xbf16> to vector<8xf32>
+  // CHECK:   vector.outerproduct %[[ea]], %[[eb]], {{.*}} : vector<3xf32>, vector<8xf32>
+  tpp.matmul ins(%arg0: memref<3x4xbf16>, %arg1: memref<4x8xbf16>) out(%arg2: memref<3x8xf32>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @brgemm_to_vector(
+func.func @brgemm_to_vector(%arg0: memref<2x4x8xf32>, %arg1: memref<2x8x16xf32>, %arg2: memref<4x16xf32>) {
+  // CHECK-DAG: %[[c0:.*]] = arith.constant 0 : index
+  // CHECK-DAG: %[[c2:.*]] = arith.constant 2 : index
+  // CHECK: %[[acc:.*]] = vector.transfer_read %arg2{{.*}} : memref<4x16xf32>, vector<4x16xf32>
+  // CHECK: %[[res:.*]] = scf.for %[[b:.*]] = %[[c0]] to %[[c2]] {{.*}} iter_args(%[[biter:.*]] = %[[acc]]) -> (vector<4x16xf32>) {
+  // CHECK:   %[[kres:.*]] = scf.for %[[k:.*]] = {{.*}} iter_args(%[[kiter:.*]] = %[[biter]]) -> (vector<4x16xf32>) {
+  // CHECK:     vector.transfer_read %arg0[%[[b]], %[[c0]], %[[k]]]{{.*}} : memref<2x4x8xf32>, vector<4xf32>
+  // CHECK:     vector.transfer_read %arg1[%[[b]], %[[k]], %[[c0]]]{{.*}} : memref<2x8x16xf32>, vector<16xf32>
+  // CHECK:     vector.outerproduct
+  // CHECK:   scf.yield %[[kres]] : vector<4x16xf32>
+  // CHECK: vector.transfer_write %[[res]], %arg2{{.*}} : vector<4x16xf32>, memref<4x16xf32>
+  tpp.brgemm ins(%arg0: memref<2x4x8xf32>, %arg1: memref<2x8x16xf32>) out(%arg2: memref<4x16xf32>)
+  return
+}
+
+// -----
+
+// The accumulators start from the bias; C is only written.
+// CHECK-LABEL: func.func @fused_brgemm_to_vector(
+func.func @fused_brgemm_to_vector(%arg0: memref<2x4x8xf32>, %arg1: memref<2x8x16xf32>, %arg2: memref<16xf32>, %arg3: memref<4x16xf32>) {
+  // CHECK-DAG: %[[zero:.*]] = arith.constant dense<0.000000e+00> : vector<4x16xf32>
+  // CHECK-NOT: vector.transfer_read %arg3
+  // CHECK: %[[bias:.*]] = vector.transfer_read %arg2{{.*}} : memref<16xf32>, vector<16xf32>
+  // CHECK: %[[acc:.*]] = vector.broadcast %[[bias]] : vector<16xf32> to vector<4x16xf32>
+  // CHECK: %[[res:.*]] = scf.for {{.*}} iter_args(%{{.*}} = %[[acc]]) -> (vector<4x16xf32>) {
+  // CHECK:   vector.outerproduct
+  // CHECK: %[[relu:.*]] = arith.maxf %[[res]], %[[zero]] : vector<4x16xf32>
+  // CHECK: vector.transfer_write %[[relu]], %arg3{{.*}} : vector<4x16xf32>, memref<4x16xf32>
+  tpp.fused_brgemm ins(%arg0: memref<2x4x8xf32>, %arg1: memref<2x8x16xf32>, %arg2: memref<16xf32>)
+                   out(%arg3: memref<4x16xf32>)
+  return
+}
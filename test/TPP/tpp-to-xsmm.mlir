@@ -95,6 +95,20 @@ func.func @matmul_to_xsmm(%arg0: memref<3x3xf32>, %arg1: memref<3x3xf32>, %arg2:
 
 // -----
 
+// CHECK-LABEL: @muladd_to_xsmm(
+// CHECK-SAME: %[[arg_zero:.*]]: memref<4x32xf32, strided<[64, 1], offset: ?>>, %[[arg_one:.*]]: memref<32xf32>, %[[arg_two:.*]]: memref<4x32xf32>)
+func.func @muladd_to_xsmm(%arg0: memref<4x32xf32, strided<[64, 1], offset: ?>>,
+                          %arg1: memref<32xf32>, %arg2: memref<4x32xf32>) {
+  // The broadcast row has a zero leading dimension.
+  // CHECK: %[[dispatch:.*]] = xsmm.ternary.dispatch muladd [4, 32, 64, 0, 32]
+  // CHECK: xsmm.ternary muladd(%[[dispatch]], %[[arg_zero]], %[[arg_one]], %[[arg_two]])
+  tpp.muladd ins(%arg0: memref<4x32xf32, strided<[64, 1], offset: ?>>,
+                 %arg1: memref<32xf32>) out(%arg2: memref<4x32xf32>)
+  return
+}
+
+// -----
+
 // CHECK-LABEL: @identity_to_xsmm(
 func.func @identity_to_xsmm(%arg0: f32, %arg1: memref<5x6xf32>) {
 
@@ -128,6 +142,18 @@ func.func @relu_to_xsmm(%arg0: memref<5x6xf32>, %arg1: memref<5x6xf32>) {
 
 // -----
 
+// CHECK-LABEL: @relu_strided_to_xsmm(
+func.func @relu_strided_to_xsmm(%arg0: memref<5x6xf32, strided<[8, 1], offset: ?>>,
+                                %arg1: memref<5x6xf32>) {
+
+  // CHECK: xsmm.unary.dispatch relu [5, 6, 8, 6](broadcast none dataType f32)
+  // CHECK: xsmm.unary relu
+  tpp.relu ins(%arg0: memref<5x6xf32, strided<[8, 1], offset: ?>>) out(%arg1: memref<5x6xf32>)
+  return
+}
+
+// -----
+
 // CHECK-LABEL: @brgemm_to_xsmm(
 func.func @brgemm_to_xsmm(%arg0: memref<3x5x4xf32>, %arg1: memref<3x4x5xf32>,
                           %arg2: memref<5x5xf32>) -> memref<5x5xf32> {
@@ -137,3 +163,57 @@ func.func @brgemm_to_xsmm(%arg0: memref<3x5x4xf32>, %arg1: memref<3x4x5xf32>,
              out(%arg2: memref<5x5xf32>)
   return %arg2: memref<5x5xf32>
 }
+
+// -----
+
+// CHECK-LABEL: @fused_brgemm_to_xsmm(
+// CHECK-SAME: %[[ARG0:.+]]: memref<3x5x4xf32>, %[[ARG1:.+]]: memref<3x4x5xf32>, %[[ARG2:.+]]: memref<5xf32>, %[[ARG3:.+]]: memref<5x5xf32>
+func.func @fused_brgemm_to_xsmm(%arg0: memref<3x5x4xf32>, %arg1: memref<3x4x5xf32>,
+                                %arg2: memref<5xf32>, %arg3: memref<5x5xf32>) -> memref<5x5xf32> {
+  // CHECK-DAG: %[[BATCH:.+]] = arith.constant 3 : i64
+  // CHECK-DAG: %[[DISPATCH:.+]] = xsmm.ternary.dispatch fused_brgemm [5, 5, 4, 4, 5, 5](dataType f32)
+  // CHECK: xsmm.ternary fused_brgemm(%[[DISPATCH]], %[[ARG0]], %[[ARG1]], %[[ARG2]], %[[ARG3]], %[[BATCH]])
+  tpp.fused_brgemm ins(%arg0: memref<3x5x4xf32>, %arg1: memref<3x4x5xf32>, %arg2: memref<5xf32>)
+                   out(%arg3: memref<5x5xf32>)
+  return %arg3: memref<5x5xf32>
+}
+
+// -----
+
+// CHECK-LABEL: @offset_brgemm_to_xsmm(
+// CHECK-SAME: %[[ARG0:.+]]: memref<2x6x2xf32>, %[[ARG1:.+]]: memref<2x2x2xf32>, %[[ARG2:.+]]: memref<4x2xf32>
+func.func @offset_brgemm_to_xsmm(%arg0: memref<2x6x2xf32>, %arg1: memref<2x2x2xf32>,
+                                 %arg2: memref<4x2xf32>) -> memref<4x2xf32> {
+  // CHECK-DAG: %[[BATCH:.+]] = arith.constant 2 : i64
+  // CHECK-DAG: %[[DISPATCH:.+]] = xsmm.ternary.dispatch brgemm_offs [4, 2, 2, 2, 2, 2](dataType f32)
+  // CHECK: xsmm.ternary brgemm_offs(%[[DISPATCH]], %[[ARG0]], %[[ARG1]], %[[ARG2]], %[[BATCH]])
+  // CHECK-SAME: {offsetsA = array<i64: 0, 12>, offsetsB = array<i64: 0, 4>}
+  tpp.offset_brgemm ins(%arg0: memref<2x6x2xf32>, %arg1: memref<2x2x2xf32>)
+                    out(%arg2: memref<4x2xf32>)
+                    offsetsA = [0, 12] offsetsB = [0, 4]
+  return %arg2: memref<4x2xf32>
+}
+
+// -----
+
+// CHECK-LABEL: @mixed_matmul_to_xsmm(
+// CHECK-SAME: %[[ARG0:.+]]: memref<4x8xbf16>, %[[ARG1:.+]]: memref<8x4xbf16>, %[[ARG2:.+]]: memref<4x4xf32>
+func.func @mixed_matmul_to_xsmm(%arg0: memref<4x8xbf16>, %arg1: memref<8x4xbf16>,
+                                %arg2: memref<4x4xf32>) -> memref<4x4xf32> {
+  // CHECK: %[[DISPATCH:.+]] = xsmm.ternary.dispatch matmul [4, 4, 8, 8, 4, 4](dataType bf16 computeType f32 outputType f32)
+  // CHECK: xsmm.ternary matmul(%[[DISPATCH]], %[[ARG0]], %[[ARG1]], %[[ARG2]])
+  tpp.matmul ins(%arg0: memref<4x8xbf16>, %arg1: memref<8x4xbf16>) out(%arg2: memref<4x4xf32>)
+  return %arg2: memref<4x4xf32>
+}
+
+// -----
+
+// CHECK-LABEL: @mixed_brgemm_to_xsmm(
+func.func @mixed_brgemm_to_xsmm(%arg0: memref<3x5x4xbf16>, %arg1: memref<3x4x5xbf16>,
+                                %arg2: memref<5x5xf32>) -> memref<5x5xf32> {
+  // CHECK: xsmm.ternary.dispatch brgemm [5, 5, 4, 4, 5, 5](dataType bf16 computeType f32 outputType f32)
+  // CHECK: xsmm.ternary brgemm
+  tpp.brgemm ins(%arg0: memref<3x5x4xbf16>, %arg1: memref<3x4x5xbf16>)
+             out(%arg2: memref<5x5xf32>)
+  return %arg2: memref<5x5xf32>
+}
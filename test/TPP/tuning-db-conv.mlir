@@ -0,0 +1,19 @@
+// RUN: echo '{"version": 1, "entries": [{"pass": "pack-depthwise-conv2DNhwcHwc", "op": "linalg.depthwise_conv_2d_nhwc_hwc", "shape": [1, 4, 4, 64, 3, 3], "type": "f32", "params": [16], "seconds": 0.0}, {"pass": "pack-conv2DNhwcHwcf", "op": "linalg.depthwise_conv_2d_nhwc_hwc", "shape": [1, 4, 4, 64, 3, 3], "type": "f32", "params": [8, 8], "seconds": 0.0}]}' > %t.json
+// RUN: tpp-opt %s -pack-conv2DNhwcHwcf="block-factors=32,32 tuning-db=%t.json" | FileCheck %s
+
+// The depthwise convolution reads its own entry, not the one of a dense
+// Conv2DNhwcHwcf.
+// CHECK-LABEL: func.func @depthwise(
+// CHECK-SAME:  %[[ARG0:.+]]: tensor<1x6x6x64xf32>, %[[ARG1:.+]]: tensor<3x3x64xf32>
+// CHECK: linalgx.pack %[[ARG0]] outer_dims_perm = [0, 3, 1, 2] inner_dims_pos = [3] inner_tiles = [16]
+// CHECK: linalgx.pack %[[ARG1]] outer_dims_perm = [2, 0, 1] inner_dims_pos = [2] inner_tiles = [16]
+// CHECK: linalg.generic
+// CHECK-SAME:  outs(%{{.+}} : tensor<1x4x4x4x16xf32>)
+func.func @depthwise(%i: tensor<1x6x6x64xf32>, %f: tensor<3x3x64xf32>,
+                     %o: tensor<1x4x4x64xf32>) -> tensor<1x4x4x64xf32> {
+  %0 = linalg.depthwise_conv_2d_nhwc_hwc {dilations = dense<1> : tensor<2xi64>,
+                                          strides = dense<1> : tensor<2xi64>}
+    ins(%i, %f: tensor<1x6x6x64xf32>, tensor<3x3x64xf32>)
+    outs(%o: tensor<1x4x4x64xf32>) -> tensor<1x4x4x64xf32>
+  return %0 : tensor<1x4x4x64xf32>
+}
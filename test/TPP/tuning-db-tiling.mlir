@@ -0,0 +1,26 @@
+// RUN: echo '{"version": 1, "entries": [{"pass": "convert-linalg-to-tpp", "op": "tpp.matmul", "shape": [64, 64, 4096], "type": "f32", "params": [0, 0, 256], "seconds": 0.0}]}' > %t.json
+// RUN: tpp-opt %s -convert-linalg-to-tpp="enable-tiling tuning-db=%t.json" | FileCheck %s
+
+#map0 = affine_map<(d0, d1, d2) -> (d0, d2)>
+#map1 = affine_map<(d0, d1, d2) -> (d2, d1)>
+#map2 = affine_map<(d0, d1, d2) -> (d0, d1)>
+
+// The tile sizes come from the database instead of the cost model.
+// CHECK-LABEL: func.func @large_k(
+// CHECK-SAME:  %[[ARG0:.+]]: memref<64x4096xf32>, %[[ARG1:.+]]: memref<4096x64xf32>, %[[ARG2:.+]]: memref<64x64xf32>
+// CHECK-DAG: %[[C0:.+]] = arith.constant 0 : index
+// CHECK-DAG: %[[C256:.+]] = arith.constant 256 : index
+// CHECK-DAG: %[[C4096:.+]] = arith.constant 4096 : index
+// CHECK: scf.for %[[K:.+]] = %[[C0]] to %[[C4096]] step %[[C256]] {
+// CHECK: %[[A:.+]] = memref.subview %[[ARG0]][0, %[[K]]] [64, 256] [1, 1]
+// CHECK: %[[B:.+]] = memref.subview %[[ARG1]][%[[K]], 0] [256, 64] [1, 1]
+// CHECK: tpp.matmul ins(%[[A]] : {{.+}}, %[[B]] : {{.+}}) out(%[[ARG2]] : memref<64x64xf32>)
+func.func @large_k(%arg0: memref<64x4096xf32>, %arg1: memref<4096x64xf32>, %arg2: memref<64x64xf32>) {
+  linalg.generic {indexing_maps = [#map0, #map1, #map2], iterator_types = ["parallel", "parallel", "reduction"], library_call = "tpp.matmul"} ins(%arg0, %arg1 : memref<64x4096xf32>, memref<4096x64xf32>) outs(%arg2 : memref<64x64xf32>) {
+    ^bb0(%a: f32, %b: f32, %c: f32):
+      %0 = arith.mulf %a, %b : f32
+      %1 = arith.addf %c, %0 : f32
+      linalg.yield %1 : f32
+  }
+  return
+}
@@ -0,0 +1,37 @@
+// RUN: echo '{"version": 1, "entries": [{"pass": "pack-matmul", "op": "linalg.matmul", "shape": [128, 256, 512], "type": "f32", "params": [32, 64, 16], "seconds": 0.0}]}' > %t.json
+// RUN: tpp-opt %s -split-input-file -pack-matmul="tuning-db=%t.json" | FileCheck %s
+// RUN: env TPP_TUNING_DB=%t.json tpp-opt %s -split-input-file -pack-matmul | FileCheck %s
+// RUN: tpp-opt %s -split-input-file -pack-matmul="block-factors=32,32,32 tuning-db=%t.json" | FileCheck %s -check-prefix=FALLBACK
+
+// The blocking factors come from the database, also over 'block-factors'.
+// CHECK-LABEL: func.func @tuned(
+// CHECK-SAME:  %[[ARG0:.+]]: tensor<128x512xf32>, %[[ARG1:.+]]: tensor<512x256xf32>, %[[ARG2:.+]]: tensor<128x256xf32>
+// CHECK: linalgx.pack %[[ARG0]] inner_dims_pos = [0, 1] inner_tiles = [32, 16] into %{{.+}} : (tensor<128x512xf32> tensor<4x32x32x16xf32>)
+// CHECK: linalgx.pack %[[ARG1]] outer_dims_perm = [1, 0] inner_dims_pos = [0, 1] inner_tiles = [16, 64] into %{{.+}} : (tensor<512x256xf32> tensor<4x32x16x64xf32>)
+// CHECK: linalgx.pack %[[ARG2]] inner_dims_pos = [0, 1] inner_tiles = [32, 64] into %{{.+}} : (tensor<128x256xf32> tensor<4x4x32x64xf32>)
+// FALLBACK-LABEL: func.func @tuned(
+// FALLBACK: linalg.generic
+// FALLBACK-SAME: ins(%{{.+}}, %{{.+}} : tensor<4x32x32x16xf32>, tensor<4x32x16x64xf32>) outs(%{{.+}} : tensor<4x4x32x64xf32>)
+func.func @tuned(%arg0: tensor<128x512xf32>,
+                 %arg1: tensor<512x256xf32>,
+                 %arg2: tensor<128x256xf32>) -> tensor<128x256xf32> {
+  %0 = linalg.matmul ins(%arg0, %arg1: tensor<128x512xf32>, tensor<512x256xf32>) outs(%arg2: tensor<128x256xf32>) -> tensor<128x256xf32>
+  return %0 : tensor<128x256xf32>
+}
+
+// -----
+
+// No entry for this shape: the matmul is left alone, unless 'block-factors'
+// is given.
+// CHECK-LABEL: func.func @untuned(
+// CHECK-NOT: linalgx.pack
+// CHECK: linalg.matmul
+// FALLBACK-LABEL: func.func @untuned(
+// FALLBACK: linalg.generic
+// FALLBACK-SAME: ins(%{{.+}}, %{{.+}} : tensor<2x2x32x32xf32>, tensor<2x2x32x32xf32>) outs(%{{.+}} : tensor<2x2x32x32xf32>)
+func.func @untuned(%arg0: tensor<64x64xf32>,
+                   %arg1: tensor<64x64xf32>,
+                   %arg2: tensor<64x64xf32>) -> tensor<64x64xf32> {
+  %0 = linalg.matmul ins(%arg0, %arg1: tensor<64x64xf32>, tensor<64x64xf32>) outs(%arg2: tensor<64x64xf32>) -> tensor<64x64xf32>
+  return %0 : tensor<64x64xf32>
+}
@@ -4,3 +4,21 @@
 func.func @myfunc(%arg0: memref<2x2xf32>, %arg1: memref<2x2xf32>) -> memref<2x2xf32> {
   return %arg0: memref<2x2xf32>
 }
+
+// -----
+
+func.func @brgemm_with_offsets(%arg0: i64, %arg1: memref<2x5x4xf32>, %arg2: memref<2x4x5xf32>,
+                               %arg3: memref<5x5xf32>, %arg4: i64) {
+  // expected-error @below {{'xsmm.ternary' op expect offsets only for batch-reduce over lists}}
+  xsmm.ternary brgemm(%arg0, %arg1, %arg2, %arg3, %arg4) {offsetsA = array<i64: 0>, offsetsB = array<i64: 0>} : (i64, memref<2x5x4xf32>, memref<2x4x5xf32>, memref<5x5xf32>, i64) -> ()
+  return
+}
+
+// -----
+
+func.func @brgemm_offs_mismatch(%arg0: i64, %arg1: memref<2x6x2xf32>, %arg2: memref<2x2x2xf32>,
+                                %arg3: memref<4x2xf32>, %arg4: i64) {
+  // expected-error @below {{'xsmm.ternary' op expect the same number of offsets for A and B}}
+  xsmm.ternary brgemm_offs(%arg0, %arg1, %arg2, %arg3, %arg4) {offsetsA = array<i64: 0, 12>, offsetsB = array<i64: 0>} : (i64, memref<2x6x2xf32>, memref<2x2x2xf32>, memref<4x2xf32>, i64) -> ()
+  return
+}
@@ -0,0 +1,66 @@
+// RUN: tpp-opt %s -convert-xsmm-to-func="hoist-dispatch" -split-input-file | FileCheck %s
+
+// CHECK: memref.global "private" @xsmm_kernel_table : memref<2xi64>
+// CHECK-LABEL: func.func @xsmm_init()
+// CHECK-SAME:  attributes {llvm.emit_c_interface, xsmm.dispatch_init}
+// CHECK: %[[TABLE:.+]] = memref.get_global @xsmm_kernel_table : memref<2xi64>
+// CHECK: %[[MATMUL:.+]] = call @xsmm_matmul_dispatch_f32(
+// CHECK: memref.store %[[MATMUL]], %[[TABLE]][%{{.+}}] : memref<2xi64>
+// CHECK: %[[RELU:.+]] = call @xsmm_unary_dispatch_f32(
+// CHECK: memref.store %[[RELU]], %[[TABLE]][%{{.+}}] : memref<2xi64>
+// CHECK-NOT: call @xsmm_matmul_dispatch_f32
+
+// CHECK-LABEL: func.func @matmul(
+func.func @matmul(%arg0: memref<3x3xf32>, %arg1: memref<3x3xf32>,
+                  %arg2: memref<3x3xf32>) {
+  // CHECK-DAG: %[[C0:.+]] = arith.constant 0 : index
+  // CHECK-DAG: %[[T:.+]] = memref.get_global @xsmm_kernel_table : memref<2xi64>
+  // CHECK: %[[K:.+]] = memref.load %[[T]][%[[C0]]] : memref<2xi64>
+  // CHECK: call @xsmm_matmul_invoke_f32(%[[K]]
+  %0 = xsmm.ternary.dispatch matmul [3, 3, 3, 3, 3, 3] (dataType f32)
+  xsmm.ternary matmul(%0, %arg0, %arg1, %arg2) : (i64, memref<3x3xf32>, memref<3x3xf32>, memref<3x3xf32>) -> ()
+  return
+}
+
+// CHECK-LABEL: func.func @matmul_relu(
+func.func @matmul_relu(%arg0: memref<3x3xf32>, %arg1: memref<3x3xf32>,
+                       %arg2: memref<3x3xf32>) {
+  // CHECK-DAG: %[[C0:.+]] = arith.constant 0 : index
+  // CHECK-DAG: %[[C1:.+]] = arith.constant 1 : index
+  // CHECK-NOT: call @xsmm_matmul_dispatch_f32
+  // CHECK: %[[K0:.+]] = memref.load %{{.+}}[%[[C0]]] : memref<2xi64>
+  // CHECK: call @xsmm_matmul_invoke_f32(%[[K0]]
+  // CHECK-NOT: call @xsmm_unary_dispatch_f32
+  // CHECK: %[[K1:.+]] = memref.load %{{.+}}[%[[C1]]] : memref<2xi64>
+  // CHECK: call @xsmm_unary_invoke_f32(%[[K1]]
+  %0 = xsmm.ternary.dispatch matmul [3, 3, 3, 3, 3, 3] (dataType f32)
+  xsmm.ternary matmul(%0, %arg0, %arg1, %arg2) : (i64, memref<3x3xf32>, memref<3x3xf32>, memref<3x3xf32>) -> ()
+  %1 = xsmm.unary.dispatch relu [3, 3, 3, 3](broadcast none dataType f32)
+  xsmm.unary relu(%1, %arg2, %arg2) : (i64, memref<3x3xf32>, memref<3x3xf32>) -> ()
+  return
+}
+
+// -----
+
+// CHECK: memref.global "private" @xsmm_kernel_table : memref<1xi64>
+// CHECK-LABEL: func.func @mlp_init()
+// CHECK-SAME:  attributes {llvm.emit_c_interface, xsmm.dispatch_init}
+// CHECK: call @xsmm_brgemm_dispatch_f32(
+module @mlp {
+  func.func @brgemm(%arg0: memref<2x5x4xf32>, %arg1: memref<2x4x5xf32>,
+                    %arg2: memref<5x5xf32>) {
+    %0 = xsmm.ternary.dispatch brgemm [5, 5, 4, 4, 5, 5] (dataType f32)
+    %c2_i64 = arith.constant 2 : i64
+    xsmm.ternary brgemm(%0, %arg0, %arg1, %arg2, %c2_i64) : (i64, memref<2x5x4xf32>, memref<2x4x5xf32>, memref<5x5xf32>, i64) -> ()
+    return
+  }
+}
+
+// -----
+
+// A module without dispatches is left untouched.
+// CHECK-NOT: memref.global
+// CHECK-NOT: xsmm_init
+func.func @no_dispatch(%arg0: memref<3x3xf32>) -> memref<3x3xf32> {
+  return %arg0 : memref<3x3xf32>
+}
@@ -0,0 +1,40 @@
+// RUN: tpp-opt %s -convert-xsmm-to-func="use-extract-metadata trace-kernel-sites" -split-input-file | FileCheck %s
+
+// "a.mlir:3:5\0b.mlir:7:1\0"
+// CHECK: memref.global "private" constant @xsmm_kernel_sites : memref<22xi8> = dense<[97, 46, 109, 108, 105, 114, 58, 51, 58, 53, 0, 98, 46, 109, 108, 105, 114, 58, 55, 58, 49, 0]>
+// CHECK-DAG: func.func private @xsmm_trace_site(i64, !llvm.ptr<i8>, index){{$}}
+
+// CHECK-LABEL: func.func @matmul_relu(
+func.func @matmul_relu(%arg0: memref<3x3xf32>, %arg1: memref<3x3xf32>,
+                       %arg2: memref<3x3xf32>) {
+  // CHECK-DAG: %[[ID0:.+]] = arith.constant 0 : i64
+  // CHECK-DAG: %[[ID1:.+]] = arith.constant 1 : i64
+  // CHECK: %[[SITES0:.+]] = memref.get_global @xsmm_kernel_sites : memref<22xi8>
+  // CHECK: %[[BASE0:.+]] = memref.extract_aligned_pointer_as_index %[[SITES0]]
+  // CHECK: %[[BASE0_I64:.+]] = arith.index_cast %[[BASE0]] : index to i64
+  // CHECK: %[[PTR0:.+]] = llvm.inttoptr %[[BASE0_I64]] : i64 to !llvm.ptr<i8>
+  // CHECK: call @xsmm_trace_site(%[[ID0]], %[[PTR0]], %{{.+}})
+  // CHECK: call @xsmm_matmul_invoke_f32(
+  // CHECK: %[[SITES1:.+]] = memref.get_global @xsmm_kernel_sites : memref<22xi8>
+  // CHECK: %[[BASE1:.+]] = memref.extract_aligned_pointer_as_index %[[SITES1]]
+  // CHECK: %[[BASE1_I64:.+]] = arith.index_cast %[[BASE1]] : index to i64
+  // CHECK: %[[PTR1:.+]] = llvm.inttoptr %[[BASE1_I64]] : i64 to !llvm.ptr<i8>
+  // CHECK: call @xsmm_trace_site(%[[ID1]], %[[PTR1]], %{{.+}})
+  // CHECK: call @xsmm_unary_invoke_f32(
+  %0 = xsmm.ternary.dispatch matmul [3, 3, 3, 3, 3, 3] (dataType f32)
+  xsmm.ternary matmul(%0, %arg0, %arg1, %arg2) : (i64, memref<3x3xf32>, memref<3x3xf32>, memref<3x3xf32>) -> () loc("a.mlir":3:5)
+  %1 = xsmm.unary.dispatch relu [3, 3, 3, 3](broadcast none dataType f32)
+  xsmm.unary relu(%1, %arg2, %arg2) : (i64, memref<3x3xf32>, memref<3x3xf32>) -> () loc("b.mlir":7:1)
+  return
+}
+
+// -----
+
+// Dispatches are not traced.
+// CHECK-NOT: xsmm_kernel_sites
+// CHECK-NOT: xsmm_trace_site
+// CHECK-LABEL: func.func @dispatch_only(
+func.func @dispatch_only() -> i64 {
+  %0 = xsmm.ternary.dispatch matmul [3, 3, 3, 3, 3, 3] (dataType f32)
+  return %0 : i64
+}
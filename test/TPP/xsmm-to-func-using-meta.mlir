@@ -1,7 +1,7 @@
-// RUN: tpp-opt %s -convert-xsmm-to-func="use-extract-metadata" | FileCheck %s
+// RUN: tpp-opt %s -convert-xsmm-to-func="use-extract-metadata" -split-input-file | FileCheck %s
 
-// CHECK-DAG: func.func private @xsmm_brgemm_dispatch_f32(i64, i64, i64, i64, i64, i64) -> i64
-// CHECK-DAG: func.func private @xsmm_brgemm_invoke_f32(i64, !llvm.ptr<f32>, index, !llvm.ptr<f32>, index, !llvm.ptr<f32>, index, i64)
+// CHECK-DAG: func.func private @xsmm_brgemm_dispatch_f32(i64, i64, i64, i64, i64, i64) -> i64 attributes {llvm.emit_c_interface}
+// CHECK-DAG: func.func private @xsmm_brgemm_invoke_f32(i64, !llvm.ptr<f32>, index, !llvm.ptr<f32>, index, !llvm.ptr<f32>, index, i64){{$}}
 func.func @dispatch_brgemm(%arg0: memref<2x5x4xf32>, %arg1: memref<2x4x5xf32>,
                            %arg2: memref<4x4xf32>) -> memref<4x4xf32> {
   %0 = xsmm.ternary.dispatch brgemm [5, 5, 4, 4, 5, 5] (dataType f32)
@@ -9,3 +9,30 @@ func.func @dispatch_brgemm(%arg0: memref<2x5x4xf32>, %arg1: memref<2x4x5xf32>,
   xsmm.ternary brgemm(%0, %arg0, %arg1, %arg2, %c2_i64) : (i64, memref<2x5x4xf32>, memref<2x4x5xf32>, memref<4x4xf32>, i64) -> ()
   return %arg2 : memref<4x4xf32>
 }
+
+// -----
+
+// CHECK-DAG: func.func private @xsmm_matmul_dispatch_bf16_f32_f32(i64, i64, i64, i64, i64, i64) -> i64 attributes {llvm.emit_c_interface}
+// CHECK-DAG: func.func private @xsmm_matmul_invoke_bf16_f32(i64, !llvm.ptr<bf16>, index, !llvm.ptr<bf16>, index, !llvm.ptr<f32>, index){{$}}
+// CHECK-DAG: func.func private @xsmm_unary_scalar_invoke_f32(i64, f32, !llvm.ptr<f32>, index){{$}}
+
+// CHECK-LABEL: func.func @matmul_mixed_precision(
+// CHECK-SAME:  %[[ARG0:.+]]: memref<4x8xbf16>, %[[ARG1:.+]]: memref<8x4xbf16>, %[[ARG2:.+]]: memref<4x4xf32>
+func.func @matmul_mixed_precision(%arg0: memref<4x8xbf16>, %arg1: memref<8x4xbf16>,
+                                  %arg2: memref<4x4xf32>) {
+  // CHECK-DAG: %[[CST:.+]] = arith.constant 0.000000e+00 : f32
+  // CHECK-DAG: %[[K0:.+]] = call @xsmm_unary_dispatch_f32(
+  // CHECK: %{{.+}}, %[[OFF:.+]], %{{.+}}:2, %{{.+}}:2 = memref.extract_strided_metadata %[[ARG2]]
+  // CHECK: %[[PTR:.+]] = memref.extract_aligned_pointer_as_index %[[ARG2]]
+  // CHECK: %[[PTR_I64:.+]] = arith.index_cast %[[PTR]] : index to i64
+  // CHECK: %[[LLVM_PTR:.+]] = llvm.inttoptr %[[PTR_I64]] : i64 to !llvm.ptr<f32>
+  // CHECK: call @xsmm_unary_scalar_invoke_f32(%[[K0]], %[[CST]], %[[LLVM_PTR]], %[[OFF]])
+  %0 = xsmm.unary.dispatch identity [4, 4, 1, 4](broadcast scalar dataType f32)
+  %cst = arith.constant 0.0 : f32
+  xsmm.unary identity(%0, %cst, %arg2) : (i64, f32, memref<4x4xf32>) -> ()
+  // CHECK: %[[K1:.+]] = call @xsmm_matmul_dispatch_bf16_f32_f32(
+  // CHECK: call @xsmm_matmul_invoke_bf16_f32(%[[K1]]
+  %1 = xsmm.ternary.dispatch matmul [4, 4, 8, 8, 4, 4] (dataType bf16 computeType f32 outputType f32)
+  xsmm.ternary matmul(%1, %arg0, %arg1, %arg2) : (i64, memref<4x8xbf16>, memref<8x4xbf16>, memref<4x4xf32>) -> ()
+  return
+}
@@ -19,3 +19,60 @@ func.func @dispatch_brgemm(%arg0: memref<2x5x4xf32>, %arg1: memref<2x4x5xf32>,
   xsmm.ternary brgemm(%0, %arg0, %arg1, %arg2, %c2_i64) : (i64, memref<2x5x4xf32>, memref<2x4x5xf32>, memref<4x4xf32>, i64) -> ()
   return %arg2 : memref<4x4xf32>
 }
+
+// -----
+
+// CHECK-DAG: func.func private @xsmm_fused_brgemm_dispatch_f32(i64, i64, i64, i64, i64, i64) -> i64 attributes {llvm.emit_c_interface}
+// CHECK-DAG: func.func private @xsmm_fused_brgemm_invoke_f32(i64, memref<*xf32>, memref<*xf32>, memref<*xf32>, memref<*xf32>, i64) attributes {llvm.emit_c_interface}
+func.func @dispatch_fused_brgemm(%arg0: memref<2x5x4xf32>, %arg1: memref<2x4x5xf32>,
+                                 %arg2: memref<5xf32>, %arg3: memref<5x5xf32>) -> memref<5x5xf32> {
+  %0 = xsmm.ternary.dispatch fused_brgemm [5, 5, 4, 4, 5, 5] (dataType f32)
+  %c2_i64 = arith.constant 2 : i64
+  xsmm.ternary fused_brgemm(%0, %arg0, %arg1, %arg2, %arg3, %c2_i64) : (i64, memref<2x5x4xf32>, memref<2x4x5xf32>, memref<5xf32>, memref<5x5xf32>, i64) -> ()
+  return %arg3 : memref<5x5xf32>
+}
+
+// -----
+
+// CHECK-DAG: func.func private @xsmm_brgemm_dispatch_bf16_f32_f32(i64, i64, i64, i64, i64, i64) -> i64 attributes {llvm.emit_c_interface}
+// CHECK-DAG: func.func private @xsmm_brgemm_invoke_bf16_f32(i64, memref<*xbf16>, memref<*xbf16>, memref<*xf32>, i64) attributes {llvm.emit_c_interface}
+func.func @dispatch_mixed_brgemm(%arg0: memref<2x5x4xbf16>, %arg1: memref<2x4x5xbf16>,
+                                 %arg2: memref<5x5xf32>) -> memref<5x5xf32> {
+  %0 = xsmm.ternary.dispatch brgemm [5, 5, 4, 4, 5, 5] (dataType bf16 computeType f32 outputType f32)
+  %c2_i64 = arith.constant 2 : i64
+  xsmm.ternary brgemm(%0, %arg0, %arg1, %arg2, %c2_i64) : (i64, memref<2x5x4xbf16>, memref<2x4x5xbf16>, memref<5x5xf32>, i64) -> ()
+  return %arg2 : memref<5x5xf32>
+}
+
+// -----
+
+// The offsets become constant globals of byte offsets.
+// CHECK-DAG: memref.global "private" constant @xsmm_batch_offsets_0 : memref<2xi64> = dense<[0, 48]>
+// CHECK-DAG: memref.global "private" constant @xsmm_batch_offsets_1 : memref<2xi64> = dense<[0, 16]>
+// CHECK-DAG: func.func private @xsmm_brgemm_offs_dispatch_f32(i64, i64, i64, i64, i64, i64) -> i64 attributes {llvm.emit_c_interface}
+// CHECK-DAG: func.func private @xsmm_brgemm_offs_invoke_f32(i64, memref<*xf32>, memref<*xf32>, memref<*xf32>, memref<*xi64>, memref<*xi64>, i64) attributes {llvm.emit_c_interface}
+// CHECK-LABEL: func.func @dispatch_brgemm_offs(
+func.func @dispatch_brgemm_offs(%arg0: memref<2x6x2xf32>, %arg1: memref<2x2x2xf32>,
+                                %arg2: memref<4x2xf32>) -> memref<4x2xf32> {
+  // CHECK-DAG: memref.get_global @xsmm_batch_offsets_0 : memref<2xi64>
+  // CHECK-DAG: memref.get_global @xsmm_batch_offsets_1 : memref<2xi64>
+  // CHECK: call @xsmm_brgemm_offs_invoke_f32
+  %0 = xsmm.ternary.dispatch brgemm_offs [4, 2, 2, 2, 2, 2] (dataType f32)
+  %c2_i64 = arith.constant 2 : i64
+  xsmm.ternary brgemm_offs(%0, %arg0, %arg1, %arg2, %c2_i64) {offsetsA = array<i64: 0, 12>, offsetsB = array<i64: 0, 4>} : (i64, memref<2x6x2xf32>, memref<2x2x2xf32>, memref<4x2xf32>, i64) -> ()
+  return %arg2 : memref<4x2xf32>
+}
+
+// -----
+
+// CHECK-DAG: func.func private @xsmm_muladd_dispatch_f32(i64, i64, i64, i64, i64) -> i64 attributes {llvm.emit_c_interface}
+// CHECK-DAG: func.func private @xsmm_muladd_invoke_f32(i64, memref<*xf32>, memref<*xf32>, memref<*xf32>) attributes {llvm.emit_c_interface}
+// CHECK-LABEL: func.func @dispatch_muladd(
+func.func @dispatch_muladd(%arg0: memref<4x32xf32>, %arg1: memref<32xf32>,
+                           %arg2: memref<4x32xf32>) -> memref<4x32xf32> {
+  // CHECK: %[[DISPATCH:.+]] = call @xsmm_muladd_dispatch_f32
+  // CHECK: call @xsmm_muladd_invoke_f32(%[[DISPATCH]]
+  %0 = xsmm.ternary.dispatch muladd [4, 32, 32, 0, 32] (dataType f32)
+  xsmm.ternary muladd(%0, %arg0, %arg1, %arg2) : (i64, memref<4x32xf32>, memref<32xf32>, memref<4x32xf32>) -> ()
+  return %arg2 : memref<4x32xf32>
+}
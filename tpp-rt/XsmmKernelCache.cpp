@@ -0,0 +1,107 @@
+//===- XsmmKernelCache.cpp - Process-wide LIBXSMM kernel cache ------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "XsmmKernelCache.h"
+
+using namespace tpp;
+
+// Zero-initialized: all the slots start EMPTY and all the counters at zero.
+static KernelCache kernelCache;
+
+KernelKey tpp::makeGemmKey(KernelKind kind, KernelDataType dtype, int64_t m,
+                           int64_t n, int64_t k, int64_t lda, int64_t ldb,
+                           int64_t ldc, int64_t flags) {
+  KernelKey key;
+  key.kind = static_cast<int64_t>(kind);
+  key.dtype = static_cast<int64_t>(dtype);
+  key.m = m;
+  key.n = n;
+  key.k = k;
+  key.lda = lda;
+  key.ldb = ldb;
+  key.ldc = ldc;
+  key.op = 0;
+  key.flags = flags;
+  return key;
+}
+
+KernelKey tpp::makeEltwiseKey(KernelKind kind, KernelDataType dtype, int64_t m,
+                              int64_t n, int64_t ldi, int64_t ldi2,
+                              int64_t ldo, int64_t op, int64_t flags) {
+  KernelKey key;
+  key.kind = static_cast<int64_t>(kind);
+  key.dtype = static_cast<int64_t>(dtype);
+  key.m = m;
+  key.n = n;
+  key.k = 0;
+  key.lda = ldi;
+  key.ldb = ldi2;
+  key.ldc = ldo;
+  key.op = op;
+  key.flags = flags;
+  return key;
+}
+
+// FNV-1a over the descriptor fields followed by a final avalanche, so that
+// descriptors differing only in a leading dimension land in different slots.
+size_t KernelCache::hash(const KernelKey &key) {
+  const int64_t fields[] = {key.kind, key.dtype, key.m,   key.n,  key.k,
+                            key.lda,  key.ldb,   key.ldc, key.op, key.flags};
+  uint64_t h = 14695981039346656037ULL;
+  for (int64_t field : fields) {
+    h ^= static_cast<uint64_t>(field);
+    h *= 1099511628211ULL;
+  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return static_cast<size_t>(h);
+}
+
+size_t KernelCache::getStripe() {
+  static std::atomic<size_t> nextStripe(0);
+  static thread_local size_t stripe =
+      nextStripe.fetch_add(1, std::memory_order_relaxed) % kNumStripes;
+  return stripe;
+}
+
+bool KernelCache::findKey(int64_t kernel, KernelKey &key) const {
+  for (size_t idx = 0; idx < kNumSlots; idx++) {
+    const Slot &slot = slots[idx];
+    if (slot.state.load(std::memory_order_acquire) != READY)
+      continue;
+    if (slot.kernel == kernel) {
+      key = slot.key;
+      return true;
+    }
+  }
+  return false;
+}
+
+int64_t KernelCache::getNumHits() const {
+  int64_t hits = 0;
+  for (size_t idx = 0; idx < kNumStripes; idx++)
+    hits += stripes[idx].hits.load(std::memory_order_relaxed);
+  return hits;
+}
+
+int64_t KernelCache::getNumMisses() const {
+  int64_t misses = 0;
+  for (size_t idx = 0; idx < kNumStripes; idx++)
+    misses += stripes[idx].misses.load(std::memory_order_relaxed);
+  return misses;
+}
+
+void KernelCache::resetStats() {
+  for (size_t idx = 0; idx < kNumStripes; idx++) {
+    stripes[idx].hits.store(0, std::memory_order_relaxed);
+    stripes[idx].misses.store(0, std::memory_order_relaxed);
+  }
+}
+
+KernelCache &KernelCache::get() { return kernelCache; }
@@ -0,0 +1,178 @@
+//===- XsmmKernelCache.h - Process-wide LIBXSMM kernel cache ----*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares a lock-free, read-mostly cache that maps a kernel
+// descriptor (kind, data type, shapes, leading dimensions and flags) to the
+// JITed LIBXSMM kernel. Entries are never evicted: once a descriptor has been
+// dispatched successfully, every later lookup is a few loads and a key
+// compare. Entities in this file must be compliant with C++11.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TPP_EXECUTIONENGINE_XSMMKERNELCACHE_H
+#define TPP_EXECUTIONENGINE_XSMMKERNELCACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace tpp {
+
+// Kernel families handled by the runtime. The unary/binary operation kind
+// (e.g., relu or identity) is part of the descriptor through `op`.
+enum class KernelKind : int64_t {
+  MATMUL = 0,
+  BRGEMM = 1,
+  UNARY = 2,
+  BINARY = 3,
+  FUSED_BRGEMM = 4,
+  BRGEMM_OFFS = 5,
+  BRGEMM_ADDR = 6,
+  MULADD = 7,
+};
+
+// Data types as seen by the runtime entry points. BF16_F32 denotes bf16
+// inputs with f32 accumulation and output.
+enum class KernelDataType : int64_t {
+  BF16 = 0,
+  F32 = 1,
+  BF16_F32 = 2,
+};
+
+// Descriptor of a dispatched kernel. Fields not used by a given kind must be
+// zero so that equal kernels produce equal keys. For unary and binary kernels
+// `lda`/`ldb` are the input leading dimensions and `ldc` is the output one.
+struct KernelKey {
+  int64_t kind;
+  int64_t dtype;
+  int64_t m;
+  int64_t n;
+  int64_t k;
+  int64_t lda;
+  int64_t ldb;
+  int64_t ldc;
+  int64_t op;
+  int64_t flags;
+
+  bool operator==(const KernelKey &other) const {
+    return kind == other.kind && dtype == other.dtype && m == other.m &&
+           n == other.n && k == other.k && lda == other.lda &&
+           ldb == other.ldb && ldc == other.ldc && op == other.op &&
+           flags == other.flags;
+  }
+  bool operator!=(const KernelKey &other) const { return !(*this == other); }
+};
+
+KernelKey makeGemmKey(KernelKind kind, KernelDataType dtype, int64_t m,
+                      int64_t n, int64_t k, int64_t lda, int64_t ldb,
+                      int64_t ldc, int64_t flags = 0);
+
+KernelKey makeEltwiseKey(KernelKind kind, KernelDataType dtype, int64_t m,
+                         int64_t n, int64_t ldi, int64_t ldi2, int64_t ldo,
+                         int64_t op, int64_t flags);
+
+// Open-addressing hash table with a fixed number of slots. A slot goes
+// EMPTY -> BUSY -> READY exactly once, or back to EMPTY if the dispatch
+// fails; readers only ever observe READY slots with a fully published key and
+// kernel. If the table is full lookups degrade gracefully to a direct
+// dispatch.
+class KernelCache {
+public:
+  // Must be a power of two.
+  static const size_t kNumSlots = 4096;
+
+  // Return the kernel for `key`, calling `dispatch` (returning an int64_t
+  // kernel address) on a miss. Concurrent misses on the same key dispatch
+  // once; the losers wait for the winner to publish the entry. A failed
+  // dispatch (a null kernel) is not cached: the slot is released and the next
+  // lookup of the key dispatches again.
+  template <typename DispatchFn>
+  int64_t lookupOrDispatch(const KernelKey &key, DispatchFn dispatch) {
+    size_t idx = hash(key) & (kNumSlots - 1);
+    for (size_t probe = 0; probe < kNumSlots;
+         probe++, idx = (idx + 1) & (kNumSlots - 1)) {
+      Slot &slot = slots[idx];
+      int state = slot.state.load(std::memory_order_acquire);
+      while (state != READY) {
+        if (state == EMPTY) {
+          int expected = EMPTY;
+          if (slot.state.compare_exchange_strong(expected, BUSY,
+                                                 std::memory_order_acq_rel)) {
+            int64_t kernel = dispatch();
+            countMiss();
+            if (!kernel) {
+              slot.state.store(EMPTY, std::memory_order_release);
+              return kernel;
+            }
+            slot.key = key;
+            slot.kernel = kernel;
+            slot.state.store(READY, std::memory_order_release);
+            return kernel;
+          }
+          state = expected;
+          continue;
+        }
+        // Another thread is JITing into this slot; wait for the publication
+        // (or the release of the slot) before comparing keys.
+        state = slot.state.load(std::memory_order_acquire);
+      }
+      if (slot.key == key) {
+        countHit();
+        return slot.kernel;
+      }
+    }
+    countMiss();
+    return dispatch();
+  }
+
+  // Look up the descriptor of a kernel previously returned by
+  // `lookupOrDispatch`. Linear in the number of slots; not meant for the hot
+  // path.
+  bool findKey(int64_t kernel, KernelKey &key) const;
+
+  int64_t getNumHits() const;
+  int64_t getNumMisses() const;
+  void resetStats();
+
+  // Process-wide instance shared by all the dispatch entry points.
+  static KernelCache &get();
+
+private:
+  enum SlotState { EMPTY = 0, BUSY = 1, READY = 2 };
+
+  struct Slot {
+    std::atomic<int> state;
+    KernelKey key;
+    int64_t kernel;
+  };
+
+  // Counters are striped over cache lines so that threads hitting the cache
+  // concurrently do not bounce a single line.
+  static const size_t kNumStripes = 64;
+  struct alignas(64) Counter {
+    std::atomic<int64_t> hits;
+    std::atomic<int64_t> misses;
+  };
+
+  static size_t hash(const KernelKey &key);
+  static size_t getStripe();
+
+  void countHit() {
+    stripes[getStripe()].hits.fetch_add(1, std::memory_order_relaxed);
+  }
+  void countMiss() {
+    stripes[getStripe()].misses.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  Slot slots[kNumSlots];
+  Counter stripes[kNumStripes];
+};
+
+} // namespace tpp
+
+#endif // TPP_EXECUTIONENGINE_XSMMKERNELCACHE_H
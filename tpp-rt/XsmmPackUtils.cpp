@@ -0,0 +1,171 @@
+//===- XsmmPackUtils.cpp - Block repacking with LIBXSMM -------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "XsmmPackUtils.h"
+#include "XsmmProfiler.h"
+#include "XsmmRunnerUtils.h"
+#include "libxsmm.h" // NOLINT [build/include_subdir]
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace tpp;
+
+static size_t getElementSize(KernelDataType dtype) {
+  return dtype == KernelDataType::F32 ? sizeof(float) : sizeof(bf16);
+}
+
+// Kernels go through the usual dispatch entry points, thus they are JITed
+// once per shape and served from the kernel cache afterwards. Returns null if
+// LIBXSMM cannot generate the kernel on this machine.
+static libxsmm_meltwfunction_unary dispatchUnary(KernelDataType dtype,
+                                                 int64_t rows, int64_t cols,
+                                                 int64_t ldi, int64_t ldo,
+                                                 int64_t type) {
+  int64_t kernel =
+      (dtype == KernelDataType::F32)
+          ? _mlir_ciface_xsmm_unary_dispatch_f32(
+                rows, cols, ldi, ldo, type, LIBXSMM_MELTW_FLAG_UNARY_NONE)
+          : _mlir_ciface_xsmm_unary_dispatch_bf16(
+                rows, cols, ldi, ldo, type, LIBXSMM_MELTW_FLAG_UNARY_NONE);
+  return reinterpret_cast<libxsmm_meltwfunction_unary>(kernel);
+}
+
+// Copy a `rows` x `cols` block between two row-major buffers.
+static void copyBlock(libxsmm_meltwfunction_unary kernel, char *in, char *out,
+                      int64_t rows, int64_t cols, int64_t ldi, int64_t ldo,
+                      size_t elementSize) {
+  if (kernel) {
+    libxsmm_meltw_unary_param param;
+    param.in.primary = (void *)in;
+    param.out.primary = (void *)out;
+    kernel(&param);
+    return;
+  }
+  for (int64_t i = 0; i < rows; i++)
+    memcpy(out + i * ldo * elementSize, in + i * ldi * elementSize,
+           cols * elementSize);
+}
+
+static void copyBlocks(char *flat, char *blocked, int64_t rows, int64_t cols,
+                       int64_t ldFlat, int64_t blockRows, int64_t blockCols,
+                       BlockOrder order, KernelDataType dtype, bool toBlocked) {
+  // Partial blocks are not supported: the rows and columns of the matrix past
+  // the last full block would be left out of the copy.
+  if (blockRows <= 0 || blockCols <= 0 || rows % blockRows != 0 ||
+      cols % blockCols != 0) {
+    fprintf(stderr,
+            "%s: blocks of %" PRId64 "x%" PRId64
+            " do not tile a %" PRId64 "x%" PRId64 " matrix\n",
+            toBlocked ? "pack_blocks" : "unpack_blocks", blockRows, blockCols,
+            rows, cols);
+    abort();
+  }
+  size_t elementSize = getElementSize(dtype);
+  int64_t rowBlocks = rows / blockRows;
+  int64_t colBlocks = cols / blockCols;
+  int64_t blockSize = blockRows * blockCols;
+  int64_t ldi = toBlocked ? ldFlat : blockCols;
+  int64_t ldo = toBlocked ? blockCols : ldFlat;
+  libxsmm_meltwfunction_unary kernel =
+      dispatchUnary(dtype, blockRows, blockCols, ldi, ldo,
+                    LIBXSMM_MELTW_TYPE_UNARY_IDENTITY);
+
+#ifdef _OPENMP
+#pragma omp parallel for collapse(2)
+#endif
+  for (int64_t i = 0; i < rowBlocks; i++) {
+    for (int64_t j = 0; j < colBlocks; j++) {
+      char *flatBlock =
+          flat + (i * blockRows * ldFlat + j * blockCols) * elementSize;
+      int64_t blockIdx =
+          (order == BlockOrder::ROW_MAJOR) ? i * colBlocks + j
+                                           : j * rowBlocks + i;
+      char *packedBlock = blocked + blockIdx * blockSize * elementSize;
+      if (toBlocked)
+        copyBlock(kernel, flatBlock, packedBlock, blockRows, blockCols, ldi,
+                  ldo, elementSize);
+      else
+        copyBlock(kernel, packedBlock, flatBlock, blockRows, blockCols, ldi,
+                  ldo, elementSize);
+    }
+  }
+}
+
+void tpp::packBlocks(void *flat, void *blocked, int64_t rows, int64_t cols,
+                     int64_t ldFlat, int64_t blockRows, int64_t blockCols,
+                     BlockOrder order, KernelDataType dtype) {
+  traceCall("pack_blocks", [&]() {
+    copyBlocks(static_cast<char *>(flat), static_cast<char *>(blocked), rows,
+               cols, ldFlat, blockRows, blockCols, order, dtype,
+               /*toBlocked=*/true);
+  });
+}
+
+void tpp::unpackBlocks(void *blocked, void *flat, int64_t rows, int64_t cols,
+                       int64_t ldFlat, int64_t blockRows, int64_t blockCols,
+                       BlockOrder order, KernelDataType dtype) {
+  traceCall("unpack_blocks", [&]() {
+    copyBlocks(static_cast<char *>(flat), static_cast<char *>(blocked), rows,
+               cols, ldFlat, blockRows, blockCols, order, dtype,
+               /*toBlocked=*/false);
+  });
+}
+
+// Largest even number of rows, up to 64, that divides `rows`. The rows of a
+// matrix are split in chunks of this size to expose parallelism when the
+// batch is small.
+static int64_t getVNNIRowChunk(int64_t rows) {
+  for (int64_t chunk = 64; chunk > 2; chunk -= 2)
+    if (rows % chunk == 0)
+      return chunk;
+  return 2;
+}
+
+static void packVNNIImpl(void *src, void *dst, int64_t batch,
+                        int64_t srcBatchStride, int64_t rows, int64_t cols,
+                        int64_t ldSrc) {
+  bf16 *in = static_cast<bf16 *>(src);
+  bf16 *out = static_cast<bf16 *>(dst);
+  int64_t chunk = getVNNIRowChunk(rows);
+  int64_t numChunks = rows / chunk;
+  libxsmm_meltwfunction_unary kernel =
+      dispatchUnary(KernelDataType::BF16, chunk, cols, ldSrc, cols,
+                    LIBXSMM_MELTW_TYPE_UNARY_TRANSFORM_NORM_TO_VNNI2);
+
+#ifdef _OPENMP
+#pragma omp parallel for collapse(2)
+#endif
+  for (int64_t b = 0; b < batch; b++) {
+    for (int64_t c = 0; c < numChunks; c++) {
+      // Row r of the input lands at row r / 2 of the output, which is
+      // 2 * cols elements wide: a chunk starts at offset r * cols.
+      bf16 *inChunk = in + b * srcBatchStride + c * chunk * ldSrc;
+      bf16 *outChunk = out + b * rows * cols + c * chunk * cols;
+      if (kernel) {
+        libxsmm_meltw_unary_param param;
+        param.in.primary = (void *)inChunk;
+        param.out.primary = (void *)outChunk;
+        kernel(&param);
+        continue;
+      }
+      for (int64_t r = 0; r < chunk; r++)
+        for (int64_t j = 0; j < cols; j++)
+          outChunk[(r / 2) * cols * 2 + j * 2 + r % 2] = inChunk[r * ldSrc + j];
+    }
+  }
+}
+
+void tpp::packVNNI(void *src, void *dst, int64_t batch, int64_t srcBatchStride,
+                   int64_t rows, int64_t cols, int64_t ldSrc) {
+  traceCall("pack_vnni", [&]() {
+    packVNNIImpl(src, dst, batch, srcBatchStride, rows, cols, ldSrc);
+  });
+}
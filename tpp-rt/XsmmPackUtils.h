@@ -0,0 +1,56 @@
+//===- XsmmPackUtils.h - Block repacking with LIBXSMM -----------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the repacking engine used to move matrices in and out of
+// the blocked layouts consumed by the BRGEMM kernels (NC <-> NCnc, KC <-> CKkc)
+// and to the bf16 VNNI layout. Every block is copied by a LIBXSMM identity or
+// transform kernel and the outer block loops are split across threads.
+// Entities in this file must be compliant with C++11.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TPP_EXECUTIONENGINE_XSMMPACKUTILS_H
+#define TPP_EXECUTIONENGINE_XSMMPACKUTILS_H
+
+#include "XsmmKernelCache.h"
+
+#include <cstdint>
+
+namespace tpp {
+
+// Order of the blocks in the blocked buffer. For a `rows` x `cols` matrix with
+// `blockRows` x `blockCols` blocks, ROW_MAJOR is NCnc (the block at row-block i
+// and column-block j is at [i][j]) and COL_MAJOR is CKkc (it is at [j][i]).
+// Each block is stored contiguously in row-major order.
+enum class BlockOrder {
+  ROW_MAJOR = 0,
+  COL_MAJOR = 1,
+};
+
+// Copy the row-major matrix `flat`, with leading dimension `ldFlat`, into the
+// contiguous blocked buffer `blocked`. The block sizes must divide the matrix
+// sizes, otherwise the process aborts.
+void packBlocks(void *flat, void *blocked, int64_t rows, int64_t cols,
+                int64_t ldFlat, int64_t blockRows, int64_t blockCols,
+                BlockOrder order, KernelDataType dtype);
+
+// Inverse of `packBlocks`.
+void unpackBlocks(void *blocked, void *flat, int64_t rows, int64_t cols,
+                  int64_t ldFlat, int64_t blockRows, int64_t blockCols,
+                  BlockOrder order, KernelDataType dtype);
+
+// Repack `batch` bf16 row-major matrices of `rows` x `cols` elements into the
+// VNNI layout [rows / 2][cols][2]. Input matrices are `srcBatchStride`
+// elements apart and have leading dimension `ldSrc`; output matrices are
+// contiguous. `rows` must be even.
+void packVNNI(void *src, void *dst, int64_t batch, int64_t srcBatchStride,
+              int64_t rows, int64_t cols, int64_t ldSrc);
+
+} // namespace tpp
+
+#endif // TPP_EXECUTIONENGINE_XSMMPACKUTILS_H
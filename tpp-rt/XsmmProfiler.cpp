@@ -0,0 +1,449 @@
+//===- XsmmProfiler.cpp - LIBXSMM kernel profiling and tracing ------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "XsmmProfiler.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+
+using namespace tpp;
+
+const char *const tpp::kProfileEnvVar = "TPP_XSMM_PROFILE";
+const char *const tpp::kTraceEnvVar = "TPP_XSMM_TRACE";
+const char *const tpp::kTraceEventsEnvVar = "TPP_XSMM_TRACE_EVENTS";
+
+std::atomic<unsigned> tpp::enabledInstrumentation(0);
+
+void tpp::setInstrumentationEnabled(Instrumentation kind, bool enable) {
+  if (enable)
+    enabledInstrumentation.fetch_or(static_cast<unsigned>(kind),
+                                    std::memory_order_relaxed);
+  else
+    enabledInstrumentation.fetch_and(~static_cast<unsigned>(kind),
+                                     std::memory_order_relaxed);
+}
+
+// Zero-initialized: all the slots start unclaimed with zero counters.
+static KernelProfiler kernelProfiler;
+
+static KernelTracer kernelTracer;
+
+// Path of the trace written at exit.
+static std::string tracePath;
+
+static void printProfileAtExit() {
+  KernelProfiler::get().print(stderr);
+}
+
+static void writeTraceAtExit() {
+  if (!KernelTracer::get().write(tracePath.c_str()))
+    fprintf(stderr, "cannot write the kernel trace to '%s'\n",
+            tracePath.c_str());
+}
+
+// Read the environment once, before any kernel can be invoked.
+namespace {
+struct InstrumentationInit {
+  InstrumentationInit() {
+    const char *profile = std::getenv(kProfileEnvVar);
+    if (profile && *profile && std::strcmp(profile, "0") != 0) {
+      KernelProfiler::setEnabled(true);
+      std::atexit(printProfileAtExit);
+    }
+    const char *trace = std::getenv(kTraceEnvVar);
+    if (trace && *trace) {
+      if (const char *events = std::getenv(kTraceEventsEnvVar)) {
+        long long numEvents = std::atoll(events);
+        if (numEvents > 0)
+          KernelTracer::get().setCapacity(static_cast<size_t>(numEvents));
+      }
+      tracePath = trace;
+      KernelTracer::setEnabled(true);
+      std::atexit(writeTraceAtExit);
+    }
+  }
+};
+} // namespace
+
+static InstrumentationInit instrumentationInit;
+
+static const char *getKindName(int64_t kind) {
+  switch (static_cast<KernelKind>(kind)) {
+  case KernelKind::MATMUL:
+    return "matmul";
+  case KernelKind::BRGEMM:
+    return "brgemm";
+  case KernelKind::UNARY:
+    return "unary";
+  case KernelKind::BINARY:
+    return "binary";
+  case KernelKind::FUSED_BRGEMM:
+    return "fused_brgemm";
+  case KernelKind::BRGEMM_OFFS:
+    return "brgemm_offs";
+  case KernelKind::BRGEMM_ADDR:
+    return "brgemm_addr";
+  case KernelKind::MULADD:
+    return "muladd";
+  }
+  return "unknown";
+}
+
+static const char *getDataTypeName(int64_t dtype) {
+  switch (static_cast<KernelDataType>(dtype)) {
+  case KernelDataType::BF16:
+    return "bf16";
+  case KernelDataType::F32:
+    return "f32";
+  case KernelDataType::BF16_F32:
+    return "bf16_f32";
+  }
+  return "unknown";
+}
+
+static double getInputElementSize(int64_t dtype) {
+  return static_cast<KernelDataType>(dtype) == KernelDataType::F32 ? 4.0 : 2.0;
+}
+
+static double getOutputElementSize(int64_t dtype) {
+  return static_cast<KernelDataType>(dtype) == KernelDataType::BF16 ? 2.0 : 4.0;
+}
+
+static bool isGemm(int64_t kind) {
+  KernelKind kernelKind = static_cast<KernelKind>(kind);
+  return kernelKind == KernelKind::MATMUL || kernelKind == KernelKind::BRGEMM ||
+         kernelKind == KernelKind::FUSED_BRGEMM ||
+         kernelKind == KernelKind::BRGEMM_OFFS ||
+         kernelKind == KernelKind::BRGEMM_ADDR;
+}
+
+double KernelProfile::getFlops() const {
+  if (!hasKey)
+    return 0.0;
+  if (static_cast<KernelKind>(key.kind) == KernelKind::MULADD)
+    return 2.0 * key.m * key.n * calls;
+  if (!isGemm(key.kind))
+    return 0.0;
+  return 2.0 * key.m * key.n * key.k * batches;
+}
+
+// Every operand is assumed to be touched once per call: A and B blocks once
+// per batch, C read and written once.
+double KernelProfile::getBytes() const {
+  if (!hasKey)
+    return 0.0;
+  double inSize = getInputElementSize(key.dtype);
+  double outSize = getOutputElementSize(key.dtype);
+  double mn = static_cast<double>(key.m) * key.n;
+  if (isGemm(key.kind)) {
+    double inputs = (static_cast<double>(key.m) * key.k +
+                     static_cast<double>(key.k) * key.n) *
+                    inSize * batches;
+    return inputs + 2.0 * mn * outSize * calls;
+  }
+  if (static_cast<KernelKind>(key.kind) == KernelKind::BINARY)
+    return 3.0 * mn * inSize * calls;
+  // A broadcast B (ldb = 0) is a single row.
+  if (static_cast<KernelKind>(key.kind) == KernelKind::MULADD) {
+    double b = key.ldb == 0 ? static_cast<double>(key.n) : mn;
+    return (3.0 * mn + b) * inSize * calls;
+  }
+  return mn * (inSize + outSize) * calls;
+}
+
+size_t KernelProfiler::hash(int64_t kernel) {
+  uint64_t h = static_cast<uint64_t>(kernel);
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return static_cast<size_t>(h);
+}
+
+void KernelProfiler::record(int64_t kernel, int64_t numBatches,
+                            int64_t nanoseconds) {
+  // A zero minimum means "no call yet".
+  if (nanoseconds < 1)
+    nanoseconds = 1;
+  size_t idx = hash(kernel) & (kNumSlots - 1);
+  for (size_t probe = 0; probe < kNumSlots;
+       probe++, idx = (idx + 1) & (kNumSlots - 1)) {
+    Slot &slot = slots[idx];
+    int64_t owner = slot.kernel.load(std::memory_order_relaxed);
+    // On failure `owner` is the kernel that claimed the slot first.
+    if (owner == 0 && slot.kernel.compare_exchange_strong(
+                          owner, kernel, std::memory_order_relaxed))
+      owner = kernel;
+    if (owner != kernel)
+      continue;
+    slot.calls.fetch_add(1, std::memory_order_relaxed);
+    slot.batches.fetch_add(numBatches, std::memory_order_relaxed);
+    slot.totalNs.fetch_add(nanoseconds, std::memory_order_relaxed);
+    int64_t current = slot.minNs.load(std::memory_order_relaxed);
+    while ((current == 0 || nanoseconds < current) &&
+           !slot.minNs.compare_exchange_weak(current, nanoseconds,
+                                             std::memory_order_relaxed))
+      ;
+    current = slot.maxNs.load(std::memory_order_relaxed);
+    while (nanoseconds > current &&
+           !slot.maxNs.compare_exchange_weak(current, nanoseconds,
+                                             std::memory_order_relaxed))
+      ;
+    return;
+  }
+}
+
+std::vector<KernelProfile> KernelProfiler::collect() const {
+  std::vector<KernelProfile> profiles;
+  for (size_t idx = 0; idx < kNumSlots; idx++) {
+    const Slot &slot = slots[idx];
+    int64_t kernel = slot.kernel.load(std::memory_order_relaxed);
+    int64_t calls = slot.calls.load(std::memory_order_relaxed);
+    if (kernel == 0 || calls == 0)
+      continue;
+    KernelProfile profile;
+    std::memset(&profile.key, 0, sizeof(profile.key));
+    profile.hasKey = KernelCache::get().findKey(kernel, profile.key);
+    profile.kernel = kernel;
+    profile.calls = calls;
+    profile.batches = slot.batches.load(std::memory_order_relaxed);
+    profile.totalNs = slot.totalNs.load(std::memory_order_relaxed);
+    profile.minNs = slot.minNs.load(std::memory_order_relaxed);
+    profile.maxNs = slot.maxNs.load(std::memory_order_relaxed);
+    profiles.push_back(profile);
+  }
+  std::sort(profiles.begin(), profiles.end(),
+            [](const KernelProfile &lhs, const KernelProfile &rhs) {
+              return lhs.totalNs > rhs.totalNs;
+            });
+  return profiles;
+}
+
+void KernelProfiler::print(FILE *out) const {
+  std::vector<KernelProfile> profiles = collect();
+  if (profiles.empty())
+    return;
+  int64_t totalNs = 0;
+  for (const KernelProfile &profile : profiles)
+    totalNs += profile.totalNs;
+
+  fprintf(out, "TPP XSMM kernel profile: %zu kernels, %.3f ms\n",
+          profiles.size(), totalNs * 1e-6);
+  fprintf(out,
+          "%-12s %-8s %6s %6s %6s %6s %6s %6s %4s %10s %10s %6s %10s %10s "
+          "%10s %9s %9s\n",
+          "kind", "dtype", "m", "n", "k", "lda", "ldb", "ldc", "op", "calls",
+          "total(ms)", "%", "avg(us)", "min(us)", "max(us)", "GFLOPS", "GB/s");
+  for (const KernelProfile &profile : profiles) {
+    const KernelKey &key = profile.key;
+    double seconds = profile.totalNs * 1e-9;
+    double flops = profile.getFlops();
+    double bytes = profile.getBytes();
+    if (profile.hasKey)
+      fprintf(out,
+              "%-12s %-8s %6" PRId64 " %6" PRId64 " %6" PRId64 " %6" PRId64
+              " %6" PRId64 " %6" PRId64 " %4" PRId64,
+              getKindName(key.kind), getDataTypeName(key.dtype), key.m, key.n,
+              key.k, key.lda, key.ldb, key.ldc, key.op);
+    else
+      fprintf(out, "%-12s 0x%-53" PRIx64, "unknown",
+              static_cast<uint64_t>(profile.kernel));
+    fprintf(out, " %10" PRId64 " %10.3f %6.2f %10.3f %10.3f %10.3f",
+            profile.calls, seconds * 1e3,
+            totalNs ? 100.0 * profile.totalNs / totalNs : 0.0,
+            profile.totalNs * 1e-3 / profile.calls, profile.minNs * 1e-3,
+            profile.maxNs * 1e-3);
+    if (flops > 0.0)
+      fprintf(out, " %9.2f", flops / seconds * 1e-9);
+    else
+      fprintf(out, " %9s", "-");
+    if (bytes > 0.0)
+      fprintf(out, " %9.2f\n", bytes / seconds * 1e-9);
+    else
+      fprintf(out, " %9s\n", "-");
+  }
+}
+
+void KernelProfiler::reset() {
+  for (size_t idx = 0; idx < kNumSlots; idx++) {
+    Slot &slot = slots[idx];
+    slot.calls.store(0, std::memory_order_relaxed);
+    slot.batches.store(0, std::memory_order_relaxed);
+    slot.totalNs.store(0, std::memory_order_relaxed);
+    slot.minNs.store(0, std::memory_order_relaxed);
+    slot.maxNs.store(0, std::memory_order_relaxed);
+  }
+}
+
+KernelProfiler &KernelProfiler::get() { return kernelProfiler; }
+
+// Site of the next kernel invocation of the thread, set by the compiled code.
+static thread_local int64_t currentSiteId = -1;
+static thread_local const char *currentSite = nullptr;
+
+// Buffer of the thread, created on its first event.
+static thread_local void *currentBuffer = nullptr;
+
+void KernelTracer::setSite(int64_t siteId, const char *location) {
+  currentSiteId = siteId;
+  currentSite = location;
+}
+
+void KernelTracer::setCapacity(size_t numEvents) {
+  std::lock_guard<std::mutex> lock(mutex);
+  capacity = numEvents;
+}
+
+KernelTracer::ThreadBuffer &KernelTracer::getThreadBuffer() {
+  if (currentBuffer)
+    return *static_cast<ThreadBuffer *>(currentBuffer);
+  std::lock_guard<std::mutex> lock(mutex);
+  ThreadBuffer *buffer = new ThreadBuffer();
+  buffer->events.resize(capacity);
+  buffer->next = 0;
+  buffer->wrapped = false;
+  buffer->threadId = static_cast<int64_t>(buffers.size());
+  buffers.push_back(buffer);
+  currentBuffer = buffer;
+  return *buffer;
+}
+
+void KernelTracer::append(const TraceEvent &event) {
+  ThreadBuffer &buffer = getThreadBuffer();
+  if (buffer.events.empty())
+    return;
+  buffer.events[buffer.next] = event;
+  if (++buffer.next == buffer.events.size()) {
+    buffer.next = 0;
+    buffer.wrapped = true;
+  }
+}
+
+void KernelTracer::recordKernel(int64_t kernel, int64_t startNs,
+                                int64_t endNs) {
+  TraceEvent event = {nullptr,       kernel, currentSite,
+                      currentSiteId, startNs, endNs};
+  currentSiteId = -1;
+  currentSite = nullptr;
+  append(event);
+}
+
+void KernelTracer::recordCall(const char *name, int64_t startNs,
+                              int64_t endNs) {
+  TraceEvent event = {name, 0, nullptr, -1, startNs, endNs};
+  append(event);
+}
+
+// Name a kernel after its descriptor, e.g., "brgemm f32 32x32x32".
+static std::string getKernelName(int64_t kernel) {
+  KernelKey key;
+  if (!KernelCache::get().findKey(kernel, key))
+    return "unknown";
+  char name[128];
+  if (isGemm(key.kind))
+    snprintf(name, sizeof(name), "%s %s %" PRId64 "x%" PRId64 "x%" PRId64,
+             getKindName(key.kind), getDataTypeName(key.dtype), key.m, key.n,
+             key.k);
+  else
+    snprintf(name, sizeof(name), "%s %s %" PRId64 "x%" PRId64 " op %" PRId64,
+             getKindName(key.kind), getDataTypeName(key.dtype), key.m, key.n,
+             key.op);
+  return name;
+}
+
+static void writeJSONString(FILE *out, const char *str) {
+  fputc('"', out);
+  for (; *str; str++) {
+    unsigned char c = static_cast<unsigned char>(*str);
+    if (c == '"' || c == '\\')
+      fprintf(out, "\\%c", c);
+    else if (c < 0x20)
+      fprintf(out, "\\u%04x", c);
+    else
+      fputc(c, out);
+  }
+  fputc('"', out);
+}
+
+bool KernelTracer::write(const char *path) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  FILE *out = fopen(path, "w");
+  if (!out)
+    return false;
+
+  // Timestamps are relative to the first recorded event.
+  int64_t origin = INT64_MAX;
+  for (const ThreadBuffer *buffer : buffers) {
+    size_t numEvents = buffer->wrapped ? buffer->events.size() : buffer->next;
+    for (size_t idx = 0; idx < numEvents; idx++)
+      origin = std::min(origin, buffer->events[idx].startNs);
+  }
+
+  std::map<int64_t, std::string> kernelNames;
+  bool first = true;
+  fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+  for (const ThreadBuffer *buffer : buffers) {
+    fprintf(out,
+            "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,"
+            "\"tid\":%" PRId64 ",\"args\":{\"name\":\"thread %" PRId64
+            "\"}}",
+            first ? "" : ",", buffer->threadId, buffer->threadId);
+    first = false;
+    // Oldest event first.
+    size_t numEvents = buffer->wrapped ? buffer->events.size() : buffer->next;
+    size_t begin = buffer->wrapped ? buffer->next : 0;
+    for (size_t count = 0; count < numEvents; count++) {
+      const TraceEvent &event =
+          buffer->events[(begin + count) % buffer->events.size()];
+      fprintf(out, ",\n{\"name\":");
+      if (event.name) {
+        writeJSONString(out, event.name);
+        fprintf(out, ",\"cat\":\"runtime\"");
+      } else {
+        auto it = kernelNames.find(event.kernel);
+        if (it == kernelNames.end())
+          it = kernelNames
+                   .insert(std::make_pair(event.kernel,
+                                          getKernelName(event.kernel)))
+                   .first;
+        writeJSONString(out, it->second.c_str());
+        fprintf(out, ",\"cat\":\"kernel\"");
+      }
+      fprintf(out,
+              ",\"ph\":\"X\",\"pid\":0,\"tid\":%" PRId64
+              ",\"ts\":%.3f,\"dur\":%.3f",
+              buffer->threadId, (event.startNs - origin) * 1e-3,
+              (event.endNs - event.startNs) * 1e-3);
+      if (!event.name) {
+        fprintf(out, ",\"args\":{\"kernel\":\"0x%" PRIx64 "\"",
+                static_cast<uint64_t>(event.kernel));
+        if (event.site) {
+          fprintf(out, ",\"site\":%" PRId64 ",\"loc\":", event.siteId);
+          writeJSONString(out, event.site);
+        }
+        fprintf(out, "}");
+      }
+      fprintf(out, "}");
+    }
+  }
+  fprintf(out, "\n]}\n");
+  return fclose(out) == 0;
+}
+
+void KernelTracer::reset() {
+  std::lock_guard<std::mutex> lock(mutex);
+  for (ThreadBuffer *buffer : buffers) {
+    buffer->next = 0;
+    buffer->wrapped = false;
+  }
+}
+
+KernelTracer &KernelTracer::get() { return kernelTracer; }
@@ -0,0 +1,236 @@
+//===- XsmmProfiler.h - LIBXSMM kernel profiling and tracing ----*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the opt-in instrumentation of the JITed LIBXSMM kernels.
+//
+// When TPP_XSMM_PROFILE is set to a non-zero value, every kernel invocation is
+// timed and accounted to the kernel address; the descriptor of the kernel is
+// recovered from the kernel cache when the table is read. The table is printed
+// to stderr, sorted by total time, at process exit.
+//
+// When TPP_XSMM_TRACE names a file, every kernel invocation and every block
+// repacking is appended to a per-thread ring buffer, which is written to that
+// file as a Chrome trace (chrome://tracing, Perfetto) at process exit.
+//
+// Entities in this file must be compliant with C++11.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TPP_EXECUTIONENGINE_XSMMPROFILER_H
+#define TPP_EXECUTIONENGINE_XSMMPROFILER_H
+
+#include "XsmmKernelCache.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+namespace tpp {
+
+// Environment variable enabling the profiler.
+extern const char *const kProfileEnvVar;
+// Environment variable naming the trace file, which enables the tracer.
+extern const char *const kTraceEnvVar;
+// Environment variable setting the number of events kept per thread.
+extern const char *const kTraceEventsEnvVar;
+
+// Instrumentation switched on in the runtime. The enabled kinds are kept in a
+// single word so that the invocation path tests all of them with one branch.
+enum class Instrumentation : unsigned {
+  PROFILE = 1,
+  TRACE = 2,
+};
+
+extern std::atomic<unsigned> enabledInstrumentation;
+
+inline bool isInstrumentationEnabled(Instrumentation kind) {
+  return enabledInstrumentation.load(std::memory_order_relaxed) &
+         static_cast<unsigned>(kind);
+}
+
+void setInstrumentationEnabled(Instrumentation kind, bool enable);
+
+// Monotonic time in nanoseconds.
+inline int64_t getTimeNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Counters of one kernel. `batches` is the sum of the batch-reduce counts of
+// all the calls (one per call for non-batched kernels).
+struct KernelProfile {
+  KernelKey key;
+  bool hasKey;
+  int64_t kernel;
+  int64_t calls;
+  int64_t batches;
+  int64_t totalNs;
+  int64_t minNs;
+  int64_t maxNs;
+
+  // Floating-point operations and bytes moved over all the calls, estimated
+  // from the descriptor. Zero if the descriptor is unknown; no flops are
+  // counted for element-wise kernels.
+  double getFlops() const;
+  double getBytes() const;
+};
+
+// Fixed-size, lock-free table of counters keyed by kernel address. A slot is
+// claimed once by a compare-and-swap on its kernel address and never released.
+// Invocations of kernels that do not fit are not recorded.
+class KernelProfiler {
+public:
+  // Must be a power of two.
+  static const size_t kNumSlots = 4096;
+
+  static bool isEnabled() {
+    return isInstrumentationEnabled(Instrumentation::PROFILE);
+  }
+  static void setEnabled(bool enable) {
+    setInstrumentationEnabled(Instrumentation::PROFILE, enable);
+  }
+
+  // Account a call of `kernel` reducing over `numBatches` blocks and taking
+  // `nanoseconds`.
+  void record(int64_t kernel, int64_t numBatches, int64_t nanoseconds);
+
+  // Snapshot of the counters, sorted by decreasing total time.
+  std::vector<KernelProfile> collect() const;
+
+  // Print the sorted table to `out`.
+  void print(FILE *out) const;
+
+  // Drop all the counters.
+  void reset();
+
+  // Process-wide instance shared by all the invoke entry points.
+  static KernelProfiler &get();
+
+private:
+  // Claimed slots are never reset to zero, so `reset` does not race with a
+  // concurrent `record` claiming the same slot.
+  struct alignas(64) Slot {
+    std::atomic<int64_t> kernel;
+    std::atomic<int64_t> calls;
+    std::atomic<int64_t> batches;
+    std::atomic<int64_t> totalNs;
+    std::atomic<int64_t> minNs;
+    std::atomic<int64_t> maxNs;
+  };
+
+  static size_t hash(int64_t kernel);
+
+  Slot slots[kNumSlots];
+};
+
+// One timed call. Kernel invocations have a null `name`, other calls (e.g.,
+// block repacking) have a zero `kernel`. `site` is the source location of the
+// invocation, if the compiler emitted one, and `siteId` its index (-1 if
+// none).
+struct TraceEvent {
+  const char *name;
+  int64_t kernel;
+  const char *site;
+  int64_t siteId;
+  int64_t startNs;
+  int64_t endNs;
+};
+
+// Per-thread ring buffers of trace events. Each thread appends to its own
+// buffer without synchronization; buffers are registered once per thread and
+// live until process exit. When a buffer is full the oldest events are
+// overwritten.
+class KernelTracer {
+public:
+  static bool isEnabled() {
+    return isInstrumentationEnabled(Instrumentation::TRACE);
+  }
+  static void setEnabled(bool enable) {
+    setInstrumentationEnabled(Instrumentation::TRACE, enable);
+  }
+
+  // Label the next kernel invocation of the calling thread with a source
+  // location. `location` must outlive the tracer.
+  static void setSite(int64_t siteId, const char *location);
+
+  // Number of events kept per thread, for buffers created after the call.
+  void setCapacity(size_t numEvents);
+
+  // Record an invocation of `kernel`, consuming the site of the thread.
+  void recordKernel(int64_t kernel, int64_t startNs, int64_t endNs);
+
+  // Record a call of the runtime named `name`.
+  void recordCall(const char *name, int64_t startNs, int64_t endNs);
+
+  // Write all the buffers to `path` as a Chrome trace. Kernels are named
+  // after their descriptor. Must not run concurrently with kernel invocations.
+  bool write(const char *path) const;
+
+  // Drop all the recorded events. Must not run concurrently with kernel
+  // invocations.
+  void reset();
+
+  // Process-wide instance shared by all the invoke entry points.
+  static KernelTracer &get();
+
+private:
+  struct ThreadBuffer {
+    std::vector<TraceEvent> events;
+    size_t next;
+    bool wrapped;
+    int64_t threadId;
+  };
+
+  ThreadBuffer &getThreadBuffer();
+  void append(const TraceEvent &event);
+
+  mutable std::mutex mutex;
+  std::vector<ThreadBuffer *> buffers;
+  size_t capacity = 1 << 16;
+};
+
+// Run `invoke`, the call of `kernel` reducing over `numBatches` blocks, and
+// time it for the enabled instrumentation. The only cost when instrumentation
+// is disabled is one predictable branch.
+template <typename InvokeFn>
+inline void profileKernel(int64_t kernel, int64_t numBatches,
+                          InvokeFn invoke) {
+  unsigned enabled = enabledInstrumentation.load(std::memory_order_relaxed);
+  if (__builtin_expect(enabled != 0, 0)) {
+    int64_t start = getTimeNs();
+    invoke();
+    int64_t end = getTimeNs();
+    if (enabled & static_cast<unsigned>(Instrumentation::PROFILE))
+      KernelProfiler::get().record(kernel, numBatches, end - start);
+    if (enabled & static_cast<unsigned>(Instrumentation::TRACE))
+      KernelTracer::get().recordKernel(kernel, start, end);
+    return;
+  }
+  invoke();
+}
+
+// Run `call`, a runtime call named `name` that is not a kernel invocation,
+// recording it in the trace when tracing is enabled.
+template <typename CallFn>
+inline void traceCall(const char *name, CallFn call) {
+  if (__builtin_expect(KernelTracer::isEnabled(), 0)) {
+    int64_t start = getTimeNs();
+    call();
+    KernelTracer::get().recordCall(name, start, getTimeNs());
+    return;
+  }
+  call();
+}
+
+} // namespace tpp
+
+#endif // TPP_EXECUTIONENGINE_XSMMPROFILER_H
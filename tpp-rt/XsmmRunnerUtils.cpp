@@ -13,46 +13,31 @@
 //===----------------------------------------------------------------------===//
 
 #include "XsmmRunnerUtils.h"
+#include "XsmmKernelCache.h"
+#include "XsmmPackUtils.h"
+#include "XsmmProfiler.h"
 #include "libxsmm.h" // NOLINT [build/include_subdir]
 
-extern "C" void _mlir_ciface_xsmm_matmul_invoke_f32(
-    int64_t funcAddr, UnrankedMemRefType<float> *A,
-    UnrankedMemRefType<float> *B, UnrankedMemRefType<float> *C) {
+#include <cstring>
+#include <vector>
+
+//----------------------------------------------------------------------------//
+// Kernel invocation. The templates are shared by the unranked memref ABI
+// (`_mlir_ciface_xxx`) and the bare-pointer ABI, which only differ in how the
+// operand addresses are obtained. Every kernel call goes through
+// `profileKernel`, which times it when TPP_XSMM_PROFILE or TPP_XSMM_TRACE is
+// set.
+//----------------------------------------------------------------------------//
 
-  //   std::cout << "matrix A: \n";
-  //   printMemRefMetaData(std::cout, DynamicMemRefType<float>(*A));
-  //    std::cout << "\n";
-  //   std::cout << "matrix B: \n";
-  //   printMemRefMetaData(std::cout, DynamicMemRefType<float>(*B));
-  //   std::cout << "\n";
-  //   std::cout << "matrix C: \n";
-  //   printMemRefMetaData(std::cout, DynamicMemRefType<float>(*C));
-  //   std::cout << "\n";
-  //   std::cout << "funcAddr: " << funcAddr << "\n";
-
-  DynamicMemRefType<float> matrixA = DynamicMemRefType<float>(*A);
-  DynamicMemRefType<float> matrixB = DynamicMemRefType<float>(*B);
-  DynamicMemRefType<float> matrixC = DynamicMemRefType<float>(*C);
-
-  float *addr_a = matrixA.data + matrixA.offset;
-  float *addr_b = matrixB.data + matrixB.offset;
-  float *addr_c = matrixC.data + matrixC.offset;
-
-  //    int64_t M = matrixC.sizes[0];
-  //    int64_t N = matrixC.sizes[1];
-  //    int64_t K = matrixA.sizes[1];
-  //
-  //    for (int i = 0; i < M; i++) {
-  //      for (int j = 0; j < N; j++) {
-  //        for (int k = 0; k < K; k++) {
-  //          float *curr_addr_a = i * matrixA.strides[0] + addr_a + k;
-  //          float *curr_addr_b = k * matrixB.strides[0] + addr_b + j;
-  //          float *curr_addr_c = i * matrixC.strides[0] + addr_c + j;
-  //          *curr_addr_c += (*curr_addr_a) * (*curr_addr_b);
-  //        }
-  //      }
-  //    }
+template <typename T>
+static T *getAlignedAddress(UnrankedMemRefType<T> *memref) {
+  DynamicMemRefType<T> tensor = DynamicMemRefType<T>(*memref);
+  return tensor.data + tensor.offset;
+}
 
+template <typename TIn, typename TOut>
+static void xsmm_matmul_invoke_impl(int64_t funcAddr, TIn *addr_a,
+                                    TIn *addr_b, TOut *addr_c) {
   libxsmm_xmmfunction sgemm;
   libxsmm_gemm_param gemm_param;
   // LIBXSMM col-major change A with B.
@@ -60,61 +45,162 @@ extern "C" void _mlir_ciface_xsmm_matmul_invoke_f32(
   gemm_param.b.primary = (void *)addr_a;
   gemm_param.c.primary = (void *)addr_c;
   sgemm.gemm = reinterpret_cast<libxsmm_gemmfunction>(funcAddr);
-  sgemm.gemm(&gemm_param);
+  tpp::profileKernel(funcAddr, /*numBatches=*/1,
+                     [&]() { sgemm.gemm(&gemm_param); });
 }
 
-extern "C" void _mlir_ciface_xsmm_matmul_invoke_bf16(
-    int64_t funcAddr, UnrankedMemRefType<bf16> *A, UnrankedMemRefType<bf16> *B,
-    UnrankedMemRefType<bf16> *C) {
+template <typename TIn, typename TOut>
+static void xsmm_brgemm_invoke_impl(int64_t addr, TIn *addr_tensorA,
+                                    TIn *addr_tensorB, TOut *addr_tensorC,
+                                    int64_t numBatches) {
+  libxsmm_xmmfunction sgemm;
+  libxsmm_gemm_param gemm_param;
+  sgemm.gemm = reinterpret_cast<libxsmm_gemmfunction>(addr);
+  unsigned long long numBatchesVar = numBatches;
+  gemm_param.a.primary = (void *)addr_tensorB;
+  gemm_param.b.primary = (void *)addr_tensorA;
+  gemm_param.c.primary = (void *)addr_tensorC;
+  gemm_param.op.tertiary = (void *)&numBatchesVar;
+  tpp::profileKernel(addr, numBatches, [&]() { sgemm.gemm(&gemm_param); });
+}
 
-  // std::cout << "matrix A: \n";
-  //    printMemRefMetaData(std::cout, DynamicMemRefType<bf16>(*A));
-  //    std::cout << "\n";
-  //    std::cout << "matrix B: \n";
-  //    printMemRefMetaData(std::cout, DynamicMemRefType<bf16>(*B));
-  //    std::cout << "\n";
-  //    std::cout << "matrix C: \n";
-  //    printMemRefMetaData(std::cout, DynamicMemRefType<bf16>(*C));
-  //    std::cout << "\n";
-  //    std::cout << "funcAddr: " << funcAddr << "\n";
-
-  DynamicMemRefType<bf16> matrixA = DynamicMemRefType<bf16>(*A);
-  DynamicMemRefType<bf16> matrixB = DynamicMemRefType<bf16>(*B);
-  DynamicMemRefType<bf16> matrixC = DynamicMemRefType<bf16>(*C);
-
-  bf16 *addr_a = matrixA.data + matrixA.offset;
-  bf16 *addr_b = matrixB.data + matrixB.offset;
-  bf16 *addr_c = matrixC.data + matrixC.offset;
-
-  //    int64_t M = matrixC.sizes[0];
-  //    int64_t N = matrixC.sizes[1];
-  //    int64_t K = matrixA.sizes[1];
-  //
-  //    for (int i = 0; i < M; i++) {
-  //      for (int j = 0; j < N; j++) {
-  //        for (int k = 0; k < K; k++) {
-  //          float *curr_addr_a = i * matrixA.strides[0] + addr_a + k;
-  //          float *curr_addr_b = k * matrixB.strides[0] + addr_b + j;
-  //          float *curr_addr_c = i * matrixC.strides[0] + addr_c + j;
-  //          *curr_addr_c += (*curr_addr_a) * (*curr_addr_b);
-  //        }
-  //      }
-  //    }
+// C = relu(bias + sum_i(A_i * B_i)). As for the plain BRGEMM, LIBXSMM sees the
+// column-major problem: the row-major bias along n becomes a column vector
+// along LIBXSMM's m, broadcast over the columns.
+template <typename T>
+static void xsmm_fused_brgemm_invoke_impl(int64_t addr, T *addr_tensorA,
+                                          T *addr_tensorB, T *addr_tensorBias,
+                                          T *addr_tensorC,
+                                          int64_t numBatches) {
+  libxsmm_xmmfunction sgemm;
+  libxsmm_gemm_ext_param gemm_param;
+  memset(&gemm_param, 0, sizeof(gemm_param));
+  sgemm.gemm_ext = reinterpret_cast<libxsmm_gemmfunction_ext>(addr);
+  unsigned long long numBatchesVar = numBatches;
+  gemm_param.a.primary = (void *)addr_tensorB;
+  gemm_param.b.primary = (void *)addr_tensorA;
+  gemm_param.c.primary = (void *)addr_tensorC;
+  gemm_param.d.primary = (void *)addr_tensorBias;
+  gemm_param.op.tertiary = (void *)&numBatchesVar;
+  tpp::profileKernel(addr, numBatches,
+                     [&]() { sgemm.gemm_ext(&gemm_param); });
+}
 
+// C += sum_i(A_i * B_i) where A_i (B_i) starts `offsetsA[i]` (`offsetsB[i]`)
+// bytes after A (B). The batch matrices can be anywhere in A and B, e.g., the
+// taps of a convolution filter and the pixels of the image they read.
+template <typename T>
+static void xsmm_brgemm_offs_invoke_impl(int64_t addr, T *addr_tensorA,
+                                         T *addr_tensorB, T *addr_tensorC,
+                                         int64_t *offsetsA, int64_t *offsetsB,
+                                         int64_t numBatches) {
   libxsmm_xmmfunction sgemm;
   libxsmm_gemm_param gemm_param;
-  // LIBXSMM col-major change A with B.
-  gemm_param.a.primary = (void *)addr_b;
-  gemm_param.b.primary = (void *)addr_a;
-  gemm_param.c.primary = (void *)addr_c;
-  sgemm.gemm = reinterpret_cast<libxsmm_gemmfunction>(funcAddr);
-  sgemm.gemm(&gemm_param);
+  sgemm.gemm = reinterpret_cast<libxsmm_gemmfunction>(addr);
+  unsigned long long numBatchesVar = numBatches;
+  // LIBXSMM col-major change A with B, offsets included.
+  gemm_param.a.primary = (void *)addr_tensorB;
+  gemm_param.a.secondary = (void *)offsetsB;
+  gemm_param.b.primary = (void *)addr_tensorA;
+  gemm_param.b.secondary = (void *)offsetsA;
+  gemm_param.c.primary = (void *)addr_tensorC;
+  gemm_param.op.tertiary = (void *)&numBatchesVar;
+  tpp::profileKernel(addr, numBatches, [&]() { sgemm.gemm(&gemm_param); });
 }
 
-extern "C" int64_t _mlir_ciface_xsmm_matmul_dispatch_f32(int64_t m, int64_t n,
-                                                         int64_t k, int64_t lda,
-                                                         int64_t ldb,
-                                                         int64_t ldc) {
+// Same as the offset variant for an address-list kernel: the addresses of the
+// batch matrices are computed from the offsets before the call, in per-thread
+// buffers as kernels run in parallel regions.
+template <typename T>
+static void xsmm_brgemm_addr_invoke_impl(int64_t addr, T *addr_tensorA,
+                                         T *addr_tensorB, T *addr_tensorC,
+                                         int64_t *offsetsA, int64_t *offsetsB,
+                                         int64_t numBatches) {
+  static thread_local std::vector<const void *> addressesA;
+  static thread_local std::vector<const void *> addressesB;
+  addressesA.resize(numBatches);
+  addressesB.resize(numBatches);
+  for (int64_t batch = 0; batch < numBatches; batch++) {
+    addressesA[batch] = (const char *)addr_tensorA + offsetsA[batch];
+    addressesB[batch] = (const char *)addr_tensorB + offsetsB[batch];
+  }
+  libxsmm_xmmfunction sgemm;
+  libxsmm_gemm_param gemm_param;
+  sgemm.gemm = reinterpret_cast<libxsmm_gemmfunction>(addr);
+  unsigned long long numBatchesVar = numBatches;
+  gemm_param.a.primary = (void *)addressesB.data();
+  gemm_param.b.primary = (void *)addressesA.data();
+  gemm_param.c.primary = (void *)addr_tensorC;
+  gemm_param.op.tertiary = (void *)&numBatchesVar;
+  tpp::profileKernel(addr, numBatches, [&]() { sgemm.gemm(&gemm_param); });
+}
+
+template <typename T>
+static void xsmm_unary_invoke_impl(int64_t addr, T *addr_a, T *addr_b) {
+  libxsmm_meltwfunction_unary kernel =
+      reinterpret_cast<libxsmm_meltwfunction_unary>(addr);
+  libxsmm_meltw_unary_param param;
+  param.in.primary = (void *)addr_a;
+  param.out.primary = (void *)addr_b;
+  tpp::profileKernel(addr, /*numBatches=*/1, [&]() { kernel(&param); });
+}
+
+template <typename T>
+static void xsmm_unary_scalar_invoke_impl(int64_t addr, T input,
+                                          T *addr_b) {
+  libxsmm_meltwfunction_unary kernel =
+      reinterpret_cast<libxsmm_meltwfunction_unary>(addr);
+  libxsmm_meltw_unary_param param;
+  param.in.primary = (void *)&input;
+  param.out.primary = (void *)addr_b;
+  tpp::profileKernel(addr, /*numBatches=*/1, [&]() { kernel(&param); });
+}
+
+template <typename T>
+static void xsmm_binary_invoke_impl(int64_t addr, T *addr_tensor_lhs,
+                                    T *addr_tensor_rhs) {
+  libxsmm_meltwfunction_binary kernel =
+      reinterpret_cast<libxsmm_meltwfunction_binary>(addr);
+  libxsmm_meltw_binary_param param;
+  // TODO: check if we need to swap also here.
+  param.in0.primary = (void *)addr_tensor_lhs;
+  param.in1.primary = (void *)addr_tensor_rhs;
+  param.out.primary = (void *)addr_tensor_rhs;
+  tpp::profileKernel(addr, /*numBatches=*/1, [&]() { kernel(&param); });
+}
+
+// C += A * B element-wise. LIBXSMM reads C as the third input and updates it
+// in place.
+template <typename T>
+static void xsmm_muladd_invoke_impl(int64_t addr, T *addr_a, T *addr_b,
+                                    T *addr_c) {
+  libxsmm_meltwfunction_ternary kernel =
+      reinterpret_cast<libxsmm_meltwfunction_ternary>(addr);
+  libxsmm_meltw_ternary_param param;
+  param.in0.primary = (void *)addr_a;
+  param.in1.primary = (void *)addr_b;
+  param.in2.primary = (void *)addr_c;
+  param.out.primary = (void *)addr_c;
+  tpp::profileKernel(addr, /*numBatches=*/1, [&]() { kernel(&param); });
+}
+
+extern "C" void _mlir_ciface_xsmm_matmul_invoke_f32(
+    int64_t funcAddr, UnrankedMemRefType<float> *A,
+    UnrankedMemRefType<float> *B, UnrankedMemRefType<float> *C) {
+  xsmm_matmul_invoke_impl(funcAddr, getAlignedAddress(A),
+                          getAlignedAddress(B), getAlignedAddress(C));
+}
+
+extern "C" void _mlir_ciface_xsmm_matmul_invoke_bf16(
+    int64_t funcAddr, UnrankedMemRefType<bf16> *A, UnrankedMemRefType<bf16> *B,
+    UnrankedMemRefType<bf16> *C) {
+  xsmm_matmul_invoke_impl(funcAddr, getAlignedAddress(A),
+                          getAlignedAddress(B), getAlignedAddress(C));
+}
+
+static int64_t xsmm_matmul_dispatch_f32_impl(int64_t m, int64_t n, int64_t k,
+                                             int64_t lda, int64_t ldb,
+                                             int64_t ldc) {
   // std::cout << "lda: " << lda << "\n";
   // std::cout << "ldb: " << ldb << "\n";
   // std::cout << "ldc: " << ldc << "\n";
@@ -149,9 +235,9 @@ extern "C" int64_t _mlir_ciface_xsmm_matmul_dispatch_f32(int64_t m, int64_t n,
   return reinterpret_cast<int64_t>(sgemm);
 }
 
-extern "C" int64_t
-_mlir_ciface_xsmm_matmul_dispatch_bf16(int64_t m, int64_t n, int64_t k,
-                                       int64_t lda, int64_t ldb, int64_t ldc) {
+static int64_t xsmm_matmul_dispatch_bf16_impl(int64_t m, int64_t n,
+                                              int64_t k, int64_t lda,
+                                              int64_t ldb, int64_t ldc) {
   // std::cout << "lda: " << lda << "\n";
   // std::cout << "ldb: " << ldb << "\n";
   // std::cout << "ldc: " << ldc << "\n";
@@ -186,11 +272,10 @@ _mlir_ciface_xsmm_matmul_dispatch_bf16(int64_t m, int64_t n, int64_t k,
   return reinterpret_cast<int64_t>(sgemm);
 }
 
-extern "C" int64_t _mlir_ciface_xsmm_unary_dispatch_f32(int64_t m, int64_t n,
-                                                        int64_t ldi,
-                                                        int64_t ldo,
-                                                        int64_t type,
-                                                        int64_t bcast_type) {
+static int64_t xsmm_unary_dispatch_f32_impl(int64_t m, int64_t n,
+                                            int64_t ldi, int64_t ldo,
+                                            int64_t type,
+                                            int64_t bcast_type) {
 
   // std::cout << "ldi: " << ldi << "\n";
   // std::cout << "ldo: " << ldo << "\n";
@@ -220,11 +305,10 @@ extern "C" int64_t _mlir_ciface_xsmm_unary_dispatch_f32(int64_t m, int64_t n,
   return reinterpret_cast<int64_t>(kernel);
 }
 
-extern "C" int64_t _mlir_ciface_xsmm_unary_dispatch_bf16(int64_t m, int64_t n,
-                                                         int64_t ldi,
-                                                         int64_t ldo,
-                                                         int64_t type,
-                                                         int64_t bcast_type) {
+static int64_t xsmm_unary_dispatch_bf16_impl(int64_t m, int64_t n,
+                                             int64_t ldi, int64_t ldo,
+                                             int64_t type,
+                                             int64_t bcast_type) {
 
   // std::cout << "ldi: " << ldi << "\n";
   // std::cout << "ldo: " << ldo << "\n";
@@ -254,11 +338,10 @@ extern "C" int64_t _mlir_ciface_xsmm_unary_dispatch_bf16(int64_t m, int64_t n,
   return reinterpret_cast<int64_t>(kernel);
 }
 
-extern "C" int64_t _mlir_ciface_xsmm_binary_dispatch(int64_t m, int64_t n,
-                                                     int64_t ldiLhs,
-                                                     int64_t ldiRhs,
-                                                     int64_t ldo, int64_t type,
-                                                     int64_t bcast_type) {
+static int64_t xsmm_binary_dispatch_impl(int64_t m, int64_t n,
+                                         int64_t ldiLhs, int64_t ldiRhs,
+                                         int64_t ldo, int64_t type,
+                                         int64_t bcast_type) {
 
   libxsmm_meltw_binary_flags binary_flags =
       static_cast<libxsmm_meltw_binary_flags>(bcast_type);
@@ -287,201 +370,162 @@ extern "C" void
 _mlir_ciface_xsmm_unary_invoke_f32(int64_t addr,
                                    UnrankedMemRefType<float> *input,
                                    UnrankedMemRefType<float> *output) {
-  // std::cout << "tensor input: \n";
-  // printMemRefMetaData(std::cout, DynamicMemRefType<float>(*input));
-  // std::cout << "tensor output: \n";
-  // printMemRefMetaData(std::cout, DynamicMemRefType<float>(*output));
-
-  DynamicMemRefType<float> tensorA = DynamicMemRefType<float>(*input);
-  DynamicMemRefType<float> tensorB = DynamicMemRefType<float>(*output);
-
-  float *addr_a = tensorA.data + tensorA.offset;
-  float *addr_b = tensorB.data + tensorB.offset;
-
-  libxsmm_meltwfunction_unary kernel =
-      reinterpret_cast<libxsmm_meltwfunction_unary>(addr);
-  libxsmm_meltw_unary_param param;
-  param.in.primary = (void *)addr_a;
-  param.out.primary = (void *)addr_b;
-  kernel(&param);
+  xsmm_unary_invoke_impl(addr, getAlignedAddress(input),
+                         getAlignedAddress(output));
 }
 
 extern "C" void
 _mlir_ciface_xsmm_unary_invoke_bf16(int64_t addr,
                                     UnrankedMemRefType<bf16> *input,
                                     UnrankedMemRefType<bf16> *output) {
-  // std::cout << "tensor input: \n";
-  // printMemRefMetaData(std::cout, DynamicMemRefType<bf16>(*input));
-  // std::cout << "tensor output: \n";
-  // printMemRefMetaData(std::cout, DynamicMemRefType<bf16>(*output));
-
-  DynamicMemRefType<bf16> tensorA = DynamicMemRefType<bf16>(*input);
-  DynamicMemRefType<bf16> tensorB = DynamicMemRefType<bf16>(*output);
-
-  bf16 *addr_a = tensorA.data + tensorA.offset;
-  bf16 *addr_b = tensorB.data + tensorB.offset;
-
-  libxsmm_meltwfunction_unary kernel =
-      reinterpret_cast<libxsmm_meltwfunction_unary>(addr);
-  libxsmm_meltw_unary_param param;
-  param.in.primary = (void *)addr_a;
-  param.out.primary = (void *)addr_b;
-  kernel(&param);
+  xsmm_unary_invoke_impl(addr, getAlignedAddress(input),
+                         getAlignedAddress(output));
 }
 
 extern "C" void
 _mlir_ciface_xsmm_binary_invoke(int64_t addr, UnrankedMemRefType<float> *lhs,
                                 UnrankedMemRefType<float> *rhs) {
-
-  DynamicMemRefType<float> tensorLhs = DynamicMemRefType<float>(*lhs);
-  DynamicMemRefType<float> tensorRhs = DynamicMemRefType<float>(*rhs);
-
-  float *addr_tensor_lhs = tensorLhs.data + tensorLhs.offset;
-  float *addr_tensor_rhs = tensorRhs.data + tensorRhs.offset;
-
-  libxsmm_meltwfunction_binary kernel =
-      reinterpret_cast<libxsmm_meltwfunction_binary>(addr);
-  libxsmm_meltw_binary_param param;
-  // TODO: check if we need to swap also here.
-  param.in0.primary = (void *)addr_tensor_lhs;
-  param.in1.primary = (void *)addr_tensor_rhs;
-  param.out.primary = (void *)addr_tensor_rhs;
-  kernel(&param);
+  xsmm_binary_invoke_impl(addr, getAlignedAddress(lhs), getAlignedAddress(rhs));
 }
 
 extern "C" void
 _mlir_ciface_xsmm_unary_scalar_invoke_f32(int64_t addr, float input,
                                           UnrankedMemRefType<float> *output) {
-
-  DynamicMemRefType<float> tensorB = DynamicMemRefType<float>(*output);
-
-  libxsmm_meltwfunction_unary kernel =
-      reinterpret_cast<libxsmm_meltwfunction_unary>(addr);
-  libxsmm_meltw_unary_param param;
-  param.in.primary = (void *)&input;
-  param.out.primary = (void *)tensorB.data;
-  kernel(&param);
+  xsmm_unary_scalar_invoke_impl(addr, input, getAlignedAddress(output));
 }
 
 extern "C" void
 _mlir_ciface_xsmm_unary_scalar_invoke_bf16(int64_t addr, bf16 input,
                                            UnrankedMemRefType<bf16> *output) {
-
-  DynamicMemRefType<bf16> tensorB = DynamicMemRefType<bf16>(*output);
-
-  libxsmm_meltwfunction_unary kernel =
-      reinterpret_cast<libxsmm_meltwfunction_unary>(addr);
-  libxsmm_meltw_unary_param param;
-  param.in.primary = (void *)&input;
-  param.out.primary = (void *)tensorB.data;
-  kernel(&param);
-}
-
-LIBXSMM_INLINE void matrix_copy_NC_to_NCNC(float *src, float *dst, int T, int N,
-                                           int C, int bn, int bc) {
-  int t, n1, n2, c1, c2;
-  int nBlocks = N / bn;
-  int cBlocks = C / bc;
-  LIBXSMM_VLA_DECL(3, float, real_src, src, N, C);
-  LIBXSMM_VLA_DECL(5, float, real_dst, dst, nBlocks, cBlocks, bn, bc);
-
-  for (t = 0; t < T; t++) {
-    for (n1 = 0; n1 < nBlocks; n1++) {
-      for (c1 = 0; c1 < cBlocks; c1++) {
-        for (n2 = 0; n2 < bn; n2++) {
-          for (c2 = 0; c2 < bc; c2++) {
-            LIBXSMM_VLA_ACCESS(5, real_dst, t, n1, c1, n2, c2, nBlocks, cBlocks,
-                               bn, bc) =
-                LIBXSMM_VLA_ACCESS(3, real_src, t, n1 * bn + n2, c1 * bc + c2,
-                                   N, C);
-          }
-        }
-      }
-    }
-  }
+  xsmm_unary_scalar_invoke_impl(addr, input, getAlignedAddress(output));
 }
 
 extern "C" void _mlir_ciface_matrix_copy_NC_to_NCNC(
     UnrankedMemRefType<float> *input, UnrankedMemRefType<float> *output,
     int64_t N, int64_t C, int64_t n, int64_t c) {
-  // std::cout << "\n";
-  // printMemRefMetaData(std::cout, DynamicMemRefType<float>(*input));
-  // std::cout << "\n";
-  // printMemRefMetaData(std::cout, DynamicMemRefType<float>(*output));
-  // std::cout << "\n";
-  DynamicMemRefType<float> tensorInput = DynamicMemRefType<float>(*input);
-  DynamicMemRefType<float> tensorOutput = DynamicMemRefType<float>(*output);
+  // The input is a C x N matrix, blocked in c x n blocks.
+  tpp::packBlocks(getAlignedAddress(input), getAlignedAddress(output), C, N,
+                  /*ldFlat=*/N, c, n, tpp::BlockOrder::ROW_MAJOR,
+                  tpp::KernelDataType::F32);
+}
 
-  float *addr_input = tensorInput.data + tensorInput.offset;
-  float *addr_output = tensorOutput.data + tensorOutput.offset;
+//----------------------------------------------------------------------------//
+// Block repacking: NC <-> NCnc, KC <-> CKkc and bf16 VNNI.
+//----------------------------------------------------------------------------//
 
-  matrix_copy_NC_to_NCNC(addr_input, addr_output, 1, C, N, c, n);
+// The flat matrix is row-major with unit inner stride, the blocked buffer is
+// contiguous. Block sizes are the two innermost sizes of the blocked buffer.
+template <typename T>
+static void xsmm_pack_blocks_impl(UnrankedMemRefType<T> *flat,
+                                  UnrankedMemRefType<T> *blocked,
+                                  tpp::BlockOrder order,
+                                  tpp::KernelDataType dtype, bool toBlocked) {
+  DynamicMemRefType<T> flatTensor = DynamicMemRefType<T>(*flat);
+  DynamicMemRefType<T> blockedTensor = DynamicMemRefType<T>(*blocked);
+  T *addr_flat = flatTensor.data + flatTensor.offset;
+  T *addr_blocked = blockedTensor.data + blockedTensor.offset;
+  int64_t rows = flatTensor.sizes[0];
+  int64_t cols = flatTensor.sizes[1];
+  int64_t ldFlat = flatTensor.strides[0];
+  int64_t blockRows = blockedTensor.sizes[2];
+  int64_t blockCols = blockedTensor.sizes[3];
+  if (toBlocked)
+    tpp::packBlocks(addr_flat, addr_blocked, rows, cols, ldFlat, blockRows,
+                    blockCols, order, dtype);
+  else
+    tpp::unpackBlocks(addr_blocked, addr_flat, rows, cols, ldFlat, blockRows,
+                      blockCols, order, dtype);
+}
+
+extern "C" void
+_mlir_ciface_xsmm_pack_NC_to_NCnc_f32(UnrankedMemRefType<float> *input,
+                                      UnrankedMemRefType<float> *output) {
+  xsmm_pack_blocks_impl(input, output, tpp::BlockOrder::ROW_MAJOR,
+                        tpp::KernelDataType::F32, /*toBlocked=*/true);
+}
+
+extern "C" void
+_mlir_ciface_xsmm_pack_NC_to_NCnc_bf16(UnrankedMemRefType<bf16> *input,
+                                       UnrankedMemRefType<bf16> *output) {
+  xsmm_pack_blocks_impl(input, output, tpp::BlockOrder::ROW_MAJOR,
+                        tpp::KernelDataType::BF16, /*toBlocked=*/true);
+}
+
+extern "C" void
+_mlir_ciface_xsmm_pack_KC_to_CKkc_f32(UnrankedMemRefType<float> *input,
+                                      UnrankedMemRefType<float> *output) {
+  xsmm_pack_blocks_impl(input, output, tpp::BlockOrder::COL_MAJOR,
+                        tpp::KernelDataType::F32, /*toBlocked=*/true);
+}
+
+extern "C" void
+_mlir_ciface_xsmm_pack_KC_to_CKkc_bf16(UnrankedMemRefType<bf16> *input,
+                                       UnrankedMemRefType<bf16> *output) {
+  xsmm_pack_blocks_impl(input, output, tpp::BlockOrder::COL_MAJOR,
+                        tpp::KernelDataType::BF16, /*toBlocked=*/true);
+}
+
+extern "C" void
+_mlir_ciface_xsmm_unpack_NCnc_to_NC_f32(UnrankedMemRefType<float> *input,
+                                        UnrankedMemRefType<float> *output) {
+  xsmm_pack_blocks_impl(output, input, tpp::BlockOrder::ROW_MAJOR,
+                        tpp::KernelDataType::F32, /*toBlocked=*/false);
+}
+
+extern "C" void
+_mlir_ciface_xsmm_unpack_NCnc_to_NC_bf16(UnrankedMemRefType<bf16> *input,
+                                         UnrankedMemRefType<bf16> *output) {
+  xsmm_pack_blocks_impl(output, input, tpp::BlockOrder::ROW_MAJOR,
+                        tpp::KernelDataType::BF16, /*toBlocked=*/false);
+}
+
+extern "C" void
+_mlir_ciface_xsmm_unpack_CKkc_to_KC_f32(UnrankedMemRefType<float> *input,
+                                        UnrankedMemRefType<float> *output) {
+  xsmm_pack_blocks_impl(output, input, tpp::BlockOrder::COL_MAJOR,
+                        tpp::KernelDataType::F32, /*toBlocked=*/false);
+}
+
+extern "C" void
+_mlir_ciface_xsmm_unpack_CKkc_to_KC_bf16(UnrankedMemRefType<bf16> *input,
+                                         UnrankedMemRefType<bf16> *output) {
+  xsmm_pack_blocks_impl(output, input, tpp::BlockOrder::COL_MAJOR,
+                        tpp::KernelDataType::BF16, /*toBlocked=*/false);
+}
+
+// [..., K, N] -> [..., K / 2, N, 2]. The leading dimensions of the input must
+// collapse into a single batch dimension.
+extern "C" void
+_mlir_ciface_xsmm_pack_vnni_bf16(UnrankedMemRefType<bf16> *input,
+                                 UnrankedMemRefType<bf16> *output) {
+  DynamicMemRefType<bf16> tensorInput = DynamicMemRefType<bf16>(*input);
+  int64_t rank = tensorInput.rank;
+  int64_t batch = 1;
+  for (int64_t dim = 0; dim < rank - 2; dim++)
+    batch *= tensorInput.sizes[dim];
+  int64_t batchStride = (rank > 2) ? tensorInput.strides[rank - 3] : 0;
+  tpp::packVNNI(getAlignedAddress(input), getAlignedAddress(output), batch,
+                batchStride, tensorInput.sizes[rank - 2],
+                tensorInput.sizes[rank - 1], tensorInput.strides[rank - 2]);
 }
 
 extern "C" void _mlir_ciface_xsmm_brgemm_invoke_f32(
     int64_t addr, UnrankedMemRefType<float> *A, UnrankedMemRefType<float> *B,
     UnrankedMemRefType<float> *C, int64_t numBatches) {
-  // std::cout << "numBatch: " << numBatches << "\n";
-  // std::cout << "\n A: \n";
-  // printMemRefMetaData(std::cout, DynamicMemRefType<float>(*A));
-  // std::cout << "\n B: \n";
-  // printMemRefMetaData(std::cout, DynamicMemRefType<float>(*B));
-  // std::cout << "\n C: \n";
-  // printMemRefMetaData(std::cout, DynamicMemRefType<float>(*C));
-  // std::cout << "\n";
-
-  DynamicMemRefType<float> tensorA = DynamicMemRefType<float>(*A);
-  DynamicMemRefType<float> tensorB = DynamicMemRefType<float>(*B);
-  DynamicMemRefType<float> tensorC = DynamicMemRefType<float>(*C);
-  float *addr_tensorA = tensorA.data + tensorA.offset;
-  float *addr_tensorB = tensorB.data + tensorB.offset;
-  float *addr_tensorC = tensorC.data + tensorC.offset;
-
-  libxsmm_xmmfunction sgemm;
-  libxsmm_gemm_param gemm_param;
-  sgemm.gemm = reinterpret_cast<libxsmm_gemmfunction>(addr);
-  unsigned long long numBatchesVar = numBatches;
-  gemm_param.a.primary = (void *)addr_tensorB;
-  gemm_param.b.primary = (void *)addr_tensorA;
-  gemm_param.c.primary = (void *)addr_tensorC;
-  gemm_param.op.tertiary = (void *)&numBatchesVar;
-  sgemm.gemm(&gemm_param);
+  xsmm_brgemm_invoke_impl(addr, getAlignedAddress(A), getAlignedAddress(B),
+                          getAlignedAddress(C), numBatches);
 }
 
 extern "C" void _mlir_ciface_xsmm_brgemm_invoke_bf16(
     int64_t addr, UnrankedMemRefType<bf16> *A, UnrankedMemRefType<bf16> *B,
     UnrankedMemRefType<bf16> *C, int64_t numBatches) {
-  // std::cout << "numBatch: " << numBatches << "\n";
-  // std::cout << "\n A: \n";
-  // printMemRefMetaData(std::cout, DynamicMemRefType<bf16>(*A));
-  // std::cout << "\n B: \n";
-  // printMemRefMetaData(std::cout, DynamicMemRefType<bf16>(*B));
-  // std::cout << "\n C: \n";
-  // printMemRefMetaData(std::cout, DynamicMemRefType<bf16>(*C));
-  // std::cout << "\n";
-
-  DynamicMemRefType<bf16> tensorA = DynamicMemRefType<bf16>(*A);
-  DynamicMemRefType<bf16> tensorB = DynamicMemRefType<bf16>(*B);
-  DynamicMemRefType<bf16> tensorC = DynamicMemRefType<bf16>(*C);
-  bf16 *addr_tensorA = tensorA.data + tensorA.offset;
-  bf16 *addr_tensorB = tensorB.data + tensorB.offset;
-  bf16 *addr_tensorC = tensorC.data + tensorC.offset;
-
-  libxsmm_xmmfunction sgemm;
-  libxsmm_gemm_param gemm_param;
-  sgemm.gemm = reinterpret_cast<libxsmm_gemmfunction>(addr);
-  unsigned long long numBatchesVar = numBatches;
-  gemm_param.a.primary = (void *)addr_tensorB;
-  gemm_param.b.primary = (void *)addr_tensorA;
-  gemm_param.c.primary = (void *)addr_tensorC;
-  gemm_param.op.tertiary = (void *)&numBatchesVar;
-  sgemm.gemm(&gemm_param);
+  xsmm_brgemm_invoke_impl(addr, getAlignedAddress(A), getAlignedAddress(B),
+                          getAlignedAddress(C), numBatches);
 }
 
-extern "C" int64_t _mlir_ciface_xsmm_brgemm_dispatch_f32(int64_t m, int64_t n,
-                                                         int64_t k, int64_t lda,
-                                                         int64_t ldb,
-                                                         int64_t ldc) {
+static int64_t xsmm_brgemm_dispatch_f32_impl(int64_t m, int64_t n, int64_t k,
+                                             int64_t lda, int64_t ldb,
+                                             int64_t ldc) {
   // std::cout << "lda: " << lda << "\n";
   // std::cout << "lbd: " << ldb << "\n";
   // std::cout << "ldc: " << ldc << "\n";
@@ -526,9 +570,9 @@ extern "C" int64_t _mlir_ciface_xsmm_brgemm_dispatch_f32(int64_t m, int64_t n,
   return reinterpret_cast<int64_t>(sgemm);
 }
 
-extern "C" int64_t
-_mlir_ciface_xsmm_brgemm_dispatch_bf16(int64_t m, int64_t n, int64_t k,
-                                       int64_t lda, int64_t ldb, int64_t ldc) {
+static int64_t xsmm_brgemm_dispatch_bf16_impl(int64_t m, int64_t n,
+                                              int64_t k, int64_t lda,
+                                              int64_t ldb, int64_t ldc) {
   // std::cout << "lda: " << lda << "\n";
   // std::cout << "lbd: " << ldb << "\n";
   // std::cout << "ldc: " << ldc << "\n";
@@ -573,6 +617,696 @@ _mlir_ciface_xsmm_brgemm_dispatch_bf16(int64_t m, int64_t n, int64_t k,
   return reinterpret_cast<int64_t>(sgemm);
 }
 
+extern "C" void _mlir_ciface_xsmm_fused_brgemm_invoke_f32(
+    int64_t addr, UnrankedMemRefType<float> *A, UnrankedMemRefType<float> *B,
+    UnrankedMemRefType<float> *bias, UnrankedMemRefType<float> *C,
+    int64_t numBatches) {
+  xsmm_fused_brgemm_invoke_impl(addr, getAlignedAddress(A),
+                                getAlignedAddress(B), getAlignedAddress(bias),
+                                getAlignedAddress(C), numBatches);
+}
+
+extern "C" void _mlir_ciface_xsmm_fused_brgemm_invoke_bf16(
+    int64_t addr, UnrankedMemRefType<bf16> *A, UnrankedMemRefType<bf16> *B,
+    UnrankedMemRefType<bf16> *bias, UnrankedMemRefType<bf16> *C,
+    int64_t numBatches) {
+  xsmm_fused_brgemm_invoke_impl(addr, getAlignedAddress(A),
+                                getAlignedAddress(B), getAlignedAddress(bias),
+                                getAlignedAddress(C), numBatches);
+}
+
+// Same shape and batch-reduce configuration as the plain BRGEMM, with C
+// overwritten (beta = 0), a broadcast bias add and a relu applied on the
+// accumulators before the store.
+static int64_t xsmm_fused_brgemm_dispatch_impl(int64_t m, int64_t n, int64_t k,
+                                               int64_t lda, int64_t ldb,
+                                               int64_t ldc,
+                                               libxsmm_datatype dtype,
+                                               size_t elementSize) {
+  libxsmm_blasint stride_a = lda * m * elementSize;
+  libxsmm_blasint stride_b = ldb * k * elementSize;
+
+  libxsmm_gemm_shape l_shape;
+  libxsmm_bitfield l_flags =
+      LIBXSMM_GEMM_FLAGS('N', 'N') | LIBXSMM_GEMM_FLAG_BETA_0;
+  libxsmm_bitfield l_prefetch_flags = 0;
+  libxsmm_gemm_batch_reduce_config l_brconfig;
+
+  l_shape.m = n;
+  l_shape.n = m;
+  l_shape.k = k;
+  l_shape.lda = ldb;
+  l_shape.ldb = lda;
+  l_shape.ldc = ldc;
+  l_shape.a_in_type = dtype;
+  l_shape.b_in_type = dtype;
+  l_shape.out_type = dtype;
+  l_shape.comp_type = dtype;
+  l_brconfig.br_type = LIBXSMM_GEMM_BATCH_REDUCE_STRIDE;
+  l_brconfig.br_stride_a_hint = stride_b;
+  l_brconfig.br_stride_b_hint = stride_a;
+  l_brconfig.br_unroll_hint = 0;
+
+  libxsmm_gemm_ext_unary_argops l_argops;
+  memset(&l_argops, 0, sizeof(l_argops));
+  l_argops.cp_unary_type = LIBXSMM_MELTW_TYPE_UNARY_RELU;
+  l_argops.cp_unary_flags = LIBXSMM_MELTW_FLAG_UNARY_NONE;
+  l_argops.ldcp = ldc;
+
+  libxsmm_gemm_ext_binary_postops l_postops;
+  memset(&l_postops, 0, sizeof(l_postops));
+  l_postops.d_in_type = dtype;
+  l_postops.d_binary_flags = LIBXSMM_MELTW_FLAG_BINARY_BCAST_COL_IN_0;
+  l_postops.d_binary_type = LIBXSMM_MELTW_TYPE_BINARY_ADD;
+  l_postops.ldd = ldc;
+
+  auto sgemm = libxsmm_dispatch_brgemm_ext_v2(
+      l_shape, l_flags, l_prefetch_flags, l_brconfig, l_argops, l_postops);
+
+  return reinterpret_cast<int64_t>(sgemm);
+}
+
+//----------------------------------------------------------------------------//
+// BRGEMM over offset and address lists. The batch matrices are not evenly
+// spaced, thus the kernel gets no stride hint.
+//----------------------------------------------------------------------------//
+
+extern "C" void _mlir_ciface_xsmm_brgemm_offs_invoke_f32(
+    int64_t addr, UnrankedMemRefType<float> *A, UnrankedMemRefType<float> *B,
+    UnrankedMemRefType<float> *C, UnrankedMemRefType<int64_t> *offsetsA,
+    UnrankedMemRefType<int64_t> *offsetsB, int64_t numBatches) {
+  xsmm_brgemm_offs_invoke_impl(addr, getAlignedAddress(A), getAlignedAddress(B),
+                               getAlignedAddress(C),
+                               getAlignedAddress(offsetsA),
+                               getAlignedAddress(offsetsB), numBatches);
+}
+
+extern "C" void _mlir_ciface_xsmm_brgemm_offs_invoke_bf16(
+    int64_t addr, UnrankedMemRefType<bf16> *A, UnrankedMemRefType<bf16> *B,
+    UnrankedMemRefType<bf16> *C, UnrankedMemRefType<int64_t> *offsetsA,
+    UnrankedMemRefType<int64_t> *offsetsB, int64_t numBatches) {
+  xsmm_brgemm_offs_invoke_impl(addr, getAlignedAddress(A), getAlignedAddress(B),
+                               getAlignedAddress(C),
+                               getAlignedAddress(offsetsA),
+                               getAlignedAddress(offsetsB), numBatches);
+}
+
+extern "C" void _mlir_ciface_xsmm_brgemm_addr_invoke_f32(
+    int64_t addr, UnrankedMemRefType<float> *A, UnrankedMemRefType<float> *B,
+    UnrankedMemRefType<float> *C, UnrankedMemRefType<int64_t> *offsetsA,
+    UnrankedMemRefType<int64_t> *offsetsB, int64_t numBatches) {
+  xsmm_brgemm_addr_invoke_impl(addr, getAlignedAddress(A), getAlignedAddress(B),
+                               getAlignedAddress(C),
+                               getAlignedAddress(offsetsA),
+                               getAlignedAddress(offsetsB), numBatches);
+}
+
+extern "C" void _mlir_ciface_xsmm_brgemm_addr_invoke_bf16(
+    int64_t addr, UnrankedMemRefType<bf16> *A, UnrankedMemRefType<bf16> *B,
+    UnrankedMemRefType<bf16> *C, UnrankedMemRefType<int64_t> *offsetsA,
+    UnrankedMemRefType<int64_t> *offsetsB, int64_t numBatches) {
+  xsmm_brgemm_addr_invoke_impl(addr, getAlignedAddress(A), getAlignedAddress(B),
+                               getAlignedAddress(C),
+                               getAlignedAddress(offsetsA),
+                               getAlignedAddress(offsetsB), numBatches);
+}
+
+static int64_t
+xsmm_brgemm_list_dispatch_impl(int64_t m, int64_t n, int64_t k, int64_t lda,
+                               int64_t ldb, int64_t ldc,
+                               libxsmm_gemm_batch_reduce_type brType,
+                               libxsmm_datatype dtype) {
+  libxsmm_gemm_shape l_shape;
+  libxsmm_bitfield l_flags = LIBXSMM_GEMM_FLAGS('N', 'N');
+  libxsmm_bitfield l_prefetch_flags = 0;
+  libxsmm_gemm_batch_reduce_config l_brconfig;
+
+  l_shape.m = n;
+  l_shape.n = m;
+  l_shape.k = k;
+  l_shape.lda = ldb;
+  l_shape.ldb = lda;
+  l_shape.ldc = ldc;
+  l_shape.a_in_type = dtype;
+  l_shape.b_in_type = dtype;
+  l_shape.out_type = dtype;
+  l_shape.comp_type = dtype;
+  l_brconfig.br_type = brType;
+  l_brconfig.br_stride_a_hint = 0;
+  l_brconfig.br_stride_b_hint = 0;
+  l_brconfig.br_unroll_hint = 0;
+
+  auto sgemm = libxsmm_dispatch_brgemm_v2(l_shape, l_flags, l_prefetch_flags,
+                                          l_brconfig);
+
+  return reinterpret_cast<int64_t>(sgemm);
+}
+
+//----------------------------------------------------------------------------//
+// Element-wise multiply-add: C += A * B, where a zero `ldb` denotes a row
+// vector B broadcast along the rows of C.
+//----------------------------------------------------------------------------//
+
+extern "C" void
+_mlir_ciface_xsmm_muladd_invoke_f32(int64_t addr, UnrankedMemRefType<float> *A,
+                                    UnrankedMemRefType<float> *B,
+                                    UnrankedMemRefType<float> *C) {
+  xsmm_muladd_invoke_impl(addr, getAlignedAddress(A), getAlignedAddress(B),
+                          getAlignedAddress(C));
+}
+
+extern "C" void
+_mlir_ciface_xsmm_muladd_invoke_bf16(int64_t addr, UnrankedMemRefType<bf16> *A,
+                                     UnrankedMemRefType<bf16> *B,
+                                     UnrankedMemRefType<bf16> *C) {
+  xsmm_muladd_invoke_impl(addr, getAlignedAddress(A), getAlignedAddress(B),
+                          getAlignedAddress(C));
+}
+
+static int64_t xsmm_muladd_dispatch_impl(int64_t m, int64_t n, int64_t lda,
+                                         int64_t ldb, int64_t ldc,
+                                         libxsmm_datatype dtype) {
+  libxsmm_meltw_ternary_shape ternary_shape;
+  // Row major to col major swap m with n: the row vector B becomes a column
+  // vector broadcast over LIBXSMM's columns.
+  ternary_shape.m = static_cast<libxsmm_blasint>(n);
+  ternary_shape.n = static_cast<libxsmm_blasint>(m);
+  ternary_shape.ldi = static_cast<libxsmm_blasint>(lda);
+  ternary_shape.ldi2 = static_cast<libxsmm_blasint>(ldb == 0 ? n : ldb);
+  ternary_shape.ldi3 = static_cast<libxsmm_blasint>(ldc);
+  ternary_shape.ldo = static_cast<libxsmm_blasint>(ldc);
+  ternary_shape.in0_type = dtype;
+  ternary_shape.in1_type = dtype;
+  ternary_shape.in2_type = dtype;
+  ternary_shape.out_type = dtype;
+  ternary_shape.comp_type = LIBXSMM_DATATYPE_F32;
+
+  libxsmm_bitfield flags = LIBXSMM_MELTW_FLAG_TERNARY_REUSE_IN_2_AS_OUT;
+  if (ldb == 0)
+    flags |= LIBXSMM_MELTW_FLAG_TERNARY_BCAST_COL_IN_1;
+  libxsmm_meltwfunction_ternary kernel = libxsmm_dispatch_meltw_ternary_v2(
+      LIBXSMM_MELTW_TYPE_TERNARY_MULADD, ternary_shape, flags);
+
+  return reinterpret_cast<int64_t>(kernel);
+}
+
+//----------------------------------------------------------------------------//
+// Mixed precision: bf16 inputs, f32 accumulation and f32 output.
+//----------------------------------------------------------------------------//
+
+extern "C" void _mlir_ciface_xsmm_matmul_invoke_bf16_f32(
+    int64_t funcAddr, UnrankedMemRefType<bf16> *A, UnrankedMemRefType<bf16> *B,
+    UnrankedMemRefType<float> *C) {
+  xsmm_matmul_invoke_impl(funcAddr, getAlignedAddress(A),
+                          getAlignedAddress(B), getAlignedAddress(C));
+}
+
+extern "C" void _mlir_ciface_xsmm_brgemm_invoke_bf16_f32(
+    int64_t addr, UnrankedMemRefType<bf16> *A, UnrankedMemRefType<bf16> *B,
+    UnrankedMemRefType<float> *C, int64_t numBatches) {
+  xsmm_brgemm_invoke_impl(addr, getAlignedAddress(A), getAlignedAddress(B),
+                          getAlignedAddress(C), numBatches);
+}
+
+static libxsmm_gemm_shape getMixedPrecisionShape(int64_t m, int64_t n,
+                                                 int64_t k, int64_t lda,
+                                                 int64_t ldb, int64_t ldc) {
+  libxsmm_gemm_shape l_shape;
+  // LIBXSMM col-major change m with n.
+  l_shape.m = n;
+  l_shape.n = m;
+  l_shape.k = k;
+  l_shape.lda = ldb;
+  l_shape.ldb = lda;
+  l_shape.ldc = ldc;
+  l_shape.a_in_type = LIBXSMM_DATATYPE_BF16;
+  l_shape.b_in_type = LIBXSMM_DATATYPE_BF16;
+  l_shape.out_type = LIBXSMM_DATATYPE_F32;
+  l_shape.comp_type = LIBXSMM_DATATYPE_F32;
+  return l_shape;
+}
+
+static int64_t xsmm_matmul_dispatch_bf16_f32_impl(int64_t m, int64_t n,
+                                                  int64_t k, int64_t lda,
+                                                  int64_t ldb, int64_t ldc) {
+  libxsmm_gemm_shape l_shape = getMixedPrecisionShape(m, n, k, lda, ldb, ldc);
+  libxsmm_bitfield l_flags = LIBXSMM_GEMM_FLAGS('N', 'N');
+  libxsmm_bitfield l_prefetch_flags = 0;
+
+  auto sgemm = libxsmm_dispatch_gemm_v2(l_shape, l_flags, l_prefetch_flags);
+  return reinterpret_cast<int64_t>(sgemm);
+}
+
+static int64_t xsmm_brgemm_dispatch_bf16_f32_impl(int64_t m, int64_t n,
+                                                  int64_t k, int64_t lda,
+                                                  int64_t ldb, int64_t ldc) {
+  libxsmm_gemm_shape l_shape = getMixedPrecisionShape(m, n, k, lda, ldb, ldc);
+  libxsmm_bitfield l_flags = LIBXSMM_GEMM_FLAGS('N', 'N');
+  libxsmm_bitfield l_prefetch_flags = 0;
+  libxsmm_gemm_batch_reduce_config l_brconfig;
+
+  // The batch strides are in terms of the (bf16) inputs.
+  l_brconfig.br_type = LIBXSMM_GEMM_BATCH_REDUCE_STRIDE;
+  l_brconfig.br_stride_a_hint = ldb * k * sizeof(bf16);
+  l_brconfig.br_stride_b_hint = lda * m * sizeof(bf16);
+  l_brconfig.br_unroll_hint = 0;
+
+  auto sgemm = libxsmm_dispatch_brgemm_v2(l_shape, l_flags, l_prefetch_flags,
+                                          l_brconfig);
+  return reinterpret_cast<int64_t>(sgemm);
+}
+
+//----------------------------------------------------------------------------//
+// Dispatch entry points. Kernels are looked up in the process-wide cache and
+// JITed by LIBXSMM only on the first request for a given descriptor.
+//----------------------------------------------------------------------------//
+
+using tpp::KernelCache;
+using tpp::KernelDataType;
+using tpp::KernelKind;
+
+extern "C" int64_t _mlir_ciface_xsmm_matmul_dispatch_f32(int64_t m, int64_t n,
+                                                         int64_t k, int64_t lda,
+                                                         int64_t ldb,
+                                                         int64_t ldc) {
+  tpp::KernelKey key = tpp::makeGemmKey(KernelKind::MATMUL, KernelDataType::F32,
+                                        m, n, k, lda, ldb, ldc);
+  return KernelCache::get().lookupOrDispatch(key, [&]() {
+    return xsmm_matmul_dispatch_f32_impl(m, n, k, lda, ldb, ldc);
+  });
+}
+
+extern "C" int64_t
+_mlir_ciface_xsmm_matmul_dispatch_bf16(int64_t m, int64_t n, int64_t k,
+                                       int64_t lda, int64_t ldb, int64_t ldc) {
+  tpp::KernelKey key = tpp::makeGemmKey(
+      KernelKind::MATMUL, KernelDataType::BF16, m, n, k, lda, ldb, ldc);
+  return KernelCache::get().lookupOrDispatch(key, [&]() {
+    return xsmm_matmul_dispatch_bf16_impl(m, n, k, lda, ldb, ldc);
+  });
+}
+
+extern "C" int64_t _mlir_ciface_xsmm_brgemm_dispatch_f32(int64_t m, int64_t n,
+                                                         int64_t k, int64_t lda,
+                                                         int64_t ldb,
+                                                         int64_t ldc) {
+  tpp::KernelKey key = tpp::makeGemmKey(KernelKind::BRGEMM, KernelDataType::F32,
+                                        m, n, k, lda, ldb, ldc);
+  return KernelCache::get().lookupOrDispatch(key, [&]() {
+    return xsmm_brgemm_dispatch_f32_impl(m, n, k, lda, ldb, ldc);
+  });
+}
+
+extern "C" int64_t
+_mlir_ciface_xsmm_brgemm_dispatch_bf16(int64_t m, int64_t n, int64_t k,
+                                       int64_t lda, int64_t ldb, int64_t ldc) {
+  tpp::KernelKey key = tpp::makeGemmKey(
+      KernelKind::BRGEMM, KernelDataType::BF16, m, n, k, lda, ldb, ldc);
+  return KernelCache::get().lookupOrDispatch(key, [&]() {
+    return xsmm_brgemm_dispatch_bf16_impl(m, n, k, lda, ldb, ldc);
+  });
+}
+
+extern "C" int64_t _mlir_ciface_xsmm_matmul_dispatch_bf16_f32_f32(
+    int64_t m, int64_t n, int64_t k, int64_t lda, int64_t ldb, int64_t ldc) {
+  tpp::KernelKey key = tpp::makeGemmKey(
+      KernelKind::MATMUL, KernelDataType::BF16_F32, m, n, k, lda, ldb, ldc);
+  return KernelCache::get().lookupOrDispatch(key, [&]() {
+    return xsmm_matmul_dispatch_bf16_f32_impl(m, n, k, lda, ldb, ldc);
+  });
+}
+
+extern "C" int64_t _mlir_ciface_xsmm_brgemm_dispatch_bf16_f32_f32(
+    int64_t m, int64_t n, int64_t k, int64_t lda, int64_t ldb, int64_t ldc) {
+  tpp::KernelKey key = tpp::makeGemmKey(
+      KernelKind::BRGEMM, KernelDataType::BF16_F32, m, n, k, lda, ldb, ldc);
+  return KernelCache::get().lookupOrDispatch(key, [&]() {
+    return xsmm_brgemm_dispatch_bf16_f32_impl(m, n, k, lda, ldb, ldc);
+  });
+}
+
+extern "C" int64_t _mlir_ciface_xsmm_fused_brgemm_dispatch_f32(
+    int64_t m, int64_t n, int64_t k, int64_t lda, int64_t ldb, int64_t ldc) {
+  tpp::KernelKey key = tpp::makeGemmKey(
+      KernelKind::FUSED_BRGEMM, KernelDataType::F32, m, n, k, lda, ldb, ldc);
+  return KernelCache::get().lookupOrDispatch(key, [&]() {
+    return xsmm_fused_brgemm_dispatch_impl(m, n, k, lda, ldb, ldc,
+                                           LIBXSMM_DATATYPE_F32, sizeof(float));
+  });
+}
+
+extern "C" int64_t _mlir_ciface_xsmm_fused_brgemm_dispatch_bf16(
+    int64_t m, int64_t n, int64_t k, int64_t lda, int64_t ldb, int64_t ldc) {
+  tpp::KernelKey key = tpp::makeGemmKey(
+      KernelKind::FUSED_BRGEMM, KernelDataType::BF16, m, n, k, lda, ldb, ldc);
+  return KernelCache::get().lookupOrDispatch(key, [&]() {
+    return xsmm_fused_brgemm_dispatch_impl(m, n, k, lda, ldb, ldc,
+                                           LIBXSMM_DATATYPE_BF16, sizeof(bf16));
+  });
+}
+
+extern "C" int64_t _mlir_ciface_xsmm_brgemm_offs_dispatch_f32(
+    int64_t m, int64_t n, int64_t k, int64_t lda, int64_t ldb, int64_t ldc) {
+  tpp::KernelKey key = tpp::makeGemmKey(
+      KernelKind::BRGEMM_OFFS, KernelDataType::F32, m, n, k, lda, ldb, ldc);
+  return KernelCache::get().lookupOrDispatch(key, [&]() {
+    return xsmm_brgemm_list_dispatch_impl(m, n, k, lda, ldb, ldc,
+                                          LIBXSMM_GEMM_BATCH_REDUCE_OFFSET,
+                                          LIBXSMM_DATATYPE_F32);
+  });
+}
+
+extern "C" int64_t _mlir_ciface_xsmm_brgemm_offs_dispatch_bf16(
+    int64_t m, int64_t n, int64_t k, int64_t lda, int64_t ldb, int64_t ldc) {
+  tpp::KernelKey key = tpp::makeGemmKey(
+      KernelKind::BRGEMM_OFFS, KernelDataType::BF16, m, n, k, lda, ldb, ldc);
+  return KernelCache::get().lookupOrDispatch(key, [&]() {
+    return xsmm_brgemm_list_dispatch_impl(m, n, k, lda, ldb, ldc,
+                                          LIBXSMM_GEMM_BATCH_REDUCE_OFFSET,
+                                          LIBXSMM_DATATYPE_BF16);
+  });
+}
+
+extern "C" int64_t _mlir_ciface_xsmm_brgemm_addr_dispatch_f32(
+    int64_t m, int64_t n, int64_t k, int64_t lda, int64_t ldb, int64_t ldc) {
+  tpp::KernelKey key = tpp::makeGemmKey(
+      KernelKind::BRGEMM_ADDR, KernelDataType::F32, m, n, k, lda, ldb, ldc);
+  return KernelCache::get().lookupOrDispatch(key, [&]() {
+    return xsmm_brgemm_list_dispatch_impl(m, n, k, lda, ldb, ldc,
+                                          LIBXSMM_GEMM_BATCH_REDUCE_ADDRESS,
+                                          LIBXSMM_DATATYPE_F32);
+  });
+}
+
+extern "C" int64_t _mlir_ciface_xsmm_brgemm_addr_dispatch_bf16(
+    int64_t m, int64_t n, int64_t k, int64_t lda, int64_t ldb, int64_t ldc) {
+  tpp::KernelKey key = tpp::makeGemmKey(
+      KernelKind::BRGEMM_ADDR, KernelDataType::BF16, m, n, k, lda, ldb, ldc);
+  return KernelCache::get().lookupOrDispatch(key, [&]() {
+    return xsmm_brgemm_list_dispatch_impl(m, n, k, lda, ldb, ldc,
+                                          LIBXSMM_GEMM_BATCH_REDUCE_ADDRESS,
+                                          LIBXSMM_DATATYPE_BF16);
+  });
+}
+
+extern "C" int64_t _mlir_ciface_xsmm_muladd_dispatch_f32(int64_t m, int64_t n,
+                                                         int64_t lda,
+                                                         int64_t ldb,
+                                                         int64_t ldc) {
+  tpp::KernelKey key =
+      tpp::makeEltwiseKey(KernelKind::MULADD, KernelDataType::F32, m, n, lda,
+                          ldb, ldc, /*op=*/0, /*flags=*/0);
+  return KernelCache::get().lookupOrDispatch(key, [&]() {
+    return xsmm_muladd_dispatch_impl(m, n, lda, ldb, ldc,
+                                     LIBXSMM_DATATYPE_F32);
+  });
+}
+
+extern "C" int64_t _mlir_ciface_xsmm_muladd_dispatch_bf16(int64_t m, int64_t n,
+                                                          int64_t lda,
+                                                          int64_t ldb,
+                                                          int64_t ldc) {
+  tpp::KernelKey key =
+      tpp::makeEltwiseKey(KernelKind::MULADD, KernelDataType::BF16, m, n, lda,
+                          ldb, ldc, /*op=*/0, /*flags=*/0);
+  return KernelCache::get().lookupOrDispatch(key, [&]() {
+    return xsmm_muladd_dispatch_impl(m, n, lda, ldb, ldc,
+                                     LIBXSMM_DATATYPE_BF16);
+  });
+}
+
+extern "C" int64_t _mlir_ciface_xsmm_unary_dispatch_f32(int64_t m, int64_t n,
+                                                        int64_t ldi,
+                                                        int64_t ldo,
+                                                        int64_t type,
+                                                        int64_t bcast_type) {
+  tpp::KernelKey key =
+      tpp::makeEltwiseKey(KernelKind::UNARY, KernelDataType::F32, m, n, ldi,
+                          /*ldi2=*/0, ldo, type, bcast_type);
+  return KernelCache::get().lookupOrDispatch(key, [&]() {
+    return xsmm_unary_dispatch_f32_impl(m, n, ldi, ldo, type, bcast_type);
+  });
+}
+
+extern "C" int64_t _mlir_ciface_xsmm_unary_dispatch_bf16(int64_t m, int64_t n,
+                                                         int64_t ldi,
+                                                         int64_t ldo,
+                                                         int64_t type,
+                                                         int64_t bcast_type) {
+  tpp::KernelKey key =
+      tpp::makeEltwiseKey(KernelKind::UNARY, KernelDataType::BF16, m, n, ldi,
+                          /*ldi2=*/0, ldo, type, bcast_type);
+  return KernelCache::get().lookupOrDispatch(key, [&]() {
+    return xsmm_unary_dispatch_bf16_impl(m, n, ldi, ldo, type, bcast_type);
+  });
+}
+
+extern "C" int64_t _mlir_ciface_xsmm_binary_dispatch(int64_t m, int64_t n,
+                                                     int64_t ldiLhs,
+                                                     int64_t ldiRhs,
+                                                     int64_t ldo, int64_t type,
+                                                     int64_t bcast_type) {
+  tpp::KernelKey key =
+      tpp::makeEltwiseKey(KernelKind::BINARY, KernelDataType::F32, m, n,
+                          ldiLhs, ldiRhs, ldo, type, bcast_type);
+  return KernelCache::get().lookupOrDispatch(key, [&]() {
+    return xsmm_binary_dispatch_impl(m, n, ldiLhs, ldiRhs, ldo, type,
+                                     bcast_type);
+  });
+}
+
+extern "C" void xsmm_dispatch_cache_stats(int64_t *hits, int64_t *misses) {
+  if (hits)
+    *hits = KernelCache::get().getNumHits();
+  if (misses)
+    *misses = KernelCache::get().getNumMisses();
+}
+
+extern "C" void xsmm_dispatch_cache_reset_stats() {
+  KernelCache::get().resetStats();
+}
+
+//----------------------------------------------------------------------------//
+// Kernel profiling.
+//----------------------------------------------------------------------------//
+
+using tpp::KernelProfile;
+using tpp::KernelProfiler;
+
+extern "C" void xsmm_profile_enable(int64_t enable) {
+  KernelProfiler::setEnabled(enable != 0);
+}
+
+extern "C" int64_t xsmm_profile_get_entries(xsmm_profile_entry *entries,
+                                            int64_t maxEntries) {
+  std::vector<KernelProfile> profiles = KernelProfiler::get().collect();
+  int64_t numEntries = static_cast<int64_t>(profiles.size());
+  for (int64_t idx = 0; idx < numEntries && idx < maxEntries; idx++) {
+    const KernelProfile &profile = profiles[idx];
+    xsmm_profile_entry &entry = entries[idx];
+    entry.kind = profile.hasKey ? profile.key.kind : -1;
+    entry.dtype = profile.key.dtype;
+    entry.m = profile.key.m;
+    entry.n = profile.key.n;
+    entry.k = profile.key.k;
+    entry.lda = profile.key.lda;
+    entry.ldb = profile.key.ldb;
+    entry.ldc = profile.key.ldc;
+    entry.op = profile.key.op;
+    entry.flags = profile.key.flags;
+    entry.calls = profile.calls;
+    entry.totalSeconds = profile.totalNs * 1e-9;
+    entry.minSeconds = profile.minNs * 1e-9;
+    entry.maxSeconds = profile.maxNs * 1e-9;
+    entry.gflops = profile.getFlops() / profile.totalNs;
+    entry.gbytesPerSecond = profile.getBytes() / profile.totalNs;
+  }
+  return numEntries;
+}
+
+extern "C" void xsmm_profile_print() { KernelProfiler::get().print(stderr); }
+
+extern "C" void xsmm_profile_reset() { KernelProfiler::get().reset(); }
+
+//----------------------------------------------------------------------------//
+// Kernel trace.
+//----------------------------------------------------------------------------//
+
+using tpp::KernelTracer;
+
+extern "C" void xsmm_trace_site(int64_t id, char *sites, int64_t offset) {
+  KernelTracer::setSite(id, sites + offset);
+}
+
+extern "C" void xsmm_trace_enable(int64_t enable) {
+  KernelTracer::setEnabled(enable != 0);
+}
+
+extern "C" int xsmm_trace_write(const char *path) {
+  return KernelTracer::get().write(path) ? 0 : -1;
+}
+
+extern "C" void xsmm_trace_reset() { KernelTracer::get().reset(); }
+
+//----------------------------------------------------------------------------//
+// Bare-pointer ABI: every memref is an (aligned pointer, offset) pair.
+//----------------------------------------------------------------------------//
+
+extern "C" void xsmm_matmul_invoke_f32(int64_t addr, float *A, int64_t offsetA,
+                                       float *B, int64_t offsetB, float *C,
+                                       int64_t offsetC) {
+  xsmm_matmul_invoke_impl(addr, A + offsetA, B + offsetB, C + offsetC);
+}
+
+extern "C" void xsmm_matmul_invoke_bf16(int64_t addr, bf16 *A, int64_t offsetA,
+                                        bf16 *B, int64_t offsetB, bf16 *C,
+                                        int64_t offsetC) {
+  xsmm_matmul_invoke_impl(addr, A + offsetA, B + offsetB, C + offsetC);
+}
+
+extern "C" void xsmm_matmul_invoke_bf16_f32(int64_t addr, bf16 *A,
+                                            int64_t offsetA, bf16 *B,
+                                            int64_t offsetB, float *C,
+                                            int64_t offsetC) {
+  xsmm_matmul_invoke_impl(addr, A + offsetA, B + offsetB, C + offsetC);
+}
+
+extern "C" void xsmm_brgemm_invoke_f32(int64_t addr, float *A, int64_t offsetA,
+                                       float *B, int64_t offsetB, float *C,
+                                       int64_t offsetC, int64_t numBatches) {
+  xsmm_brgemm_invoke_impl(addr, A + offsetA, B + offsetB, C + offsetC,
+                          numBatches);
+}
+
+extern "C" void xsmm_brgemm_invoke_bf16(int64_t addr, bf16 *A, int64_t offsetA,
+                                        bf16 *B, int64_t offsetB, bf16 *C,
+                                        int64_t offsetC, int64_t numBatches) {
+  xsmm_brgemm_invoke_impl(addr, A + offsetA, B + offsetB, C + offsetC,
+                          numBatches);
+}
+
+extern "C" void xsmm_brgemm_invoke_bf16_f32(int64_t addr, bf16 *A,
+                                            int64_t offsetA, bf16 *B,
+                                            int64_t offsetB, float *C,
+                                            int64_t offsetC,
+                                            int64_t numBatches) {
+  xsmm_brgemm_invoke_impl(addr, A + offsetA, B + offsetB, C + offsetC,
+                          numBatches);
+}
+
+extern "C" void xsmm_fused_brgemm_invoke_f32(int64_t addr, float *A,
+                                             int64_t offsetA, float *B,
+                                             int64_t offsetB, float *bias,
+                                             int64_t offsetBias, float *C,
+                                             int64_t offsetC,
+                                             int64_t numBatches) {
+  xsmm_fused_brgemm_invoke_impl(addr, A + offsetA, B + offsetB,
+                                bias + offsetBias, C + offsetC, numBatches);
+}
+
+extern "C" void xsmm_fused_brgemm_invoke_bf16(int64_t addr, bf16 *A,
+                                              int64_t offsetA, bf16 *B,
+                                              int64_t offsetB, bf16 *bias,
+                                              int64_t offsetBias, bf16 *C,
+                                              int64_t offsetC,
+                                              int64_t numBatches) {
+  xsmm_fused_brgemm_invoke_impl(addr, A + offsetA, B + offsetB,
+                                bias + offsetBias, C + offsetC, numBatches);
+}
+
+extern "C" void xsmm_brgemm_offs_invoke_f32(int64_t addr, float *A,
+                                            int64_t offsetA, float *B,
+                                            int64_t offsetB, float *C,
+                                            int64_t offsetC, int64_t *offsetsA,
+                                            int64_t offsetOffsetsA,
+                                            int64_t *offsetsB,
+                                            int64_t offsetOffsetsB,
+                                            int64_t numBatches) {
+  xsmm_brgemm_offs_invoke_impl(addr, A + offsetA, B + offsetB, C + offsetC,
+                               offsetsA + offsetOffsetsA,
+                               offsetsB + offsetOffsetsB, numBatches);
+}
+
+extern "C" void xsmm_brgemm_offs_invoke_bf16(int64_t addr, bf16 *A,
+                                             int64_t offsetA, bf16 *B,
+                                             int64_t offsetB, bf16 *C,
+                                             int64_t offsetC, int64_t *offsetsA,
+                                             int64_t offsetOffsetsA,
+                                             int64_t *offsetsB,
+                                             int64_t offsetOffsetsB,
+                                             int64_t numBatches) {
+  xsmm_brgemm_offs_invoke_impl(addr, A + offsetA, B + offsetB, C + offsetC,
+                               offsetsA + offsetOffsetsA,
+                               offsetsB + offsetOffsetsB, numBatches);
+}
+
+extern "C" void xsmm_brgemm_addr_invoke_f32(int64_t addr, float *A,
+                                            int64_t offsetA, float *B,
+                                            int64_t offsetB, float *C,
+                                            int64_t offsetC, int64_t *offsetsA,
+                                            int64_t offsetOffsetsA,
+                                            int64_t *offsetsB,
+                                            int64_t offsetOffsetsB,
+                                            int64_t numBatches) {
+  xsmm_brgemm_addr_invoke_impl(addr, A + offsetA, B + offsetB, C + offsetC,
+                               offsetsA + offsetOffsetsA,
+                               offsetsB + offsetOffsetsB, numBatches);
+}
+
+extern "C" void xsmm_brgemm_addr_invoke_bf16(int64_t addr, bf16 *A,
+                                             int64_t offsetA, bf16 *B,
+                                             int64_t offsetB, bf16 *C,
+                                             int64_t offsetC, int64_t *offsetsA,
+                                             int64_t offsetOffsetsA,
+                                             int64_t *offsetsB,
+                                             int64_t offsetOffsetsB,
+                                             int64_t numBatches) {
+  xsmm_brgemm_addr_invoke_impl(addr, A + offsetA, B + offsetB, C + offsetC,
+                               offsetsA + offsetOffsetsA,
+                               offsetsB + offsetOffsetsB, numBatches);
+}
+
+extern "C" void xsmm_muladd_invoke_f32(int64_t addr, float *A, int64_t offsetA,
+                                       float *B, int64_t offsetB, float *C,
+                                       int64_t offsetC) {
+  xsmm_muladd_invoke_impl(addr, A + offsetA, B + offsetB, C + offsetC);
+}
+
+extern "C" void xsmm_muladd_invoke_bf16(int64_t addr, bf16 *A, int64_t offsetA,
+                                        bf16 *B, int64_t offsetB, bf16 *C,
+                                        int64_t offsetC) {
+  xsmm_muladd_invoke_impl(addr, A + offsetA, B + offsetB, C + offsetC);
+}
+
+extern "C" void xsmm_unary_invoke_f32(int64_t addr, float *input,
+                                      int64_t offsetInput, float *output,
+                                      int64_t offsetOutput) {
+  xsmm_unary_invoke_impl(addr, input + offsetInput, output + offsetOutput);
+}
+
+extern "C" void xsmm_unary_invoke_bf16(int64_t addr, bf16 *input,
+                                       int64_t offsetInput, bf16 *output,
+                                       int64_t offsetOutput) {
+  xsmm_unary_invoke_impl(addr, input + offsetInput, output + offsetOutput);
+}
+
+extern "C" void xsmm_unary_scalar_invoke_f32(int64_t addr, float input,
+                                             float *output,
+                                             int64_t offsetOutput) {
+  xsmm_unary_scalar_invoke_impl(addr, input, output + offsetOutput);
+}
+
+extern "C" void xsmm_unary_scalar_invoke_bf16(int64_t addr, bf16 input,
+                                              bf16 *output,
+                                              int64_t offsetOutput) {
+  xsmm_unary_scalar_invoke_impl(addr, input, output + offsetOutput);
+}
+
+extern "C" void xsmm_binary_invoke(int64_t addr, float *lhs, int64_t offsetLhs,
+                                   float *rhs, int64_t offsetRhs) {
+  xsmm_binary_invoke_impl(addr, lhs + offsetLhs, rhs + offsetRhs);
+}
+
 //----------------------------------------------------------------------------//
 // BRGEMM connection on the IREE side.
 //----------------------------------------------------------------------------//
@@ -643,22 +1377,8 @@ extern "C" int iree_xsmm_brgemm_invoke_f32(void *context, void *params,
     int64_t numBatches;
   } xsmm_brgemm_invoke_f32_t;
   xsmm_brgemm_invoke_f32_t *p = (xsmm_brgemm_invoke_f32_t *)params;
-
-  float *addr_tensorA = p->pA + p->offA;
-  float *addr_tensorB = p->pB + p->offB;
-  float *addr_tensorC = p->pC + p->offC;
-
-  libxsmm_xmmfunction sgemm;
-  libxsmm_gemm_param gemm_param;
-  sgemm.gemm = reinterpret_cast<libxsmm_gemmfunction>(p->addr);
-  unsigned long long numBatchesVar = p->numBatches;
-  // LIBXSMM col-major change A with B.
-  gemm_param.a.primary = (void *)addr_tensorB;
-  gemm_param.b.primary = (void *)addr_tensorA;
-  gemm_param.c.primary = (void *)addr_tensorC;
-  gemm_param.op.tertiary = (void *)&numBatchesVar;
-  sgemm.gemm(&gemm_param);
-
+  xsmm_brgemm_invoke_impl(p->addr, p->pA + p->offA, p->pB + p->offB,
+                          p->pC + p->offC, p->numBatches);
   return 0;
 }
 
@@ -674,20 +1394,8 @@ extern "C" int iree_xsmm_matmul_invoke_f32(void *context, void *params,
     int64_t offC;
   } xsmm_matmul_invoke_f32_t;
   xsmm_matmul_invoke_f32_t *p = (xsmm_matmul_invoke_f32_t *)params;
-
-  float *addr_tensorA = p->pA + p->offA;
-  float *addr_tensorB = p->pB + p->offB;
-  float *addr_tensorC = p->pC + p->offC;
-
-  libxsmm_xmmfunction sgemm;
-  libxsmm_gemm_param gemm_param;
-  // LIBXSMM col-major change A with B.
-  gemm_param.a.primary = (void *)addr_tensorB;
-  gemm_param.b.primary = (void *)addr_tensorA;
-  gemm_param.c.primary = (void *)addr_tensorC;
-  sgemm.gemm = reinterpret_cast<libxsmm_gemmfunction>(p->addr);
-  sgemm.gemm(&gemm_param);
-
+  xsmm_matmul_invoke_impl(p->addr, p->pA + p->offA, p->pB + p->offB,
+                          p->pC + p->offC);
   return 0;
 }
 
@@ -701,16 +1409,6 @@ extern "C" int iree_xsmm_unary_invoke(void *context, void *params,
     int64_t offB;
   } xsmm_unary_invoke;
   xsmm_unary_invoke *p = (xsmm_unary_invoke *)params;
-
-  float *addr_a = p->pA + p->offA;
-  float *addr_b = p->pB + p->offB;
-
-  libxsmm_meltwfunction_unary kernel =
-      reinterpret_cast<libxsmm_meltwfunction_unary>(p->addr);
-  libxsmm_meltw_unary_param param;
-  param.in.primary = (void *)addr_a;
-  param.out.primary = (void *)addr_b;
-  kernel(&param);
-
+  xsmm_unary_invoke_impl(p->addr, p->pA + p->offA, p->pB + p->offB);
   return 0;
 }
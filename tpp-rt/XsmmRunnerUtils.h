@@ -82,6 +82,42 @@ _mlir_ciface_matrix_copy_NC_to_NCNC(UnrankedMemRefType<float> *,
                                     UnrankedMemRefType<float> *, int64_t,
                                     int64_t, int64_t, int64_t);
 
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_xsmm_pack_NC_to_NCnc_f32(UnrankedMemRefType<float> *,
+                                      UnrankedMemRefType<float> *);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_xsmm_pack_NC_to_NCnc_bf16(UnrankedMemRefType<bf16> *,
+                                       UnrankedMemRefType<bf16> *);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_xsmm_pack_KC_to_CKkc_f32(UnrankedMemRefType<float> *,
+                                      UnrankedMemRefType<float> *);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_xsmm_pack_KC_to_CKkc_bf16(UnrankedMemRefType<bf16> *,
+                                       UnrankedMemRefType<bf16> *);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_xsmm_unpack_NCnc_to_NC_f32(UnrankedMemRefType<float> *,
+                                        UnrankedMemRefType<float> *);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_xsmm_unpack_NCnc_to_NC_bf16(UnrankedMemRefType<bf16> *,
+                                         UnrankedMemRefType<bf16> *);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_xsmm_unpack_CKkc_to_KC_f32(UnrankedMemRefType<float> *,
+                                        UnrankedMemRefType<float> *);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_xsmm_unpack_CKkc_to_KC_bf16(UnrankedMemRefType<bf16> *,
+                                         UnrankedMemRefType<bf16> *);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_xsmm_pack_vnni_bf16(UnrankedMemRefType<bf16> *,
+                                 UnrankedMemRefType<bf16> *);
+
 extern "C" MLIR_RUNNERUTILS_EXPORT void
 _mlir_ciface_xsmm_brgemm_invoke_f32(int64_t, UnrankedMemRefType<float> *,
                                     UnrankedMemRefType<float> *,
@@ -91,6 +127,280 @@ extern "C" MLIR_RUNNERUTILS_EXPORT void
 _mlir_ciface_xsmm_brgemm_invoke_bf16(int64_t, UnrankedMemRefType<bf16> *,
                                      UnrankedMemRefType<bf16> *,
                                      UnrankedMemRefType<bf16> *, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT int64_t
+_mlir_ciface_xsmm_fused_brgemm_dispatch_f32(int64_t, int64_t, int64_t, int64_t,
+                                            int64_t, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT int64_t
+_mlir_ciface_xsmm_fused_brgemm_dispatch_bf16(int64_t, int64_t, int64_t,
+                                             int64_t, int64_t, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_xsmm_fused_brgemm_invoke_f32(int64_t, UnrankedMemRefType<float> *,
+                                          UnrankedMemRefType<float> *,
+                                          UnrankedMemRefType<float> *,
+                                          UnrankedMemRefType<float> *, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_xsmm_fused_brgemm_invoke_bf16(int64_t, UnrankedMemRefType<bf16> *,
+                                           UnrankedMemRefType<bf16> *,
+                                           UnrankedMemRefType<bf16> *,
+                                           UnrankedMemRefType<bf16> *,
+                                           int64_t);
+
+//----------------------------------------------------------------------------//
+// BRGEMM over lists of byte offsets (`offs`) or addresses (`addr`) of the
+// batch matrices. The invocation takes A, B, C, the offsets of the batch
+// matrices in A and B, and the batch size; the address-list kernels get the
+// addresses computed from the offsets.
+//----------------------------------------------------------------------------//
+
+extern "C" MLIR_RUNNERUTILS_EXPORT int64_t
+_mlir_ciface_xsmm_brgemm_offs_dispatch_f32(int64_t, int64_t, int64_t, int64_t,
+                                           int64_t, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT int64_t
+_mlir_ciface_xsmm_brgemm_offs_dispatch_bf16(int64_t, int64_t, int64_t, int64_t,
+                                            int64_t, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_xsmm_brgemm_offs_invoke_f32(
+    int64_t, UnrankedMemRefType<float> *, UnrankedMemRefType<float> *,
+    UnrankedMemRefType<float> *, UnrankedMemRefType<int64_t> *,
+    UnrankedMemRefType<int64_t> *, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_xsmm_brgemm_offs_invoke_bf16(
+    int64_t, UnrankedMemRefType<bf16> *, UnrankedMemRefType<bf16> *,
+    UnrankedMemRefType<bf16> *, UnrankedMemRefType<int64_t> *,
+    UnrankedMemRefType<int64_t> *, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT int64_t
+_mlir_ciface_xsmm_brgemm_addr_dispatch_f32(int64_t, int64_t, int64_t, int64_t,
+                                           int64_t, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT int64_t
+_mlir_ciface_xsmm_brgemm_addr_dispatch_bf16(int64_t, int64_t, int64_t, int64_t,
+                                            int64_t, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_xsmm_brgemm_addr_invoke_f32(
+    int64_t, UnrankedMemRefType<float> *, UnrankedMemRefType<float> *,
+    UnrankedMemRefType<float> *, UnrankedMemRefType<int64_t> *,
+    UnrankedMemRefType<int64_t> *, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_xsmm_brgemm_addr_invoke_bf16(
+    int64_t, UnrankedMemRefType<bf16> *, UnrankedMemRefType<bf16> *,
+    UnrankedMemRefType<bf16> *, UnrankedMemRefType<int64_t> *,
+    UnrankedMemRefType<int64_t> *, int64_t);
+
+//----------------------------------------------------------------------------//
+// Element-wise multiply-add C += A * B. The dispatch takes m, n, lda, ldb and
+// ldc, with ldb = 0 for a row vector B broadcast along the rows of C.
+//----------------------------------------------------------------------------//
+
+extern "C" MLIR_RUNNERUTILS_EXPORT int64_t
+_mlir_ciface_xsmm_muladd_dispatch_f32(int64_t, int64_t, int64_t, int64_t,
+                                      int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT int64_t
+_mlir_ciface_xsmm_muladd_dispatch_bf16(int64_t, int64_t, int64_t, int64_t,
+                                       int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_xsmm_muladd_invoke_f32(int64_t, UnrankedMemRefType<float> *,
+                                    UnrankedMemRefType<float> *,
+                                    UnrankedMemRefType<float> *);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_xsmm_muladd_invoke_bf16(int64_t, UnrankedMemRefType<bf16> *,
+                                     UnrankedMemRefType<bf16> *,
+                                     UnrankedMemRefType<bf16> *);
+
+//----------------------------------------------------------------------------//
+// Mixed precision: bf16 inputs, f32 accumulation and f32 output.
+//----------------------------------------------------------------------------//
+
+extern "C" MLIR_RUNNERUTILS_EXPORT int64_t
+_mlir_ciface_xsmm_matmul_dispatch_bf16_f32_f32(int64_t, int64_t, int64_t,
+                                               int64_t, int64_t, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT int64_t
+_mlir_ciface_xsmm_brgemm_dispatch_bf16_f32_f32(int64_t, int64_t, int64_t,
+                                               int64_t, int64_t, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_xsmm_matmul_invoke_bf16_f32(int64_t, UnrankedMemRefType<bf16> *,
+                                         UnrankedMemRefType<bf16> *,
+                                         UnrankedMemRefType<float> *);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+_mlir_ciface_xsmm_brgemm_invoke_bf16_f32(int64_t, UnrankedMemRefType<bf16> *,
+                                         UnrankedMemRefType<bf16> *,
+                                         UnrankedMemRefType<float> *, int64_t);
+
+//----------------------------------------------------------------------------//
+// Bare-pointer ABI (-convert-xsmm-to-func="use-extract-metadata"). Each memref
+// is passed as its aligned pointer and offset, in elements; sizes and strides
+// are already encoded in the dispatched kernel.
+//----------------------------------------------------------------------------//
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+xsmm_matmul_invoke_f32(int64_t, float *, int64_t, float *, int64_t, float *,
+                       int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+xsmm_matmul_invoke_bf16(int64_t, bf16 *, int64_t, bf16 *, int64_t, bf16 *,
+                        int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+xsmm_matmul_invoke_bf16_f32(int64_t, bf16 *, int64_t, bf16 *, int64_t, float *,
+                            int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+xsmm_brgemm_invoke_f32(int64_t, float *, int64_t, float *, int64_t, float *,
+                       int64_t, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+xsmm_brgemm_invoke_bf16(int64_t, bf16 *, int64_t, bf16 *, int64_t, bf16 *,
+                        int64_t, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+xsmm_brgemm_invoke_bf16_f32(int64_t, bf16 *, int64_t, bf16 *, int64_t, float *,
+                            int64_t, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+xsmm_fused_brgemm_invoke_f32(int64_t, float *, int64_t, float *, int64_t,
+                             float *, int64_t, float *, int64_t, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+xsmm_fused_brgemm_invoke_bf16(int64_t, bf16 *, int64_t, bf16 *, int64_t,
+                              bf16 *, int64_t, bf16 *, int64_t, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+xsmm_brgemm_offs_invoke_f32(int64_t, float *, int64_t, float *, int64_t,
+                            float *, int64_t, int64_t *, int64_t, int64_t *,
+                            int64_t, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+xsmm_brgemm_offs_invoke_bf16(int64_t, bf16 *, int64_t, bf16 *, int64_t,
+                             bf16 *, int64_t, int64_t *, int64_t, int64_t *,
+                             int64_t, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+xsmm_brgemm_addr_invoke_f32(int64_t, float *, int64_t, float *, int64_t,
+                            float *, int64_t, int64_t *, int64_t, int64_t *,
+                            int64_t, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+xsmm_brgemm_addr_invoke_bf16(int64_t, bf16 *, int64_t, bf16 *, int64_t,
+                             bf16 *, int64_t, int64_t *, int64_t, int64_t *,
+                             int64_t, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+xsmm_muladd_invoke_f32(int64_t, float *, int64_t, float *, int64_t, float *,
+                       int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+xsmm_muladd_invoke_bf16(int64_t, bf16 *, int64_t, bf16 *, int64_t, bf16 *,
+                        int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+xsmm_unary_invoke_f32(int64_t, float *, int64_t, float *, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+xsmm_unary_invoke_bf16(int64_t, bf16 *, int64_t, bf16 *, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+xsmm_unary_scalar_invoke_f32(int64_t, float, float *, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+xsmm_unary_scalar_invoke_bf16(int64_t, bf16, bf16 *, int64_t);
+
+extern "C" MLIR_RUNNERUTILS_EXPORT void xsmm_binary_invoke(int64_t, float *,
+                                                           int64_t, float *,
+                                                           int64_t);
+
+//----------------------------------------------------------------------------//
+// Kernel cache statistics.
+//----------------------------------------------------------------------------//
+
+/// Number of dispatch requests served from the process-wide kernel cache
+/// (hits) and of requests that had to JIT a new kernel (misses). Either
+/// pointer can be null.
+extern "C" MLIR_RUNNERUTILS_EXPORT void
+xsmm_dispatch_cache_stats(int64_t *hits, int64_t *misses);
+
+/// Reset the hit/miss counters. Cached kernels are kept.
+extern "C" MLIR_RUNNERUTILS_EXPORT void xsmm_dispatch_cache_reset_stats();
+
+//----------------------------------------------------------------------------//
+// Kernel profiling. Setting TPP_XSMM_PROFILE to a non-zero value times every
+// kernel invocation and prints a per-kernel table to stderr at process exit.
+//----------------------------------------------------------------------------//
+
+/// Counters of one dispatched kernel. The descriptor fields follow the
+/// dispatch arguments; `kind` is -1 if the kernel is not in the dispatch
+/// cache. `gflops` is zero for element-wise kernels.
+typedef struct {
+  int64_t kind;
+  int64_t dtype;
+  int64_t m;
+  int64_t n;
+  int64_t k;
+  int64_t lda;
+  int64_t ldb;
+  int64_t ldc;
+  int64_t op;
+  int64_t flags;
+  int64_t calls;
+  double totalSeconds;
+  double minSeconds;
+  double maxSeconds;
+  double gflops;
+  double gbytesPerSecond;
+} xsmm_profile_entry;
+
+/// Turn profiling on or off at run time, regardless of TPP_XSMM_PROFILE.
+extern "C" MLIR_RUNNERUTILS_EXPORT void xsmm_profile_enable(int64_t enable);
+
+/// Copy up to `maxEntries` entries, sorted by decreasing total time, to
+/// `entries` and return the number of profiled kernels.
+extern "C" MLIR_RUNNERUTILS_EXPORT int64_t
+xsmm_profile_get_entries(xsmm_profile_entry *entries, int64_t maxEntries);
+
+/// Print the profile table to stderr.
+extern "C" MLIR_RUNNERUTILS_EXPORT void xsmm_profile_print();
+
+/// Reset all the counters.
+extern "C" MLIR_RUNNERUTILS_EXPORT void xsmm_profile_reset();
+
+//----------------------------------------------------------------------------//
+// Kernel trace. Setting TPP_XSMM_TRACE to a path records every kernel
+// invocation and block repacking in per-thread ring buffers of
+// TPP_XSMM_TRACE_EVENTS events (65536 by default), written to the path as a
+// Chrome trace at process exit.
+//----------------------------------------------------------------------------//
+
+/// Label the next kernel invocation of the calling thread with site `id`,
+/// whose source location is the NUL-terminated string at `sites + offset`.
+/// Emitted by -convert-xsmm-to-func="trace-kernel-sites".
+extern "C" MLIR_RUNNERUTILS_EXPORT void xsmm_trace_site(int64_t id,
+                                                        char *sites,
+                                                        int64_t offset);
+
+/// Turn tracing on or off at run time, regardless of TPP_XSMM_TRACE.
+extern "C" MLIR_RUNNERUTILS_EXPORT void xsmm_trace_enable(int64_t enable);
+
+/// Write the recorded events to `path`. Returns 0 on success, -1 if the file
+/// cannot be written.
+extern "C" MLIR_RUNNERUTILS_EXPORT int xsmm_trace_write(const char *path);
+
+/// Drop all the recorded events.
+extern "C" MLIR_RUNNERUTILS_EXPORT void xsmm_trace_reset();
+
 //----------------------------------------------------------------------------//
 // BRGEMM connection on the IREE side.
 //----------------------------------------------------------------------------//
@@ -33,6 +33,10 @@
 #include "mlir/Pass/Pass.h"
 #include "mlir/Pass/PassManager.h"
 
+#include "TPP/Dialect/Stdx/StdxDialect.h"
+#include "TPP/Dialect/Xsmm/XsmmDialect.h"
+#include "TPP/Passes.h"
+
 using namespace mlir;
 
 // This is a hack, to parse the command-line options locally
@@ -57,10 +61,14 @@ static void locaCmdLineOptParsing(int argc, char **argv) {
 static LogicalResult lowerToLLVMDialect(ModuleOp module) {
   // Minimal passes to make it work
   // We don't want TPP passes here, as that's the job of tpp-opt
-  // The IR here should be free of TPP/XSMM or any TPP extensions
+  // The IR here should be free of TPP/XSMM or any TPP extensions, but for
+  // stdx.closure which has no lowering of its own
   PassManager passManager(module.getContext());
   applyPassManagerCLOptions(passManager);
 
+  // Split the kernels wrapped in a closure into init and run functions
+  passManager.addPass(tpp::createClosureToInitRunPass());
+
   // Bufferization, if needed
   passManager.addNestedPass<func::FuncOp>(createTensorBufferizePass());
   passManager.addNestedPass<func::FuncOp>(vector::createVectorBufferizePass());
@@ -74,6 +82,8 @@ static LogicalResult lowerToLLVMDialect(ModuleOp module) {
   passManager.addPass(createConvertSCFToCFPass());
 
   // Lower to LLVM
+  // Kernels parallelized by tpp-opt come with OpenMP regions
+  passManager.addPass(createConvertOpenMPToLLVMPass());
   passManager.addPass(createConvertVectorToLLVMPass());
   passManager.addPass(createConvertFuncToLLVMPass());
   passManager.addPass(createMemRefToLLVMConversionPass());
@@ -138,10 +148,25 @@ static LogicalResult prepareMLIRKernel(Operation *op) {
     return module.emitError("No valid entry point, use mlir-cpu-runner");
   }
 
+  // If the xsmm dispatches have been hoisted, the kernel table must be filled
+  // before running the kernel
+  func::FuncOp dispatchInit;
+  for (auto& op: moduleOps) {
+    func::FuncOp func = dyn_cast_or_null<func::FuncOp>(op);
+    if (func && func->hasAttr(xsmm::XsmmDialect::getDispatchInitAttrName())) {
+      dispatchInit = func;
+      break;
+    }
+  }
+
   // If the function has no args or return values, just run it as is
   auto funcType = kernel.getFunctionType();
   if (funcType.getNumInputs() == 0 && funcType.getNumResults() == 0) {
     module.emitRemark("Entry point already created, just running the IR");
+    if (dispatchInit) {
+      auto initBuilder = OpBuilder::atBlockBegin(&kernel.getBody().front());
+      initBuilder.create<func::CallOp>(kernel.getLoc(), dispatchInit);
+    }
     return lowerToLLVMDialect(module);
   }
 
@@ -198,6 +223,8 @@ static LogicalResult prepareMLIRKernel(Operation *op) {
 
   // Get those globals as arguments (function insertion point)
   builder.setInsertionPointToStart(entryBlock);
+  if (dispatchInit)
+    builder.create<func::CallOp>(loc, dispatchInit);
   SmallVector<Value> args;
   order = 0;
   for (auto& ty: funcType.getInputs()) {
@@ -264,6 +291,7 @@ int main(int argc, char **argv) {
   // will be *parsed* by the tool, not the one generated
   DialectRegistry registry;
   registerAllDialects(registry);
+  registry.insert<mlir::stdx::StdxDialect>();
   registerAllToLLVMIRTranslations(registry);
 
   // This is how we integrate with the pipeline
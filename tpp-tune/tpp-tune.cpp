@@ -0,0 +1,540 @@
+//===- tpp-tune.cpp - TPP offline autotuner -------------------------------===//
+//
+// Main entry point to a command line utility that sweeps the block factors and
+// tile sizes of the TPP passes for every op of an MLIR kernel. Each variant is
+// compiled with the given pass pipeline, JIT-compiled and timed, and the
+// fastest parameters for each op are written to a tuning database that the
+// passes read back (see TPP/TuningDatabase.h).
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/TargetSelect.h"
+
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Arith/Transforms/Passes.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Linalg/Passes.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/ExecutionEngine/ExecutionEngine.h"
+#include "mlir/ExecutionEngine/OptUtils.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/InitAllDialects.h"
+#include "mlir/InitAllPasses.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Pass/PassInstrumentation.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Pass/PassRegistry.h"
+#include "mlir/Target/LLVMIR/Dialect/All.h"
+
+#include "TPP/CostModel.h"
+#include "TPP/Dialect/LinalgX/BufferizableOpInterfaceImpl.h"
+#include "TPP/Dialect/LinalgX/LinalgXDialect.h"
+#include "TPP/Dialect/Mathx/MathxDialect.h"
+#include "TPP/Dialect/Stdx/StdxDialect.h"
+#include "TPP/Dialect/Tpp/TppDialect.h"
+#include "TPP/Dialect/Tpp/TppUtils.h"
+#include "TPP/Dialect/Xsmm/XsmmDialect.h"
+#include "TPP/Passes.h"
+#include "TPP/TuningDatabase.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <limits>
+#include <numeric>
+
+using namespace mlir;
+
+static llvm::cl::opt<std::string> inputFilename(llvm::cl::Positional,
+                                                llvm::cl::desc("<input file>"),
+                                                llvm::cl::init("-"));
+
+static llvm::cl::opt<std::string> pipeline(
+    "pipeline", llvm::cl::Required,
+    llvm::cl::desc("Pass pipeline compiling the kernel, up to but excluding "
+                   "the lowering to LLVM"));
+
+static llvm::cl::opt<std::string>
+    mainFuncName("e", llvm::cl::desc("The kernel function to time"),
+                 llvm::cl::value_desc("function name"),
+                 llvm::cl::init("entry"));
+
+static llvm::cl::opt<std::string>
+    outputFilename("o", llvm::cl::Required,
+                   llvm::cl::desc("Tuning database to create or update"),
+                   llvm::cl::value_desc("filename"));
+
+static llvm::cl::opt<unsigned>
+    maxCandidates("max-candidates",
+                  llvm::cl::desc("Maximum number of variants timed per op"),
+                  llvm::cl::init(32));
+
+static llvm::cl::opt<unsigned>
+    numIterations("n", llvm::cl::desc("Number of timed kernel calls"),
+                  llvm::cl::init(100));
+
+static llvm::cl::list<std::string>
+    sharedLibs("shared-libs", llvm::cl::desc("Libraries to link dynamically"),
+               llvm::cl::MiscFlags::CommaSeparated);
+
+//===----------------------------------------------------------------------===//
+// Tuning sites
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+// An op tuned by one of the passes of the pipeline and the parameters to try.
+struct TuningSite {
+  tpp::TuningEntry entry;
+  SmallVector<SmallVector<int64_t>> candidates;
+};
+
+} // namespace
+
+// Power-of-two divisors of `dim` smaller than `dim`, largest first.
+static SmallVector<int64_t> getPowerOfTwoDivisors(int64_t dim) {
+  SmallVector<int64_t> divisors;
+  for (int64_t divisor = 1; divisor < dim; divisor *= 2)
+    if (dim % divisor == 0)
+      divisors.push_back(divisor);
+  std::reverse(divisors.begin(), divisors.end());
+  return divisors;
+}
+
+// Every combination of one value per dimension.
+static SmallVector<SmallVector<int64_t>>
+getCartesianProduct(ArrayRef<SmallVector<int64_t>> valuesPerDim) {
+  SmallVector<SmallVector<int64_t>> product = {{}};
+  for (ArrayRef<int64_t> values : valuesPerDim) {
+    SmallVector<SmallVector<int64_t>> extended;
+    for (ArrayRef<int64_t> prefix : product) {
+      for (int64_t value : values) {
+        extended.push_back(llvm::to_vector(prefix));
+        extended.back().push_back(value);
+      }
+    }
+    product = std::move(extended);
+  }
+  return product;
+}
+
+// Block factors along M, N and K, ranked by the BRGEMM cost model. Blocks
+// smaller than 8 are only tried if the dimension has no larger divisor.
+static SmallVector<SmallVector<int64_t>>
+getMatmulCandidates(ArrayRef<int64_t> shape, int64_t elementBytes) {
+  SmallVector<SmallVector<int64_t>> factorsPerDim;
+  for (int64_t dim : shape) {
+    SmallVector<int64_t> factors = {dim};
+    for (int64_t divisor : getPowerOfTwoDivisors(dim))
+      if (divisor >= 8 || factors.size() == 1)
+        factors.push_back(divisor);
+    factorsPerDim.push_back(factors);
+  }
+  SmallVector<SmallVector<int64_t>> candidates =
+      getCartesianProduct(factorsPerDim);
+  auto getCost = [&](ArrayRef<int64_t> tiles) {
+    return tpp::estimateMatmulCost(shape[0], shape[1], shape[2], tiles[0],
+                                   tiles[1], tiles[2], elementBytes,
+                                   /*batchReduce=*/true, tpp::TargetInfo());
+  };
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [&](ArrayRef<int64_t> lhs, ArrayRef<int64_t> rhs) {
+                     return getCost(lhs) < getCost(rhs);
+                   });
+  return candidates;
+}
+
+// Block factors for the channels of a convolution. The first factor blocks
+// both the input and the output channels, thus it must divide both.
+static SmallVector<SmallVector<int64_t>>
+getConvCandidates(int64_t inputChannels, int64_t outputChannels) {
+  int64_t common = std::gcd(inputChannels, outputChannels);
+  SmallVector<int64_t> factors = {common};
+  llvm::append_range(factors, getPowerOfTwoDivisors(common));
+  return getCartesianProduct({factors, factors});
+}
+
+// Tile sizes for each loop: untiled or a power-of-two divisor. Variants that
+// tile fewer loops come first.
+static SmallVector<SmallVector<int64_t>>
+getTileSizesCandidates(ArrayRef<int64_t> shape) {
+  SmallVector<SmallVector<int64_t>> sizesPerDim;
+  for (int64_t dim : shape) {
+    SmallVector<int64_t> sizes = {0};
+    llvm::append_range(sizes, getPowerOfTwoDivisors(dim));
+    sizesPerDim.push_back(sizes);
+  }
+  SmallVector<SmallVector<int64_t>> candidates =
+      getCartesianProduct(sizesPerDim);
+  auto getNumTiledLoops = [](ArrayRef<int64_t> sizes) {
+    return llvm::count_if(sizes, [](int64_t size) { return size != 0; });
+  };
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [&](ArrayRef<int64_t> lhs, ArrayRef<int64_t> rhs) {
+                     return getNumTiledLoops(lhs) < getNumTiledLoops(rhs);
+                   });
+  // The all-zero variant is the pass default.
+  candidates.erase(candidates.begin());
+  return candidates;
+}
+
+// Return `linalgOp` as a site if `pass` looks up its parameters. The
+// conditions mirror the ops each pass rewrites.
+static Optional<TuningSite> getTuningSite(StringRef pass,
+                                          linalg::LinalgOp linalgOp) {
+  FailureOr<tpp::TuningEntry> entry = tpp::TuningEntry::get(pass, linalgOp);
+  if (failed(entry))
+    return llvm::None;
+  TuningSite site;
+  ArrayRef<int64_t> shape = entry->shape;
+  if (pass == "pack-matmul") {
+    // A marked linalg.generic is turned into a linalg.matmul by the pass.
+    if (!linalgOp.hasTensorSemantics() ||
+        !(isa<linalg::MatmulOp>(linalgOp) ||
+          tpp::isMarkedWithTpp(linalgOp, "tpp.matmul")))
+      return llvm::None;
+    entry->op = linalg::MatmulOp::getOperationName().str();
+    int64_t elementBytes =
+        getElementTypeOrSelf(linalgOp.getInputOperand(0)->get().getType())
+            .getIntOrFloatBitWidth() /
+        8;
+    site.candidates = getMatmulCandidates(shape, elementBytes);
+  } else if (pass == "pack-conv2DNchwFchw") {
+    if (!linalgOp.hasTensorSemantics())
+      return llvm::None;
+    if (isa<linalg::Conv2DNchwFchwOp>(linalgOp)) {
+      // Loops: [N][K][P][Q][C][R][S].
+      site.candidates = getConvCandidates(shape[4], shape[1]);
+    } else if (isa<linalg::Conv2DNgchwFgchwOp>(linalgOp)) {
+      // Loops: [N][G][K][P][Q][C][R][S].
+      entry->pass = "pack-conv2DNgchwFgchw";
+      site.candidates = getConvCandidates(shape[5], shape[2]);
+    } else {
+      return llvm::None;
+    }
+  } else if (pass == "pack-conv2DNhwcHwcf") {
+    if (!linalgOp.hasTensorSemantics())
+      return llvm::None;
+    if (isa<linalg::Conv2DNhwcHwcfOp>(linalgOp)) {
+      // Loops: [N][P][Q][K][R][S][C].
+      site.candidates = getConvCandidates(shape[6], shape[3]);
+    } else if (isa<linalg::DepthwiseConv2DNhwcHwcOp>(linalgOp)) {
+      // Loops: [N][P][Q][C][R][S]. Only the first factor blocks C.
+      entry->pass = "pack-depthwise-conv2DNhwcHwc";
+      site.candidates.push_back({shape[3]});
+      for (int64_t factor : getPowerOfTwoDivisors(shape[3]))
+        site.candidates.push_back({factor});
+    } else {
+      return llvm::None;
+    }
+  } else if (pass == "tile-consumer-and-fuse-producers") {
+    if (!isa<linalg::GenericOp>(linalgOp) ||
+        !linalgOp.hasTensorSemantics() || !linalg::isElementwise(linalgOp))
+      return llvm::None;
+    site.candidates = getTileSizesCandidates(shape);
+  } else if (pass == "convert-linalg-to-tpp") {
+    if (!linalgOp.hasBufferSemantics() || !tpp::hasTppMark(linalgOp))
+      return llvm::None;
+    site.candidates = getTileSizesCandidates(shape);
+  } else {
+    return llvm::None;
+  }
+  if (site.candidates.size() > maxCandidates)
+    site.candidates.resize(maxCandidates);
+  site.entry = *entry;
+  return site;
+}
+
+namespace {
+
+// Collect the ops visible to the tunable passes right before they run.
+struct TuningSiteCollector : public PassInstrumentation {
+  TuningSiteCollector(SmallVectorImpl<TuningSite> &sites) : sites(sites) {}
+
+  void runBeforePass(Pass *pass, Operation *op) override {
+    op->walk([&](linalg::LinalgOp linalgOp) {
+      Optional<TuningSite> site = getTuningSite(pass->getArgument(), linalgOp);
+      if (!site)
+        return;
+      // Ops with the same key share their parameters.
+      std::string key = site->entry.getKey();
+      if (llvm::any_of(sites, [&](const TuningSite &other) {
+            return other.entry.getKey() == key;
+          }))
+        return;
+      sites.push_back(std::move(*site));
+    });
+  }
+
+  SmallVectorImpl<TuningSite> &sites;
+};
+
+} // namespace
+
+//===----------------------------------------------------------------------===//
+// Compilation and timing
+//===----------------------------------------------------------------------===//
+
+// Run the user pipeline. If `sites` is set, collect the tunable ops.
+static LogicalResult runPipeline(ModuleOp module,
+                                 SmallVectorImpl<TuningSite> *sites) {
+  PassManager passManager(module.getContext());
+  if (failed(parsePassPipeline(pipeline, passManager, llvm::errs())))
+    return failure();
+  if (sites)
+    passManager.addInstrumentation(
+        std::make_unique<TuningSiteCollector>(*sites));
+  return passManager.run(module);
+}
+
+// Add a function that allocates and initializes the kernel arguments, then
+// calls the kernel as many times as its only argument. Return its name.
+static FailureOr<std::string> createTimingWrapper(ModuleOp module) {
+  auto kernel = module.lookupSymbol<func::FuncOp>(mainFuncName);
+  if (!kernel)
+    return module.emitError("kernel function '" + mainFuncName +
+                            "' not found");
+
+  // If the xsmm dispatches have been hoisted, the kernel table must be filled
+  // before running the kernel.
+  func::FuncOp dispatchInit;
+  for (func::FuncOp func : module.getOps<func::FuncOp>()) {
+    if (func->hasAttr(xsmm::XsmmDialect::getDispatchInitAttrName())) {
+      dispatchInit = func;
+      break;
+    }
+  }
+
+  OpBuilder builder = OpBuilder::atBlockEnd(module.getBody());
+  Location loc = kernel.getLoc();
+  std::string name = "_tpp_tune_" + mainFuncName;
+  auto wrapper = builder.create<func::FuncOp>(
+      loc, name, builder.getFunctionType({builder.getIndexType()}, {}));
+  Block *entryBlock = wrapper.addEntryBlock();
+  builder.setInsertionPointToStart(entryBlock);
+  if (dispatchInit)
+    builder.create<func::CallOp>(loc, dispatchInit);
+
+  SmallVector<Value> args;
+  for (Type type : kernel.getFunctionType().getInputs()) {
+    auto memrefType = type.dyn_cast<MemRefType>();
+    if (!memrefType || !memrefType.hasStaticShape() ||
+        !memrefType.getLayout().isIdentity())
+      return kernel.emitError("expect statically shaped memref arguments");
+    Value buffer = builder.create<memref::AllocOp>(
+        loc, memrefType, builder.getI64IntegerAttr(64));
+    Type elementType = memrefType.getElementType();
+    Attribute oneAttr = elementType.isa<FloatType>()
+                            ? Attribute(builder.getFloatAttr(elementType, 1.0))
+                            : Attribute(builder.getIntegerAttr(elementType, 1));
+    Value one = builder.create<arith::ConstantOp>(loc, oneAttr);
+    builder.create<linalg::FillOp>(loc, one, buffer);
+    args.push_back(buffer);
+  }
+
+  Value zero = builder.create<arith::ConstantIndexOp>(loc, 0);
+  Value step = builder.create<arith::ConstantIndexOp>(loc, 1);
+  builder.create<scf::ForOp>(
+      loc, zero, entryBlock->getArgument(0), step, llvm::None,
+      [&](OpBuilder &nestedBuilder, Location nestedLoc, Value, ValueRange) {
+        nestedBuilder.create<func::CallOp>(nestedLoc, kernel, args);
+        nestedBuilder.create<scf::YieldOp>(nestedLoc);
+      });
+  for (Value buffer : args)
+    builder.create<memref::DeallocOp>(loc, buffer);
+  builder.create<func::ReturnOp>(loc);
+  return name;
+}
+
+// Same lowering as tpp-run: the output of the pipeline is free of TPP/XSMM.
+static LogicalResult lowerToLLVMDialect(ModuleOp module) {
+  PassManager passManager(module.getContext());
+  passManager.addNestedPass<func::FuncOp>(createConvertLinalgToLoopsPass());
+  passManager.addPass(arith::createArithExpandOpsPass());
+  passManager.addPass(createConvertVectorToSCFPass());
+  passManager.addPass(createConvertSCFToCFPass());
+  passManager.addPass(createConvertOpenMPToLLVMPass());
+  passManager.addPass(createConvertVectorToLLVMPass());
+  passManager.addPass(createConvertFuncToLLVMPass());
+  passManager.addPass(createMemRefToLLVMConversionPass());
+  passManager.addNestedPass<func::FuncOp>(createArithToLLVMConversionPass());
+  passManager.addNestedPass<func::FuncOp>(createCanonicalizerPass());
+  passManager.addPass(createReconcileUnrealizedCastsPass());
+  return passManager.run(module);
+}
+
+// Compile `input` with the candidate database `db`, handed to the passes
+// through the file in `dbPath`, and return the average time of one kernel call
+// in seconds.
+static FailureOr<double> timeVariant(ModuleOp input,
+                                     const tpp::TuningDatabase &db,
+                                     StringRef dbPath) {
+  std::string error;
+  if (failed(db.save(dbPath, error))) {
+    llvm::errs() << error << "\n";
+    return failure();
+  }
+
+  // Invalid parameters are expected for some variants, skip them silently.
+  ScopedDiagnosticHandler silenceDiagnostics(
+      input.getContext(), [](Diagnostic &) { return success(); });
+  OwningOpRef<ModuleOp> module = input.clone();
+  if (failed(runPipeline(*module, /*sites=*/nullptr)))
+    return failure();
+  FailureOr<std::string> wrapperName = createTimingWrapper(*module);
+  if (failed(wrapperName) || failed(lowerToLLVMDialect(*module)))
+    return failure();
+
+  SmallVector<StringRef> libs(sharedLibs.begin(), sharedLibs.end());
+  ExecutionEngineOptions engineOptions;
+  engineOptions.transformer = makeOptimizingTransformer(
+      /*optLevel=*/3, /*sizeLevel=*/0, /*targetMachine=*/nullptr);
+  engineOptions.sharedLibPaths = libs;
+  auto engine = ExecutionEngine::create(*module, engineOptions);
+  if (!engine) {
+    llvm::errs() << llvm::toString(engine.takeError()) << "\n";
+    return failure();
+  }
+
+  // A first call dispatches the kernels and warms up the caches.
+  if (llvm::Error err = (*engine)->invoke(*wrapperName, int64_t(1))) {
+    llvm::errs() << llvm::toString(std::move(err)) << "\n";
+    return failure();
+  }
+  auto start = std::chrono::steady_clock::now();
+  if (llvm::Error err =
+          (*engine)->invoke(*wrapperName, int64_t(numIterations))) {
+    llvm::errs() << llvm::toString(std::move(err)) << "\n";
+    return failure();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / numIterations;
+}
+
+int main(int argc, char **argv) {
+  llvm::InitLLVM y(argc, argv);
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+  mlir::registerAllPasses();
+  registerTppCompilerPasses();
+  llvm::cl::ParseCommandLineOptions(argc, argv, "TPP offline autotuner\n");
+  if (numIterations == 0) {
+    llvm::errs() << "expect at least one timed kernel call\n";
+    return 1;
+  }
+
+  DialectRegistry registry;
+  registry.insert<mlir::tpp::TppDialect>();
+  registry.insert<mlir::mathx::MathxDialect>();
+  registry.insert<mlir::stdx::StdxDialect>();
+  registry.insert<mlir::xsmm::XsmmDialect>();
+  registry.insert<mlir::linalgx::LinalgXDialect>();
+  mlir::linalgx::registerBufferizableOpInterfaceExternalModels(registry);
+  registerAllDialects(registry);
+  registerAllToLLVMIRTranslations(registry);
+  MLIRContext context(registry);
+  context.loadAllAvailableDialects();
+  // Variants are compiled and timed one at a time.
+  context.disableMultithreading();
+
+  OwningOpRef<ModuleOp> input =
+      parseSourceFile<ModuleOp>(inputFilename, &context);
+  if (!input)
+    return 1;
+
+  // Entries of other kernels in an existing database are preserved.
+  tpp::TuningDatabase db;
+  if (llvm::sys::fs::exists(outputFilename)) {
+    std::string error;
+    FailureOr<tpp::TuningDatabase> existingDb =
+        tpp::TuningDatabase::load(outputFilename, error);
+    if (failed(existingDb)) {
+      llvm::errs() << error << "\n";
+      return 1;
+    }
+    db = std::move(*existingDb);
+  }
+
+  // Candidate databases reach the passes through TPP_TUNING_DB, so that the
+  // pipeline does not need a 'tuning-db' option on each pass.
+  SmallString<128> dbPath;
+  if (std::error_code ec =
+          llvm::sys::fs::createTemporaryFile("tpp-tune", "json", dbPath)) {
+    llvm::errs() << "cannot create a temporary file: " << ec.message() << "\n";
+    return 1;
+  }
+  llvm::FileRemover dbRemover(dbPath);
+  ::setenv(tpp::kTuningDatabaseEnvVar, dbPath.c_str(), /*overwrite=*/1);
+
+  // Sites are collected with the current database, then tuned one after the
+  // other: each site is timed with the parameters already selected for the
+  // previous ones.
+  SmallVector<TuningSite> sites;
+  {
+    std::string error;
+    if (failed(db.save(dbPath, error))) {
+      llvm::errs() << error << "\n";
+      return 1;
+    }
+    OwningOpRef<ModuleOp> module = input->clone();
+    if (failed(runPipeline(*module, &sites)))
+      return 1;
+  }
+  llvm::outs() << "Found " << sites.size() << " tunable ops\n";
+
+  for (TuningSite &site : sites) {
+    llvm::outs() << site.entry.getKey() << "\n";
+    // The baseline uses the parameters already in the database, if any, or
+    // the ones of the pipeline.
+    Optional<tpp::TuningEntry> bestEntry;
+    if (const tpp::TuningEntry *entry = db.find(site.entry))
+      bestEntry = *entry;
+    FailureOr<double> baseline = timeVariant(*input, db, dbPath);
+    double bestSeconds = std::numeric_limits<double>::infinity();
+    if (succeeded(baseline)) {
+      bestSeconds = *baseline;
+      llvm::outs() << "  baseline: " << bestSeconds << " s\n";
+    }
+
+    for (ArrayRef<int64_t> params : site.candidates) {
+      tpp::TuningEntry candidate = site.entry;
+      candidate.params.assign(params.begin(), params.end());
+      tpp::TuningDatabase candidateDb = db;
+      candidateDb.insert(candidate);
+      FailureOr<double> seconds = timeVariant(*input, candidateDb, dbPath);
+      llvm::outs() << "  [";
+      llvm::interleaveComma(params, llvm::outs());
+      llvm::outs() << "]: ";
+      if (failed(seconds)) {
+        llvm::outs() << "failed\n";
+        continue;
+      }
+      llvm::outs() << *seconds << " s\n";
+      if (*seconds < bestSeconds) {
+        bestSeconds = *seconds;
+        candidate.seconds = *seconds;
+        bestEntry = candidate;
+      }
+    }
+
+    if (bestEntry) {
+      db.insert(*bestEntry);
+      llvm::outs() << "  best: [";
+      llvm::interleaveComma(bestEntry->params, llvm::outs());
+      llvm::outs() << "]\n";
+    }
+  }
+
+  std::string error;
+  if (failed(db.save(outputFilename, error))) {
+    llvm::errs() << error << "\n";
+    return 1;
+  }
+  return 0;
+}